@@ -0,0 +1,36 @@
+/*
+ * Client configuration shared by WrapperBench and UniMRCPBindingBench.
+ */
+
+#ifndef BENCH_CONFIG_H
+#define BENCH_CONFIG_H
+
+/** @brief Client configuration, MRCPv1 profile "bench" of nothing listening */
+static char const BENCH_CONFIG[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+	"<unimrcpclient version=\"1.0\">"
+	"<properties><ip>127.0.0.1</ip></properties>"
+	"<components>"
+	"<resource-factory><resource id=\"speechsynth\" enable=\"true\"/></resource-factory>"
+	"<rtsp-uac id=\"RTSP-Agent-1\" type=\"UniRTSP\">"
+	"<max-connection-count>10</max-connection-count>"
+	"<sdp-origin>UniMRCPBench</sdp-origin>"
+	"</rtsp-uac>"
+	"<media-engine id=\"Media-Engine-1\"><realtime-rate>1</realtime-rate></media-engine>"
+	"<rtp-factory id=\"RTP-Factory-1\"><rtp-port-min>44000</rtp-port-min><rtp-port-max>44100</rtp-port-max></rtp-factory>"
+	"</components>"
+	"<settings>"
+	"<rtp-settings id=\"RTP-Settings-1\"><ptime>20</ptime><codecs>PCMU L16/96/8000</codecs></rtp-settings>"
+	"<rtsp-settings id=\"RTSP-Down\"><server-ip>127.0.0.1</server-ip><server-port>1</server-port>"
+	"<resource-location>media</resource-location><resource-map>"
+	"<param name=\"speechsynth\" value=\"speechsynthesizer\"/>"
+	"</resource-map></rtsp-settings>"
+	"</settings>"
+	"<profiles>"
+	"<mrcpv1-profile id=\"bench\"><rtsp-uac>RTSP-Agent-1</rtsp-uac><media-engine>Media-Engine-1</media-engine>"
+	"<rtp-factory>RTP-Factory-1</rtp-factory><rtsp-settings>RTSP-Down</rtsp-settings><rtp-settings>RTP-Settings-1</rtp-settings>"
+	"</mrcpv1-profile>"
+	"</profiles>"
+	"</unimrcpclient>";
+
+#endif /* BENCH_CONFIG_H */
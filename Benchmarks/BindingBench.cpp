@@ -0,0 +1,338 @@
+/*
+ * Binding overhead benchmark, see BindingBench.h.
+ *
+ * Built into the modules only with CMake option BENCHMARK_BINDINGS. Drives the
+ * wrapper through the protected members of the termination and the channel.
+ */
+
+/** @brief Enum constants named as in UniMRCP-wrapper.cpp, apart from those of UniMRCP headers */
+#define UNIMRCP_WRAPPER_CPP
+#include "Benchmarks/BindingBench.h"
+#include "Benchmarks/BenchConfig.h"
+#include "apr_atomic.h"
+#include "apr_time.h"
+#include "mrcp_application.h"
+#include "mrcp_message.h"
+#include "mrcp_session.h"
+#include "mrcp_synth_resource.h"
+
+/** @brief Throw UniMRCP exception from here, as in UniMRCP-wrapper.cpp */
+#define UNIMRCP_THROW(msg) throw UniMRCPException(__FILE__, __LINE__, msg)
+
+
+/** @brief Hands out the stream UniMRCPBindingBench is about to open and calls it as the media thread does */
+class UniMRCPBindingTermination : public UniMRCPAudioTermination {
+public:
+	UniMRCPBindingTermination(UniMRCPClientSession* session) :
+		UniMRCPAudioTermination(session),
+		nextRx(NULL),
+		nextTx(NULL)
+	{
+	}
+
+	bool OpenRx(mpf_audio_stream_t* stm) { return StmOpenRx(stm, NULL) == TRUE; }
+	void CloseRx(mpf_audio_stream_t* stm) { StmCloseRx(stm); }
+	void ReadFrame(mpf_audio_stream_t* stm, mpf_frame_t* frame) { StmReadFrame(stm, frame); }
+	bool OpenTx(mpf_audio_stream_t* stm) { return StmOpenTx(stm, NULL) == TRUE; }
+	void CloseTx(mpf_audio_stream_t* stm) { StmCloseTx(stm); }
+	void WriteFrame(mpf_audio_stream_t* stm, mpf_frame_t const* frame) { StmWriteFrame(stm, frame); }
+
+	virtual UniMRCPStreamRx* OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return nextRx;
+	}
+
+	virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return nextTx;
+	}
+
+	UniMRCPStreamRx* nextRx;
+	UniMRCPStreamTx* nextTx;
+};
+
+
+/** @brief What the binding streams do in ReadFrame() */
+class UniMRCPNativeStreamRx : public UniMRCPStreamRx {
+public:
+	UniMRCPNativeStreamRx(bool _data) : data(_data)
+	{
+		memset(buf, 0, sizeof(buf));
+	}
+
+	virtual bool ReadFrame()
+	{
+		if (data)
+			SetData(buf, sizeof(buf));
+		return true;
+	}
+
+private:
+	bool data;
+	char buf[UniMRCPBindingBench::FRAME_SIZE];
+};
+
+
+/** @brief What the binding streams do in WriteFrame() */
+class UniMRCPNativeStreamTx : public UniMRCPStreamTx {
+public:
+	UniMRCPNativeStreamTx(bool _data) : data(_data) {}
+
+	virtual bool WriteFrame()
+	{
+		if (data)
+			GetData(buf, sizeof(buf));
+		return true;
+	}
+
+private:
+	bool data;
+	char buf[UniMRCPBindingBench::FRAME_SIZE];
+};
+
+
+/** @brief What the binding channels do in OnMessageReceive() */
+class UniMRCPNativeChannel : public UniMRCPBenchChannel {
+public:
+	UniMRCPNativeChannel(UniMRCPBindingBench* bench) :
+		UniMRCPBenchChannel(bench),
+		completed(0)
+	{
+	}
+
+	virtual bool OnMessageReceive(UniMRCPSynthesizerMessage const* message)
+	{
+		if (message->GetEventID() == SYNTHESIZER_SPEAK_COMPLETE)
+			completed++;
+		return true;
+	}
+
+	unsigned long completed;
+};
+
+
+/** @brief Keeps results of the native getters alive */
+static volatile unsigned long bindingSink = 0;
+
+/** @brief How long to wait for adding of a channel to fail */
+#define ADD_TIMEOUT apr_time_from_sec(10)
+
+
+static inline double NsPerCall(apr_interval_time_t elapsed, unsigned long n)
+{
+	return n ? static_cast<double>(elapsed) * 1000 / static_cast<double>(n) : 0;
+}
+
+
+UniMRCPBenchChannel::UniMRCPBenchChannel(UniMRCPBindingBench* _bench) THROWS(UniMRCPException) :
+	UniMRCPClientResourceChannel<MRCP_SYNTHESIZER>(_bench->session, _bench->term),
+	bench(_bench),
+	added(0)
+{
+}
+
+
+bool UniMRCPBenchChannel::OnAdd(UniMRCPSigStatusCode status)
+{
+	(void) status;
+	apr_atomic_set32(&added, 1);
+	return true;
+}
+
+
+bool UniMRCPBenchChannel::WaitAdded()
+{
+	apr_time_t deadline = apr_time_now() + ADD_TIMEOUT;
+	while (!apr_atomic_read32(&added)) {
+		if (apr_time_now() >= deadline)
+			return false;
+		apr_sleep(1000);
+	}
+	return true;
+}
+
+
+mrcp_message_t* UniMRCPBenchChannel::CreateEvent(apr_pool_t* pool)
+{
+	mrcp_message_t* request = mrcp_application_message_create(sess, chan, SYNTHESIZER_SPEAK);
+	return request ? mrcp_event_create(request, SYNTHESIZER_SPEAK_COMPLETE, pool) : NULL;
+}
+
+
+double UniMRCPBenchChannel::Receive(mrcp_message_t* message, apr_pool_t* pool, unsigned long n, unsigned long chunk)
+{
+	/* OnMsgReceive() wraps the messages in the session pool, lend it the given one */
+	apr_pool_t* own = sess->pool;
+	sess->pool = pool;
+	apr_time_t start = apr_time_now();
+	try {
+		for (unsigned long i = 0; i < n; i++) {
+			OnMsgReceive(message);
+			if ((i % chunk) == chunk - 1)
+				apr_pool_clear(pool);
+		}
+	} catch (...) {
+		sess->pool = own;
+		throw;
+	}
+	apr_interval_time_t elapsed = apr_time_now() - start;
+	sess->pool = own;
+	apr_pool_clear(pool);
+	return NsPerCall(elapsed, n);
+}
+
+
+UniMRCPBindingBench::UniMRCPBindingBench() THROWS(UniMRCPException) :
+	pool(NULL),
+	msgPool(NULL),
+	client(NULL),
+	session(NULL),
+	term(NULL),
+	stm(NULL),
+	frame(NULL),
+	msgChannel(NULL),
+	event(NULL),
+	msg(NULL)
+{
+	if ((apr_pool_create(&pool, NULL) != APR_SUCCESS) ||
+		(apr_pool_create(&msgPool, pool) != APR_SUCCESS))
+	{
+		Destroy();
+		UNIMRCP_THROW("Cannot create memory pool");
+	}
+	try {
+		client = new UniMRCPClient(BENCH_CONFIG);
+		session = new UniMRCPClientSession(client, "bench");
+		term = new UniMRCPBindingTermination(session);
+		msgChannel = new UniMRCPBenchChannel(this);
+	} catch (...) {
+		Destroy();
+		throw;
+	}
+	stm = static_cast<mpf_audio_stream_t*>(apr_pcalloc(pool, sizeof(mpf_audio_stream_t)));
+	stm->obj = term;
+	frame = static_cast<mpf_frame_t*>(apr_pcalloc(pool, sizeof(mpf_frame_t)));
+	frame->codec_frame.buffer = apr_pcalloc(pool, FRAME_SIZE);
+	frame->codec_frame.size = FRAME_SIZE;
+	event = msgChannel->CreateEvent(pool);
+	if (!event) {
+		Destroy();
+		UNIMRCP_THROW("Cannot create MRCP messages");
+	}
+	msg = msgChannel->CreateMessage(SYNTHESIZER_SPEAK);
+}
+
+
+UniMRCPBindingBench::~UniMRCPBindingBench()
+{
+	Destroy();
+}
+
+
+void UniMRCPBindingBench::Destroy()
+{
+	/* The message is in the session pool */
+	msg = NULL;
+	delete msgChannel;
+	msgChannel = NULL;
+	delete term;
+	term = NULL;
+	delete session;
+	session = NULL;
+	delete client;
+	client = NULL;
+	if (pool)
+		apr_pool_destroy(pool);
+	pool = NULL;
+}
+
+
+double UniMRCPBindingBench::ReadFrames(UniMRCPStreamRx* stream, unsigned long n) THROWS(UniMRCPException)
+{
+	term->nextRx = stream;
+	if (!stream || !term->OpenRx(stm))
+		UNIMRCP_THROW("Cannot open stream");
+	apr_time_t start = apr_time_now();
+	for (unsigned long i = 0; i < n; i++) {
+		frame->type = MEDIA_FRAME_TYPE_NONE;
+		term->ReadFrame(stm, frame);
+	}
+	apr_interval_time_t elapsed = apr_time_now() - start;
+	term->CloseRx(stm);
+	return NsPerCall(elapsed, n);
+}
+
+
+double UniMRCPBindingBench::WriteFrames(UniMRCPStreamTx* stream, unsigned long n) THROWS(UniMRCPException)
+{
+	term->nextTx = stream;
+	if (!stream || !term->OpenTx(stm))
+		UNIMRCP_THROW("Cannot open stream");
+	frame->type = MEDIA_FRAME_TYPE_AUDIO;
+	apr_time_t start = apr_time_now();
+	for (unsigned long i = 0; i < n; i++)
+		term->WriteFrame(stm, frame);
+	apr_interval_time_t elapsed = apr_time_now() - start;
+	term->CloseTx(stm);
+	return NsPerCall(elapsed, n);
+}
+
+
+double UniMRCPBindingBench::ReceiveMessages(UniMRCPBenchChannel* channel, unsigned long n) THROWS(UniMRCPException)
+{
+	if (!channel || (channel->bench != this))
+		UNIMRCP_THROW("Channel not created for this benchmark");
+	/* Once the add failed, the stack does not touch the session pool lent below */
+	if (!channel->WaitAdded())
+		UNIMRCP_THROW("Channel add not completed");
+	return channel->Receive(event, msgPool, n, CHUNK);
+}
+
+
+UniMRCPSynthesizerMessage* UniMRCPBindingBench::GetMessage()
+{
+	return msg;
+}
+
+
+double UniMRCPBindingBench::NativeReadFrames(bool data, unsigned long n) THROWS(UniMRCPException)
+{
+	UniMRCPNativeStreamRx stream(data);
+	return ReadFrames(&stream, n);
+}
+
+
+double UniMRCPBindingBench::NativeWriteFrames(bool data, unsigned long n) THROWS(UniMRCPException)
+{
+	UniMRCPNativeStreamTx stream(data);
+	return WriteFrames(&stream, n);
+}
+
+
+double UniMRCPBindingBench::NativeReceiveMessages(unsigned long n) THROWS(UniMRCPException)
+{
+	UniMRCPNativeChannel channel(this);
+	double ret = ReceiveMessages(&channel, n);
+	bindingSink += channel.completed;
+	return ret;
+}
+
+
+double UniMRCPBindingBench::NativeAccessHeaders(unsigned long n)
+{
+	unsigned long sum = 0;
+	apr_time_t start = apr_time_now();
+	for (unsigned long i = 0; i < n; i++) {
+		msg->content_type_set("application/ssml+xml");
+		msg->content_length_set(i);
+		msg->speech_language_set("en-US");
+		sum += msg->content_type_get()[0] + msg->content_length_get() + msg->speech_language_get()[0];
+	}
+	apr_interval_time_t elapsed = apr_time_now() - start;
+	bindingSink += sum;
+	return NsPerCall(elapsed, n * 6);
+}
@@ -0,0 +1,113 @@
+/*
+ * Binding overhead benchmark, built into the modules with CMake option
+ * BENCHMARK_BINDINGS and wrapped by BindingBench.i, see Python/BindingBench.py,
+ * Java/BindingBench.java and CSharp/BindingBench.cs.
+ */
+
+#ifndef BINDING_BENCH_H
+#define BINDING_BENCH_H
+
+#include "UniMRCP-wrapper.h"
+
+class UniMRCPBenchChannel;
+class UniMRCPBindingTermination;
+
+
+/**
+ * @brief Calls the user callbacks the way UniMRCP does, to measure the cost of the language bindings.
+ *
+ * Runs on a session of its own client with a profile of no server, so the
+ * channels are never added. UniMRCPClient::StaticInitialize() must be called
+ * first. Every method returns nanoseconds per call. The Native* methods run the same scenarios with C++
+ * objects to compare the bindings against.
+ */
+class UniMRCPBindingBench {
+public:
+	enum {
+		FRAME_SIZE = 160, ///< Size of the frames passed to the streams, 10 ms of 8 kHz LPCM
+		CHUNK = 1024      ///< Messages received between clearing of their pool
+	};
+
+	UniMRCPBindingBench() THROWS(UniMRCPException);
+	~UniMRCPBindingBench();
+
+	/** @brief Open the stream, call its ReadFrame() n times as the media thread does and close it */
+	double ReadFrames(UniMRCPStreamRx* stream, unsigned long n) THROWS(UniMRCPException);
+	/** @brief Open the stream, pass n audio frames to its WriteFrame() and close it */
+	double WriteFrames(UniMRCPStreamTx* stream, unsigned long n) THROWS(UniMRCPException);
+	/**
+	 * @brief Pass SPEAK-COMPLETE to OnMessageReceive() of the channel n times.
+	 *
+	 * Waits for adding of the channel to fail first, the stack leaves the
+	 * session alone then. The messages are wrapped in a pool cleared every
+	 * #CHUNK calls instead of the session pool, so do not keep them.
+	 * @param channel Channel created for this benchmark
+	 */
+	double ReceiveMessages(UniMRCPBenchChannel* channel, unsigned long n) THROWS(UniMRCPException);
+	/** @brief SPEAK request to access headers of, owned by the benchmark */
+	UniMRCPSynthesizerMessage* GetMessage();
+
+	/** @brief ReadFrames() of a C++ stream, filling the frame by SetData() if data is true */
+	double NativeReadFrames(bool data, unsigned long n) THROWS(UniMRCPException);
+	/** @brief WriteFrames() of a C++ stream, copying the frame by GetData() if data is true */
+	double NativeWriteFrames(bool data, unsigned long n) THROWS(UniMRCPException);
+	/** @brief ReceiveMessages() of a C++ channel checking the event ID */
+	double NativeReceiveMessages(unsigned long n) THROWS(UniMRCPException);
+	/**
+	 * @brief Set and get content_type, content_length and speech_language of GetMessage() n times
+	 * @return Nanoseconds per access, i.e. per one of the six calls
+	 */
+	double NativeAccessHeaders(unsigned long n);
+
+private:
+	/** Release what the constructor created so far */
+	void Destroy();
+
+private:
+	apr_pool_t* pool;                 ///< Pool of the C stream and frame
+	apr_pool_t* msgPool;              ///< Pool of the received messages
+	UniMRCPClient* client;            ///< Client with a profile of no server
+	UniMRCPClientSession* session;    ///< Session of the channels
+	UniMRCPBindingTermination* term;  ///< Termination handing out the streams
+	mpf_audio_stream_t* stm;          ///< C stream the callbacks are called for
+	mpf_frame_t* frame;               ///< Frame passed to the streams
+	UniMRCPBenchChannel* msgChannel;  ///< Channel the messages below are created in
+	mrcp_message_t* event;            ///< SPEAK-COMPLETE passed to the channels
+	UniMRCPSynthesizerMessage* msg;   ///< Message returned by GetMessage()
+
+	friend class UniMRCPBenchChannel;
+};
+
+
+/**
+ * @brief Synthesizer channel OnMessageReceive() of which is called by UniMRCPBindingBench::ReceiveMessages().
+ *
+ * Derive the channels measured from it, leaving OnAdd() alone.
+ */
+class UniMRCPBenchChannel : public UniMRCPClientResourceChannel<MRCP_SYNTHESIZER> {
+public:
+	UniMRCPBenchChannel(UniMRCPBindingBench* bench) THROWS(UniMRCPException);
+
+	/** @brief Explicitly define public destructor, otherwise SWIG exception occurs */
+	virtual inline ~UniMRCPBenchChannel()
+	{
+	}
+
+	/** @brief Adding failed as there is no server, the channel is ready for the benchmark */
+	virtual bool OnAdd(UniMRCPSigStatusCode status);
+
+private:
+	/** Wait for OnAdd(), false if it does not come in time */
+	bool WaitAdded();
+	/** SPEAK-COMPLETE of a SPEAK created in the channel */
+	mrcp_message_t* CreateEvent(apr_pool_t* pool);
+	/** Pass the message to OnMsgReceive() n times wrapping it in the pool cleared every chunk calls, ns per call */
+	double Receive(mrcp_message_t* message, apr_pool_t* pool, unsigned long n, unsigned long chunk);
+
+	UniMRCPBindingBench* bench;  ///< Benchmark the channel was created for
+	volatile unsigned added;     ///< Set by OnAdd()
+
+	friend class UniMRCPBindingBench;
+};
+
+#endif /* BINDING_BENCH_H */
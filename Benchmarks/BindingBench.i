@@ -0,0 +1,12 @@
+/*
+ * Binding overhead benchmark, included by UniMRCP-wrapper.i with UW_BENCHMARK
+ * (CMake option BENCHMARK_BINDINGS) only.
+ */
+
+%{
+#include "Benchmarks/BindingBench.h"
+%}
+
+%feature("director") UniMRCPBenchChannel;
+
+%include "Benchmarks/BindingBench.h"
@@ -0,0 +1,128 @@
+/*
+ * Cost of debug logging in a callback when the log priority filters it out.
+ *
+ * Compares the former unconditional apt_log() call, the UW_LOG() priority
+ * check done by the wrapper before evaluating arguments, UW_SLOG() without a
+ * session override, and the same check compiled out by UW_LOG_MIN_PRIORITY.
+ *
+ * Includes UniMRCP-wrapper.cpp to measure its own macros rather than copies.
+ *
+ * Usage: LogFilter [iterations]
+ */
+
+/* Debug messages compiled in whatever the build configured, the compiled out case lowers it below */
+#ifdef UW_LOG_MIN_PRIORITY
+#	undef UW_LOG_MIN_PRIORITY
+#endif
+#define UW_LOG_MIN_PRIORITY APT_PRIO_DEBUG
+#include "UniMRCP-wrapper.cpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+static char const platform[] = "Benchmark";
+static unsigned long handled = 0;
+
+
+// Formats like UniMRCPLogger::LogExtHandler, never reached at NOTICE
+static apt_bool_t LogHandler(char const* file, int line, char const* id, apt_log_priority_e priority, char const* format, va_list arg_ptr)
+{
+	(void) file;
+	(void) line;
+	(void) id;
+	(void) priority;
+	char buf[4096];
+	apr_vsnprintf(buf, sizeof(buf), format, arg_ptr);
+	handled++;
+	return TRUE;
+}
+
+
+// Work of a typical callback besides logging
+struct BenchSession {
+	void*    obj;
+	unsigned status;
+	unsigned calls;
+};
+
+static int OnUpdateUnfiltered(BenchSession* s, unsigned status)
+{
+	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s AppOnSessionUpdate: session(%pp) status(%d) obj(%pp)",
+		platform, s, status, s->obj);
+	s->status = status;
+	return ++s->calls;
+}
+
+static int OnUpdateFiltered(BenchSession* s, unsigned status)
+{
+	UW_LOG(APT_PRIO_DEBUG, "%s AppOnSessionUpdate: session(%pp) status(%d) obj(%pp)",
+		platform, s, status, s->obj);
+	s->status = status;
+	return ++s->calls;
+}
+
+static int OnUpdateSession(BenchSession* s, unsigned status)
+{
+	UW_SLOG(-1, APT_PRIO_DEBUG, "%s AppOnSessionUpdate: session(%pp) status(%d) obj(%pp)",
+		platform, s, status, s->obj);
+	s->status = status;
+	return ++s->calls;
+}
+
+/* UW_LOG_ON() reads UW_LOG_MIN_PRIORITY where it is expanded */
+#undef UW_LOG_MIN_PRIORITY
+#define UW_LOG_MIN_PRIORITY APT_PRIO_NOTICE
+
+static int OnUpdateCompiledOut(BenchSession* s, unsigned status)
+{
+	UW_LOG(APT_PRIO_DEBUG, "%s AppOnSessionUpdate: session(%pp) status(%d) obj(%pp)",
+		platform, s, status, s->obj);
+	s->status = status;
+	return ++s->calls;
+}
+
+
+typedef int (*Callback)(BenchSession* s, unsigned status);
+
+static void Run(char const* name, Callback cb, unsigned long iterations)
+{
+	BenchSession s = {&s, 0, 0};
+	// Through a volatile pointer, so that the call is not inlined away
+	Callback volatile call = cb;
+	apr_time_t start = apr_time_now();
+	for (unsigned long i = 0; i < iterations; i++)
+		call(&s, static_cast<unsigned>(i & 1));
+	apr_time_t elapsed = apr_time_now() - start;
+	printf("%-14s %10lu calls %10.2f ns/call\n", name, iterations,
+		static_cast<double>(elapsed) * 1000 / static_cast<double>(iterations));
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+	if (!iterations)
+		iterations = 1;
+	if (apr_initialize() != APR_SUCCESS)
+		return 1;
+	apr_pool_t* pool = apt_pool_create();
+	if (!pool) {
+		apr_terminate();
+		return 1;
+	}
+	apt_log_instance_create(APT_LOG_OUTPUT_NONE, APT_PRIO_NOTICE, pool);
+	apt_log_ext_handler_set(reinterpret_cast<apt_log_ext_handler_f>(LogHandler));
+
+	printf("Debug message in a callback, log priority NOTICE\n");
+	Run("unfiltered", OnUpdateUnfiltered, iterations);
+	Run("filtered", OnUpdateFiltered, iterations);
+	Run("session", OnUpdateSession, iterations);
+	Run("compiled out", OnUpdateCompiledOut, iterations);
+	if (handled)
+		printf("Unexpected: %lu messages formatted\n", handled);
+
+	apt_log_instance_destroy();
+	apr_pool_destroy(pool);
+	apr_terminate();
+	return 0;
+}
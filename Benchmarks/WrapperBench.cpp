@@ -0,0 +1,841 @@
+/*
+ * Microbenchmarks of the wrapper hot paths with results in JSON.
+ *
+ * Includes UniMRCP-wrapper.cpp through WrapperInternals.h to reach the internals
+ * and drives them directly. No server is needed, the session of the client of
+ * BenchConfig.h gets no channel:
+ * - outgoing streams through StmReadFrame(): UniMRCPStreamRxBuffered (also with
+ *   a producer thread contending for its lock) and UniMRCPStreamRxMemory
+ * - StmReadFrame() and StmWriteFrame() dispatch to trivial streams
+ * - message header setters and getters, rendering of lazily added headers
+ *   as done by UniMRCPMessage::Send(), Vendor-Specific-Parameters
+ * - UniMRCPLogger::LogExtHandler() formatting, synchronous and queued
+ *
+ * Every benchmark runs the iterations in a number of batches, ns_per_op is
+ * the median batch. The contended stream records every call and reports
+ * percentiles. Keep the output of a build to compare later ones against it.
+ *
+ * Usage: WrapperBench [options], see Usage() below
+ */
+
+#include "WrapperInternals.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "mrcp_default_factory.h"
+#include "mrcp_resource_factory.h"
+#include "BenchConfig.h"
+
+/** @brief 10 ms of 8 kHz LPCM */
+#define FRAME_SIZE 160
+/** @brief Frames the producer of the contended stream keeps ahead at most */
+#define PRODUCER_AHEAD 64
+/** @brief Operations per timed chunk where untimed work must be interleaved */
+#define CHUNK 1000
+#define MAX_RESULTS 32
+
+static char const LOG_FORMAT[] = "%s AppOnSessionUpdate: session(%pp) status(%d) obj(%pp)";
+
+static apr_uint64_t NowNs()
+{
+#ifdef WIN32
+	static LARGE_INTEGER freq = {{0, 0}};
+	LARGE_INTEGER now;
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return static_cast<apr_uint64_t>(static_cast<double>(now.QuadPart) * 1e9 / static_cast<double>(freq.QuadPart));
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<apr_uint64_t>(ts.tv_sec) * 1000000000 + static_cast<apr_uint64_t>(ts.tv_nsec);
+#endif
+}
+
+
+static int CompareDouble(void const* a, void const* b)
+{
+	double x = *static_cast<double const*>(a);
+	double y = *static_cast<double const*>(b);
+	return x < y ? -1 : x > y;
+}
+
+
+static int CompareUint32(void const* a, void const* b)
+{
+	apr_uint32_t x = *static_cast<apr_uint32_t const*>(a);
+	apr_uint32_t y = *static_cast<apr_uint32_t const*>(b);
+	return x < y ? -1 : x > y;
+}
+
+
+/** @brief Percentile of sorted samples */
+static apr_uint32_t Percentile(apr_uint32_t const* sorted, unsigned long count, double pct)
+{
+	if (!count) return 0;
+	unsigned long i = static_cast<unsigned long>(pct / 100 * static_cast<double>(count - 1) + 0.5);
+	return sorted[i < count ? i : count - 1];
+}
+
+
+/** @brief Discards log messages, the formatting is measured */
+class NullLogger : public UniMRCPLogger {
+public:
+	NullLogger() : logged(0) {}
+	virtual bool Log(char const* file, unsigned line, UniMRCPLogPriority priority, char const* message)
+	{
+		(void) file;
+		(void) line;
+		(void) priority;
+		logged += message[0] != 0;
+		return true;
+	}
+	unsigned long logged;
+};
+
+
+/** @brief Supplies no audio, just for the dispatch cost */
+class NullStreamRx : public UniMRCPStreamRx {
+public:
+	virtual bool ReadFrame() { return true; }
+};
+
+
+/** @brief Accepts frames without looking at them */
+class NullStreamTx : public UniMRCPStreamTx {
+public:
+	virtual bool WriteFrame() { return true; }
+};
+
+
+/** @brief Hands out the streams the benchmark is about to open */
+class BenchTermination : public UniMRCPAudioTermination {
+public:
+	BenchTermination(UniMRCPClientSession* session) :
+		UniMRCPAudioTermination(session),
+		nextRx(NULL),
+		nextTx(NULL)
+	{
+	}
+
+	virtual UniMRCPStreamRx* OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return nextRx;
+	}
+
+	virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return nextTx;
+	}
+
+	UniMRCPStreamRx* nextRx;
+	UniMRCPStreamTx* nextTx;
+};
+
+
+/** @brief Outcome of one benchmark, latency fields only for the contended stream */
+struct BenchResult {
+	char const*   name;
+	unsigned long iterations;
+	double        nsPerOp;
+	double        minNs;
+	double        maxNs;
+	bool          latency;
+	apr_uint32_t  p50;
+	apr_uint32_t  p99;
+	apr_uint32_t  p999;
+	apr_uint32_t  max;
+	apr_uint32_t  producerP50;
+	apr_uint32_t  producerP99;
+	unsigned long underruns;
+};
+
+
+class UniMRCPBenchmark {
+public:
+	UniMRCPBenchmark(unsigned long iterations, unsigned batches);
+	~UniMRCPBenchmark();
+
+	bool Init();
+	void Run(char const* filter);
+	void Report(FILE* f, char const* label) const;
+
+private:
+	/** @brief Benchmark body, returns nanoseconds taken by n operations */
+	typedef apr_uint64_t (UniMRCPBenchmark::*Body)(unsigned long n);
+
+	void Measure(char const* name, Body body);
+	BenchResult* AddResult(char const* name);
+
+	bool OpenRx(UniMRCPStreamRx* stream);
+	void CloseRx();
+	bool ReadFrame();
+	UniMRCPSynthesizerMessage* NewMessage();
+	void DeleteMessage();
+	int LogExt(char const* format, ...);
+
+	apr_uint64_t StmReadFrame(unsigned long n);
+	apr_uint64_t StmWriteFrame(unsigned long n);
+	apr_uint64_t RxMemoryRead(unsigned long n);
+	apr_uint64_t RxBufferedAdd(unsigned long n);
+	apr_uint64_t RxBufferedRead(unsigned long n);
+	void RxBufferedContended();
+	static void* APR_THREAD_FUNC Producer(apr_thread_t* thread, void* data);
+	apr_uint64_t HeaderSetStr(unsigned long n);
+	apr_uint64_t HeaderGetStr(unsigned long n);
+	apr_uint64_t HeaderSetSimple(unsigned long n);
+	apr_uint64_t HeaderGetSimple(unsigned long n);
+	apr_uint64_t HeaderSetSynth(unsigned long n);
+	apr_uint64_t MessageRender(unsigned long n);
+	apr_uint64_t VendorParamAppend(unsigned long n);
+	apr_uint64_t VendorParamFind(unsigned long n);
+	apr_uint64_t VendorParamGet(unsigned long n);
+	apr_uint64_t LogExtHandler(unsigned long n);
+	apr_uint64_t LogExtHandlerQueued(unsigned long n);
+
+private:
+	unsigned long iterations;
+	unsigned batches;
+	apr_pool_t* pool;
+	apr_pool_t* msgPool;            ///< Cleared with every message
+	mrcp_resource_factory_t* factory;
+	UniMRCPClient* client;
+	UniMRCPClientSession* session;  ///< Owns the termination, never gets a channel
+	BenchTermination* term;
+	mpf_audio_stream_t* stm;
+	mpf_frame_t frame;
+	char frameBuf[FRAME_SIZE];
+	char audio[FRAME_SIZE * 100];   ///< 1 s of audio for the streams
+	UniMRCPSynthesizerMessage* msg;
+	UniMRCPStreamRxBuffered* shared; ///< Contended stream
+	volatile apr_uint32_t produced;
+	volatile apr_uint32_t consumed;
+	volatile apr_uint32_t done;
+	apr_uint32_t* producerNs;
+	unsigned long producerCount;
+	NullLogger logger;
+	volatile unsigned long sink;    ///< Keeps results of getters alive
+	BenchResult results[MAX_RESULTS];
+	unsigned resultCount;
+};
+
+
+UniMRCPBenchmark::UniMRCPBenchmark(unsigned long _iterations, unsigned _batches) :
+	iterations(_iterations),
+	batches(_batches),
+	pool(NULL),
+	msgPool(NULL),
+	factory(NULL),
+	client(NULL),
+	session(NULL),
+	term(NULL),
+	stm(NULL),
+	msg(NULL),
+	shared(NULL),
+	produced(0),
+	consumed(0),
+	done(0),
+	producerNs(NULL),
+	producerCount(0),
+	sink(0),
+	resultCount(0)
+{
+	memset(&frame, 0, sizeof(frame));
+	frame.codec_frame.buffer = frameBuf;
+	frame.codec_frame.size = FRAME_SIZE;
+	for (size_t i = 0; i < sizeof(audio); i++)
+		audio[i] = static_cast<char>(i * 7);
+}
+
+
+UniMRCPBenchmark::~UniMRCPBenchmark()
+{
+	CloseRx();
+	DeleteMessage();
+	delete term;
+	delete session;
+	delete client;
+	if (factory)
+		mrcp_resource_factory_destroy(factory);
+	if (pool)
+		apr_pool_destroy(pool);
+}
+
+
+bool UniMRCPBenchmark::Init()
+{
+	UniMRCPClient::StaticInitialize(&logger, UW_APT_PRIO_NOTICE);
+	if ((apr_pool_create(&pool, NULL) != APR_SUCCESS) ||
+		(apr_pool_create(&msgPool, pool) != APR_SUCCESS))
+		return false;
+	factory = mrcp_default_factory_create(pool);
+	if (!factory)
+		return false;
+	client = new UniMRCPClient(BENCH_CONFIG);
+	session = new UniMRCPClientSession(client, "bench");
+	term = new BenchTermination(session);
+	stm = static_cast<mpf_audio_stream_t*>(apr_pcalloc(pool, sizeof(mpf_audio_stream_t)));
+	stm->obj = term;
+	return true;
+}
+
+
+BenchResult* UniMRCPBenchmark::AddResult(char const* name)
+{
+	if (resultCount >= MAX_RESULTS)
+		return NULL;
+	BenchResult* r = &results[resultCount++];
+	memset(r, 0, sizeof(*r));
+	r->name = name;
+	return r;
+}
+
+
+void UniMRCPBenchmark::Measure(char const* name, Body body)
+{
+	double perOp[64];
+	unsigned count = batches < 64 ? batches : 64;
+	// Warm up caches and the allocators
+	(this->*body)(iterations / 10 + 1);
+	for (unsigned i = 0; i < count; i++)
+		perOp[i] = static_cast<double>((this->*body)(iterations)) / static_cast<double>(iterations);
+	qsort(perOp, count, sizeof(double), CompareDouble);
+	BenchResult* r = AddResult(name);
+	if (!r) return;
+	r->iterations = iterations;
+	r->nsPerOp = perOp[count / 2];
+	r->minNs = perOp[0];
+	r->maxNs = perOp[count - 1];
+	fprintf(stderr, "%-24s %10.1f ns/op\n", name, r->nsPerOp);
+}
+
+
+bool UniMRCPBenchmark::OpenRx(UniMRCPStreamRx* stream)
+{
+	CloseRx();
+	term->nextRx = stream;
+	if (UniMRCPAudioTermination::StmOpenRx(stm, NULL) == TRUE)
+		return true;
+	delete stream;
+	return false;
+}
+
+
+void UniMRCPBenchmark::CloseRx()
+{
+	if (!term || !term->streamRx)
+		return;
+	UniMRCPStreamRx* stream = term->streamRx;
+	UniMRCPAudioTermination::StmCloseRx(stm);
+	delete stream;
+}
+
+
+/** @brief Read a frame as the media engine does */
+inline bool UniMRCPBenchmark::ReadFrame()
+{
+	frame.type = MEDIA_FRAME_TYPE_NONE;
+	return UniMRCPAudioTermination::StmReadFrame(stm, &frame) && (frame.type & MEDIA_FRAME_TYPE_AUDIO);
+}
+
+
+/** @brief Fresh SPEAK request without a channel, previous one freed */
+UniMRCPSynthesizerMessage* UniMRCPBenchmark::NewMessage()
+{
+	DeleteMessage();
+	apr_pool_clear(msgPool);
+	mrcp_message_t* m = mrcp_request_create(mrcp_resource_get(factory, MRCP_SYNTHESIZER_RESOURCE),
+		MRCP_VERSION_2, SYNTHESIZER_SPEAK, msgPool);
+	if (!m)
+		UNIMRCP_THROW("Cannot create message");
+	msg = new UniMRCPSynthesizerMessage(NULL, NULL, m, true);
+	return msg;
+}
+
+
+void UniMRCPBenchmark::DeleteMessage()
+{
+	delete msg;
+	msg = NULL;
+}
+
+
+int UniMRCPBenchmark::LogExt(char const* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	int ret = UniMRCPLogger::LogExtHandler(__FILE__, __LINE__, NULL, UW_APT_PRIO_NOTICE, format, ap);
+	va_end(ap);
+	return ret;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::StmReadFrame(unsigned long n)
+{
+	if (!OpenRx(new NullStreamRx()))
+		return 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		ReadFrame();
+	return NowNs() - start;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::StmWriteFrame(unsigned long n)
+{
+	NullStreamTx stream;
+	term->nextTx = &stream;
+	if (UniMRCPAudioTermination::StmOpenTx(stm, NULL) != TRUE)
+		return 0;
+	memset(frameBuf, 0, sizeof(frameBuf));
+	frame.type = MEDIA_FRAME_TYPE_AUDIO;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		UniMRCPAudioTermination::StmWriteFrame(stm, &frame);
+	apr_uint64_t elapsed = NowNs() - start;
+	UniMRCPAudioTermination::StmCloseTx(stm);
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::RxMemoryRead(unsigned long n)
+{
+	if (!OpenRx(new UniMRCPStreamRxMemory(audio, sizeof(audio), false, UniMRCPStreamRxMemory::SRM_REWIND)))
+		return 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		ReadFrame();
+	return NowNs() - start;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::RxBufferedAdd(unsigned long n)
+{
+	UniMRCPStreamRxBuffered* stream = new UniMRCPStreamRxBuffered();
+	if (!OpenRx(stream))
+		return 0;
+	apr_uint64_t elapsed = 0;
+	for (unsigned long i = 0; i < n; i += CHUNK) {
+		unsigned long chunk = n - i < CHUNK ? n - i : CHUNK;
+		apr_uint64_t start = NowNs();
+		for (unsigned long j = 0; j < chunk; j++)
+			stream->AddData(audio, FRAME_SIZE);
+		elapsed += NowNs() - start;
+		while (ReadFrame())
+			;
+	}
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::RxBufferedRead(unsigned long n)
+{
+	UniMRCPStreamRxBuffered* stream = new UniMRCPStreamRxBuffered();
+	if (!OpenRx(stream))
+		return 0;
+	apr_uint64_t elapsed = 0;
+	for (unsigned long i = 0; i < n; i += CHUNK) {
+		unsigned long chunk = n - i < CHUNK ? n - i : CHUNK;
+		for (unsigned long j = 0; j < chunk; j++)
+			stream->AddData(audio + (j % 100) * FRAME_SIZE, FRAME_SIZE);
+		apr_uint64_t start = NowNs();
+		for (unsigned long j = 0; j < chunk; j++)
+			ReadFrame();
+		elapsed += NowNs() - start;
+	}
+	return elapsed;
+}
+
+
+void* APR_THREAD_FUNC UniMRCPBenchmark::Producer(apr_thread_t* thread, void* data)
+{
+	UniMRCPBenchmark* b = static_cast<UniMRCPBenchmark*>(data);
+	while (!apr_atomic_read32(&b->done)) {
+		if (apr_atomic_read32(&b->produced) - apr_atomic_read32(&b->consumed) >= PRODUCER_AHEAD) {
+			apr_thread_yield();
+			continue;
+		}
+		apr_uint64_t start = NowNs();
+		b->shared->AddData(b->audio, FRAME_SIZE);
+		apr_uint64_t took = NowNs() - start;
+		if (b->producerCount < b->iterations)
+			b->producerNs[b->producerCount++] = static_cast<apr_uint32_t>(took);
+		apr_atomic_inc32(&b->produced);
+	}
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+
+/** @brief Media thread reading as fast as it can while another thread adds data */
+void UniMRCPBenchmark::RxBufferedContended()
+{
+	apr_uint32_t* readNs = static_cast<apr_uint32_t*>(malloc(iterations * sizeof(apr_uint32_t)));
+	producerNs = static_cast<apr_uint32_t*>(malloc(iterations * sizeof(apr_uint32_t)));
+	shared = new UniMRCPStreamRxBuffered();
+	apr_thread_t* thread = NULL;
+	if (!readNs || !producerNs || !OpenRx(shared) ||
+		(apr_thread_create(&thread, NULL, Producer, this, pool) != APR_SUCCESS))
+	{
+		fprintf(stderr, "Cannot run rx_buffered_contended\n");
+		free(readNs);
+		free(producerNs);
+		producerNs = NULL;
+		return;
+	}
+	unsigned long underruns = 0;
+	apr_uint64_t total = 0;
+	for (unsigned long i = 0; i < iterations; i++) {
+		apr_uint64_t start = NowNs();
+		bool got = ReadFrame();
+		apr_uint64_t took = NowNs() - start;
+		readNs[i] = static_cast<apr_uint32_t>(took);
+		total += took;
+		if (got)
+			apr_atomic_inc32(&consumed);
+		else
+			underruns++;
+	}
+	apr_atomic_set32(&done, 1);
+	apr_status_t status;
+	apr_thread_join(&status, thread);
+	CloseRx();
+	shared = NULL;
+
+	qsort(readNs, iterations, sizeof(apr_uint32_t), CompareUint32);
+	qsort(producerNs, producerCount, sizeof(apr_uint32_t), CompareUint32);
+	BenchResult* r = AddResult("rx_buffered_contended");
+	if (r) {
+		r->iterations = iterations;
+		r->nsPerOp = static_cast<double>(total) / static_cast<double>(iterations);
+		r->minNs = readNs[0];
+		r->maxNs = readNs[iterations - 1];
+		r->latency = true;
+		r->p50 = Percentile(readNs, iterations, 50);
+		r->p99 = Percentile(readNs, iterations, 99);
+		r->p999 = Percentile(readNs, iterations, 99.9);
+		r->max = readNs[iterations - 1];
+		r->producerP50 = Percentile(producerNs, producerCount, 50);
+		r->producerP99 = Percentile(producerNs, producerCount, 99);
+		r->underruns = underruns;
+		fprintf(stderr, "%-24s %10.1f ns/op p99 %u ns, %lu underruns\n",
+			r->name, r->nsPerOp, r->p99, underruns);
+	}
+	free(readNs);
+	free(producerNs);
+	producerNs = NULL;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::HeaderSetStr(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		m->content_type_set("application/ssml+xml");
+	return NowNs() - start;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::HeaderGetStr(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	m->content_type_set("application/ssml+xml");
+	unsigned long sum = 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		sum += m->content_type_get()[i & 7];
+	apr_uint64_t elapsed = NowNs() - start;
+	sink += sum;
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::HeaderSetSimple(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		m->content_length_set(i);
+	return NowNs() - start;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::HeaderGetSimple(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	m->content_length_set(42);
+	unsigned long sum = 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		sum += m->content_length_get();
+	apr_uint64_t elapsed = NowNs() - start;
+	sink += sum;
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::HeaderSetSynth(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		m->voice_name_set("Jane");
+	return NowNs() - start;
+}
+
+
+/** @brief Two generic and two synthesizer headers rendered, removed first to render them again */
+apr_uint64_t UniMRCPBenchmark::MessageRender(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	m->content_type_set("application/ssml+xml");
+	m->content_length_set(120);
+	m->voice_name_set("Jane");
+	m->kill_on_barge_in_set(true);
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++) {
+		m->UniMRCPMessage::RemoveProperty(UW_HEADER_GENERIC_CONTENT_TYPE);
+		m->UniMRCPMessage::RemoveProperty(UW_HEADER_GENERIC_CONTENT_LENGTH);
+		m->RemoveProperty(UW_HEADER_SYNTHESIZER_VOICE_NAME);
+		m->RemoveProperty(UW_HEADER_SYNTHESIZER_KILL_ON_BARGE_IN);
+		m->RenderProperties();
+	}
+	return NowNs() - start;
+}
+
+
+/** @brief Messages get a few parameters, start over every 8 */
+apr_uint64_t UniMRCPBenchmark::VendorParamAppend(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++) {
+		if (!(i & 7))
+			m->UniMRCPMessage::hdr->vendor_specific_params = NULL;
+		m->VendorParamAppend("com.example.param", "value");
+	}
+	return NowNs() - start;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::VendorParamFind(unsigned long n)
+{
+	static char const* const names[8] = {
+		"com.example.a", "com.example.b", "com.example.c", "com.example.d",
+		"com.example.e", "com.example.f", "com.example.g", "com.example.h"
+	};
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	for (unsigned i = 0; i < 8; i++)
+		m->VendorParamAppend(names[i], "value");
+	unsigned long found = 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		found += m->VendorParamFind(names[i & 7]) != NULL;
+	apr_uint64_t elapsed = NowNs() - start;
+	sink += found;
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::VendorParamGet(unsigned long n)
+{
+	UniMRCPSynthesizerMessage* m = NewMessage();
+	for (unsigned i = 0; i < 8; i++)
+		m->VendorParamAppend("com.example.param", "value");
+	unsigned long sum = 0;
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++) {
+		unsigned idx = static_cast<unsigned>(i & 7);
+		sum += m->VendorParamGetName(idx)[0] + m->VendorParamGetValue(idx)[0] + m->VendorParamCount();
+	}
+	apr_uint64_t elapsed = NowNs() - start;
+	sink += sum;
+	return elapsed;
+}
+
+
+apr_uint64_t UniMRCPBenchmark::LogExtHandler(unsigned long n)
+{
+	apr_uint64_t start = NowNs();
+	for (unsigned long i = 0; i < n; i++)
+		LogExt(LOG_FORMAT, swig_target_platform, this, static_cast<int>(i & 3), stm);
+	return NowNs() - start;
+}
+
+
+/** @brief Queueing only, the queue is let drain between chunks */
+apr_uint64_t UniMRCPBenchmark::LogExtHandlerQueued(unsigned long n)
+{
+	apr_uint64_t elapsed = 0;
+	for (unsigned long i = 0; i < n; i += CHUNK) {
+		unsigned long chunk = n - i < CHUNK ? n - i : CHUNK;
+		apr_uint64_t start = NowNs();
+		for (unsigned long j = 0; j < chunk; j++)
+			LogExt(LOG_FORMAT, swig_target_platform, this, static_cast<int>(j & 3), stm);
+		elapsed += NowNs() - start;
+		UniMRCPLogStats stats;
+		do {
+			apr_sleep(1000);
+			UniMRCPClient::GetLogStats(stats);
+		} while (stats.queueDepth);
+	}
+	return elapsed;
+}
+
+
+void UniMRCPBenchmark::Run(char const* filter)
+{
+	static struct {
+		char const* name;
+		Body body;
+	} const benches[] = {
+		{"stm_read_frame", &UniMRCPBenchmark::StmReadFrame},
+		{"stm_write_frame", &UniMRCPBenchmark::StmWriteFrame},
+		{"rx_memory_read", &UniMRCPBenchmark::RxMemoryRead},
+		{"rx_buffered_add", &UniMRCPBenchmark::RxBufferedAdd},
+		{"rx_buffered_read", &UniMRCPBenchmark::RxBufferedRead},
+		{"rx_buffered_contended", NULL},
+		{"header_set_str", &UniMRCPBenchmark::HeaderSetStr},
+		{"header_get_str", &UniMRCPBenchmark::HeaderGetStr},
+		{"header_set_simple", &UniMRCPBenchmark::HeaderSetSimple},
+		{"header_get_simple", &UniMRCPBenchmark::HeaderGetSimple},
+		{"header_set_synth", &UniMRCPBenchmark::HeaderSetSynth},
+		{"message_render", &UniMRCPBenchmark::MessageRender},
+		{"vendor_param_append", &UniMRCPBenchmark::VendorParamAppend},
+		{"vendor_param_find", &UniMRCPBenchmark::VendorParamFind},
+		{"vendor_param_get", &UniMRCPBenchmark::VendorParamGet},
+		{"log_ext_handler", &UniMRCPBenchmark::LogExtHandler},
+		// Last, the queue cannot be stopped
+		{"log_ext_handler_queued", &UniMRCPBenchmark::LogExtHandlerQueued}
+	};
+	for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		if (filter && !strstr(benches[i].name, filter))
+			continue;
+		if (benches[i].body == &UniMRCPBenchmark::LogExtHandlerQueued)
+			UniMRCPClient::StartAsyncLogging(4096);
+		if (benches[i].body)
+			Measure(benches[i].name, benches[i].body);
+		else
+			RxBufferedContended();
+		CloseRx();
+	}
+	DeleteMessage();
+}
+
+
+/** @brief Print string as JSON */
+static void JsonString(FILE* f, char const* s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		unsigned char c = static_cast<unsigned char>(*s);
+		if ((c == '"') || (c == '\\'))
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+	fputc('"', f);
+}
+
+
+void UniMRCPBenchmark::Report(FILE* f, char const* label) const
+{
+	char stamp[32];
+	time_t now = time(NULL);
+	strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+	fprintf(f, "{\n  \"benchmark\": \"WrapperBench\",\n  \"label\": ");
+	JsonString(f, label ? label : "");
+	fprintf(f, ",\n  \"time\": \"%s\",\n"
+		"  \"wrapper\": \"%d.%d.%d\",\n  \"unimrcp\": \"%d.%d.%d\",\n  \"apr\": \"%d.%d.%d\",\n"
+		"  \"iterations\": %lu,\n  \"batches\": %u,\n  \"results\": [",
+		stamp, UW_MAJOR_VERSION, UW_MINOR_VERSION, UW_PATCH_VERSION,
+		UNI_MAJOR_VERSION, UNI_MINOR_VERSION, UNI_PATCH_VERSION,
+		APR_MAJOR_VERSION, APR_MINOR_VERSION, APR_PATCH_VERSION,
+		iterations, batches);
+	for (unsigned i = 0; i < resultCount; i++) {
+		BenchResult const* r = &results[i];
+		fprintf(f, "%s\n    {\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.2f, \"min_ns\": %.2f, \"max_ns\": %.2f",
+			i ? "," : "", r->name, r->iterations, r->nsPerOp, r->minNs, r->maxNs);
+		if (r->latency)
+			fprintf(f, ", \"p50_ns\": %u, \"p99_ns\": %u, \"p999_ns\": %u, \"max_latency_ns\": %u"
+				", \"producer_p50_ns\": %u, \"producer_p99_ns\": %u, \"underruns\": %lu",
+				r->p50, r->p99, r->p999, r->max, r->producerP50, r->producerP99, r->underruns);
+		fputc('}', f);
+	}
+	fprintf(f, "\n  ]\n}\n");
+}
+
+
+static void Usage(char const* prog)
+{
+	printf("Usage: %s [options]\n"
+		"\t-n n       Iterations per batch (200000)\n"
+		"\t-r n       Batches, the median is reported (5)\n"
+		"\t-f text    Run only benchmarks with the text in their name\n"
+		"\t-l label   Label of the results, e.g. commit ID\n"
+		"\t-o file    Write JSON to the file instead of standard output\n", prog);
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	unsigned long iterations = 200000;
+	unsigned batches = 5;
+	char const* filter = NULL;
+	char const* label = NULL;
+	char const* output = NULL;
+	for (int i = 1; i < argc; i++) {
+		char const* opt = argv[i];
+		if ((opt[0] != '-') || !opt[1] || opt[2] || (i + 1 >= argc)) {
+			Usage(argv[0]);
+			return 1;
+		}
+		char const* val = argv[++i];
+		switch (opt[1]) {
+		case 'n': iterations = strtoul(val, NULL, 10); break;
+		case 'r': batches = static_cast<unsigned>(strtoul(val, NULL, 10)); break;
+		case 'f': filter = val; break;
+		case 'l': label = val; break;
+		case 'o': output = val; break;
+		default:
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+	if (!iterations || !batches) {
+		Usage(argv[0]);
+		return 1;
+	}
+
+	int ret = 0;
+	try {
+		UniMRCPBenchmark bench(iterations, batches);
+		if (!bench.Init()) {
+			fprintf(stderr, "Cannot initialize the benchmark\n");
+			ret = 1;
+		} else {
+			bench.Run(filter);
+			FILE* f = output ? fopen(output, "w") : stdout;
+			if (f) {
+				bench.Report(f, label);
+				if (f != stdout)
+					fclose(f);
+			} else {
+				fprintf(stderr, "Cannot write %s\n", output);
+				ret = 1;
+			}
+		}
+	} catch (UniMRCPException const& ex) {
+		fprintf(stderr, "Benchmark failed: %s\n", ex.msg);
+		ret = 1;
+	}
+	UniMRCPClient::StaticDeinitialize();
+	return ret;
+}
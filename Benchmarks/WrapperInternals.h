@@ -0,0 +1,25 @@
+/*
+ * Wrapper internals for the benchmarks and tests, include instead of UniMRCP-wrapper.cpp.
+ *
+ * The classes of UniMRCP-wrapper.h are declared with all their members public,
+ * so that the public header needs no hooks for the programs driving the
+ * internals. UniMRCP-wrapper.cpp itself is compiled as it is.
+ */
+
+#ifndef WRAPPER_INTERNALS_H
+#define WRAPPER_INTERNALS_H
+
+/* Everything the header includes, before the access keywords are redefined */
+#include <cstddef>
+#include <cstdarg>
+
+#define UNIMRCP_WRAPPER_CPP
+#define private public
+#define protected public
+#include "UniMRCP-wrapper.h"
+#undef protected
+#undef private
+
+#include "UniMRCP-wrapper.cpp"
+
+#endif /* WRAPPER_INTERNALS_H */
@@ -0,0 +1,193 @@
+using System;
+using System.Diagnostics;
+
+/*
+ * Cost of the C# binding: runs the UniMRCPBindingBench scenarios with C#
+ * streams and channel and with their C++ counterparts and compares them.
+ * Needs the library built with BENCHMARK_BINDINGS=ON, no server is used.
+ * Python/BindingBench.py and Java/BindingBench.java run the same scenarios.
+ *
+ * Usage: BindingBench [iterations] [rounds]
+ */
+class BindingBench
+{
+    static readonly int FRAME_SIZE = UniMRCPBindingBench.FRAME_SIZE;
+
+    // Scenario returning ns per call
+    delegate double Run(UniMRCPBindingBench bench, uint n);
+
+    // Discards log messages
+    class BenchLogger : UniMRCPLogger
+    {
+        public override bool Log(string file, uint line, UniMRCPLogPriority priority, string message)
+        {
+            return true;
+        }
+    }
+
+
+    // Supplies a frame of silence if data, otherwise just returns
+    class BenchStreamRx : UniMRCPStreamRx
+    {
+        private byte[] buf;
+
+        public BenchStreamRx(bool data)
+        {
+            buf = data ? new byte[FRAME_SIZE] : null;
+        }
+
+        public override bool ReadFrame()
+        {
+            if (buf != null)
+                SetData(buf);
+            return true;
+        }
+    }
+
+
+    // Copies the frame out if data, otherwise just returns
+    class BenchStreamTx : UniMRCPStreamTx
+    {
+        private byte[] buf;
+
+        public BenchStreamTx(bool data)
+        {
+            buf = data ? new byte[FRAME_SIZE] : null;
+        }
+
+        public override bool WriteFrame()
+        {
+            if (buf != null)
+                GetData(buf);
+            return true;
+        }
+    }
+
+
+    // Counts SPEAK-COMPLETE events
+    class BenchChannel : UniMRCPBenchChannel
+    {
+        public ulong completed = 0;
+
+        public BenchChannel(UniMRCPBindingBench bench) :
+            base(bench)
+        { }
+
+        public override bool OnMessageReceive(UniMRCPSynthesizerMessage message)
+        {
+            if (message.GetEventID() == UniMRCPSynthesizerEvent.SYNTHESIZER_SPEAK_COMPLETE)
+                completed++;
+            return true;
+        }
+    }
+
+
+    static double ReadFrames(UniMRCPBindingBench bench, uint n, bool data)
+    {
+        using (BenchStreamRx stream = new BenchStreamRx(data))
+            return bench.ReadFrames(stream, n);
+    }
+
+    static double WriteFrames(UniMRCPBindingBench bench, uint n, bool data)
+    {
+        using (BenchStreamTx stream = new BenchStreamTx(data))
+            return bench.WriteFrames(stream, n);
+    }
+
+    static double ReceiveMessages(UniMRCPBindingBench bench, uint n)
+    {
+        using (BenchChannel chan = new BenchChannel(bench))
+            return bench.ReceiveMessages(chan, n);
+    }
+
+    // Same accesses as UniMRCPBindingBench::NativeAccessHeaders(), ns per access
+    static ulong total = 0;
+    static double AccessHeaders(UniMRCPBindingBench bench, uint n)
+    {
+        UniMRCPSynthesizerMessage msg = bench.GetMessage();
+        Stopwatch sw = Stopwatch.StartNew();
+        for (uint i = 0; i < n; i++)
+        {
+            msg.content_type = "application/ssml+xml";
+            msg.content_length = i;
+            msg.speech_language = "en-US";
+            total += msg.content_type[0] + msg.content_length + msg.speech_language[0];
+        }
+        sw.Stop();
+        return sw.Elapsed.TotalMilliseconds * 1e6 / ((double) n * 6);
+    }
+
+    // Median of the rounds after a warm-up
+    static double Measure(Run run, UniMRCPBindingBench bench, uint n, int rounds)
+    {
+        double[] results = new double[rounds];
+        run(bench, n / 10 + 1);
+        for (int i = 0; i < rounds; i++)
+            results[i] = run(bench, n);
+        Array.Sort(results);
+        return results[rounds / 2];
+    }
+
+
+    static void Main(string[] args)
+    {
+        uint iterations = args.Length > 0 ? UInt32.Parse(args[0]) : 100000;
+        int rounds = args.Length > 1 ? Int32.Parse(args[1]) : 5;
+        string[] names = {
+            "read_frame", "read_frame_set_data", "write_frame", "write_frame_get_data",
+            "header_access", "message_receive"
+        };
+        Run[] runs = {
+            delegate(UniMRCPBindingBench b, uint n) { return ReadFrames(b, n, false); },
+            delegate(UniMRCPBindingBench b, uint n) { return ReadFrames(b, n, true); },
+            delegate(UniMRCPBindingBench b, uint n) { return WriteFrames(b, n, false); },
+            delegate(UniMRCPBindingBench b, uint n) { return WriteFrames(b, n, true); },
+            AccessHeaders,
+            ReceiveMessages
+        };
+        Run[] natives = {
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeReadFrames(false, n); },
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeReadFrames(true, n); },
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeWriteFrames(false, n); },
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeWriteFrames(true, n); },
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeAccessHeaders(n); },
+            delegate(UniMRCPBindingBench b, uint n) { return b.NativeReceiveMessages(n); }
+        };
+
+        BenchLogger logger = new BenchLogger();
+        try
+        {
+            UniMRCPClient.StaticInitialize(logger, UniMRCPLogPriority.WARNING);
+        }
+        catch (ApplicationException ex)
+        {
+            Console.WriteLine("Unable to initialize platform: " + ex.Message);
+            Environment.Exit(1);
+        }
+
+        int err = 0;
+        UniMRCPBindingBench bench = null;
+        try
+        {
+            bench = new UniMRCPBindingBench();
+            Console.WriteLine("C# binding overhead, {0} iterations, median of {1} rounds", iterations, rounds);
+            Console.WriteLine("{0,-22} {1,12} {2,12} {3,12} {4,8}", "scenario", "ns/call", "calls/s", "C++ ns/call", "ratio");
+            for (int i = 0; i < names.Length; i++)
+            {
+                double ns = Measure(runs[i], bench, iterations, rounds);
+                double nativeNs = Measure(natives[i], bench, iterations, rounds);
+                Console.WriteLine("{0,-22} {1,12:F1} {2,12:F0} {3,12:F1} {4,7:F1}x", names[i], ns,
+                    ns > 0 ? 1e9 / ns : 0, nativeNs, nativeNs > 0 ? ns / nativeNs : 0);
+            }
+        }
+        catch (ApplicationException ex)
+        {
+            err = 1;
+            Console.WriteLine("An error occured: " + ex.Message);
+        }
+
+        if (bench != null) bench.Dispose();
+        UniMRCPClient.StaticDeinitialize();
+        Environment.Exit(err);
+    }
+}
@@ -204,10 +204,10 @@ public:
 		// Load grammar content from file
 		ifstream stm(grammarfile);
 		string content((std::istreambuf_iterator<char>(stm)), (std::istreambuf_iterator<char>()));
+		// Define the grammar in the session (only once) and reference it by URI
+		char const* uri = DefineGrammar("application/grammar+xml", content.c_str());
 		// Start processing here
-		UniMRCPRecognizerMessage* msg = CreateMessage(RECOGNIZER_RECOGNIZE);
-		msg->content_type_set("application/grammar+xml");
-		msg->SetBody(content.data(), content.length());
+		UniMRCPRecognizerMessage* msg = CreateRecognizeMessage(uri);
 		return msg->Send();
 	}
 
@@ -216,6 +216,11 @@ public:
 	{
 		// Analyze, update your application state and reply messages here
 		if (message->GetMsgType() == MRCP_MESSAGE_TYPE_RESPONSE) {
+			if (message->GetMethodID() == RECOGNIZER_DEFINE_GRAMMAR) {
+				if (message->GetStatusCode() != MRCP_STATUS_CODE_SUCCESS)
+					return Fail(cout << "DEFINE-GRAMMAR request failed: " << message->GetStatusCode());
+				return true;
+			}
 			if (message->GetStatusCode() != MRCP_STATUS_CODE_SUCCESS)
 				return Fail(cout << "RECOGNIZE request failed: " << message->GetStatusCode());
 			if (message->GetRequestState() != MRCP_REQUEST_STATE_INPROGRESS)
@@ -234,6 +239,11 @@ public:
 			char const* reason = message->completion_reason_get();
 			cout << "Recognition complete: " << message->completion_cause_get() << ' ' <<
 				(reason ? reason : "") << endl;
+			UniMRCPNLSMLInterpretation nbest[UW_NLSML_MAX_INTERPRETATIONS];
+			unsigned count = message->ParseNLSML(nbest, UW_NLSML_MAX_INTERPRETATIONS);
+			for (unsigned i = 0; i < count; i++)
+				cout << "  " << nbest[i].confidence << ' ' <<
+					string(nbest[i].input, nbest[i].input_len) << endl;
 			return true;
 		}
 		return Fail(cout << "Unknown message arrived");
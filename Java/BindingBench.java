@@ -0,0 +1,269 @@
+import java.util.Arrays;
+import org.unimrcp.swig.*;
+
+/*
+ * Cost of the Java binding: runs the UniMRCPBindingBench scenarios with Java
+ * streams and channel and with their C++ counterparts and compares them.
+ * Needs the library built with BENCHMARK_BINDINGS=ON, no server is used.
+ * Python/BindingBench.py and CSharp/BindingBench.cs run the same scenarios.
+ *
+ * Usage: BindingBench [iterations] [rounds]
+ */
+class BindingBench
+{
+    private static final int FRAME_SIZE = UniMRCPBindingBench.FRAME_SIZE;
+
+    // Load native library
+    static {
+        System.loadLibrary("UniMRCP");
+    }
+
+    // Discards log messages
+    private static class BenchLogger extends UniMRCPLogger
+    {
+        public boolean Log(String file, long line, UniMRCPLogPriority priority, String message)
+        {
+            return true;
+        }
+    }
+
+
+    // Supplies a frame of silence if data, otherwise just returns
+    private static class BenchStreamRx extends UniMRCPStreamRx
+    {
+        private byte[] buf;
+
+        public BenchStreamRx(boolean data)
+        {
+            buf = data ? new byte[FRAME_SIZE] : null;
+        }
+
+        public boolean ReadFrame()
+        {
+            if (buf != null)
+                SetData(buf);
+            return true;
+        }
+    }
+
+
+    // Copies the frame out if data, otherwise just returns
+    private static class BenchStreamTx extends UniMRCPStreamTx
+    {
+        private byte[] buf;
+
+        public BenchStreamTx(boolean data)
+        {
+            buf = data ? new byte[FRAME_SIZE] : null;
+        }
+
+        public boolean WriteFrame()
+        {
+            if (buf != null)
+                GetData(buf);
+            return true;
+        }
+    }
+
+
+    // Counts SPEAK-COMPLETE events
+    private static class BenchChannel extends UniMRCPBenchChannel
+    {
+        public long completed = 0;
+
+        public BenchChannel(UniMRCPBindingBench bench)
+        {
+            super(bench);
+        }
+
+        public boolean OnMessageReceive(UniMRCPSynthesizerMessage message)
+        {
+            if (message.GetEventID() == UniMRCPSynthesizerEvent.SYNTHESIZER_SPEAK_COMPLETE)
+                completed++;
+            return true;
+        }
+    }
+
+
+    // Scenario returning ns per call
+    private static abstract class Scenario
+    {
+        public final String name;
+
+        public Scenario(String name)
+        {
+            this.name = name;
+        }
+
+        public abstract double run(UniMRCPBindingBench bench, long n);
+        public abstract double runNative(UniMRCPBindingBench bench, long n);
+    }
+
+
+    private static abstract class StreamScenario extends Scenario
+    {
+        protected final boolean data;
+
+        public StreamScenario(String name, boolean data)
+        {
+            super(name);
+            this.data = data;
+        }
+    }
+
+
+    private static class ReadScenario extends StreamScenario
+    {
+        public ReadScenario(String name, boolean data)
+        {
+            super(name, data);
+        }
+
+        public double run(UniMRCPBindingBench bench, long n)
+        {
+            BenchStreamRx stream = new BenchStreamRx(data);
+            double ns = bench.ReadFrames(stream, n);
+            stream.delete();
+            return ns;
+        }
+
+        public double runNative(UniMRCPBindingBench bench, long n)
+        {
+            return bench.NativeReadFrames(data, n);
+        }
+    }
+
+
+    private static class WriteScenario extends StreamScenario
+    {
+        public WriteScenario(String name, boolean data)
+        {
+            super(name, data);
+        }
+
+        public double run(UniMRCPBindingBench bench, long n)
+        {
+            BenchStreamTx stream = new BenchStreamTx(data);
+            double ns = bench.WriteFrames(stream, n);
+            stream.delete();
+            return ns;
+        }
+
+        public double runNative(UniMRCPBindingBench bench, long n)
+        {
+            return bench.NativeWriteFrames(data, n);
+        }
+    }
+
+
+    // Same accesses as UniMRCPBindingBench::NativeAccessHeaders(), ns per access
+    private static class HeaderScenario extends Scenario
+    {
+        public long total = 0;
+
+        public HeaderScenario()
+        {
+            super("header_access");
+        }
+
+        public double run(UniMRCPBindingBench bench, long n)
+        {
+            UniMRCPSynthesizerMessage msg = bench.GetMessage();
+            long start = System.nanoTime();
+            for (long i = 0; i < n; i++) {
+                msg.setContent_type("application/ssml+xml");
+                msg.setContent_length(i);
+                msg.setSpeech_language("en-US");
+                total += msg.getContent_type().charAt(0) + msg.getContent_length() + msg.getSpeech_language().charAt(0);
+            }
+            return (double) (System.nanoTime() - start) / (n * 6);
+        }
+
+        public double runNative(UniMRCPBindingBench bench, long n)
+        {
+            return bench.NativeAccessHeaders(n);
+        }
+    }
+
+
+    private static class ReceiveScenario extends Scenario
+    {
+        public ReceiveScenario()
+        {
+            super("message_receive");
+        }
+
+        public double run(UniMRCPBindingBench bench, long n)
+        {
+            BenchChannel chan = new BenchChannel(bench);
+            double ns = bench.ReceiveMessages(chan, n);
+            chan.delete();
+            return ns;
+        }
+
+        public double runNative(UniMRCPBindingBench bench, long n)
+        {
+            return bench.NativeReceiveMessages(n);
+        }
+    }
+
+
+    // Median of the rounds after a warm-up
+    private static double measure(Scenario s, boolean nat, UniMRCPBindingBench bench, long n, int rounds)
+    {
+        double[] results = new double[rounds];
+        if (nat)
+            s.runNative(bench, n / 10 + 1);
+        else
+            s.run(bench, n / 10 + 1);
+        for (int i = 0; i < rounds; i++)
+            results[i] = nat ? s.runNative(bench, n) : s.run(bench, n);
+        Arrays.sort(results);
+        return results[rounds / 2];
+    }
+
+
+    public static void main(String[] args)
+    {
+        long iterations = args.length > 0 ? Long.parseLong(args[0]) : 100000;
+        int rounds = args.length > 1 ? Integer.parseInt(args[1]) : 5;
+        Scenario[] scenarios = {
+            new ReadScenario("read_frame", false),
+            new ReadScenario("read_frame_set_data", true),
+            new WriteScenario("write_frame", false),
+            new WriteScenario("write_frame_get_data", true),
+            new HeaderScenario(),
+            new ReceiveScenario()
+        };
+
+        BenchLogger logger = new BenchLogger();
+        try {
+            UniMRCPClient.StaticInitialize(logger, UniMRCPLogPriority.WARNING);
+        } catch (Exception ex) {
+            System.out.println("Unable to initialize platform: " + ex.getMessage());
+            System.exit(1);
+        }
+
+        int err = 0;
+        UniMRCPBindingBench bench = null;
+        try {
+            bench = new UniMRCPBindingBench();
+            System.out.println(String.format("Java binding overhead, %d iterations, median of %d rounds", iterations, rounds));
+            System.out.println(String.format("%-22s %12s %12s %12s %8s", "scenario", "ns/call", "calls/s", "C++ ns/call", "ratio"));
+            for (Scenario s : scenarios) {
+                double ns = measure(s, false, bench, iterations, rounds);
+                double nativeNs = measure(s, true, bench, iterations, rounds);
+                System.out.println(String.format("%-22s %12.1f %12.0f %12.1f %7.1fx", s.name, ns,
+                    ns > 0 ? 1e9 / ns : 0, nativeNs, nativeNs > 0 ? ns / nativeNs : 0));
+            }
+        } catch (Exception ex) {
+            err = 1;
+            System.out.println("An error occured: " + ex.getMessage());
+        }
+
+        if (bench != null)
+            bench.delete();
+        UniMRCPClient.StaticDeinitialize();
+        System.exit(err);
+    }
+}
@@ -0,0 +1,140 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Cost of the Python binding: runs the UniMRCPBindingBench scenarios with Python
+# streams and channel and with their C++ counterparts and compares them.
+# Needs the module built with BENCHMARK_BINDINGS=ON, no server is used.
+# Java/BindingBench.java and CSharp/BindingBench.cs run the same scenarios.
+#
+# Usage: BindingBench.py [iterations] [rounds]
+from __future__ import print_function
+import sys
+import timeit
+
+# Import UniMRCP symbols
+from UniMRCP import *
+
+try:
+    xrange
+except NameError:
+    xrange = range
+
+FRAME_SIZE = UniMRCPBindingBench.FRAME_SIZE
+
+
+# Discards log messages
+class BenchLogger(UniMRCPLogger):
+    def __init__(self):
+        super(BenchLogger, self).__init__()
+
+    def Log(self, file, line, prio, message):
+        return True
+
+
+# Supplies a frame of silence if data, otherwise just returns
+class BenchStreamRx(UniMRCPStreamRx):
+    def __init__(self, data):
+        super(BenchStreamRx, self).__init__()
+        self.buf = bytearray(FRAME_SIZE) if data else None
+
+    def ReadFrame(self):
+        if self.buf is not None:
+            self.SetData(self.buf)
+        return True
+
+
+# Copies the frame out if data, otherwise just returns
+class BenchStreamTx(UniMRCPStreamTx):
+    def __init__(self, data):
+        super(BenchStreamTx, self).__init__()
+        self.buf = bytearray(FRAME_SIZE) if data else None
+
+    def WriteFrame(self):
+        if self.buf is not None:
+            self.GetData(self.buf)
+        return True
+
+
+# Counts SPEAK-COMPLETE events
+class BenchChannel(UniMRCPBenchChannel):
+    def __init__(self, bench):
+        super(BenchChannel, self).__init__(bench)
+        self.completed = 0
+
+    def OnMessageReceive(self, message):
+        if message.GetEventID() == SYNTHESIZER_SPEAK_COMPLETE:
+            self.completed += 1
+        return True
+
+
+# Same accesses as UniMRCPBindingBench::NativeAccessHeaders(), ns per access
+def access_headers(bench, n):
+    msg = bench.GetMessage()
+    total = 0
+    start = timeit.default_timer()
+    for i in xrange(n):
+        msg.content_type = "application/ssml+xml"
+        msg.content_length = i
+        msg.speech_language = "en-US"
+        total += ord(msg.content_type[0]) + msg.content_length + ord(msg.speech_language[0])
+    return (timeit.default_timer() - start) * 1e9 / (n * 6)
+
+
+# Name, Python scenario, C++ scenario; each returns ns per call
+SCENARIOS = [
+    ("read_frame",
+        lambda b, n: b.ReadFrames(BenchStreamRx(False), n),
+        lambda b, n: b.NativeReadFrames(False, n)),
+    ("read_frame_set_data",
+        lambda b, n: b.ReadFrames(BenchStreamRx(True), n),
+        lambda b, n: b.NativeReadFrames(True, n)),
+    ("write_frame",
+        lambda b, n: b.WriteFrames(BenchStreamTx(False), n),
+        lambda b, n: b.NativeWriteFrames(False, n)),
+    ("write_frame_get_data",
+        lambda b, n: b.WriteFrames(BenchStreamTx(True), n),
+        lambda b, n: b.NativeWriteFrames(True, n)),
+    ("header_access",
+        access_headers,
+        lambda b, n: b.NativeAccessHeaders(n)),
+    ("message_receive",
+        lambda b, n: b.ReceiveMessages(BenchChannel(b), n),
+        lambda b, n: b.NativeReceiveMessages(n)),
+]
+
+
+# Median of the rounds after a warm-up
+def measure(bench, run, n, rounds):
+    run(bench, n // 10 + 1)
+    results = sorted(run(bench, n) for _ in xrange(rounds))
+    return results[len(results) // 2]
+
+
+iterations = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+rounds = int(sys.argv[2]) if len(sys.argv) > 2 else 5
+
+logger = BenchLogger()
+try:
+    UniMRCPClient.StaticInitialize(logger, APT_PRIO_WARNING)
+except RuntimeError as ex:
+    print("Unable to initialize platform:", ex)
+    sys.exit(1)
+
+err = 0
+bench = None
+try:
+    bench = UniMRCPBindingBench()
+    print("Python binding overhead, %d iterations, median of %d rounds" % (iterations, rounds))
+    print("%-22s %12s %12s %12s %8s" % ("scenario", "ns/call", "calls/s", "C++ ns/call", "ratio"))
+    for name, run, native in SCENARIOS:
+        ns = measure(bench, run, iterations, rounds)
+        native_ns = measure(bench, native, iterations, rounds)
+        print("%-22s %12.1f %12.0f %12.1f %7.1fx" % (name, ns, 1e9 / ns if ns else 0,
+            native_ns, ns / native_ns if native_ns else 0))
+except RuntimeError as ex:
+    err = 1
+    print("An error occured:", ex)
+
+bench = None
+UniMRCPClient.StaticDeinitialize()
+sys.exit(err)
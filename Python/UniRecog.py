@@ -114,16 +114,20 @@ class UniRecogChannel(UniMRCPRecognizerChannel):
             return self.Fail("Failed to add channel: %d" % status)
         # Load grammar content from file
         content = open(grammarfile, "rb").read()
+        # Define the grammar in the session (only once) and reference it by URI
+        uri = self.DefineGrammar("application/grammar+xml", content)
         # Start processing here
-        msg = self.CreateMessage(RECOGNIZER_RECOGNIZE)
-        msg.content_type = "application/grammar+xml"
-        msg.SetBody(content)
+        msg = self.CreateRecognizeMessage(uri)
         return msg.Send()
 
     # Response or event from the server arrived
     def OnMessageReceive(self, message):
         # Analyze message, update your application state and reply messages here
         if message.GetMsgType() == MRCP_MESSAGE_TYPE_RESPONSE:
+            if message.GetMethodID() == RECOGNIZER_DEFINE_GRAMMAR:
+                if message.GetStatusCode() != MRCP_STATUS_CODE_SUCCESS:
+                    return self.Fail("DEFINE-GRAMMAR request failed: %d" % message.GetStatusCode())
+                return True
             if message.GetStatusCode() != MRCP_STATUS_CODE_SUCCESS:
                 return self.Fail("RECOGNIZE request failed: %d" % message.GetStatusCode())
             if message.GetRequestState() != MRCP_REQUEST_STATE_INPROGRESS:
@@ -138,6 +142,10 @@ class UniRecogChannel(UniMRCPRecognizerChannel):
             return True
         if message.GetEventID() == RECOGNIZER_RECOGNITION_COMPLETE:
             print "Recognition complete:", message.completion_cause, message.completion_reason
+            result = UniMRCPNLSMLResult()
+            if message.ParseNLSML(result):
+                for i in range(result.Count()):
+                    print "  ", result.Confidence(i), result.Input(i)
             self.sem.release()
             return True  # Does not actually matter
         return self.Fail("Unknown message received")
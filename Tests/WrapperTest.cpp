@@ -0,0 +1,1457 @@
+/*
+ * Behavioural tests of the wrapper internals.
+ *
+ * Includes UniMRCP-wrapper.cpp through Benchmarks/WrapperInternals.h to reach
+ * the internals like Benchmarks/WrapperBench.cpp does. No server is needed,
+ * the clients use TEST_CONFIG below with profiles of closed local ports, so
+ * that channels get created but never added. Every test is registered with CTest under its name.
+ *
+ * Usage: WrapperTest [test ...], all tests if none named. Exits with the number
+ * of failed tests.
+ */
+
+#include "Benchmarks/WrapperInternals.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <stdlib.h>
+#endif
+
+/** @brief Client configuration, MRCPv1 profiles "down-1" and "down-2" of nothing listening */
+static char const TEST_CONFIG[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+	"<unimrcpclient version=\"1.0\">"
+	"<properties><ip>127.0.0.1</ip></properties>"
+	"<components>"
+	"<resource-factory>"
+	"<resource id=\"speechsynth\" enable=\"true\"/>"
+	"<resource id=\"speechrecog\" enable=\"true\"/>"
+	"</resource-factory>"
+	"<rtsp-uac id=\"RTSP-Agent-1\" type=\"UniRTSP\">"
+	"<max-connection-count>10</max-connection-count>"
+	"<sdp-origin>WrapperTest</sdp-origin>"
+	"</rtsp-uac>"
+	"<media-engine id=\"Media-Engine-1\"><realtime-rate>1</realtime-rate></media-engine>"
+	"<rtp-factory id=\"RTP-Factory-1\"><rtp-port-min>43000</rtp-port-min><rtp-port-max>43100</rtp-port-max></rtp-factory>"
+	"</components>"
+	"<settings>"
+	"<rtp-settings id=\"RTP-Settings-1\"><ptime>20</ptime><codecs>PCMU PCMA L16/96/8000</codecs></rtp-settings>"
+	"<rtsp-settings id=\"RTSP-Down-1\"><server-ip>127.0.0.1</server-ip><server-port>1</server-port>"
+	"<resource-location>media</resource-location><resource-map>"
+	"<param name=\"speechsynth\" value=\"speechsynthesizer\"/><param name=\"speechrecog\" value=\"speechrecognizer\"/>"
+	"</resource-map></rtsp-settings>"
+	"<rtsp-settings id=\"RTSP-Down-2\"><server-ip>127.0.0.1</server-ip><server-port>2</server-port>"
+	"<resource-location>media</resource-location><resource-map>"
+	"<param name=\"speechsynth\" value=\"speechsynthesizer\"/><param name=\"speechrecog\" value=\"speechrecognizer\"/>"
+	"</resource-map></rtsp-settings>"
+	"</settings>"
+	"<profiles>"
+	"<mrcpv1-profile id=\"down-1\"><rtsp-uac>RTSP-Agent-1</rtsp-uac><media-engine>Media-Engine-1</media-engine>"
+	"<rtp-factory>RTP-Factory-1</rtp-factory><rtsp-settings>RTSP-Down-1</rtsp-settings><rtp-settings>RTP-Settings-1</rtp-settings>"
+	"</mrcpv1-profile>"
+	"<mrcpv1-profile id=\"down-2\"><rtsp-uac>RTSP-Agent-1</rtsp-uac><media-engine>Media-Engine-1</media-engine>"
+	"<rtp-factory>RTP-Factory-1</rtp-factory><rtsp-settings>RTSP-Down-2</rtsp-settings><rtp-settings>RTP-Settings-1</rtp-settings>"
+	"</mrcpv1-profile>"
+	"</profiles>"
+	"</unimrcpclient>";
+
+/** @brief Fail the running test unless cond holds */
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			UniMRCPTest::Fail(__LINE__, #cond); \
+			return; \
+		} \
+	} while (0)
+
+
+/** @brief Keeps the output of the tests readable */
+class QuietLogger : public UniMRCPLogger {
+public:
+	virtual bool Log(char const* file, unsigned line, UniMRCPLogPriority priority, char const* message)
+	{
+		(void) file;
+		(void) line;
+		if (priority <= UW_APT_PRIO_WARNING)
+			fprintf(stderr, "  log: %s\n", message);
+		return true;
+	}
+};
+
+
+/** @brief Keeps the last message logged by the tests themselves, the stack threads may log meanwhile */
+class CapturingLogger : public UniMRCPLogger {
+public:
+	CapturingLogger() :
+		line(0),
+		priority(UW_APT_PRIO_EMERGENCY),
+		count(0)
+	{
+		file[0] = message[0] = 0;
+	}
+
+	virtual bool Log(char const* _file, unsigned _line, UniMRCPLogPriority _priority, char const* _message)
+	{
+		if (strcmp(_file, __FILE__))
+			return true;
+		apr_cpystrn(file, _file, sizeof(file));
+		line = _line;
+		priority = _priority;
+		apr_cpystrn(message, _message, sizeof(message));
+		count++;
+		return true;
+	}
+
+	char               file[256];
+	unsigned           line;
+	UniMRCPLogPriority priority;
+	char               message[256];
+	unsigned           count;
+};
+
+
+/** @brief Holds the logging thread in the first message of the tests until released */
+class BlockingLogger : public UniMRCPLogger {
+public:
+	BlockingLogger() :
+		held(0),
+		released(0),
+		count(0),
+		longest(0),
+		reports(0)
+	{
+	}
+
+	virtual bool Log(char const* file, unsigned line, UniMRCPLogPriority priority, char const* message)
+	{
+		(void) line;
+		(void) priority;
+		if (strstr(message, "logging queue full"))
+			reports++;
+		if (strcmp(file, __FILE__))
+			return true;
+		apr_atomic_set32(&held, 1);
+		apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+		while (!apr_atomic_read32(&released) && (apr_time_now() < deadline))
+			apr_sleep(apr_time_from_msec(5));
+		count++;
+		if (strlen(message) > longest)
+			longest = strlen(message);
+		return true;
+	}
+
+	/** @brief Wait until the logging thread is held */
+	bool WaitHeld()
+	{
+		apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+		while (!apr_atomic_read32(&held) && (apr_time_now() < deadline))
+			apr_sleep(apr_time_from_msec(5));
+		return apr_atomic_read32(&held) != 0;
+	}
+
+	volatile apr_uint32_t held;
+	volatile apr_uint32_t released;
+	unsigned              count;
+	size_t                longest;
+	unsigned              reports;
+};
+
+
+/** @brief Streams are never opened, the channels are not added */
+class TestTermination : public UniMRCPAudioTermination {
+public:
+	TestTermination(UniMRCPClientSession* session) :
+		UniMRCPAudioTermination(session)
+	{
+		AddCapability("LPCM", SAMPLE_RATE_8000);
+	}
+
+	virtual UniMRCPStreamRx* OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return NULL;
+	}
+
+	virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return NULL;
+	}
+};
+
+
+/** @brief Opens the streams given, as if the media engine did */
+class StreamTermination : public TestTermination {
+public:
+	StreamTermination(UniMRCPClientSession* session) :
+		TestTermination(session),
+		rx(NULL),
+		tx(NULL)
+	{
+	}
+
+	virtual UniMRCPStreamRx* OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return rx;
+	}
+
+	virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq)
+	{
+		(void) enabled; (void) payload_type; (void) name; (void) format; (void) channels; (void) freq;
+		return tx;
+	}
+
+	UniMRCPStreamRx* rx;
+	UniMRCPStreamTx* tx;
+};
+
+
+/** @brief Records the outcome of the channel add */
+class AddedChannel : public UniMRCPRecognizerChannel {
+public:
+	AddedChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) :
+		UniMRCPRecognizerChannel(session, termination),
+		added(0),
+		status(UW_MRCP_SIG_STATUS_CODE_SUCCESS)
+	{
+	}
+
+	virtual bool OnAdd(UniMRCPSigStatusCode _status)
+	{
+		status = _status;
+		apr_atomic_inc32(&added);
+		return true;
+	}
+
+	volatile apr_uint32_t added;
+	UniMRCPSigStatusCode  status;
+};
+
+
+/** @brief Holds the client task in OnAdd() until released, so that the stack cannot answer meanwhile */
+class StalledChannel : public UniMRCPRecognizerChannel {
+public:
+	StalledChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) :
+		UniMRCPRecognizerChannel(session, termination),
+		stalled(0),
+		released(0),
+		timeouts(0)
+	{
+	}
+
+	virtual bool OnAdd(UniMRCPSigStatusCode status)
+	{
+		(void) status;
+		apr_atomic_set32(&stalled, 1);
+		apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+		while (!apr_atomic_read32(&released) && (apr_time_now() < deadline))
+			apr_sleep(apr_time_from_msec(5));
+		return true;
+	}
+
+	virtual UniMRCPTimeoutAction OnRequestTimeout(UniMRCPRequest* request)
+	{
+		(void) request;
+		apr_atomic_inc32(&timeouts);
+		return UW_TIMEOUT_NONE;
+	}
+
+	/** @brief Wait until the client task is held */
+	bool WaitStalled()
+	{
+		apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+		while (!apr_atomic_read32(&stalled) && (apr_time_now() < deadline))
+			apr_sleep(apr_time_from_msec(5));
+		return apr_atomic_read32(&stalled) != 0;
+	}
+
+	volatile apr_uint32_t stalled;
+	volatile apr_uint32_t released;
+	volatile apr_uint32_t timeouts;
+};
+
+
+/** @brief Counts its completions */
+class CountedRequest : public UniMRCPRecognizerRequest {
+public:
+	CountedRequest() :
+		completed(0)
+	{
+	}
+
+	virtual void OnComplete()
+	{
+		apr_atomic_inc32(&completed);
+	}
+
+	volatile apr_uint32_t completed;
+};
+
+
+/** @brief Sessions are warmed by the tests, the pool's own refills fail at once */
+class TestSessionPool : public UniMRCPSessionPool {
+public:
+	TestSessionPool(UniMRCPClient* client, unsigned size, unsigned long idle_timeout_ms) :
+		UniMRCPSessionPool(client, "down-1", size, idle_timeout_ms)
+	{
+	}
+
+	virtual UniMRCPClientSession* CreateSession(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException)
+	{
+		(void) client;
+		(void) profile;
+		return NULL;
+	}
+
+	virtual UniMRCPClientChannel* CreateChannel(UniMRCPClientSession* session) THROWS(UniMRCPException)
+	{
+		(void) session;
+		return NULL;
+	}
+};
+
+
+/** @brief Fails to create the second session, records the reports */
+class TestSessionBatch : public UniMRCPSessionBatch {
+public:
+	TestSessionBatch(UniMRCPClient* client) :
+		UniMRCPSessionBatch(client, "down-1"),
+		created(0),
+		setups(0),
+		succeeded(0),
+		failed(0),
+		terminations(0),
+		terminated(0)
+	{
+		memset(terms, 0, sizeof(terms));
+	}
+
+	virtual UniMRCPClientSession* CreateSession(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException)
+	{
+		if (created++ == 1)
+			return NULL;
+		return UniMRCPSessionBatch::CreateSession(client, profile);
+	}
+
+	virtual UniMRCPClientChannel* CreateChannel(UniMRCPClientSession* session) THROWS(UniMRCPException)
+	{
+		TestTermination* term = new TestTermination(session);
+		terms[created - 1] = term;
+		return new UniMRCPRecognizerChannel(session, term);
+	}
+
+	virtual void OnSetupComplete(unsigned _succeeded, unsigned _failed)
+	{
+		succeeded = _succeeded;
+		failed = _failed;
+		apr_atomic_inc32(&setups);
+	}
+
+	virtual void OnTerminateComplete(unsigned _terminated)
+	{
+		terminated = _terminated;
+		apr_atomic_inc32(&terminations);
+	}
+
+	/** @brief Wait until the callback counted by calls was called */
+	static bool Wait(volatile apr_uint32_t& calls)
+	{
+		apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+		while (!apr_atomic_read32(&calls) && (apr_time_now() < deadline))
+			apr_sleep(apr_time_from_msec(10));
+		return apr_atomic_read32(&calls) != 0;
+	}
+
+	unsigned              created;
+	TestTermination*      terms[4];
+	volatile apr_uint32_t setups;
+	unsigned              succeeded;
+	unsigned              failed;
+	volatile apr_uint32_t terminations;
+	unsigned              terminated;
+};
+
+
+class UniMRCPTest {
+public:
+	typedef void (*Body)();
+
+	struct Case {
+		char const* name;
+		Body        body;
+	};
+
+	static Case const cases[];
+	static bool failed;
+
+	static void Fail(unsigned line, char const* what)
+	{
+		fprintf(stderr, "  line %u: CHECK(%s) failed\n", line, what);
+		failed = true;
+	}
+
+	/* Timer wheel */
+	static void TimerIdle();
+	static void TimerOverlong();
+	static void TimerStop();
+	/* Latency histograms */
+	static void LatencyMatched();
+	/* Metrics */
+	static void MetricsGauges();
+	static void MetricsCounters();
+	/* Asynchronous requests */
+	static void AsyncTimeout();
+	static void AsyncCorrelation();
+	/* Profile groups */
+	static void GroupFailover();
+	/* Client pools */
+	static void PoolHash();
+	static void PoolBalance();
+	static void PoolPinned();
+	/* Session pools */
+	static void SessionPoolCheckout();
+	static void SessionPoolIdle();
+	/* Session batches */
+	static void SessionBatch();
+	/* Admission */
+	static void AdmissionLimits();
+	/* Drain */
+	static void DrainCounting();
+	static void DrainIdle();
+	/* Grammars */
+	static void GrammarDefine();
+	/* NLSML */
+	static void NlsmlParse();
+	/* Logging */
+	static void LogPriorityChange();
+	static void LogSampling();
+	static void LogQueue();
+	/* Trace log */
+	static void TraceRing();
+
+private:
+	/** @brief Records when a timer fired */
+	struct Stamp {
+		UniMRCPTimer          timer;
+		volatile apr_uint32_t fired;
+		apr_time_t            at;
+	};
+
+	static void Fired(UniMRCPTimer* timer);
+	static void QueueLog(UniMRCPLogQueue* q, char const* format, ...);
+	static bool WaitFired(Stamp& s, unsigned long timeout_ms);
+	static UniMRCPClientSession* Warm(UniMRCPSessionPool& pool, TestTermination*& term);
+};
+
+
+bool UniMRCPTest::failed = false;
+
+
+void UniMRCPTest::Fired(UniMRCPTimer* timer)
+{
+	Stamp* s = static_cast<Stamp*>(timer->obj);
+	s->at = apr_time_now();
+	apr_atomic_set32(&s->fired, 1);
+}
+
+
+void UniMRCPTest::QueueLog(UniMRCPLogQueue* q, char const* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	q->Push(__FILE__, __LINE__, UW_APT_PRIO_NOTICE, format, ap);
+	va_end(ap);
+}
+
+
+bool UniMRCPTest::WaitFired(Stamp& s, unsigned long timeout_ms)
+{
+	apr_time_t deadline = apr_time_now() + apr_time_from_msec(timeout_ms);
+	while (!apr_atomic_read32(&s.fired) && (apr_time_now() < deadline))
+		apr_sleep(apr_time_from_msec(1));
+	return apr_atomic_read32(&s.fired) != 0;
+}
+
+
+/** @brief Put a session into the pool as if its channel was added, it is not */
+UniMRCPClientSession* UniMRCPTest::Warm(UniMRCPSessionPool& pool, TestTermination*& term)
+{
+	UniMRCPClientSession* sess = new UniMRCPClientSession(pool.client, pool.profile);
+	term = new TestTermination(sess);
+	AddedChannel* chan = new AddedChannel(sess, term);
+	/* The failed add is reported to the channel, the session is not pooled yet */
+	apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+	while (!apr_atomic_read32(&chan->added) && (apr_time_now() < deadline))
+		apr_sleep(apr_time_from_msec(10));
+	UniMRCPPooledSession* e = new UniMRCPPooledSession;
+	memset(e, 0, sizeof(*e));
+	e->pool = &pool;
+	e->sess = sess;
+	e->chan = chan;
+	e->state = POOLED_WARMING;
+	e->healthy = 1;
+	e->created = apr_time_now();
+	e->timer.callback = UniMRCPSessionPool::IdleTimeout;
+	e->timer.obj = e;
+	sess->owner.pooled = e;
+	apr_thread_mutex_lock(pool.mutex);
+	pool.stats.warming++;
+	apr_thread_mutex_unlock(pool.mutex);
+	pool.Warmed(e, true);
+	return sess;
+}
+
+
+/** @brief A timer added after the wheel was idle for a while must not fire early */
+void UniMRCPTest::TimerIdle()
+{
+	UniMRCPTimerWheel* w = new UniMRCPTimerWheel();
+	Stamp a, b;
+	memset(&a, 0, sizeof(a));
+	memset(&b, 0, sizeof(b));
+	a.timer.callback = b.timer.callback = Fired;
+	a.timer.obj = &a;
+	b.timer.obj = &b;
+	w->Add(&a.timer, 20);
+	bool firstFired = WaitFired(a, 1000);
+	/* Many ticks the idle wheel does not turn */
+	apr_sleep(apr_time_from_msec(300));
+	apr_time_t added = apr_time_now();
+	w->Add(&b.timer, 200);
+	bool secondFired = WaitFired(b, 2000);
+	w->Release();
+	CHECK(firstFired);
+	CHECK(secondFired);
+	CHECK(b.at - added >= apr_time_from_msec(200));
+	CHECK(b.at - added < apr_time_from_msec(200 + 20 * UW_TIMER_TICK_MS));
+}
+
+
+/** @brief Beyond the top level range the timer waits in its farthest slot and expires on time */
+void UniMRCPTest::TimerOverlong()
+{
+	UniMRCPTimerWheel* w = new UniMRCPTimerWheel();
+	apr_uint64_t range = APR_UINT64_C(1) << (UniMRCPTimerWheel::LEVEL_BITS * UniMRCPTimerWheel::LEVELS);
+	UniMRCPTimer t;
+	memset(&t, 0, sizeof(t));
+	/* Turned by hand, the thread is not started without Add() */
+	w->now = 12345;
+	t.expires = w->now + range + range / 2 + 7;
+	w->Place(&t);
+	apr_uint64_t firedAt = 0;
+	while (w->now < t.expires + 1) {
+		w->Tick();
+		if (w->expired) {
+			firedAt = w->now;
+			break;
+		}
+	}
+	if (t.pprev)
+		w->Unlink(&t);
+	w->Release();
+	CHECK(firedAt == t.expires);
+}
+
+
+/** @brief A stopped wheel detaches its timers, cancelling them later is harmless */
+void UniMRCPTest::TimerStop()
+{
+	UniMRCPTimerWheel* w = new UniMRCPTimerWheel();
+	Stamp a;
+	memset(&a, 0, sizeof(a));
+	a.timer.callback = Fired;
+	a.timer.obj = &a;
+	w->Add(&a.timer, 10000);
+	w->Retain();
+	w->Stop();
+	bool detached = !a.timer.wheel && !a.timer.pprev && !w->count;
+	bool rejected = false;
+	try {
+		w->Add(&a.timer, 10);
+	} catch (UniMRCPException const&) {
+		rejected = true;
+	}
+	w->Release();
+	/* Still referenced as a session would */
+	w->Cancel(&a.timer);
+	w->Release();
+	CHECK(detached);
+	CHECK(rejected);
+	CHECK(!apr_atomic_read32(&a.fired));
+}
+
+
+/** @brief The request ID assigned after sending is picked up from the first response */
+void UniMRCPTest::LatencyMatched()
+{
+	UniMRCPLatencyStats response, complete, event;
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	UniMRCPRecognizerChannel chan(&sess, &term);
+	mrcp_message_t* req = mrcp_application_message_create(chan.sess, chan.chan, RECOGNIZER_RECOGNIZE);
+	CHECK(req);
+	UniMRCPClient::ResetLatency();
+	/* Not known when sending */
+	req->start_line.request_id = 0;
+	chan.LatencySent(req);
+	/* Assigned by the client task */
+	req->start_line.request_id = 7;
+	mrcp_message_t* resp = mrcp_response_create(req, req->pool);
+	resp->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+	chan.LatencyReceived(resp);
+	mrcp_message_t* evt = mrcp_event_create(req, RECOGNIZER_RECOGNITION_COMPLETE, req->pool);
+	evt->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	chan.LatencyReceived(evt);
+	UniMRCPClient::GetLatency(UW_LATENCY_RESPONSE, MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE, response);
+	UniMRCPClient::GetLatency(UW_LATENCY_COMPLETE, MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE, complete);
+	UniMRCPClient::GetLatency(UW_LATENCY_EVENT, MRCP_RECOGNIZER, RECOGNIZER_RECOGNITION_COMPLETE, event);
+	CHECK(response.count == 1);
+	CHECK(complete.count == 1);
+	CHECK(event.count == 1);
+	/* The slot is free again */
+	for (unsigned i = 0; i < UW_LATENCY_SLOTS; i++)
+		CHECK(!chan.inflight[i].msg);
+}
+
+
+/** @brief Gauges follow the live objects, streams deleted while open included */
+void UniMRCPTest::MetricsGauges()
+{
+	UniMRCPMetricsSnapshot before, live, deleted, after;
+	UniMRCPClient::GetMetrics(before);
+	bool opened;
+	{
+		/* Outlives the termination, which detaches from it */
+		mpf_audio_stream_t stm;
+		memset(&stm, 0, sizeof(stm));
+		UniMRCPClient client(TEST_CONFIG);
+		UniMRCPClientSession sess(&client, "down-1");
+		StreamTermination term(&sess);
+		UniMRCPRecognizerChannel chan(&sess, &term);
+		stm.obj = &term;
+		term.rx = new UniMRCPStreamRx();
+		term.tx = new UniMRCPStreamTx();
+		opened = UniMRCPAudioTermination::StmOpenRx(&stm, NULL) && UniMRCPAudioTermination::StmOpenTx(&stm, NULL);
+		UniMRCPClient::GetMetrics(live);
+		/* The application may delete them before the media engine closes them */
+		delete term.rx;
+		delete term.tx;
+		UniMRCPClient::GetMetrics(deleted);
+	}
+	UniMRCPClient::GetMetrics(after);
+	CHECK(opened);
+	CHECK(live.Get(UW_METRIC_CLIENTS) == before.Get(UW_METRIC_CLIENTS) + 1);
+	CHECK(live.Get(UW_METRIC_SESSIONS) == before.Get(UW_METRIC_SESSIONS) + 1);
+	CHECK(live.Get(UW_METRIC_CHANNELS) == before.Get(UW_METRIC_CHANNELS) + 1);
+	CHECK(live.Get(UW_METRIC_STREAMS) == before.Get(UW_METRIC_STREAMS) + 2);
+	CHECK(deleted.Get(UW_METRIC_STREAMS) == before.Get(UW_METRIC_STREAMS));
+	CHECK(after.Get(UW_METRIC_CLIENTS) == before.Get(UW_METRIC_CLIENTS));
+	CHECK(after.Get(UW_METRIC_CHANNELS) == before.Get(UW_METRIC_CHANNELS));
+	CHECK(after.Get(UW_METRIC_STREAMS) == before.Get(UW_METRIC_STREAMS));
+}
+
+
+/** @brief Messages are counted by resource and method, counters keep growing past 32 bits */
+void UniMRCPTest::MetricsCounters()
+{
+	UniMRCPMetricsSnapshot before, received, half, wrapped;
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	UniMRCPRecognizerChannel chan(&sess, &term);
+	mrcp_message_t* req = mrcp_application_message_create(chan.sess, chan.chan, RECOGNIZER_RECOGNIZE);
+	CHECK(req);
+	mrcp_message_t* resp = mrcp_response_create(req, req->pool);
+	resp->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	UniMRCPClient::GetMetrics(before);
+	UniMRCPClientChannel::AppOnMessageReceive(client.app, chan.sess, chan.chan, resp);
+	UniMRCPClient::GetMetrics(received);
+	/* Twice half the range wraps the 32-bit cell */
+	MetricAdd(UW_METRIC_MESSAGES_SENT, 0x80000000u);
+	UniMRCPClient::GetMetrics(half);
+	MetricAdd(UW_METRIC_MESSAGES_SENT, 0x80000000u);
+	MetricInc(UW_METRIC_MESSAGES_SENT);
+	UniMRCPClient::GetMetrics(wrapped);
+	CHECK(received.Get(UW_METRIC_MESSAGES_RECEIVED) == before.Get(UW_METRIC_MESSAGES_RECEIVED) + 1);
+	CHECK(received.GetResponses(MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE) ==
+		before.GetResponses(MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE) + 1);
+	CHECK(received.GetEvents(MRCP_RECOGNIZER, RECOGNIZER_RECOGNITION_COMPLETE) ==
+		before.GetEvents(MRCP_RECOGNIZER, RECOGNIZER_RECOGNITION_COMPLETE));
+	CHECK(wrapped.Get(UW_METRIC_MESSAGES_SENT) == received.Get(UW_METRIC_MESSAGES_SENT) + APR_UINT64_C(0x100000001));
+}
+
+
+/** @brief A request past its deadline completes once as timed out, one the stack answers completes once too */
+void UniMRCPTest::AsyncTimeout()
+{
+	/* Outlive the channel, which fails what is still tracked */
+	CountedRequest late, answered;
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	StalledChannel chan(&sess, &term);
+	chan.SendAsync(chan.CreateMessage(RECOGNIZER_RECOGNIZE), &late, 50);
+	bool lateDone = late.Wait(5000);
+	UniMRCPAsyncState lateState = late.GetState();
+	apr_atomic_set32(&chan.released, 1);
+	/* Completed by the response of the stack, or else by the deadline */
+	chan.SendAsync(chan.CreateMessage(RECOGNIZER_RECOGNIZE), &answered, 3000);
+	bool answeredDone = answered.Wait(10000);
+	/* Give a wrong second completion the chance to arrive */
+	apr_sleep(apr_time_from_msec(200));
+	CHECK(lateDone);
+	CHECK(lateState == UW_ASYNC_TIMED_OUT);
+	CHECK(apr_atomic_read32(&late.completed) == 1);
+	CHECK(answeredDone);
+	CHECK(apr_atomic_read32(&answered.completed) == 1);
+	CHECK(apr_atomic_read32(&chan.timeouts) == 1u + (answered.GetState() == UW_ASYNC_TIMED_OUT));
+}
+
+
+/** @brief The first response is matched by the ID the stack assigned, handles of the channel are reused */
+void UniMRCPTest::AsyncCorrelation()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	StalledChannel chan(&sess, &term);
+	bool stalled = chan.WaitStalled();
+	UniMRCPRecognizerMessage* msg = chan.CreateMessage(RECOGNIZER_RECOGNIZE);
+	UniMRCPRecognizerRequest* req = chan.SendAsync(msg);
+	/* Answered as the held client task would, it assigns the ID to the very message sent */
+	mrcp_message_t* sent = msg->msg;
+	sent->start_line.request_id = 5;
+	mrcp_message_t* resp = mrcp_response_create(sent, sent->pool);
+	resp->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+	chan.OnMsgReceive(resp);
+	UniMRCPAsyncState progress = req->GetState();
+	UniMRCPRequestId id = req->GetRequestId();
+	bool responded = req->GetResponse() != NULL;
+	mrcp_message_t* evt = mrcp_event_create(sent, RECOGNIZER_RECOGNITION_COMPLETE, sent->pool);
+	evt->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	chan.OnMsgReceive(evt);
+	UniMRCPAsyncState done = req->GetState();
+	bool completed = req->GetEvent() != NULL;
+	UniMRCPRecognizerRequest* next = chan.SendAsync(chan.CreateMessage(RECOGNIZER_RECOGNIZE));
+	UniMRCPRecognizerRequest* another = chan.SendAsync(chan.CreateMessage(RECOGNIZER_RECOGNIZE));
+	apr_atomic_set32(&chan.released, 1);
+	CHECK(stalled);
+	CHECK(id == 5);
+	CHECK(progress == UW_ASYNC_IN_PROGRESS);
+	CHECK(responded);
+	CHECK(done == UW_ASYNC_COMPLETE);
+	CHECK(completed);
+	/* Complete, so reused, the next one is still in use */
+	CHECK(next == req);
+	CHECK(another != req);
+}
+
+
+/** @brief A channel failing to set up on the first profile is retried on the next one before OnAdd() */
+void UniMRCPTest::GroupFailover()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	client.AddProfileToGroup("down", "down-1");
+	client.AddProfileToGroup("down", "down-2");
+	client.SetGroupBalancing("down", UW_BALANCE_ROUND_ROBIN, 60000);
+	UniMRCPClientSession sess(&client, "down");
+	TestTermination term(&sess);
+	AddedChannel chan(&sess, &term);
+	apr_time_t deadline = apr_time_now() + apr_time_from_sec(10);
+	while (!apr_atomic_read32(&chan.added) && (apr_time_now() < deadline))
+		apr_sleep(apr_time_from_msec(10));
+	/* Give a wrong second report the chance to arrive */
+	apr_sleep(apr_time_from_msec(200));
+	CHECK(apr_atomic_read32(&chan.added) == 1);
+	CHECK(chan.status != UW_MRCP_SIG_STATUS_CODE_SUCCESS);
+	/* Both were tried before giving up */
+	CHECK(!client.IsProfileHealthy("down", "down-1"));
+	CHECK(!client.IsProfileHealthy("down", "down-2"));
+}
+
+
+/** @brief Keys spread evenly, a new bucket takes keys only from the others, the same key finds the same client */
+void UniMRCPTest::PoolHash()
+{
+	unsigned const buckets = 8, keys = 8000;
+	unsigned counts[buckets + 1];
+	memset(counts, 0, sizeof(counts));
+	bool inRange = true, consistent = true;
+	for (unsigned k = 0; k < keys; k++) {
+		apr_uint64_t key = HashFNV1a(FNV1A_INIT, reinterpret_cast<char const*>(&k), sizeof(k));
+		unsigned b = JumpHash(key, buckets);
+		unsigned grown = JumpHash(key, buckets + 1);
+		inRange = inRange && (b < buckets) && (grown <= buckets);
+		/* Stays put or moves to the new bucket */
+		consistent = consistent && ((grown == b) || (grown == buckets));
+		counts[b]++;
+	}
+	unsigned least = keys, most = 0;
+	for (unsigned b = 0; b < buckets; b++) {
+		if (counts[b] < least)
+			least = counts[b];
+		if (counts[b] > most)
+			most = counts[b];
+	}
+	UniMRCPClientPool pool(TEST_CONFIG, false, 3);
+	pool.SetPlacement(UW_PLACEMENT_HASH);
+	UniMRCPClient* first = pool.SelectClient("call-1");
+	bool same = true;
+	for (unsigned i = 0; i < 10; i++)
+		same = same && (pool.SelectClient("call-1") == first);
+	bool spread = false;
+	char key[16];
+	for (unsigned i = 2; (i < 100) && !spread; i++) {
+		apr_snprintf(key, sizeof(key), "call-%u", i);
+		spread = pool.SelectClient(key) != first;
+	}
+	CHECK(inRange);
+	CHECK(consistent);
+	CHECK(least > keys / buckets * 8 / 10);
+	CHECK(most < keys / buckets * 12 / 10);
+	CHECK(same);
+	CHECK(spread);
+}
+
+
+/** @brief Sessions go to the least loaded client, sessions with neither pool nor client are rejected */
+void UniMRCPTest::PoolBalance()
+{
+	UniMRCPClientPool pool(TEST_CONFIG, false, 2);
+	UniMRCPClientSession* sessions[4];
+	unsigned loads[4][2];
+	for (unsigned i = 0; i < 4; i++) {
+		sessions[i] = new UniMRCPClientSession(&pool, "down-1");
+		loads[i][0] = pool.GetClient(0)->GetSessionCount();
+		loads[i][1] = pool.GetClient(1)->GetSessionCount();
+	}
+	for (unsigned i = 0; i < 4; i++)
+		delete sessions[i];
+	bool noPool = false, noClient = false;
+	try {
+		UniMRCPClientSession s(static_cast<UniMRCPClientPool*>(NULL), "down-1");
+	} catch (UniMRCPException const&) {
+		noPool = true;
+	}
+	try {
+		UniMRCPClientSession s(static_cast<UniMRCPClient*>(NULL), "down-1");
+	} catch (UniMRCPException const&) {
+		noClient = true;
+	}
+	CHECK(loads[0][0] + loads[0][1] == 1);
+	CHECK(loads[1][0] == 1 && loads[1][1] == 1);
+	CHECK(loads[2][0] + loads[2][1] == 3);
+	CHECK(loads[3][0] == 2 && loads[3][1] == 2);
+	CHECK(noPool);
+	CHECK(noClient);
+}
+
+
+/** @brief Pinned clients run on their CPU, the creating thread keeps its affinity */
+void UniMRCPTest::PoolPinned()
+{
+#ifdef __linux__
+	cpu_set_t before, after;
+	CHECK(!sched_getaffinity(0, sizeof(before), &before));
+	int cpu = AllowedCPU(before, 0);
+	unsigned pinnedThreads = 0;
+	{
+		UniMRCPClientPool pool(TEST_CONFIG, false, 1, true);
+		CHECK(!sched_getaffinity(0, sizeof(after), &after));
+		/* Threads of the client task, media engine and agents */
+		DIR* dir = opendir("/proc/self/task");
+		CHECK(dir);
+		struct dirent* e;
+		while ((e = readdir(dir)) != NULL) {
+			pid_t tid = static_cast<pid_t>(atoi(e->d_name));
+			cpu_set_t set;
+			if ((tid > 0) && !sched_getaffinity(tid, sizeof(set), &set) &&
+				(CPU_COUNT(&set) == 1) && CPU_ISSET(cpu, &set))
+			{
+				pinnedThreads++;
+			}
+		}
+		closedir(dir);
+	}
+	CHECK(CPU_EQUAL(&before, &after));
+	CHECK(cpu >= 0);
+	/* Nothing to tell apart with a single allowed CPU */
+	if (CPU_COUNT(&before) > 1)
+		CHECK(pinnedThreads > 0);
+#endif
+}
+
+
+/** @brief Warm sessions are checked out most recent first and back in, foreign or idle ones are refused */
+void UniMRCPTest::SessionPoolCheckout()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	TestSessionPool pool(&client, 2, 0);
+	TestTermination* terms[2];
+	UniMRCPClientSession* first = Warm(pool, terms[0]);
+	UniMRCPClientSession* second = Warm(pool, terms[1]);
+	UniMRCPSessionPoolStats warm, out, empty, back;
+	pool.GetStats(warm);
+	UniMRCPClientSession* a = pool.Checkout();
+	UniMRCPClientSession* b = pool.Checkout();
+	pool.GetStats(out);
+	apr_time_t start = apr_time_now();
+	UniMRCPClientSession* none = pool.Checkout(50);
+	apr_interval_time_t waited = apr_time_now() - start;
+	pool.GetStats(empty);
+	UniMRCPClientChannel* chan = pool.GetChannel(a);
+	pool.Checkin(a);
+	bool twice = false, foreign = false;
+	try {
+		pool.Checkin(a);
+	} catch (UniMRCPException const&) {
+		twice = true;
+	}
+	UniMRCPClientSession stranger(&client, "down-1");
+	try {
+		pool.Checkin(&stranger);
+	} catch (UniMRCPException const&) {
+		foreign = true;
+	}
+	UniMRCPClientSession* again = pool.Checkout();
+	pool.Checkin(again);
+	pool.Checkin(b);
+	pool.GetStats(back);
+	pool.Destroy();
+	delete terms[0];
+	delete terms[1];
+	CHECK(warm.idle == 2 && !warm.warming && !warm.busy);
+	CHECK(a == second);
+	CHECK(b == first);
+	CHECK(!out.idle && out.busy == 2);
+	CHECK(out.checkouts == 2 && out.hits == 2);
+	CHECK(!none);
+	CHECK(waited >= apr_time_from_msec(40));
+	CHECK(empty.timeouts == 1);
+	/* Refills of the taken sessions failed, nothing left warming */
+	CHECK(empty.failures >= 2 && !empty.warming);
+	CHECK(chan && (chan->session == a));
+	CHECK(twice);
+	CHECK(foreign);
+	CHECK(again == a);
+	CHECK(back.idle == 2 && !back.busy);
+	CHECK(back.checkouts == 3 && back.hits == 3);
+	CHECK(back.hitRate > 0.74 && back.hitRate < 0.76);
+}
+
+
+/** @brief Sessions idle past the timeout are torn down and counted, not handed out */
+void UniMRCPTest::SessionPoolIdle()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	TestSessionPool pool(&client, 1, 50);
+	TestTermination* term;
+	Warm(pool, term);
+	UniMRCPSessionPoolStats expired, after;
+	apr_time_t deadline = apr_time_now() + apr_time_from_sec(5);
+	do {
+		apr_sleep(apr_time_from_msec(10));
+		pool.GetStats(expired);
+	} while (!expired.recycled && (apr_time_now() < deadline));
+	/* No dispatcher, left for the next checkout */
+	bool waiting = pool.expired != NULL;
+	UniMRCPClientSession* none = pool.Checkout();
+	pool.GetStats(after);
+	bool tornDown = !pool.expired;
+	pool.Destroy();
+	delete term;
+	CHECK(expired.recycled == 1);
+	CHECK(!expired.idle);
+	CHECK(waiting);
+	CHECK(!none);
+	CHECK(tornDown);
+	CHECK(after.timeouts == 1 && !after.checkouts);
+}
+
+
+/** @brief Setup and termination are reported once for the whole batch, sessions not created included */
+void UniMRCPTest::SessionBatch()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	TestSessionBatch batch(&client);
+	batch.Create(3);
+	bool setUp = TestSessionBatch::Wait(batch.setups);
+	bool again = false, outOfRange = false;
+	try {
+		batch.Create(1);
+	} catch (UniMRCPException const&) {
+		again = true;
+	}
+	try {
+		batch.GetSession(3);
+	} catch (UniMRCPException const&) {
+		outOfRange = true;
+	}
+	bool missing = !batch.GetSession(1) && !batch.GetChannel(1);
+	bool created = batch.GetSession(0) && batch.GetChannel(2);
+	bool ready = batch.IsReady(0) || batch.IsReady(1) || batch.IsReady(2);
+	batch.Terminate();
+	bool terminated = TestSessionBatch::Wait(batch.terminations);
+	unsigned firstTerminated = batch.terminated;
+	/* Nothing left to terminate, reported at once with the same total */
+	batch.Terminate();
+	unsigned terminations = apr_atomic_read32(&batch.terminations);
+	unsigned lastTerminated = batch.terminated;
+	batch.Destroy();
+	for (unsigned i = 0; i < 4; i++)
+		delete batch.terms[i];
+	/* Give a wrong second report the chance to arrive */
+	apr_sleep(apr_time_from_msec(200));
+	CHECK(setUp);
+	CHECK(apr_atomic_read32(&batch.setups) == 1);
+	CHECK(!batch.succeeded && (batch.failed == 3));
+	CHECK(batch.GetCount() == 0);
+	CHECK(again);
+	CHECK(outOfRange);
+	CHECK(missing);
+	CHECK(created);
+	CHECK(!ready);
+	CHECK(terminated);
+	CHECK(firstTerminated == 2);
+	CHECK(terminations == 2);
+	CHECK(lastTerminated == 2);
+	CHECK(apr_atomic_read32(&batch.terminations) == 2);
+}
+
+
+/** @brief Objects over a limit are rejected at once or after the wait with distinct codes, and counted */
+void UniMRCPTest::AdmissionLimits()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	client.SetLimit(UW_LIMIT_SESSIONS, 1);
+	client.SetLimit(UW_LIMIT_CHANNELS, 1, 50, "down-1");
+	UniMRCPClientSession* first = new UniMRCPClientSession(&client, "down-1");
+	UniMRCPErrorCode sessionCode = UW_ERROR_GENERIC;
+	try {
+		UniMRCPClientSession second(&client, "down-2");
+	} catch (UniMRCPException const& ex) {
+		sessionCode = ex.code;
+	}
+	TestTermination* term = new TestTermination(first);
+	UniMRCPErrorCode channelCode = UW_ERROR_GENERIC;
+	apr_interval_time_t waited = 0;
+	{
+		UniMRCPRecognizerChannel chan(first, term);
+		apr_time_t start = apr_time_now();
+		try {
+			UniMRCPRecognizerChannel extra(first, term);
+		} catch (UniMRCPException const& ex) {
+			channelCode = ex.code;
+			waited = apr_time_now() - start;
+		}
+	}
+	UniMRCPOccupancy sessions, channels;
+	client.GetOccupancy(UW_LIMIT_SESSIONS, sessions);
+	client.GetOccupancy(UW_LIMIT_CHANNELS, channels, "down-1");
+	delete term;
+	delete first;
+	bool readmitted = false;
+	try {
+		UniMRCPClientSession again(&client, "down-2");
+		readmitted = true;
+	} catch (UniMRCPException const&) {
+	}
+	CHECK(sessionCode == UW_ERROR_ADMISSION_REJECTED);
+	CHECK(sessions.current == 1 && sessions.peak == 1);
+	CHECK(sessions.admitted == 1 && sessions.rejected == 1 && !sessions.queued);
+	CHECK(channelCode == UW_ERROR_ADMISSION_TIMEOUT);
+	CHECK(waited >= apr_time_from_msec(40));
+	CHECK(channels.current == 0 && channels.peak == 1);
+	CHECK(channels.queued == 1 && channels.timedOut == 1 && !channels.rejected);
+	CHECK(readmitted);
+}
+
+
+/** @brief Requests sent by any means count until complete, also when stopped */
+void UniMRCPTest::DrainCounting()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	UniMRCPRecognizerChannel chan(&sess, &term);
+	mrcp_message_t* req = mrcp_application_message_create(chan.sess, chan.chan, RECOGNIZER_RECOGNIZE);
+	CHECK(req);
+	chan.LatencySent(req);
+	req->start_line.request_id = 1;
+	CHECK(chan.PendingRequests() == 1);
+	mrcp_message_t* resp = mrcp_response_create(req, req->pool);
+	resp->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+	CHECK(!chan.LatencyReceived(resp));
+	CHECK(chan.PendingRequests() == 1);
+	mrcp_message_t* evt = mrcp_event_create(req, RECOGNIZER_RECOGNITION_COMPLETE, req->pool);
+	evt->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	CHECK(chan.LatencyReceived(evt));
+	CHECK(chan.PendingRequests() == 0);
+	/* Stopped, no completion event */
+	req->start_line.request_id = 2;
+	chan.LatencySent(req);
+	resp->start_line.request_id = 2;
+	chan.LatencyReceived(resp);
+	mrcp_message_t* stop = mrcp_application_message_create(chan.sess, chan.chan, RECOGNIZER_STOP);
+	CHECK(stop);
+	chan.LatencySent(stop);
+	stop->start_line.request_id = 3;
+	CHECK(chan.PendingRequests() == 2);
+	mrcp_message_t* stopped = mrcp_response_create(stop, stop->pool);
+	stopped->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	mrcp_generic_header_t* hdr = mrcp_generic_header_get(stopped);
+	hdr->active_request_id_list.ids[0] = 2;
+	hdr->active_request_id_list.count = 1;
+	mrcp_generic_header_property_add(stopped, UW_HEADER_GENERIC_ACTIVE_REQUEST_ID_LIST);
+	CHECK(chan.LatencyReceived(stopped));
+	CHECK(chan.PendingRequests() == 0);
+}
+
+
+/** @brief Sessions without requests are terminated, Drain() returns once they are */
+void UniMRCPTest::DrainIdle()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	apr_time_t start = apr_time_now();
+	bool drained = client.Drain(5000);
+	apr_time_t took = apr_time_now() - start;
+	bool rejected = false;
+	try {
+		UniMRCPClientSession late(&client, "down-1");
+	} catch (UniMRCPException const& ex) {
+		rejected = ex.code == UW_ERROR_ADMISSION_REJECTED;
+	}
+	CHECK(drained);
+	CHECK(took < apr_time_from_msec(5000));
+	CHECK(rejected);
+}
+
+
+/** @brief Identical grammars share the ID, a failed DEFINE-GRAMMAR forgets only the grammar of its request ID */
+void UniMRCPTest::GrammarDefine()
+{
+	static char const srgs[] = "<grammar root=\"r\"><rule id=\"r\">yes</rule></grammar>";
+	char const* id = UniMRCPRecognizerChannel::RegisterGrammar("application/srgs+xml", srgs);
+	char const* other = UniMRCPRecognizerChannel::RegisterGrammar("application/srgs", srgs);
+	CHECK(id == UniMRCPRecognizerChannel::RegisterGrammar("application/srgs+xml", srgs));
+	CHECK(strcmp(id, other));
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	UniMRCPRecognizerChannel chan(&sess, &term);
+	/* Tracked as DefineGrammar() does, the channel cannot send, IDs as the stack assigns them */
+	char const* ids[2] = {id, other};
+	mrcp_message_t* reqs[2];
+	for (unsigned i = 0; i < 2; i++) {
+		UniMRCPGrammar const* g = static_cast<UniMRCPGrammar const*>(apr_hash_get(grammarCache, ids[i], APR_HASH_KEY_STRING));
+		CHECK(g);
+		reqs[i] = mrcp_application_message_create(chan.sess, chan.chan, RECOGNIZER_DEFINE_GRAMMAR);
+		CHECK(reqs[i]);
+		reqs[i]->start_line.request_id = 11 + i;
+		apr_hash_set(chan.grammars, g->id, APR_HASH_KEY_STRING, g);
+		UniMRCPPendingGrammar* p = static_cast<UniMRCPPendingGrammar*>(apr_array_push(chan.pendingGrammars));
+		p->grammar = g;
+		p->msg = reqs[i];
+	}
+	/* Answered out of order, a response of no pending request changes nothing */
+	mrcp_message_t* unknown = mrcp_response_create(reqs[0], reqs[0]->pool);
+	unknown->start_line.request_id = 13;
+	unknown->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+	chan.OnMsgReceive(unknown);
+	CHECK(chan.IsGrammarDefined(id) && chan.IsGrammarDefined(other));
+	mrcp_message_t* failed = mrcp_response_create(reqs[1], reqs[1]->pool);
+	failed->start_line.status_code = MRCP_STATUS_CODE_METHOD_FAILED;
+	chan.OnMsgReceive(failed);
+	CHECK(chan.IsGrammarDefined(id));
+	CHECK(!chan.IsGrammarDefined(other));
+	mrcp_message_t* succeeded = mrcp_response_create(reqs[0], reqs[0]->pool);
+	succeeded->start_line.status_code = MRCP_STATUS_CODE_SUCCESS;
+	chan.OnMsgReceive(succeeded);
+	CHECK(chan.IsGrammarDefined(id));
+	CHECK(!chan.pendingGrammars->nelts);
+	UniMRCPRecognizerMessage* msg = chan.CreateRecognizeMessage("session:uw-1\r\nbuiltin:grammar/digits");
+	CHECK(!strcmp(msg->content_type_get(), "text/uri-list"));
+}
+
+
+/** @brief Interpretations with the confidence scale of the MRCP version, strings decoded and copied once */
+void UniMRCPTest::NlsmlParse()
+{
+	static char const nlsml[] =
+		"<?xml version=\"1.0\"?>\n"
+		"<result xmlns=\"http://www.ietf.org/xml/ns/mrcpv2\">\n"
+		"<!-- <interpretation confidence=\"99\"/> -->\n"
+		"<interpretation grammar=\"session:uw&#x2D;1\" confidence=\"1\">\n"
+		"  <instance><city>Prague &amp; Brno</city></instance>\n"
+		"  <input mode=\"speech\"> to Prague &amp; Brno </input>\n"
+		"</interpretation>\n"
+		"<interpretation confidence=\"40\"><input mode=\"dtmf\">&#x10D;1&#32;2&#65536;&#0;&#x;</input></interpretation>\n"
+		"</result>\n";
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClientSession sess(&client, "down-1");
+	TestTermination term(&sess);
+	UniMRCPRecognizerChannel chan(&sess, &term);
+	UniMRCPRecognizerMessage* msg = chan.CreateMessage(RECOGNIZER_RECOGNIZE);
+	msg->SetBody(nlsml);
+	UniMRCPNLSMLResult v1, v2;
+	msg->msg->start_line.version = MRCP_VERSION_1;
+	CHECK(msg->ParseNLSML(v1));
+	msg->msg->start_line.version = MRCP_VERSION_2;
+	CHECK(msg->ParseNLSML(v2));
+	CHECK(v1.Count() == 2);
+	CHECK(v1.Confidence(0) > 0.0099f && v1.Confidence(0) < 0.0101f);
+	CHECK(v1.Confidence(1) > 0.399f && v1.Confidence(1) < 0.401f);
+	CHECK(v2.Confidence(0) == 1.0f);
+	CHECK(!strcmp(v1.Grammar(0), "session:uw-1"));
+	CHECK(!strcmp(v1.Mode(0), "speech"));
+	CHECK(!strcmp(v1.Input(0), "to Prague & Brno"));
+	CHECK(!strcmp(v1.Instance(0), "<city>Prague &amp; Brno</city>"));
+	CHECK(!strcmp(v1.Mode(1), "dtmf"));
+	/* UTF-8, invalid references kept */
+	CHECK(!strcmp(v1.Input(1), "\xC4\x8D" "1 2" "\xF0\x90\x80\x80" "&#0;&#x;"));
+	CHECK(!*v1.Grammar(1));
+	CHECK(v1.Input(0) == v1.Input(0));
+	bool rejected = false;
+	try {
+		v1.Input(2);
+	} catch (UniMRCPException const&) {
+		rejected = true;
+	}
+	CHECK(rejected);
+}
+
+
+/** @brief The wrapper follows the apt priority when it is changed behind its back */
+void UniMRCPTest::LogPriorityChange()
+{
+	bool before = UW_LOG_ON(APT_PRIO_DEBUG);
+	apt_log_priority_set(APT_PRIO_DEBUG);
+	bool raised = UW_LOG_ON(APT_PRIO_DEBUG);
+	apt_log_priority_set(APT_PRIO_NOTICE);
+	bool lowered = UW_LOG_ON(APT_PRIO_INFO);
+	CHECK(!before);
+	CHECK(raised);
+	CHECK(!lowered);
+	CHECK(UW_LOG_ON(APT_PRIO_NOTICE));
+}
+
+
+/** @brief Sampled sessions get the priority, their messages reach the logger unchanged */
+void UniMRCPTest::LogSampling()
+{
+	UniMRCPClient client(TEST_CONFIG);
+	UniMRCPClient::SetLogSampling(1, UW_APT_PRIO_INFO);
+	UniMRCPClientSession sampled(&client, "down-1");
+	UniMRCPClient::SetLogSampling(0);
+	UniMRCPClientSession plain(&client, "down-1");
+	CapturingLogger capture;
+	UniMRCPLogger* logger = UniMRCPLogger::logger;
+	UniMRCPLogger::logger = &capture;
+	unsigned line = __LINE__ + 1;
+	UW_SLOG(sampled.GetLogPriority(), APT_PRIO_INFO, "sampled %d", 1);
+	UW_SLOG(plain.GetLogPriority(), APT_PRIO_INFO, "plain %d", 2);
+	UW_SLOG(sampled.GetLogPriority(), APT_PRIO_DEBUG, "too detailed %d", 3);
+	UniMRCPLogger::logger = logger;
+	CHECK(sampled.GetLogPriority() == UW_APT_PRIO_INFO);
+	CHECK(plain.GetLogPriority() == -1);
+	CHECK(capture.count == 1);
+	CHECK(!strcmp(capture.message, "sampled 1"));
+	CHECK(capture.priority == UW_APT_PRIO_INFO);
+	CHECK(capture.line == line);
+	CHECK(!strcmp(capture.file, __FILE__));
+}
+
+
+/** @brief A full queue drops and counts, the rest is written out in full when stopped */
+void UniMRCPTest::LogQueue()
+{
+	char text[UW_LOG_INLINE_SIZE * 4];
+	memset(text, 'x', sizeof(text) - 1);
+	text[sizeof(text) - 1] = 0;
+	apr_pool_t* pool = apt_pool_create();
+	BlockingLogger blocking;
+	UniMRCPLogger* logger = UniMRCPLogger::logger;
+	UniMRCPLogger::logger = &blocking;
+	UniMRCPLogQueue* q = new UniMRCPLogQueue(pool, 3);
+	QueueLog(q, "first");
+	bool held = blocking.WaitHeld();
+	/* The cell of the first one is busy until it is written, three more fit */
+	QueueLog(q, "long %s", text);
+	QueueLog(q, "second");
+	QueueLog(q, "third");
+	QueueLog(q, "lost");
+	QueueLog(q, "lost too");
+	UniMRCPLogStats full, drained;
+	q->GetStats(full);
+	apr_atomic_set32(&blocking.released, 1);
+	q->Stop();
+	q->GetStats(drained);
+	delete q;
+	UniMRCPLogger::logger = logger;
+	apr_pool_destroy(pool);
+	bool rejected = false;
+	try {
+		UniMRCPLogQueue big(NULL, UW_LOG_QUEUE_MAX + 1);
+	} catch (UniMRCPException const&) {
+		rejected = true;
+	}
+	CHECK(held);
+	CHECK(full.capacity == 4);
+	CHECK(full.queueDepth == 4);
+	CHECK(full.dropped == 2);
+	CHECK(!drained.queueDepth);
+	CHECK(drained.logged == 4);
+	CHECK(blocking.count == 4);
+	CHECK(blocking.longest == strlen(text) + 5);
+	CHECK(blocking.reports == 1);
+	CHECK(rejected);
+}
+
+
+/** @brief Sessions are traced under their number, a full ring keeps the newest records, the file holds them */
+void UniMRCPTest::TraceRing()
+{
+	apr_pool_t* pool = apt_pool_create();
+	char const* dir = NULL;
+	if (apr_temp_dir_get(&dir, pool) != APR_SUCCESS)
+		dir = ".";
+	char const* path = apr_pstrcat(pool, dir, "/WrapperTest.trace", NULL);
+	/* Session records */
+	UniMRCPClient::StartTraceLog(path, 64);
+	bool twice = false;
+	try {
+		UniMRCPClient::StartTraceLog(path);
+	} catch (UniMRCPException const&) {
+		twice = true;
+	}
+	unsigned traceId;
+	char name[16];
+	bool stopRefused = false;
+	{
+		UniMRCPClient client(TEST_CONFIG);
+		UniMRCPClientSession sess(&client, "down-1");
+		traceId = sess.diag.traceId;
+		apr_cpystrn(name, mrcp_application_session_name_get(sess.sess), sizeof(name));
+		try {
+			UniMRCPClient::StopTraceLog();
+		} catch (UniMRCPException const&) {
+			stopRefused = true;
+		}
+	}
+	bool created = false, destroyed = false;
+	for (apr_uint32_t i = 0; (i < traceHeader->next) && (i < traceHeader->capacity); i++) {
+		UniMRCPTraceRecord const* r = &traceRecords[i];
+		if ((r->session != traceId) || (r->seq != i + 1))
+			continue;
+		if (r->event == UW_TRACE_SESSION_CREATE)
+			created = !strncmp(r->name, name, sizeof(r->name));
+		else if (r->event == UW_TRACE_SESSION_DESTROY)
+			destroyed = true;
+	}
+	UniMRCPClient::StopTraceLog();
+	/* Wrapped around */
+	UniMRCPClient::StartTraceLog(path, 5);
+	apr_uint32_t capacity = traceHeader->capacity;
+	for (apr_uint32_t i = 0; i < 10; i++)
+		TraceEvent(UW_TRACE_STARVATION, NULL, 1, 2, MRCP_RECOGNIZER, i);
+	UniMRCPClient::StopTraceLog();
+	UniMRCPTraceHeader header;
+	UniMRCPTraceRecord records[8];
+	memset(&header, 0, sizeof(header));
+	memset(records, 0, sizeof(records));
+	FILE* f = fopen(path, "rb");
+	size_t items = 0;
+	if (f) {
+		items = fread(&header, sizeof(header), 1, f) + fread(records, sizeof(records[0]), 8, f);
+		fclose(f);
+	}
+	apr_file_remove(path, pool);
+	apr_pool_destroy(pool);
+	bool newest = true;
+	for (apr_uint32_t n = 2; n < 10; n++) {
+		UniMRCPTraceRecord const& r = records[n & 7];
+		newest = newest && (r.seq == n + 1) && (r.value == n) && (r.event == UW_TRACE_STARVATION) &&
+			(r.session == 1) && (r.channel == 2) && (r.resource == MRCP_RECOGNIZER) && !r.name[0];
+	}
+	CHECK(twice);
+	CHECK(stopRefused);
+	CHECK(created);
+	CHECK(destroyed);
+	CHECK(capacity == 8);
+	CHECK(items == 9);
+	CHECK(!memcmp(header.magic, "UWTRACE", 8));
+	CHECK(header.version == UW_TRACE_VERSION && header.recordSize == sizeof(UniMRCPTraceRecord));
+	CHECK(header.capacity == 8 && header.next == 10);
+	CHECK(newest);
+}
+
+
+UniMRCPTest::Case const UniMRCPTest::cases[] = {
+	{"timer_idle",     TimerIdle},
+	{"timer_overlong", TimerOverlong},
+	{"timer_stop",     TimerStop},
+	{"latency_matched", LatencyMatched},
+	{"metrics_gauges", MetricsGauges},
+	{"metrics_counters", MetricsCounters},
+	{"async_timeout",  AsyncTimeout},
+	{"async_correlation", AsyncCorrelation},
+	{"group_failover", GroupFailover},
+	{"pool_hash",      PoolHash},
+	{"pool_balance",   PoolBalance},
+	{"pool_pinned",    PoolPinned},
+	{"session_pool_checkout", SessionPoolCheckout},
+	{"session_pool_idle", SessionPoolIdle},
+	{"session_batch",  SessionBatch},
+	{"admission_limits", AdmissionLimits},
+	{"drain_counting", DrainCounting},
+	{"drain_idle",     DrainIdle},
+	{"grammar_define", GrammarDefine},
+	{"nlsml_parse",    NlsmlParse},
+	{"log_priority",   LogPriorityChange},
+	{"log_sampling",   LogSampling},
+	{"log_queue",      LogQueue},
+	{"trace_ring",     TraceRing},
+	{NULL, NULL}
+};
+
+
+static bool Selected(char const* name, int argc, char const* const argv[])
+{
+	if (argc < 2)
+		return true;
+	for (int i = 1; i < argc; i++)
+		if (!strcmp(argv[i], name))
+			return true;
+	return false;
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	QuietLogger logger;
+	UniMRCPClient::StaticInitialize(&logger, UW_APT_PRIO_NOTICE);
+	int failures = 0;
+	for (UniMRCPTest::Case const* c = UniMRCPTest::cases; c->name; c++) {
+		if (!Selected(c->name, argc, argv))
+			continue;
+		UniMRCPTest::failed = false;
+		try {
+			c->body();
+		} catch (UniMRCPException const& ex) {
+			fprintf(stderr, "  exception: %s\n", ex.msg);
+			UniMRCPTest::failed = true;
+		}
+		printf("%s %s\n", UniMRCPTest::failed ? "FAIL" : "ok  ", c->name);
+		failures += UniMRCPTest::failed;
+	}
+	UniMRCPClient::StaticDeinitialize();
+	return failures;
+}
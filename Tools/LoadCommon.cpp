@@ -0,0 +1,458 @@
+/*
+ * Shared by the load generator UniLoad and the soak test UniSoak, see LoadCommon.h
+ */
+
+#include "LoadCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#	include <windows.h>
+#	include <psapi.h>
+#	pragma comment(lib, "psapi.lib")
+#else
+#	include <unistd.h>
+#	include <sys/resource.h>
+#endif
+
+// UniMRCP client root directory
+static char const ROOT_DIR1[] = "../../../../trunk";
+static char const ROOT_DIR2[] = "../../../../UniMRCP";
+static char const ROOT_DIR3[] = "../../../../unimrcp";
+
+static char const DEFAULT_TEXT[] = "This is a synthetic voice.";
+
+
+void LoadConfigInit(LoadConfig& cfg)
+{
+	cfg.rootDir = ROOT_DIR1;
+	cfg.profile = "uni2";
+	cfg.sessions = 10;
+	cfg.requests = 1;
+	cfg.recogPercent = 50;
+	cfg.grammarFile = NULL;
+	cfg.audioFile = NULL;
+	cfg.text = DEFAULT_TEXT;
+	cfg.timeoutMs = 30000;
+	cfg.durationS = 60;
+	cfg.intervalS = 5;
+	cfg.threads = 0;
+	cfg.logPrio = APT_PRIO_ERROR;
+	cfg.grammarId = NULL;
+	// Just detect various directory layout constellations
+	struct stat info;
+	if (stat(cfg.rootDir, &info))
+		cfg.rootDir = ROOT_DIR2;
+	if (stat(cfg.rootDir, &info))
+		cfg.rootDir = ROOT_DIR3;
+}
+
+
+bool LoadConfigOption(LoadConfig& cfg, char opt, char const* val)
+{
+	switch (opt) {
+	case 'r': cfg.rootDir = val; break;
+	case 'p': cfg.profile = val; break;
+	case 'c': cfg.sessions = static_cast<unsigned>(strtoul(val, NULL, 10)); break;
+	case 'm': cfg.recogPercent = static_cast<unsigned>(strtoul(val, NULL, 10)); break;
+	case 'g': cfg.grammarFile = val; break;
+	case 'a': cfg.audioFile = val; break;
+	case 's': cfg.text = val; break;
+	case 'T': cfg.timeoutMs = strtoul(val, NULL, 10); break;
+	case 'd': cfg.durationS = strtoul(val, NULL, 10); break;
+	case 'i': cfg.intervalS = strtoul(val, NULL, 10); break;
+	case 'w': cfg.threads = static_cast<unsigned>(strtoul(val, NULL, 10)); break;
+	case 'l': cfg.logPrio = static_cast<UniMRCPLogPriority>(strtoul(val, NULL, 10)); break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+
+bool LoadInputs(LoadConfig& cfg, std::string& grammar)
+{
+	if (!cfg.recogPercent)
+		return true;
+	if (!cfg.grammarFile || !cfg.audioFile) {
+		printf("Recognizer sessions need a grammar (-g) and input audio (-a)\n");
+		return false;
+	}
+	if (!ReadFile(cfg.grammarFile, grammar) || !ReadFile(cfg.audioFile, cfg.audio)) {
+		printf("Cannot read %s or %s\n", cfg.grammarFile, cfg.audioFile);
+		return false;
+	}
+	return true;
+}
+
+
+bool LoadLogger::Log(char const* file, unsigned line, UniMRCPLogPriority prio, char const* msg)
+{
+	(void) file;
+	(void) line;
+	(void) prio;
+	fprintf(stderr, "  %s\n", msg);
+	return true;
+}
+
+
+bool LoadStreamTx::WriteFrame()
+{
+	return true;
+}
+
+
+LoadTermination::LoadTermination(UniMRCPClientSession* sess, std::string const* audio) :
+	UniMRCPAudioTermination(sess),
+	rx(NULL)
+{
+	// Shared input, rewound for every request, silence after its end as from a caller waiting for the result
+	if (audio)
+		rx = new UniMRCPStreamRxMemory(audio->data(), audio->size(), false,
+			UniMRCPStreamRxMemory::SRM_ZEROS, true);
+	AddCapability("LPCM", SAMPLE_RATE_8000);
+}
+
+
+LoadTermination::~LoadTermination()
+{
+	delete rx;
+}
+
+
+UniMRCPStreamRx* LoadTermination::OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+                                                 char const* format, unsigned char channels, unsigned freq)
+{
+	(void) enabled;
+	(void) payload_type;
+	(void) name;
+	(void) format;
+	(void) channels;
+	(void) freq;
+	return rx;
+}
+
+
+UniMRCPStreamTx* LoadTermination::OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+                                                 char const* format, unsigned char channels, unsigned freq)
+{
+	(void) enabled;
+	(void) payload_type;
+	(void) name;
+	(void) format;
+	(void) channels;
+	(void) freq;
+	return &tx;
+}
+
+
+class LoadRecogChannel : public UniMRCPRecognizerChannel {
+	LoadSession* sess;
+	LoadTermination* term;
+	char const* grammarId;
+
+public:
+	LoadRecogChannel(LoadSession* sess, LoadTermination* term, char const* grammarId) :
+		UniMRCPRecognizerChannel(sess, term),
+		sess(sess),
+		term(term),
+		grammarId(grammarId)
+	{
+	}
+
+	bool SendRecognize()
+	{
+		try {
+			term->rx->Rewind();
+			// Grammar body comes from the cache, DEFINE-GRAMMAR goes out with the first request only
+			char const* uri = DefineGrammar(grammarId);
+			UniMRCPRecognizerMessage* msg = CreateRecognizeMessage(uri);
+			sess->CountMessage(sizeof(*msg));
+			return msg->Send();
+		} catch (UniMRCPException const&) {
+			sess->SetState(LoadSession::ST_FAILED);
+			return false;
+		}
+	}
+
+	virtual bool OnAdd(UniMRCPSigStatusCode status)
+	{
+		if (status != MRCP_SIG_STATUS_CODE_SUCCESS) {
+			sess->SetState(LoadSession::ST_FAILED);
+			return false;
+		}
+		sess->SetState(LoadSession::ST_RUNNING);
+		return SendRecognize();
+	}
+
+	virtual bool OnMessageReceive(UniMRCPRecognizerMessage const* message)
+	{
+		sess->CountMessage(sizeof(*message));
+		if (message->GetMsgType() == MRCP_MESSAGE_TYPE_RESPONSE) {
+			if (message->GetStatusCode() != MRCP_STATUS_CODE_SUCCESS) {
+				sess->SetState(LoadSession::ST_FAILED);
+				return false;
+			}
+			if ((message->GetMethodID() == RECOGNIZER_RECOGNIZE) &&
+				(message->GetRequestState() == MRCP_REQUEST_STATE_INPROGRESS))
+				term->rx->SetPaused(false);
+			return true;
+		}
+		if ((message->GetMsgType() == MRCP_MESSAGE_TYPE_EVENT) &&
+			(message->GetEventID() == RECOGNIZER_RECOGNITION_COMPLETE))
+		{
+			term->rx->SetPaused(true);
+			if (sess->Completed())
+				return SendRecognize();
+		}
+		return true;
+	}
+
+	virtual bool OnTerminateEvent()
+	{
+		sess->SetState(LoadSession::ST_FAILED);
+		return true;
+	}
+};
+
+
+class LoadSynthChannel : public UniMRCPSynthesizerChannel {
+	LoadSession* sess;
+	char const* text;
+
+public:
+	LoadSynthChannel(LoadSession* sess, LoadTermination* term, char const* text) :
+		UniMRCPSynthesizerChannel(sess, term),
+		sess(sess),
+		text(text)
+	{
+	}
+
+	bool SendSpeak()
+	{
+		try {
+			UniMRCPSynthesizerMessage* msg = CreateMessage(SYNTHESIZER_SPEAK);
+			sess->CountMessage(sizeof(*msg));
+			msg->content_type_set("text/plain");
+			msg->SetBody(text);
+			return msg->Send();
+		} catch (UniMRCPException const&) {
+			sess->SetState(LoadSession::ST_FAILED);
+			return false;
+		}
+	}
+
+	virtual bool OnAdd(UniMRCPSigStatusCode status)
+	{
+		if (status != MRCP_SIG_STATUS_CODE_SUCCESS) {
+			sess->SetState(LoadSession::ST_FAILED);
+			return false;
+		}
+		sess->SetState(LoadSession::ST_RUNNING);
+		return SendSpeak();
+	}
+
+	virtual bool OnMessageReceive(UniMRCPSynthesizerMessage const* message)
+	{
+		sess->CountMessage(sizeof(*message));
+		if (message->GetMsgType() == MRCP_MESSAGE_TYPE_RESPONSE) {
+			if ((message->GetStatusCode() != MRCP_STATUS_CODE_SUCCESS) ||
+				(message->GetRequestState() == MRCP_REQUEST_STATE_COMPLETE))
+			{
+				sess->SetState(LoadSession::ST_FAILED);
+				return false;
+			}
+			return true;
+		}
+		if ((message->GetMsgType() == MRCP_MESSAGE_TYPE_EVENT) &&
+			(message->GetEventID() == SYNTHESIZER_SPEAK_COMPLETE) &&
+			sess->Completed())
+			return SendSpeak();
+		return true;
+	}
+
+	virtual bool OnTerminateEvent()
+	{
+		sess->SetState(LoadSession::ST_FAILED);
+		return true;
+	}
+};
+
+
+LoadSession::LoadSession(UniMRCPClient* client, LoadConfig const& cfg, bool recog) :
+	UniMRCPClientSession(client, cfg.profile),
+	recog(recog),
+	createdAt(apr_time_now()),
+	doneAt(0),
+	firstPoolBytes(0),
+	lastPoolBytes(0),
+	state(ST_SETUP),
+	completed(0),
+	ended(0),
+	requests(cfg.requests),
+	messageBytes(0),
+	closingAt(0),
+	term(NULL),
+	chan(NULL)
+{
+	try {
+		term = new LoadTermination(this, recog ? &cfg.audio : NULL);
+		if (recog)
+			chan = new LoadRecogChannel(this, term, cfg.grammarId);
+		else
+			chan = new LoadSynthChannel(this, term, cfg.text);
+	} catch (...) {
+		delete term;
+		term = NULL;
+		throw;
+	}
+}
+
+
+LoadSession::~LoadSession()
+{
+	delete chan;
+	delete term;
+}
+
+
+void LoadSession::SetState(State st)
+{
+	apr_uint32_t cur = apr_atomic_read32(&state);
+	while ((cur == ST_SETUP) || (cur == ST_RUNNING)) {
+		apr_uint32_t prev = apr_atomic_cas32(&state, st, cur);
+		if (prev == cur)
+			break;
+		cur = prev;
+	}
+}
+
+
+bool LoadSession::Completed()
+{
+	unsigned n = apr_atomic_inc32(&completed) + 1;
+	if (n == 1)
+		firstPoolBytes = GetPoolBytes() - messageBytes;
+	if (n < requests)
+		return true;
+	lastPoolBytes = GetPoolBytes() - messageBytes;
+	SetState(ST_DONE);
+	return false;
+}
+
+
+void LoadSession::GetRxStats(UniMRCPRxStats& stats) const
+{
+	if (term && term->rx)
+		term->rx->GetRxStats(stats);
+	else
+		memset(&stats, 0, sizeof(stats));
+}
+
+
+bool LoadSession::Close(unsigned long timeout_ms)
+{
+	if (apr_atomic_read32(&ended))
+		return true;
+	apr_time_t now = apr_time_now();
+	if (!closingAt) {
+		closingAt = now;
+		Terminate();
+		return false;
+	}
+	return now - closingAt >= static_cast<apr_time_t>(timeout_ms) * 1000;
+}
+
+
+bool LoadSession::OnTerminate(UniMRCPSigStatusCode status)
+{
+	(void) status;
+	SetState(ST_FAILED);
+	apr_atomic_set32(&ended, 1);
+	return true;
+}
+
+
+bool LoadSession::OnTerminateEvent()
+{
+	SetState(ST_FAILED);
+	return true;
+}
+
+
+void CloseSessions(std::vector<LoadSession*>& closing, unsigned long timeout_ms)
+{
+	size_t j = 0;
+	for (size_t i = 0; i < closing.size(); i++) {
+		if (closing[i]->Close(timeout_ms))
+			delete closing[i];
+		else
+			closing[j++] = closing[i];
+	}
+	closing.resize(j);
+}
+
+
+double CpuSeconds()
+{
+#ifdef WIN32
+	FILETIME created, exited, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+		return 0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return static_cast<double>(k.QuadPart + u.QuadPart) / 1e7;
+#else
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru))
+		return 0;
+	return static_cast<double>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+		static_cast<double>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+
+unsigned long RssKB()
+{
+#if defined(WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return static_cast<unsigned long>(pmc.WorkingSetSize / 1024);
+#elif defined(__linux__)
+	unsigned long size = 0, resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (!f)
+		return 0;
+	if (fscanf(f, "%lu %lu", &size, &resident) != 2)
+		resident = 0;
+	fclose(f);
+	return resident * (static_cast<unsigned long>(sysconf(_SC_PAGESIZE)) / 1024);
+#else
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru))
+		return 0;
+#	ifdef __APPLE__
+	return static_cast<unsigned long>(ru.ru_maxrss / 1024);
+#	else
+	return static_cast<unsigned long>(ru.ru_maxrss);
+#	endif
+#endif
+}
+
+
+bool ReadFile(char const* path, std::string& data)
+{
+	std::ifstream stm(path, std::ios::binary | std::ios::in);
+	if (!stm)
+		return false;
+	data.assign((std::istreambuf_iterator<char>(stm)), std::istreambuf_iterator<char>());
+	return true;
+}
@@ -0,0 +1,154 @@
+/*
+ * Shared by the load generator UniLoad and the soak test UniSoak: the common
+ * configuration and options, sessions with one recognizer or synthesizer
+ * channel sending requests one after another, and process resource usage.
+ */
+
+#ifndef LOAD_COMMON_H
+#define LOAD_COMMON_H
+
+#include "UniMRCP-wrapper.h"
+#include <string>
+#include <vector>
+#include "apr_atomic.h"
+#include "apr_time.h"
+
+
+struct LoadConfig {
+	char const*        rootDir;
+	char const*        profile;
+	unsigned           sessions;      // Concurrent sessions
+	unsigned           requests;      // Requests per session
+	unsigned           recogPercent;  // Share of recognizer sessions
+	char const*        grammarFile;
+	char const*        audioFile;
+	char const*        text;
+	unsigned long      timeoutMs;     // Up to the tool, also how long a session may take to terminate
+	unsigned long      durationS;
+	unsigned long      intervalS;
+	unsigned           threads;       // Callback dispatcher threads
+	UniMRCPLogPriority logPrio;
+	// Loaded inputs
+	std::string        audio;
+	char const*        grammarId;
+};
+
+/** Defaults shared by the tools, root directory detected */
+void LoadConfigInit(LoadConfig& cfg);
+/** Take an option shared by the tools, false if it is not one of them */
+bool LoadConfigOption(LoadConfig& cfg, char opt, char const* val);
+/** Read grammar and input audio of recognizer sessions, false (reported) if they cannot be */
+bool LoadInputs(LoadConfig& cfg, std::string& grammar);
+
+
+class LoadLogger : public UniMRCPLogger {
+public:
+	virtual bool Log(char const* file, unsigned line, UniMRCPLogPriority prio, char const* msg);
+};
+
+
+// Synthesized audio is consumed and discarded
+class LoadStreamTx : public UniMRCPStreamTx {
+public:
+	virtual bool WriteFrame();
+};
+
+
+class LoadTermination : public UniMRCPAudioTermination {
+public:
+	UniMRCPStreamRxMemory* rx;  // Recognizer input, NULL for synthesizer
+	LoadStreamTx tx;
+
+	LoadTermination(UniMRCPClientSession* sess, std::string const* audio);
+	virtual ~LoadTermination();
+
+	virtual UniMRCPStreamRx* OnStreamOpenRx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq);
+	virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
+	                                        char const* format, unsigned char channels, unsigned freq);
+};
+
+
+/**
+ * Session with one recognizer (RECOGNIZE of audio streamed from memory) or
+ * synthesizer (SPEAK) channel sending the configured number of requests.
+ *
+ * Close() it before deleting it: the channel and the termination are deleted
+ * along with the session, the stack may use them until it has terminated.
+ */
+class LoadSession : public UniMRCPClientSession {
+public:
+	enum State {
+		ST_SETUP,
+		ST_RUNNING,
+		ST_DONE,
+		ST_FAILED
+	};
+
+	bool recog;
+	apr_time_t createdAt;
+	apr_time_t doneAt;        // Up to the tool
+	unsigned firstPoolBytes;  // Session pool after the first request, messages excluded
+	unsigned lastPoolBytes;   // Session pool after the last request, messages excluded
+
+	LoadSession(UniMRCPClient* client, LoadConfig const& cfg, bool recog);
+	virtual ~LoadSession();
+
+	State GetState()
+	{
+		return static_cast<State>(apr_atomic_read32(&state));
+	}
+
+	// Only setup or running sessions change state, the first result counts
+	void SetState(State st);
+
+	unsigned GetCompleted()
+	{
+		return apr_atomic_read32(&completed);
+	}
+
+	/** Count a completed request, true if another one is to be sent */
+	bool Completed();
+
+	/**
+	 * Count a message created or received. Messages stay in the session pool
+	 * by design, the snapshots above leave them out. Stack thread only.
+	 */
+	void CountMessage(size_t bytes)
+	{
+		messageBytes += static_cast<unsigned>(bytes);
+	}
+
+	void GetRxStats(UniMRCPRxStats& stats) const;
+
+	/**
+	 * Terminate the session (once), true when it has terminated and may be deleted.
+	 * Gives up waiting timeout_ms after the termination was requested.
+	 */
+	bool Close(unsigned long timeout_ms);
+
+	virtual bool OnTerminate(UniMRCPSigStatusCode status);
+	virtual bool OnTerminateEvent();
+
+private:
+	apr_uint32_t state;
+	apr_uint32_t completed;
+	apr_uint32_t ended;       // OnTerminate() called
+	unsigned requests;
+	unsigned messageBytes;    // CountMessage() so far
+	apr_time_t closingAt;     // When Close() requested the termination, 0 before
+	LoadTermination* term;
+	UniMRCPClientChannel* chan;
+};
+
+
+/** Delete the sessions closed, keep the others */
+void CloseSessions(std::vector<LoadSession*>& closing, unsigned long timeout_ms);
+
+/** User and system CPU time of the process in seconds */
+double CpuSeconds();
+/** Resident set size in kB, the peak one where the current is not available */
+unsigned long RssKB();
+bool ReadFile(char const* path, std::string& data);
+
+#endif /* LOAD_COMMON_H */
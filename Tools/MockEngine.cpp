@@ -0,0 +1,604 @@
+/*
+ * Mock MRCP engine plugin for UniMRCP server: a deterministic stand-in
+ * server for benchmarks and tests of the wrapper.
+ *
+ * Built as mocksynth, mockrecog and mockrecorder (one resource each).
+ * SPEAK produces a synthetic tone, RECOGNIZE and RECORD consume incoming
+ * audio and complete after a scripted amount of it, RECOGNIZE with a canned
+ * NLSML result. DEFINE-GRAMMAR and other requests simply succeed.
+ * Audio is counted in media frames (10 ms). Responses are delayed by a timer
+ * of the engine task, so they come even without media, and every message of
+ * a channel is sent in order. A server with the mock engines is cheap to
+ * saturate.
+ *
+ * Load the plugins from the plugin-factory of unimrcpserver.xml:
+ *
+ *   <engine id="Mock-Synth" name="mocksynth" enable="true">
+ *     <param name="response-delay" value="20"/>
+ *   </engine>
+ *   <engine id="Mock-Recog" name="mockrecog" enable="true"/>
+ *   <engine id="Mock-Recorder" name="mockrecorder" enable="true"/>
+ *
+ * Parameters (milliseconds unless noted):
+ *   response-delay      Request to its response (0)
+ *   speak-duration      Audio of a SPEAK (1000)
+ *   start-of-input      Audio received before START-OF-INPUT (100)
+ *   recognize-duration  Audio received before RECOGNITION-COMPLETE (1000)
+ *   record-duration     Audio received before RECORD-COMPLETE (1000)
+ *   noinput-timeout     No audio received, completed with no-input-timeout (5000)
+ *   tone                Frequency of the synthesized tone in Hz, 0 for silence (440)
+ *   result              NLSML body of RECOGNITION-COMPLETE, by default one with
+ *                       confidence on the scale of the MRCP version (0-100 for v1)
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "apr_thread_mutex.h"
+#include "apt_consumer_task.h"
+#include "mrcp_synth_engine.h"
+#include "mrcp_recog_engine.h"
+#include "mrcp_recorder_engine.h"
+#include "apt_log.h"
+
+#ifndef MOCK_RESOURCE
+#	define MOCK_RESOURCE MRCP_SYNTHESIZER_RESOURCE
+#endif
+
+/** @brief Media frame duration */
+#define MOCK_FRAME_MS 10
+/** @brief Tone lookup table size (power of 2) */
+#define MOCK_SINE_BITS 8
+#define MOCK_PI 3.14159265358979323846
+
+/** @brief Default result, MRCPv2 confidence is 0.0-1.0 */
+static char const MOCK_RESULT[] =
+	"<?xml version=\"1.0\"?>\n"
+	"<result>\n"
+	"  <interpretation confidence=\"0.95\">\n"
+	"    <instance>one</instance>\n"
+	"    <input mode=\"speech\">one</input>\n"
+	"  </interpretation>\n"
+	"</result>\n";
+
+/** @brief Default result, MRCPv1 confidence is 0-100 */
+static char const MOCK_RESULT_V1[] =
+	"<?xml version=\"1.0\"?>\n"
+	"<result>\n"
+	"  <interpretation confidence=\"95\">\n"
+	"    <instance>one</instance>\n"
+	"    <input mode=\"speech\">one</input>\n"
+	"  </interpretation>\n"
+	"</result>\n";
+
+
+/** @brief Engine parameters, durations of audio converted to frames */
+struct MockEngine {
+	apt_consumer_task_t* task;  ///< Runs the response timers
+	apr_uint32_t responseMs;
+	apr_uint32_t speakFrames;
+	apr_uint32_t inputFrames;
+	apr_uint32_t recognizeFrames;
+	apr_uint32_t recordFrames;
+	apr_uint32_t noInputFrames;
+	unsigned     toneHz;
+	char const*  result;                ///< NULL for the default one
+	apr_int16_t  sine[1 << MOCK_SINE_BITS];
+};
+
+/** @brief Message to send once due, after those queued before it */
+struct MockPending {
+	mrcp_message_t* message;
+	apr_time_t      due;
+	MockPending*    next;
+};
+
+struct MockChannel {
+	MockEngine*            engine;
+	mrcp_engine_channel_t* channel;
+	apr_pool_t*            pool;
+	apt_timer_t*           timer;        ///< Fires when the first pending message is due, set by the engine task only
+	apr_thread_mutex_t*    mutex;        ///< Guards the rest against the media thread and the engine task
+	apr_uint64_t           clock;        ///< Frames since the channel opened
+	MockPending*           pendingHead;  ///< Messages not sent yet (FIFO)
+	MockPending*           pendingTail;
+	MockPending*           pendingFree;  ///< Recycled queue entries
+	mrcp_message_t*        active;       ///< SPEAK, RECOGNIZE or RECORD in progress
+	bool                   started;      ///< Its IN-PROGRESS response sent, the audio runs
+	apr_uint64_t           activeFrom;   ///< Clock when the response was sent
+	apr_uint32_t           audioFrames;  ///< Audio produced or consumed for it
+	bool                   inputStarted; ///< START-OF-INPUT sent
+	apr_uint32_t           phase;        ///< Tone phase, table index in the top bits
+	apr_uint32_t           step;         ///< Phase increment per sample
+	apr_uint64_t           consumed;     ///< Bytes of incoming audio
+};
+
+
+/** @brief Work for the engine task */
+enum MockTaskMsgType {
+	MOCK_MSG_SCHEDULE, ///< First message queued, set the timer
+	MOCK_MSG_CLOSE     ///< Kill the timer and respond the channel close
+};
+
+struct MockTaskMsg {
+	MockTaskMsgType type;
+	MockChannel*    channel;
+};
+
+static apt_bool_t MockTaskMsgProcess(apt_task_t* task, apt_task_msg_t* msg);
+static void MockTimerProc(apt_timer_t* timer, void* obj);
+
+static apt_bool_t MockEngineDestroy(mrcp_engine_t* engine);
+static apt_bool_t MockEngineOpen(mrcp_engine_t* engine);
+static apt_bool_t MockEngineClose(mrcp_engine_t* engine);
+static mrcp_engine_channel_t* MockChannelCreate(mrcp_engine_t* engine, apr_pool_t* pool);
+
+static struct mrcp_engine_method_vtable_t const engine_vtable = {
+	MockEngineDestroy,
+	MockEngineOpen,
+	MockEngineClose,
+	MockChannelCreate
+};
+
+static apt_bool_t MockChannelDestroy(mrcp_engine_channel_t* channel);
+static apt_bool_t MockChannelOpen(mrcp_engine_channel_t* channel);
+static apt_bool_t MockChannelClose(mrcp_engine_channel_t* channel);
+static apt_bool_t MockChannelRequest(mrcp_engine_channel_t* channel, mrcp_message_t* request);
+
+static struct mrcp_engine_channel_method_vtable_t const channel_vtable = {
+	MockChannelDestroy,
+	MockChannelOpen,
+	MockChannelClose,
+	MockChannelRequest
+};
+
+static apt_bool_t MockStreamDestroy(mpf_audio_stream_t* stream);
+static apt_bool_t MockStreamOpen(mpf_audio_stream_t* stream, mpf_codec_t* codec);
+static apt_bool_t MockStreamClose(mpf_audio_stream_t* stream);
+static apt_bool_t MockStreamRead(mpf_audio_stream_t* stream, mpf_frame_t* frame);
+static apt_bool_t MockStreamWrite(mpf_audio_stream_t* stream, mpf_frame_t const* frame);
+
+/** @brief Synthesizer produces audio */
+static mpf_audio_stream_vtable_t const source_vtable = {
+	MockStreamDestroy,
+	MockStreamOpen,
+	MockStreamClose,
+	MockStreamRead,
+	NULL,
+	NULL,
+	NULL
+};
+
+/** @brief Recognizer and recorder consume audio */
+static mpf_audio_stream_vtable_t const sink_vtable = {
+	MockStreamDestroy,
+	NULL,
+	NULL,
+	NULL,
+	MockStreamOpen,
+	MockStreamClose,
+	MockStreamWrite
+};
+
+
+extern "C" {
+
+MRCP_PLUGIN_VERSION_DECLARE
+
+MRCP_PLUGIN_DECLARE(mrcp_engine_t*) mrcp_plugin_create(apr_pool_t* pool)
+{
+	MockEngine* mock = static_cast<MockEngine*>(apr_pcalloc(pool, sizeof(MockEngine)));
+	apt_task_msg_pool_t* msg_pool = apt_task_msg_pool_create_dynamic(sizeof(MockTaskMsg), pool);
+	mock->task = apt_consumer_task_create(mock, msg_pool, pool);
+	if (!mock->task)
+		return NULL;
+	apt_task_t* task = apt_consumer_task_base_get(mock->task);
+	apt_task_name_set(task, "Mock Engine");
+	apt_task_vtable_t* vtable = apt_task_vtable_get(task);
+	if (vtable)
+		vtable->process_msg = MockTaskMsgProcess;
+	return mrcp_engine_create(MOCK_RESOURCE, mock, &engine_vtable, pool);
+}
+
+}
+
+
+static apt_bool_t MockEngineDestroy(mrcp_engine_t* engine)
+{
+	MockEngine* mock = static_cast<MockEngine*>(engine->obj);
+	apt_task_destroy(apt_consumer_task_base_get(mock->task));
+	return TRUE;
+}
+
+
+/** @brief Duration parameter in frames, at least one */
+static apr_uint32_t MockFrames(mrcp_engine_t* engine, char const* name, unsigned long def_ms)
+{
+	char const* val = mrcp_engine_param_get(engine, name);
+	unsigned long ms = val ? strtoul(val, NULL, 10) : def_ms;
+	apr_uint32_t frames = static_cast<apr_uint32_t>((ms + MOCK_FRAME_MS - 1) / MOCK_FRAME_MS);
+	return frames ? frames : 1;
+}
+
+
+static apt_bool_t MockEngineOpen(mrcp_engine_t* engine)
+{
+	MockEngine* mock = static_cast<MockEngine*>(engine->obj);
+	char const* val = mrcp_engine_param_get(engine, "response-delay");
+	/* 0 means immediately, unlike the other durations */
+	mock->responseMs = val ? static_cast<apr_uint32_t>(strtoul(val, NULL, 10)) : 0;
+	mock->speakFrames = MockFrames(engine, "speak-duration", 1000);
+	mock->inputFrames = MockFrames(engine, "start-of-input", 100);
+	mock->recognizeFrames = MockFrames(engine, "recognize-duration", 1000);
+	mock->recordFrames = MockFrames(engine, "record-duration", 1000);
+	mock->noInputFrames = MockFrames(engine, "noinput-timeout", 5000);
+	val = mrcp_engine_param_get(engine, "tone");
+	mock->toneHz = val ? static_cast<unsigned>(strtoul(val, NULL, 10)) : 440;
+	mock->result = mrcp_engine_param_get(engine, "result");
+	for (unsigned i = 0; i < (1 << MOCK_SINE_BITS); i++)
+		mock->sine[i] = static_cast<apr_int16_t>(8000 * sin(2 * MOCK_PI * i / (1 << MOCK_SINE_BITS)));
+	apt_log(APT_LOG_MARK, APT_PRIO_INFO, "Mock engine opened: resource(%d) response(%u ms) speak(%u) "
+		"recognize(%u) record(%u) frames", static_cast<int>(MOCK_RESOURCE), mock->responseMs,
+		mock->speakFrames, mock->recognizeFrames, mock->recordFrames);
+	apt_task_start(apt_consumer_task_base_get(mock->task));
+	return mrcp_engine_open_respond(engine, TRUE);
+}
+
+
+static apt_bool_t MockEngineClose(mrcp_engine_t* engine)
+{
+	MockEngine* mock = static_cast<MockEngine*>(engine->obj);
+	apt_task_terminate(apt_consumer_task_base_get(mock->task), TRUE);
+	return mrcp_engine_close_respond(engine);
+}
+
+
+static mrcp_engine_channel_t* MockChannelCreate(mrcp_engine_t* engine, apr_pool_t* pool)
+{
+	MockChannel* mc = static_cast<MockChannel*>(apr_pcalloc(pool, sizeof(MockChannel)));
+	mc->engine = static_cast<MockEngine*>(engine->obj);
+	mc->pool = pool;
+	mc->timer = apt_task_timer_create(apt_consumer_task_base_get(mc->engine->task), MockTimerProc, mc, pool);
+	if (!mc->timer || (apr_thread_mutex_create(&mc->mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS))
+		return NULL;
+	mpf_stream_capabilities_t* caps;
+	mpf_audio_stream_vtable_t const* vtable;
+	if (MOCK_RESOURCE == MRCP_SYNTHESIZER_RESOURCE) {
+		caps = mpf_source_stream_capabilities_create(pool);
+		vtable = &source_vtable;
+	} else {
+		caps = mpf_sink_stream_capabilities_create(pool);
+		vtable = &sink_vtable;
+	}
+	mpf_codec_capabilities_add(&caps->codecs, MPF_SAMPLE_RATE_8000 | MPF_SAMPLE_RATE_16000, "LPCM");
+	mpf_termination_t* term = mrcp_engine_audio_termination_create(mc, vtable, caps, pool);
+	mc->channel = mrcp_engine_channel_create(engine, &channel_vtable, mc, term, pool);
+	return mc->channel;
+}
+
+
+static apt_bool_t MockChannelDestroy(mrcp_engine_channel_t* channel)
+{
+	MockChannel* mc = static_cast<MockChannel*>(channel->method_obj);
+	apr_thread_mutex_destroy(mc->mutex);
+	return TRUE;
+}
+
+
+static apt_bool_t MockChannelOpen(mrcp_engine_channel_t* channel)
+{
+	MockChannel* mc = static_cast<MockChannel*>(channel->method_obj);
+	mpf_codec_descriptor_t* desc = (MOCK_RESOURCE == MRCP_SYNTHESIZER_RESOURCE) ?
+		mrcp_engine_source_stream_codec_get(channel) : mrcp_engine_sink_stream_codec_get(channel);
+	if (desc && desc->sampling_rate)
+		mc->step = static_cast<apr_uint32_t>(4294967296.0 * mc->engine->toneHz / desc->sampling_rate);
+	return mrcp_engine_channel_open_respond(channel, TRUE);
+}
+
+
+/** @brief Pass work to the engine task */
+static bool MockSignal(MockChannel* mc, MockTaskMsgType type)
+{
+	apt_task_t* task = apt_consumer_task_base_get(mc->engine->task);
+	apt_task_msg_t* msg = apt_task_msg_get(task);
+	if (!msg)
+		return false;
+	msg->type = TASK_MSG_USER;
+	MockTaskMsg* mock_msg = reinterpret_cast<MockTaskMsg*>(msg->data);
+	mock_msg->type = type;
+	mock_msg->channel = mc;
+	return apt_task_msg_signal(task, msg) == TRUE;
+}
+
+
+static apt_bool_t MockChannelClose(mrcp_engine_channel_t* channel)
+{
+	MockChannel* mc = static_cast<MockChannel*>(channel->method_obj);
+	apr_thread_mutex_lock(mc->mutex);
+	/* Not sent anymore */
+	if (mc->pendingHead) {
+		mc->pendingTail->next = mc->pendingFree;
+		mc->pendingFree = mc->pendingHead;
+		mc->pendingHead = mc->pendingTail = NULL;
+	}
+	mc->active = NULL;
+	apr_thread_mutex_unlock(mc->mutex);
+	/* The timer belongs to the engine task, the channel is gone once closed */
+	if (MockSignal(mc, MOCK_MSG_CLOSE))
+		return TRUE;
+	return mrcp_engine_channel_close_respond(channel);
+}
+
+
+/** @brief Send the message, the audio of the active request starts with its response. Mutex held. */
+static void MockDeliver(MockChannel* mc, mrcp_message_t* msg)
+{
+	if (mc->active && (msg->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) &&
+		(msg->start_line.request_id == mc->active->start_line.request_id))
+	{
+		mc->started = true;
+		mc->activeFrom = mc->clock;
+	}
+	mrcp_engine_channel_message_send(mc->channel, msg);
+}
+
+
+/** @brief Send now or after the delay, in order with messages already delayed. Mutex held. */
+static void MockSend(MockChannel* mc, mrcp_message_t* msg, apr_uint32_t delay_ms)
+{
+	if (!delay_ms && !mc->pendingHead) {
+		MockDeliver(mc, msg);
+		return;
+	}
+	MockPending* p = mc->pendingFree;
+	if (p)
+		mc->pendingFree = p->next;
+	else
+		p = static_cast<MockPending*>(apr_palloc(mc->pool, sizeof(MockPending)));
+	p->message = msg;
+	p->due = apr_time_now() + apr_time_from_msec(delay_ms);
+	p->next = NULL;
+	if (mc->pendingTail) {
+		mc->pendingTail->next = p;
+		mc->pendingTail = p;
+		return;
+	}
+	mc->pendingHead = mc->pendingTail = p;
+	if (!MockSignal(mc, MOCK_MSG_SCHEDULE))
+		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Mock engine cannot schedule a response");
+}
+
+
+/** @brief Send messages due, set the timer for the next one. Engine task, mutex held. */
+static void MockFlush(MockChannel* mc)
+{
+	apr_time_t now = apr_time_now();
+	while (mc->pendingHead && (mc->pendingHead->due <= now)) {
+		MockPending* p = mc->pendingHead;
+		mc->pendingHead = p->next;
+		if (!mc->pendingHead)
+			mc->pendingTail = NULL;
+		MockDeliver(mc, p->message);
+		p->next = mc->pendingFree;
+		mc->pendingFree = p;
+	}
+	if (mc->pendingHead) {
+		apr_interval_time_t wait = mc->pendingHead->due - now;
+		apt_timer_set(mc->timer, static_cast<apr_uint32_t>((wait + 999) / 1000));
+	}
+}
+
+
+static void MockTimerProc(apt_timer_t* timer, void* obj)
+{
+	(void) timer;
+	MockChannel* mc = static_cast<MockChannel*>(obj);
+	apr_thread_mutex_lock(mc->mutex);
+	MockFlush(mc);
+	apr_thread_mutex_unlock(mc->mutex);
+}
+
+
+static apt_bool_t MockTaskMsgProcess(apt_task_t* task, apt_task_msg_t* msg)
+{
+	(void) task;
+	MockTaskMsg const* mock_msg = reinterpret_cast<MockTaskMsg const*>(msg->data);
+	MockChannel* mc = mock_msg->channel;
+	switch (mock_msg->type) {
+	case MOCK_MSG_SCHEDULE:
+		apr_thread_mutex_lock(mc->mutex);
+		MockFlush(mc);
+		apr_thread_mutex_unlock(mc->mutex);
+		break;
+	case MOCK_MSG_CLOSE:
+		apt_timer_kill(mc->timer);
+		mrcp_engine_channel_close_respond(mc->channel);
+		break;
+	}
+	return TRUE;
+}
+
+
+static mrcp_message_t* MockResponse(mrcp_message_t* request, mrcp_request_state_e state, mrcp_status_code_e status)
+{
+	mrcp_message_t* response = mrcp_response_create(request, request->pool);
+	response->start_line.request_state = state;
+	response->start_line.status_code = status;
+	return response;
+}
+
+
+/** @brief Event of the active request, the request completes with it if cause >= 0. Mutex held. */
+static void MockEvent(MockChannel* mc, mrcp_method_id event_id, int cause, char const* body = NULL)
+{
+	mrcp_message_t* req = mc->active;
+	mrcp_message_t* msg = mrcp_event_create(req, event_id, req->pool);
+	if (!msg)
+		return;
+	if (cause < 0) {
+		msg->start_line.request_state = MRCP_REQUEST_STATE_INPROGRESS;
+		MockSend(mc, msg, 0);
+		return;
+	}
+	msg->start_line.request_state = MRCP_REQUEST_STATE_COMPLETE;
+	if (MOCK_RESOURCE == MRCP_SYNTHESIZER_RESOURCE) {
+		mrcp_synth_header_t* h = static_cast<mrcp_synth_header_t*>(mrcp_resource_header_prepare(msg));
+		h->completion_cause = static_cast<mrcp_synth_completion_cause_e>(cause);
+		mrcp_resource_header_property_add(msg, SYNTHESIZER_HEADER_COMPLETION_CAUSE);
+	} else if (MOCK_RESOURCE == MRCP_RECOGNIZER_RESOURCE) {
+		mrcp_recog_header_t* h = static_cast<mrcp_recog_header_t*>(mrcp_resource_header_prepare(msg));
+		h->completion_cause = static_cast<mrcp_recog_completion_cause_e>(cause);
+		mrcp_resource_header_property_add(msg, RECOGNIZER_HEADER_COMPLETION_CAUSE);
+	} else {
+		mrcp_recorder_header_t* h = static_cast<mrcp_recorder_header_t*>(mrcp_resource_header_prepare(msg));
+		h->completion_cause = static_cast<mrcp_recorder_completion_cause_e>(cause);
+		mrcp_resource_header_property_add(msg, RECORDER_HEADER_COMPLETION_CAUSE);
+	}
+	if (body) {
+		mrcp_generic_header_t* g = mrcp_generic_header_prepare(msg);
+		apt_string_assign(&g->content_type, "application/nlsml+xml", msg->pool);
+		mrcp_generic_header_property_add(msg, GENERIC_HEADER_CONTENT_TYPE);
+		apt_string_assign(&msg->body, body, msg->pool);
+	}
+	MockSend(mc, msg, 0);
+	mc->active = NULL;
+}
+
+
+/** @brief Start SPEAK, RECOGNIZE or RECORD. Mutex held. */
+static void MockStart(MockChannel* mc, mrcp_message_t* request)
+{
+	if (mc->active) {
+		MockSend(mc, MockResponse(request, MRCP_REQUEST_STATE_COMPLETE, MRCP_STATUS_CODE_METHOD_NOT_VALID),
+			mc->engine->responseMs);
+		return;
+	}
+	mc->active = request;
+	mc->started = false;
+	mc->audioFrames = 0;
+	mc->inputStarted = false;
+	MockSend(mc, MockResponse(request, MRCP_REQUEST_STATE_INPROGRESS, MRCP_STATUS_CODE_SUCCESS),
+		mc->engine->responseMs);
+}
+
+
+/** @brief STOP the active request, no completion event follows. Mutex held. */
+static void MockStop(MockChannel* mc, mrcp_message_t* request)
+{
+	mrcp_message_t* response = MockResponse(request, MRCP_REQUEST_STATE_COMPLETE, MRCP_STATUS_CODE_SUCCESS);
+	if (mc->active) {
+		mrcp_generic_header_t* g = mrcp_generic_header_prepare(response);
+		g->active_request_id_list.ids[0] = mc->active->start_line.request_id;
+		g->active_request_id_list.count = 1;
+		mrcp_generic_header_property_add(response, GENERIC_HEADER_ACTIVE_REQUEST_ID_LIST);
+		mc->active = NULL;
+	}
+	MockSend(mc, response, mc->engine->responseMs);
+}
+
+
+static apt_bool_t MockChannelRequest(mrcp_engine_channel_t* channel, mrcp_message_t* request)
+{
+	MockChannel* mc = static_cast<MockChannel*>(channel->method_obj);
+	mrcp_method_id method = request->start_line.method_id;
+	apr_thread_mutex_lock(mc->mutex);
+	if (((MOCK_RESOURCE == MRCP_SYNTHESIZER_RESOURCE) && (method == SYNTHESIZER_SPEAK)) ||
+		((MOCK_RESOURCE == MRCP_RECOGNIZER_RESOURCE) && (method == RECOGNIZER_RECOGNIZE)) ||
+		((MOCK_RESOURCE == MRCP_RECORDER_RESOURCE) && (method == RECORDER_RECORD)))
+		MockStart(mc, request);
+	else if (((MOCK_RESOURCE == MRCP_SYNTHESIZER_RESOURCE) && (method == SYNTHESIZER_STOP)) ||
+		((MOCK_RESOURCE == MRCP_RECOGNIZER_RESOURCE) && (method == RECOGNIZER_STOP)) ||
+		((MOCK_RESOURCE == MRCP_RECORDER_RESOURCE) && (method == RECORDER_STOP)))
+		MockStop(mc, request);
+	else
+		/* DEFINE-GRAMMAR, SET-PARAMS and the rest just succeed */
+		MockSend(mc, MockResponse(request, MRCP_REQUEST_STATE_COMPLETE, MRCP_STATUS_CODE_SUCCESS),
+			mc->engine->responseMs);
+	apr_thread_mutex_unlock(mc->mutex);
+	return TRUE;
+}
+
+
+static apt_bool_t MockStreamDestroy(mpf_audio_stream_t* stream)
+{
+	(void) stream;
+	return TRUE;
+}
+
+
+static apt_bool_t MockStreamOpen(mpf_audio_stream_t* stream, mpf_codec_t* codec)
+{
+	(void) stream;
+	(void) codec;
+	return TRUE;
+}
+
+
+static apt_bool_t MockStreamClose(mpf_audio_stream_t* stream)
+{
+	(void) stream;
+	return TRUE;
+}
+
+
+/** @brief Synthesizer: tone while SPEAK is in progress */
+static apt_bool_t MockStreamRead(mpf_audio_stream_t* stream, mpf_frame_t* frame)
+{
+	MockChannel* mc = static_cast<MockChannel*>(stream->obj);
+	apr_thread_mutex_lock(mc->mutex);
+	mc->clock++;
+	if (mc->active && mc->started) {
+		apr_int16_t* samples = static_cast<apr_int16_t*>(frame->codec_frame.buffer);
+		apr_size_t count = frame->codec_frame.size / sizeof(apr_int16_t);
+		MockEngine const* mock = mc->engine;
+		if (mock->toneHz) {
+			for (apr_size_t i = 0; i < count; i++) {
+				samples[i] = mock->sine[mc->phase >> (32 - MOCK_SINE_BITS)];
+				mc->phase += mc->step;
+			}
+		} else
+			memset(samples, 0, count * sizeof(apr_int16_t));
+		frame->type |= MEDIA_FRAME_TYPE_AUDIO;
+		if (++mc->audioFrames >= mock->speakFrames)
+			MockEvent(mc, SYNTHESIZER_SPEAK_COMPLETE, SYNTHESIZER_COMPLETION_CAUSE_NORMAL);
+	}
+	apr_thread_mutex_unlock(mc->mutex);
+	return TRUE;
+}
+
+
+/** @brief Recognizer and recorder: count audio while the request is in progress */
+static apt_bool_t MockStreamWrite(mpf_audio_stream_t* stream, mpf_frame_t const* frame)
+{
+	MockChannel* mc = static_cast<MockChannel*>(stream->obj);
+	apr_thread_mutex_lock(mc->mutex);
+	mc->clock++;
+	if (mc->active && mc->started) {
+		MockEngine const* mock = mc->engine;
+		bool recog = MOCK_RESOURCE == MRCP_RECOGNIZER_RESOURCE;
+		if (frame->type & MEDIA_FRAME_TYPE_AUDIO) {
+			mc->audioFrames++;
+			mc->consumed += frame->codec_frame.size;
+		}
+		if (!mc->inputStarted && (mc->audioFrames >= mock->inputFrames)) {
+			mc->inputStarted = true;
+			MockEvent(mc, recog ? static_cast<mrcp_method_id>(RECOGNIZER_START_OF_INPUT) :
+				static_cast<mrcp_method_id>(RECORDER_START_OF_INPUT), -1);
+		}
+		bool noInput = !mc->inputStarted && (mc->clock - mc->activeFrom >= mock->noInputFrames);
+		if (recog) {
+			if (mc->audioFrames >= mock->recognizeFrames)
+				MockEvent(mc, RECOGNIZER_RECOGNITION_COMPLETE, RECOGNIZER_COMPLETION_CAUSE_SUCCESS, mock->result ? mock->result :
+					mc->active->start_line.version == MRCP_VERSION_1 ? MOCK_RESULT_V1 : MOCK_RESULT);
+			else if (noInput)
+				MockEvent(mc, RECOGNIZER_RECOGNITION_COMPLETE, RECOGNIZER_COMPLETION_CAUSE_NO_INPUT_TIMEOUT);
+		} else {
+			if (mc->audioFrames >= mock->recordFrames)
+				MockEvent(mc, RECORDER_RECORD_COMPLETE, RECORDER_COMPLETION_CAUSE_SUCCESS_SILENCE);
+			else if (noInput)
+				MockEvent(mc, RECORDER_RECORD_COMPLETE, RECORDER_COMPLETION_CAUSE_NO_INPUT_TIMEOUT);
+		}
+	}
+	apr_thread_mutex_unlock(mc->mutex);
+	return TRUE;
+}
@@ -0,0 +1,294 @@
+/*
+ * Load generator: keeps many recognizer and synthesizer sessions running
+ * through the wrapper and reports throughput, latency, audio underruns and
+ * process resource usage.
+ *
+ * Every session adds one channel, sends one RECOGNIZE (audio streamed from
+ * memory) or SPEAK, waits for its completion, holds for a while and is then
+ * terminated, destroyed once terminated and replaced. New sessions start
+ * at most at the ramp rate.
+ *
+ * Usage: UniLoad [options], see Usage() below
+ */
+
+#include "LoadCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+
+struct RampConfig : public LoadConfig {
+	double             rate;          // New sessions per second
+	unsigned long      holdMs;        // Session kept after completion
+};
+
+
+/** Totals of the run, kept by the main loop */
+struct LoadCounters {
+	unsigned long started;
+	unsigned long rejected;    // Session creation threw
+	unsigned long completed;
+	unsigned long failed;
+	unsigned long timedOut;
+	unsigned long framesRequested;
+	unsigned long framesStarved;
+	unsigned long starvationRuns;
+	unsigned long longestRun;
+};
+
+
+/** Count a session finished and close it, deleted once terminated */
+static void Reap(LoadSession* s, LoadCounters& cnt, std::vector<LoadSession*>& closing)
+{
+	if (s->recog) {
+		UniMRCPRxStats rx;
+		s->GetRxStats(rx);
+		cnt.framesRequested += rx.requested;
+		cnt.framesStarved += rx.starved;
+		cnt.starvationRuns += rx.runs;
+		if (rx.longestRun > cnt.longestRun)
+			cnt.longestRun = rx.longestRun;
+	}
+	closing.push_back(s);
+}
+
+
+/** Close sessions done and held, failed or timed out (all of them at the end) */
+static void ReapSessions(std::vector<LoadSession*>& live, std::vector<LoadSession*>& closing,
+                         RampConfig const& cfg, LoadCounters& cnt, bool all)
+{
+	apr_time_t now = apr_time_now();
+	size_t j = 0;
+	for (size_t i = 0; i < live.size(); i++) {
+		LoadSession* s = live[i];
+		LoadSession::State st = s->GetState();
+		if ((st == LoadSession::ST_DONE) && !s->doneAt)
+			s->doneAt = now;
+		if (st == LoadSession::ST_FAILED) {
+			cnt.failed++;
+		} else if (st == LoadSession::ST_DONE) {
+			if (!all && (now - s->doneAt < static_cast<apr_time_t>(cfg.holdMs) * 1000)) {
+				live[j++] = s;
+				continue;
+			}
+			cnt.completed++;
+		} else if (all || (now - s->createdAt >= static_cast<apr_time_t>(cfg.timeoutMs) * 1000)) {
+			cnt.timedOut++;
+		} else {
+			live[j++] = s;
+			continue;
+		}
+		Reap(s, cnt, closing);
+	}
+	live.resize(j);
+	CloseSessions(closing, cfg.timeoutMs);
+}
+
+
+static void PrintLatency(char const* name, UniMRCPLatencyPhase phase, UniMRCPResource resource, unsigned id)
+{
+	UniMRCPLatencyStats st;
+	UniMRCPClient::GetLatency(phase, resource, id, st);
+	if (!st.count)
+		return;
+	printf("  %-22s %8lu %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, static_cast<unsigned long>(st.count),
+		st.p50Us / 1000.0, st.p90Us / 1000.0, st.p99Us / 1000.0, st.p999Us / 1000.0, st.maxUs / 1000.0);
+}
+
+
+static void PrintSummary(RampConfig const& cfg, LoadCounters const& cnt, double seconds, double cpu)
+{
+	printf("\nSessions: started %lu, completed %lu, failed %lu, timed out %lu, rejected %lu\n",
+		cnt.started, cnt.completed, cnt.failed, cnt.timedOut, cnt.rejected);
+	printf("Throughput: %.2f sessions/s completed over %.1f s\n",
+		seconds > 0 ? cnt.completed / seconds : 0.0, seconds);
+	printf("CPU: %.1f s (%.1f %%), RSS: %lu kB\n",
+		cpu, seconds > 0 ? cpu * 100 / seconds : 0.0, RssKB());
+
+	printf("\nLatency (ms)               count       p50       p90       p99     p99.9       max\n");
+	PrintLatency("session setup", LATENCY_SESSION_UPDATE, MRCP_RECOGNIZER, 0);
+	if (cfg.recogPercent) {
+		PrintLatency("recognizer add", LATENCY_CHANNEL_ADD, MRCP_RECOGNIZER, 0);
+		PrintLatency("DEFINE-GRAMMAR", LATENCY_RESPONSE, MRCP_RECOGNIZER, RECOGNIZER_DEFINE_GRAMMAR);
+		PrintLatency("RECOGNIZE response", LATENCY_RESPONSE, MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE);
+		PrintLatency("RECOGNIZE complete", LATENCY_COMPLETE, MRCP_RECOGNIZER, RECOGNIZER_RECOGNIZE);
+	}
+	if (cfg.recogPercent < 100) {
+		PrintLatency("synthesizer add", LATENCY_CHANNEL_ADD, MRCP_SYNTHESIZER, 0);
+		PrintLatency("SPEAK response", LATENCY_RESPONSE, MRCP_SYNTHESIZER, SYNTHESIZER_SPEAK);
+		PrintLatency("SPEAK complete", LATENCY_COMPLETE, MRCP_SYNTHESIZER, SYNTHESIZER_SPEAK);
+		PrintLatency("first audio", LATENCY_FIRST_AUDIO, MRCP_SYNTHESIZER, 0);
+		PrintLatency("frame jitter", LATENCY_FRAME_JITTER, MRCP_SYNTHESIZER, 0);
+	}
+
+	if (cfg.recogPercent) {
+		UniMRCPMetricsSnapshot m;
+		UniMRCPClient::GetMetrics(m);
+		printf("\nRecognizer audio: %lu frames requested, %lu starved (%.3f %%) in %lu runs, longest %lu\n",
+			cnt.framesRequested, cnt.framesStarved,
+			cnt.framesRequested ? cnt.framesStarved * 100.0 / cnt.framesRequested : 0.0,
+			cnt.starvationRuns, cnt.longestRun);
+		printf("Underruns of all streams (including paused): %lu\n",
+			static_cast<unsigned long>(m.Get(METRIC_UNDERRUNS)));
+	}
+}
+
+
+static void Usage(char const* prog)
+{
+	printf("Usage: %s [options]\n"
+		"\t-r dir     UniMRCP client root directory\n"
+		"\t-p name    MRCP profile or profile group (uni2)\n"
+		"\t-c n       Concurrent sessions (10)\n"
+		"\t-R rate    New sessions per second (5)\n"
+		"\t-m pct     Recognizer sessions in percent, the rest synthesizer (50)\n"
+		"\t-g file    Recognizer grammar (SRGS XML)\n"
+		"\t-a file    Recognizer input audio (raw 8 kHz LPCM)\n"
+		"\t-s text    Text to synthesize\n"
+		"\t-H ms      Hold time after the request completes (1000)\n"
+		"\t-T ms      Session timeout from creation to completion (30000)\n"
+		"\t-d s       Test duration (60)\n"
+		"\t-i s       Report interval (5)\n"
+		"\t-w n       Callback dispatcher threads, 0 for the client task (0)\n"
+		"\t-l prio    Log priority 0-7 (3)\n", prog);
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	RampConfig cfg;
+	LoadConfigInit(cfg);
+	cfg.rate = 5;
+	cfg.holdMs = 1000;
+	for (int i = 1; i < argc; i++) {
+		char const* opt = argv[i];
+		if ((opt[0] != '-') || !opt[1] || opt[2] || (i + 1 >= argc)) {
+			Usage(argv[0]);
+			return 1;
+		}
+		char const* val = argv[++i];
+		switch (opt[1]) {
+		case 'R': cfg.rate = strtod(val, NULL); break;
+		case 'H': cfg.holdMs = strtoul(val, NULL, 10); break;
+		default:
+			if (!LoadConfigOption(cfg, opt[1], val)) {
+				Usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+	if (!cfg.sessions || (cfg.rate <= 0) || (cfg.recogPercent > 100) || !cfg.intervalS) {
+		Usage(argv[0]);
+		return 1;
+	}
+	std::string grammar;
+	if (!LoadInputs(cfg, grammar))
+		return 1;
+
+	unsigned short major, minor, patch;
+	UniMRCPClient::WrapperVersion(major, minor, patch);
+	printf("UniMRCP wrapper %u.%u.%u load generator\n"
+		"Root dir %s, profile %s, %u sessions at %.1f/s, %u %% recognizer, hold %lu ms, %lu s\n",
+		major, minor, patch, cfg.rootDir, cfg.profile, cfg.sessions, cfg.rate,
+		cfg.recogPercent, cfg.holdMs, cfg.durationS);
+
+	LoadLogger logger;
+	try {
+		UniMRCPClient::StaticInitialize(&logger, cfg.logPrio);
+	} catch (UniMRCPException const& ex) {
+		printf("Unable to initialize platform: %s\n", ex.msg);
+		return 1;
+	}
+
+	int ret = 0;
+	try {
+		UniMRCPClient client(cfg.rootDir, true);
+		if (cfg.threads)
+			client.StartDispatcher(cfg.threads);
+		if (cfg.recogPercent)
+			cfg.grammarId = UniMRCPRecognizerChannel::RegisterGrammar("application/srgs+xml", grammar.c_str());
+
+		std::vector<LoadSession*> live;
+		std::vector<LoadSession*> closing;
+		LoadCounters cnt;
+		memset(&cnt, 0, sizeof(cnt));
+		apr_time_t const tick = 10000;
+		apr_time_t start = apr_time_now();
+		apr_time_t end = start + static_cast<apr_time_t>(cfg.durationS) * APR_USEC_PER_SEC;
+		apr_time_t last = start;
+		apr_time_t nextReport = start + static_cast<apr_time_t>(cfg.intervalS) * APR_USEC_PER_SEC;
+		unsigned long lastCompleted = 0;
+		double cpuStart = CpuSeconds();
+		double lastCpu = cpuStart;
+		// Sessions allowed to start, refilled at the ramp rate, short bursts only
+		double credit = 1;
+		double const maxCredit = cfg.rate * tick / APR_USEC_PER_SEC > 1 ? cfg.rate * tick / APR_USEC_PER_SEC : 1;
+
+		printf("\n    time   live  started  completed  failed  timeout  sess/s   cpu %%   rss kB\n");
+		for (;;) {
+			apr_time_t now = apr_time_now();
+			if ((now >= end) && live.empty() && closing.empty())
+				break;
+			// Finishing sessions may take up to the timeout
+			if (now >= end + static_cast<apr_time_t>(cfg.timeoutMs + cfg.holdMs) * 1000) {
+				ReapSessions(live, closing, cfg, cnt, true);
+				while (!closing.empty()) {
+					apr_sleep(tick);
+					CloseSessions(closing, cfg.timeoutMs);
+				}
+				break;
+			}
+			ReapSessions(live, closing, cfg, cnt, false);
+
+			credit += cfg.rate * static_cast<double>(now - last) / APR_USEC_PER_SEC;
+			if (credit > maxCredit)
+				credit = maxCredit;
+			last = now;
+			while ((now < end) && (credit >= 1) && (live.size() < cfg.sessions)) {
+				credit -= 1;
+				// Spread resources evenly by the ratio
+				bool recog = (cnt.started + 1) * cfg.recogPercent / 100 != cnt.started * cfg.recogPercent / 100;
+				cnt.started++;
+				try {
+					live.push_back(new LoadSession(&client, cfg, recog));
+				} catch (UniMRCPException const& ex) {
+					cnt.rejected++;
+					if (cnt.rejected == 1)
+						fprintf(stderr, "Cannot create session: %s\n", ex.msg);
+				}
+			}
+
+			if (now >= nextReport) {
+				double cpu = CpuSeconds();
+				double interval = static_cast<double>(cfg.intervalS);
+				printf("%8.1f %6u %8lu %10lu %7lu %8lu %7.1f %7.1f %8lu\n",
+					static_cast<double>(now - start) / APR_USEC_PER_SEC, static_cast<unsigned>(live.size()),
+					cnt.started, cnt.completed, cnt.failed + cnt.rejected, cnt.timedOut,
+					(cnt.completed - lastCompleted) / interval, (cpu - lastCpu) * 100 / interval, RssKB());
+				fflush(stdout);
+				lastCompleted = cnt.completed;
+				lastCpu = cpu;
+				nextReport += static_cast<apr_time_t>(cfg.intervalS) * APR_USEC_PER_SEC;
+			}
+			apr_sleep(tick);
+		}
+		double seconds = static_cast<double>(apr_time_now() - start) / APR_USEC_PER_SEC;
+		PrintSummary(cfg, cnt, seconds, CpuSeconds() - cpuStart);
+		if (cnt.failed || cnt.timedOut || cnt.rejected)
+			ret = 2;
+	} catch (UniMRCPException const& ex) {
+		printf("A UniMRCP error occured: %s\n", ex.msg);
+		ret = 1;
+	} catch (std::exception const& ex) {
+		printf("An exception occured: %s\n", ex.what());
+		ret = 1;
+	}
+	try {
+		UniMRCPClient::StaticDeinitialize();
+	} catch (UniMRCPException const& ex) {
+		printf("Failed to deinitialize platform: %s\n", ex.msg);
+	}
+	return ret;
+}
@@ -0,0 +1,392 @@
+/*
+ * Soak test: cycles sessions, channels, requests and streams through the
+ * wrapper for hours and fails if memory grows with the work done.
+ *
+ * Every session adds one recognizer or synthesizer channel, sends a number
+ * of RECOGNIZE (audio streamed from memory) or SPEAK requests one after
+ * another and is then terminated, destroyed once terminated and replaced.
+ * Run it against a local server, e.g. with the mock engines (BUILD_MOCK_ENGINE),
+ * so that the server is cheap and deterministic.
+ *
+ * Periodic samples record resident set size, wrapper object counts (metric
+ * gauges), wrapper bytes in the session pools of live sessions and the log
+ * queue. After the warm-up, the slope of RSS over completed requests is the
+ * growth per operation. Within sessions, the growth of the session pool
+ * between the first and the last request is the growth per request.
+ *
+ * Exit code: 0 passed, 1 error, 2 requests failed or timed out,
+ * 3 growth over the limits or objects left after all sessions were destroyed.
+ *
+ * Usage: UniSoak [options], see Usage() below
+ */
+
+#include "LoadCommon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__SANITIZE_ADDRESS__)
+#	define SOAK_ASAN 1
+#elif defined(__has_feature)
+#	if __has_feature(address_sanitizer)
+#		define SOAK_ASAN 1
+#	endif
+#endif
+
+
+struct SoakConfig : public LoadConfig {
+	unsigned long      warmupS;       // Samples ignored by the growth check
+	double             maxGrowth;     // RSS bytes per request, 0 not checked
+	double             maxPoolGrowth; // Session pool bytes per request besides messages, negative not checked
+};
+
+
+/** Totals of the run, kept by the main loop */
+struct SoakCounters {
+	unsigned long started;
+	unsigned long rejected;       // Session creation threw
+	unsigned long completed;      // Sessions with all requests done
+	unsigned long failed;
+	unsigned long timedOut;
+	unsigned long requests;       // Requests completed by reaped sessions
+	double        poolGrowthSum;  // Session pool bytes per request, sum over sessions
+	double        poolGrowthMax;
+	unsigned long poolSessions;   // Sessions the growth was measured on
+};
+
+
+/** State of the process at one moment */
+struct SoakSample {
+	double             seconds;
+	unsigned long      requests;      // Completed so far, including live sessions
+	unsigned long      rssKB;
+	unsigned long long sessions;      // Wrapper objects alive
+	unsigned long long channels;
+	unsigned long long streams;
+	unsigned long      poolKB;        // Wrapper objects in pools of live sessions
+	unsigned long long poolAllocated; // Wrapper objects allocated from session pools ever
+	unsigned           logQueue;
+};
+
+
+/** Count a session finished and close it, deleted once terminated */
+static void Reap(LoadSession* s, SoakCounters& cnt, std::vector<LoadSession*>& closing)
+{
+	unsigned done = s->GetCompleted();
+	cnt.requests += done;
+	// Setup and the first request excluded, the rest must not grow the pool but for messages
+	if ((s->GetState() == LoadSession::ST_DONE) && (done > 1)) {
+		double growth = static_cast<double>(s->lastPoolBytes - s->firstPoolBytes) / (done - 1);
+		cnt.poolGrowthSum += growth;
+		if (growth > cnt.poolGrowthMax)
+			cnt.poolGrowthMax = growth;
+		cnt.poolSessions++;
+	}
+	closing.push_back(s);
+}
+
+
+/** Close sessions done, failed or timed out (all of them at the end) */
+static void ReapSessions(std::vector<LoadSession*>& live, std::vector<LoadSession*>& closing,
+                         SoakConfig const& cfg, SoakCounters& cnt, bool all)
+{
+	apr_time_t now = apr_time_now();
+	// Every request and the session setup get the timeout
+	apr_time_t timeout = static_cast<apr_time_t>(cfg.timeoutMs) * 1000 * (cfg.requests + 1);
+	size_t j = 0;
+	for (size_t i = 0; i < live.size(); i++) {
+		LoadSession* s = live[i];
+		LoadSession::State st = s->GetState();
+		if (st == LoadSession::ST_FAILED) {
+			cnt.failed++;
+		} else if (st == LoadSession::ST_DONE) {
+			cnt.completed++;
+		} else if (all || (now - s->createdAt >= timeout)) {
+			cnt.timedOut++;
+		} else {
+			live[j++] = s;
+			continue;
+		}
+		Reap(s, cnt, closing);
+	}
+	live.resize(j);
+	CloseSessions(closing, cfg.timeoutMs);
+}
+
+
+static void TakeSample(SoakSample& smp, std::vector<LoadSession*> const& live, SoakCounters const& cnt, double seconds)
+{
+	UniMRCPMetricsSnapshot m;
+	UniMRCPClient::GetMetrics(m);
+	UniMRCPLogStats log;
+	UniMRCPClient::GetLogStats(log);
+	unsigned long long pool = 0;
+	smp.requests = cnt.requests;
+	for (size_t i = 0; i < live.size(); i++) {
+		smp.requests += live[i]->GetCompleted();
+		pool += live[i]->GetPoolBytes();
+	}
+	smp.seconds = seconds;
+	smp.rssKB = RssKB();
+	smp.sessions = m.Get(METRIC_SESSIONS);
+	smp.channels = m.Get(METRIC_CHANNELS);
+	smp.streams = m.Get(METRIC_STREAMS);
+	smp.poolKB = static_cast<unsigned long>(pool / 1024);
+	smp.poolAllocated = m.Get(METRIC_SESSION_POOL_BYTES);
+	smp.logQueue = log.queueDepth;
+}
+
+
+static void PrintSample(SoakSample const& smp)
+{
+	printf("%8.0f %10lu %9lu %6llu %6llu %6llu %8lu %11.1f %6u\n",
+		smp.seconds, smp.requests, smp.rssKB, smp.sessions, smp.channels, smp.streams,
+		smp.poolKB, smp.requests ? static_cast<double>(smp.poolAllocated) / smp.requests : 0.0,
+		smp.logQueue);
+	fflush(stdout);
+}
+
+
+/**
+ * Least squares slope of RSS in bytes over completed requests after the warm-up.
+ * Returns false if there are not enough samples to tell.
+ */
+static bool RssGrowth(std::vector<SoakSample> const& samples, double warmupS, double& slope)
+{
+	double n = 0, mx = 0, my = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (samples[i].seconds < warmupS)
+			continue;
+		n += 1;
+		mx += static_cast<double>(samples[i].requests);
+		my += static_cast<double>(samples[i].rssKB) * 1024;
+	}
+	if (n < 3)
+		return false;
+	mx /= n;
+	my /= n;
+	double sxx = 0, sxy = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		if (samples[i].seconds < warmupS)
+			continue;
+		double dx = static_cast<double>(samples[i].requests) - mx;
+		sxx += dx * dx;
+		sxy += dx * (static_cast<double>(samples[i].rssKB) * 1024 - my);
+	}
+	if (sxx <= 0)
+		return false;
+	slope = sxy / sxx;
+	return true;
+}
+
+
+/** Wait for the wrapper objects and the log queue to go away, true if they did */
+static bool WaitReleased(SoakSample& smp, SoakCounters const& cnt, double seconds)
+{
+	std::vector<LoadSession*> none;
+	apr_time_t until = apr_time_now() + 10 * APR_USEC_PER_SEC;
+	for (;;) {
+		TakeSample(smp, none, cnt, seconds);
+		if (!smp.sessions && !smp.channels && !smp.streams && !smp.logQueue)
+			return true;
+		if (apr_time_now() >= until)
+			return false;
+		apr_sleep(100000);
+	}
+}
+
+
+static void Usage(char const* prog)
+{
+	printf("Usage: %s [options]\n"
+		"\t-r dir     UniMRCP client root directory\n"
+		"\t-p name    MRCP profile or profile group (uni2)\n"
+		"\t-c n       Concurrent sessions (4)\n"
+		"\t-n n       Requests per session (20)\n"
+		"\t-m pct     Recognizer sessions in percent, the rest synthesizer (50)\n"
+		"\t-g file    Recognizer grammar (SRGS XML)\n"
+		"\t-a file    Recognizer input audio (raw 8 kHz LPCM)\n"
+		"\t-s text    Text to synthesize\n"
+		"\t-T ms      Timeout of each request (30000)\n"
+		"\t-d s       Test duration (3600)\n"
+		"\t-i s       Sampling interval (60)\n"
+		"\t-W s       Warm-up not included in the RSS growth (300)\n"
+		"\t-G bytes   Maximum RSS growth per request, 0 not checked (%s)\n"
+		"\t-P bytes   Maximum session pool growth per request besides messages, negative not checked (0)\n"
+		"\t-w n       Callback dispatcher threads, 0 for the client task (0)\n"
+		"\t-l prio    Log priority 0-7 (3)\n", prog,
+#ifdef SOAK_ASAN
+		"0, RSS is not meaningful with AddressSanitizer"
+#else
+		"64"
+#endif
+		);
+}
+
+
+int main(int argc, char const* const argv[])
+{
+	SoakConfig cfg;
+	LoadConfigInit(cfg);
+	cfg.sessions = 4;
+	cfg.requests = 20;
+	cfg.durationS = 3600;
+	cfg.intervalS = 60;
+	cfg.warmupS = 300;
+#ifdef SOAK_ASAN
+	// Shadow memory and quarantine, LeakSanitizer reports at exit instead
+	cfg.maxGrowth = 0;
+#else
+	cfg.maxGrowth = 64;
+#endif
+	cfg.maxPoolGrowth = 0;
+	for (int i = 1; i < argc; i++) {
+		char const* opt = argv[i];
+		if ((opt[0] != '-') || !opt[1] || opt[2] || (i + 1 >= argc)) {
+			Usage(argv[0]);
+			return 1;
+		}
+		char const* val = argv[++i];
+		switch (opt[1]) {
+		case 'n': cfg.requests = static_cast<unsigned>(strtoul(val, NULL, 10)); break;
+		case 'W': cfg.warmupS = strtoul(val, NULL, 10); break;
+		case 'G': cfg.maxGrowth = strtod(val, NULL); break;
+		case 'P': cfg.maxPoolGrowth = strtod(val, NULL); break;
+		default:
+			if (!LoadConfigOption(cfg, opt[1], val)) {
+				Usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+	if (!cfg.sessions || !cfg.requests || (cfg.recogPercent > 100) || !cfg.intervalS) {
+		Usage(argv[0]);
+		return 1;
+	}
+	std::string grammar;
+	if (!LoadInputs(cfg, grammar))
+		return 1;
+
+	unsigned short major, minor, patch;
+	UniMRCPClient::WrapperVersion(major, minor, patch);
+	printf("UniMRCP wrapper %u.%u.%u soak test\n"
+		"Root dir %s, profile %s, %u sessions of %u requests, %u %% recognizer, %lu s\n",
+		major, minor, patch, cfg.rootDir, cfg.profile, cfg.sessions, cfg.requests,
+		cfg.recogPercent, cfg.durationS);
+
+	LoadLogger logger;
+	try {
+		UniMRCPClient::StaticInitialize(&logger, cfg.logPrio);
+	} catch (UniMRCPException const& ex) {
+		printf("Unable to initialize platform: %s\n", ex.msg);
+		return 1;
+	}
+
+	int ret = 0;
+	try {
+		UniMRCPClient client(cfg.rootDir, true);
+		if (cfg.threads)
+			client.StartDispatcher(cfg.threads);
+		if (cfg.recogPercent)
+			cfg.grammarId = UniMRCPRecognizerChannel::RegisterGrammar("application/srgs+xml", grammar.c_str());
+
+		std::vector<LoadSession*> live;
+		std::vector<LoadSession*> closing;
+		std::vector<SoakSample> samples;
+		SoakCounters cnt;
+		memset(&cnt, 0, sizeof(cnt));
+		apr_time_t const tick = 10000;
+		apr_time_t start = apr_time_now();
+		apr_time_t end = start + static_cast<apr_time_t>(cfg.durationS) * APR_USEC_PER_SEC;
+		apr_time_t nextSample = start + static_cast<apr_time_t>(cfg.intervalS) * APR_USEC_PER_SEC;
+
+		printf("\n    time   requests    rss kB  sess   chan  strm  pool kB  alloc B/req  logq\n");
+		for (;;) {
+			apr_time_t now = apr_time_now();
+			if ((now >= end) && live.empty() && closing.empty())
+				break;
+			// Finishing sessions may take up to the timeout of all their requests
+			if (now >= end + static_cast<apr_time_t>(cfg.timeoutMs) * 1000 * (cfg.requests + 1)) {
+				ReapSessions(live, closing, cfg, cnt, true);
+				while (!closing.empty()) {
+					apr_sleep(tick);
+					CloseSessions(closing, cfg.timeoutMs);
+				}
+				break;
+			}
+			ReapSessions(live, closing, cfg, cnt, false);
+
+			while ((now < end) && (live.size() < cfg.sessions)) {
+				// Spread resources evenly by the ratio
+				bool recog = (cnt.started + 1) * cfg.recogPercent / 100 != cnt.started * cfg.recogPercent / 100;
+				cnt.started++;
+				try {
+					live.push_back(new LoadSession(&client, cfg, recog));
+				} catch (UniMRCPException const& ex) {
+					cnt.rejected++;
+					if (cnt.rejected == 1)
+						fprintf(stderr, "Cannot create session: %s\n", ex.msg);
+					break;
+				}
+			}
+
+			if (now >= nextSample) {
+				SoakSample smp;
+				TakeSample(smp, live, cnt, static_cast<double>(now - start) / APR_USEC_PER_SEC);
+				samples.push_back(smp);
+				PrintSample(smp);
+				nextSample += static_cast<apr_time_t>(cfg.intervalS) * APR_USEC_PER_SEC;
+			}
+			apr_sleep(tick);
+		}
+		double seconds = static_cast<double>(apr_time_now() - start) / APR_USEC_PER_SEC;
+
+		printf("\nSessions: started %lu, completed %lu, failed %lu, timed out %lu, rejected %lu\n",
+			cnt.started, cnt.completed, cnt.failed, cnt.timedOut, cnt.rejected);
+		printf("Requests: %lu completed over %.1f s\n", cnt.requests, seconds);
+		if (cnt.failed || cnt.timedOut || cnt.rejected)
+			ret = 2;
+
+		double slope = 0;
+		if (!RssGrowth(samples, static_cast<double>(cfg.warmupS), slope)) {
+			printf("RSS growth: not enough samples after the warm-up\n");
+		} else {
+			bool over = (cfg.maxGrowth > 0) && (slope > cfg.maxGrowth);
+			printf("RSS growth: %.1f bytes per request%s\n", slope, over ? ", over the limit" : "");
+			if (over)
+				ret = 3;
+		}
+
+		if (cnt.poolSessions) {
+			double avg = cnt.poolGrowthSum / cnt.poolSessions;
+			bool over = (cfg.maxPoolGrowth >= 0) && (avg > cfg.maxPoolGrowth);
+			printf("Session pool growth: %.1f bytes per request, %.1f at most in %lu sessions%s\n",
+				avg, cnt.poolGrowthMax, cnt.poolSessions, over ? ", over the limit" : "");
+			if (over)
+				ret = 3;
+		}
+
+		SoakSample last;
+		if (WaitReleased(last, cnt, seconds)) {
+			printf("Released: all sessions, channels and streams, log queue empty, RSS %lu kB\n", last.rssKB);
+		} else {
+			printf("Left over: %llu sessions, %llu channels, %llu streams, %u log records\n",
+				last.sessions, last.channels, last.streams, last.logQueue);
+			ret = 3;
+		}
+	} catch (UniMRCPException const& ex) {
+		printf("A UniMRCP error occured: %s\n", ex.msg);
+		ret = 1;
+	} catch (std::exception const& ex) {
+		printf("An exception occured: %s\n", ex.what());
+		ret = 1;
+	}
+	try {
+		UniMRCPClient::StaticDeinitialize();
+	} catch (UniMRCPException const& ex) {
+		printf("Failed to deinitialize platform: %s\n", ex.msg);
+	}
+	return ret;
+}
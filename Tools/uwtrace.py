@@ -0,0 +1,126 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Decoder of UniMRCP wrapper trace log files, see UniMRCPClient::StartTraceLog()
+#
+# Usage: uwtrace.py [-s SESSION] trace-file
+#
+# Prints records oldest first, one per line. MESSAGE_SEND records get the request
+# ID of the REQUEST_ID record written upon the first response. Works with Python
+# 2.6+ and 3.
+import struct
+import sys
+import time
+from optparse import OptionParser
+
+HEADER = "8sIIIIIIQ24x"
+RECORD = "IHHQIIIIQII16s"
+VERSION = 1
+
+# UniMRCPTraceEvent
+EVENTS = [
+    "SESSION_CREATE", "SESSION_UPDATE", "SESSION_TERMINATE", "TERMINATE_EVENT",
+    "SESSION_DESTROY", "CHANNEL_CREATE", "CHANNEL_ADD", "CHANNEL_REMOVE",
+    "MESSAGE_SEND", "MESSAGE_RECEIVE", "REQUEST_TIMEOUT", "STREAM_OPEN",
+    "STREAM_CLOSE", "STARVATION", "REQUEST_ID"
+]
+RESOURCES = ["synthesizer", "recognizer", "recorder"]
+MESSAGE_TYPES = {1: "request", 2: "response", 3: "event"}
+REQUEST_STATES = ["COMPLETE", "IN-PROGRESS", "PENDING"]
+TIMEOUT_ACTIONS = ["none", "stop", "terminate"]
+DIRECTIONS = ["rx", "tx"]
+
+
+def describe(event, value, request, value1, value2, joined=None):
+    name = EVENTS[event] if event < len(EVENTS) else "EVENT_%d" % event
+    if name in ("SESSION_UPDATE", "SESSION_TERMINATE", "CHANNEL_ADD", "CHANNEL_REMOVE"):
+        return "%s status=%d" % (name, value)
+    if name == "MESSAGE_SEND":
+        # The ID is assigned after sending, REQUEST_ID tells it
+        if joined is None:
+            return "%s method=%d" % (name, value)
+        return "%s method=%d request=%d" % (name, value, joined)
+    if name == "REQUEST_ID":
+        return "%s method=%d request=%d sent=-%dus" % (name, value, request, value1)
+    if name == "MESSAGE_RECEIVE":
+        state = value2 >> 16
+        state = REQUEST_STATES[state] if state < len(REQUEST_STATES) else str(state)
+        return "%s %s id=%d request=%d status=%d state=%s" % (
+            name, MESSAGE_TYPES.get(value1, str(value1)), value, request, value2 & 0xFFFF, state)
+    if name == "REQUEST_TIMEOUT":
+        action = TIMEOUT_ACTIONS[value] if value < len(TIMEOUT_ACTIONS) else str(value)
+        return "%s request=%d action=%s" % (name, request, action)
+    if name in ("STREAM_OPEN", "STREAM_CLOSE"):
+        return "%s %s" % (name, DIRECTIONS[value] if value < 2 else str(value))
+    if name == "STARVATION":
+        return "%s frames=%d" % (name, value)
+    return name
+
+
+def join_requests(records):
+    """Request IDs of MESSAGE_SEND records by index, taken from REQUEST_ID records"""
+    send = EVENTS.index("MESSAGE_SEND")
+    request_id = EVENTS.index("REQUEST_ID")
+    pending = {}
+    joined = {}
+    for (i, rec) in enumerate(records):
+        key = (rec[5], rec[6])
+        if rec[1] == send:
+            pending.setdefault(key, []).append(i)
+        elif rec[1] == request_id and pending.get(key):
+            # The send closest to the time the ID record tells, of the same method
+            sent = rec[3] - rec[9]
+            candidates = [j for j in pending[key] if records[j][7] == rec[7]] or pending[key]
+            j = min(candidates, key=lambda j: abs(records[j][3] - sent))
+            pending[key].remove(j)
+            joined[j] = rec[8]
+    return joined
+
+
+def main():
+    parser = OptionParser(usage="%prog [-s SESSION] trace-file")
+    parser.add_option("-s", "--session", type="int", help="Print records of this session number only")
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error("Trace file expected")
+    f = open(args[0], "rb")
+    data = f.read()
+    f.close()
+
+    hsize = struct.calcsize("<" + HEADER)
+    if len(data) < hsize or data[:7] != b"UWTRACE":
+        sys.exit("Not a UniMRCP wrapper trace file")
+    # The writer's byte order
+    order = "<" if struct.unpack("<I", data[8:12])[0] == 0x01020304 else ">"
+    (magic, byte_order, version, rsize, capacity, written, reserved, started) = \
+        struct.unpack(order + HEADER, data[:hsize])
+    if version != VERSION or rsize != struct.calcsize(order + RECORD):
+        sys.exit("Unsupported trace file version %d" % version)
+
+    records = []
+    for i in range(capacity):
+        pos = hsize + i * rsize
+        if pos + rsize > len(data):
+            break
+        rec = struct.unpack(order + RECORD, data[pos:pos + rsize])
+        # Not written yet or being written when the file was copied
+        if not rec[0]:
+            continue
+        if options.session is not None and rec[5] != options.session:
+            continue
+        records.append(rec)
+    # Record numbers wrap at 2^32, the newest is written - 1
+    records.sort(key=lambda r: (r[0] - written - 1) & 0xFFFFFFFF)
+    joined = join_requests(records)
+
+    for (i, (seq, event, resource, stamp, thread, session, channel, value, request, value1, value2, name)) in enumerate(records):
+        t = time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(stamp // 1000000))
+        name = name.split(b"\0")[0].decode("ascii", "replace")
+        res = RESOURCES[resource] if resource < len(RESOURCES) else "-"
+        print("%s.%06d %08x %4d %-12s %4d %-11s %s" % (
+            t, stamp % 1000000, thread, session, name or "-", channel, res,
+            describe(event, value, request, value1, value2, joined.get(i))))
+
+
+if __name__ == "__main__":
+    main()
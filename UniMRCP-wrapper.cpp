@@ -37,6 +37,11 @@
 #include "apr_general.h"
 #include "apr_atomic.h"
 #include "apr_mmap.h"
+#include "apr_hash.h"
+#include "apr_thread_cond.h"
+#include "apr_thread_proc.h"
+#include "apr_portable.h"
+#include "apr_strings.h"
 #include "apt_pool.h"
 #include "apt_dir_layout.h"
 #include "apt_log.h"
@@ -60,6 +65,15 @@
 #if defined(WIN32) && defined(PTW32_STATIC_LIB)
 #	include "pthread.h"
 #endif
+#ifdef UW_USDT
+#	include <sys/sdt.h>
+#endif
+#ifdef __linux__
+#	include <sched.h>
+#endif
+#ifndef WIN32
+#	include <unistd.h>
+#endif
 
 #ifdef _MSC_VER
 #	define snprintf _snprintf
@@ -68,17 +82,239 @@
 
 /** @brief Throw UniMRCP exception from here with message */
 #define UNIMRCP_THROW(msg) throw UniMRCPException(__FILE__, __LINE__, msg)
+/** @brief Throw UniMRCP exception from here with error code and message */
+#define UNIMRCP_THROW_CODE(code, msg) throw UniMRCPException(__FILE__, __LINE__, msg, code)
 
 /** @brief Log line formatting buffer */
 #ifndef MAX_LOG_ENTRY_SIZE
 #	define MAX_LOG_ENTRY_SIZE 4096
 #endif
 
+/** @brief Least important priority compiled in, less important messages are compiled out */
+#ifndef UW_LOG_MIN_PRIORITY
+#	define UW_LOG_MIN_PRIORITY APT_PRIO_DEBUG
+#endif
+
+/**
+ * @brief Check whether a message would be logged, constant false below UW_LOG_MIN_PRIORITY.
+ * Asks apt every time, its priority may be changed by apt_log_priority_set() directly.
+ */
+#define UW_LOG_ON(prio) (((prio) <= UW_LOG_MIN_PRIORITY) && apt_log_priority_check(static_cast<apt_log_priority_e>(prio)))
+/** @brief Log a message if UW_LOG_ON(prio), the arguments are not even evaluated otherwise */
+#define UW_LOG(prio, ...) do { if (UW_LOG_ON(prio)) apt_log(APT_LOG_MARK, prio, __VA_ARGS__); } while (0)
+
+/**
+ * @brief Log a message of a session with log priority override lp (-1 if none).
+ *
+ * Messages the global priority filters out still reach the user logger when the override
+ * lets them, see UniMRCPClientSession::SetLogPriority(). The global case costs the same as UW_LOG().
+ */
+#define UW_SLOG(lp, prio, ...) do { \
+	if (UW_LOG_ON(prio)) apt_log(APT_LOG_MARK, prio, __VA_ARGS__); \
+	else if (((prio) <= UW_LOG_MIN_PRIORITY) && ((prio) <= (lp)) && logHandler) LogOverride(__FILE__, __LINE__, prio, __VA_ARGS__); \
+} while (0)
+
+/** @brief Handler of the user logger, NULL if logging to apt output */
+typedef int (*UniMRCPLogHandler)(char const* file, int line, char const* id, UniMRCPLogPriority priority, char const* format, va_list arg_ptr);
+static UniMRCPLogHandler logHandler = NULL;
+
+/** @brief Log sampling: one in logSampling new sessions gets logSamplePriority, 0 if off */
+static apr_uint32_t logSampling = 0;
+static int logSamplePriority = APT_PRIO_DEBUG;
+static apr_uint32_t logSampleSeq = 0;
+
+
+/**
+ * @brief Pass a message apt would filter out by the global priority to the user logger as is.
+ * apt output has no way around its filter, it gets no such messages.
+ */
+static void LogOverride(char const* file, int line, int priority, char const* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	if (logHandler)
+		logHandler(file, line, NULL, static_cast<UniMRCPLogPriority>(priority), format, ap);
+	va_end(ap);
+}
+
 /** @brief Memory page size (for MMap) */
 #ifndef PAGE_SIZE
 #	define PAGE_SIZE 4096
 #endif
 
+/** @brief Request deadline timer resolution */
+#ifndef UW_TIMER_TICK_MS
+#	define UW_TIMER_TICK_MS 10
+#endif
+
+
+/** @brief Assumed cache line size */
+#define UW_CACHE_LINE 64
+
+/** @brief Metric updated by atomic operations, on its own cache line */
+struct UniMRCPMetricCell {
+	volatile apr_uint32_t value;
+	char                  pad[UW_CACHE_LINE - sizeof(apr_uint32_t)];
+};
+
+/** @brief Per-message counters, UW_METRIC_MAX_IDS for each resource */
+enum UniMRCPMetricMessage {
+	METRIC_MSG_SENT,
+	METRIC_MSG_RESPONSES,
+	METRIC_MSG_EVENTS
+};
+
+/** @brief Index of the per-message counter */
+#define METRIC_MSG_INDEX(kind, resource, id) \
+	(UW_METRIC_SESSION_POOL_BYTES + 1 + ((kind) * 3 + (resource)) * UW_METRIC_MAX_IDS + (id))
+
+/** @brief All metrics, updated from any thread */
+static UniMRCPMetricCell   metricCells[UW_METRIC_CELLS];
+/** @brief Counter values seen by the last snapshot */
+static apr_uint32_t        metricSeen[UW_METRIC_CELLS];
+/** @brief Counters extended to 64 bits by snapshots */
+static apr_uint64_t        metricTotal[UW_METRIC_CELLS];
+/** @brief Guards the two above */
+static apr_thread_mutex_t* metricMutex = NULL;
+
+static inline void MetricInc(unsigned metric)
+{
+	apr_atomic_inc32(&metricCells[metric].value);
+}
+
+static inline void MetricDec(unsigned metric)
+{
+	apr_atomic_dec32(&metricCells[metric].value);
+}
+
+static inline void MetricAdd(unsigned metric, apr_size_t n)
+{
+	apr_atomic_add32(&metricCells[metric].value, static_cast<apr_uint32_t>(n));
+}
+
+/** @brief Count a message by resource and method or event */
+static void MetricMessage(UniMRCPMetricMessage kind, UniMRCPResource resource, apr_size_t id)
+{
+	MetricInc(kind == METRIC_MSG_SENT ? UW_METRIC_MESSAGES_SENT : UW_METRIC_MESSAGES_RECEIVED);
+	if ((resource >= MRCP_SYNTHESIZER) && (resource <= MRCP_RECORDER) && (id < UW_METRIC_MAX_IDS))
+		MetricInc(METRIC_MSG_INDEX(kind, resource, id));
+}
+
+
+/** @brief Sub-buckets per power of two, i.e. relative precision of histograms */
+#define HIST_SUB_BITS 4
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+/** @brief Buckets of values up to 2^32 microseconds */
+#define HIST_BUCKETS  ((32 - HIST_SUB_BITS) * HIST_SUB)
+
+/**
+ * @brief Log-linear latency histogram in microseconds, fixed size, updated by atomic operations.
+ *
+ * Values below 2 * HIST_SUB have own buckets, above that every power of two is split
+ * into HIST_SUB linear buckets.
+ */
+struct UniMRCPHistogram {
+	volatile apr_uint32_t buckets[HIST_BUCKETS];
+};
+
+/** @brief Request in flight for latency measurement */
+struct UniMRCPLatencySlot {
+	mrcp_message_t const* msg;  ///< Request sent, NULL if free
+	mrcp_request_id id;         ///< Assigned by the client task after sending, 0 until the first response
+	apr_size_t      method;
+	apr_time_t      sent;
+	bool            responded;  ///< First response measured
+};
+
+/** @brief Requests measured at once per channel, the oldest is forgotten */
+#define UW_LATENCY_SLOTS 8
+
+/** @brief Incoming audio timing, shared by channel (writer of SPEAK times) and media thread */
+struct UniMRCPTxTiming {
+	apr_thread_mutex_t*   mutex;          ///< Guards speakAt, 64 bits are not written at once everywhere
+	volatile apr_uint32_t speakSeq;       ///< SPEAKs sent, incremented after speakAt is set
+	apr_time_t            speakAt;        ///< When the last SPEAK was sent
+	apr_uint32_t          seenSeq;        ///< Last SPEAK handled by the media thread
+	apr_time_t            seenAt;         ///< speakAt of seenSeq, media thread copy
+	bool                  awaiting;       ///< No audio since the last SPEAK yet
+	int                   silence;        ///< G.711 silence code without the sign bit, -1 for linear samples
+	apr_time_t            lastFrame;      ///< Arrival of the previous frame, 0 if not streaming
+	apr_interval_time_t   lastInterval;   ///< Previous interarrival interval, -1 if none
+	apr_interval_time_t   jitter;         ///< RFC 3550 jitter scaled by 16
+	volatile apr_uint32_t frames;
+	volatile apr_uint32_t nonAudioFrames;
+	volatile apr_uint32_t speaks;
+	volatile apr_uint32_t firstAudioUs;
+	volatile apr_uint32_t jitterUs;
+	volatile apr_uint32_t maxJitterUs;
+};
+
+/** @brief Outgoing stream frame accounting, written by the media thread only */
+struct UniMRCPRxCounters {
+	volatile apr_uint32_t requested;
+	volatile apr_uint32_t supplied;
+	volatile apr_uint32_t shortFrames;
+	volatile apr_uint32_t zeroFilled;
+	volatile apr_uint32_t starved;
+	volatile apr_uint32_t runs;
+	volatile apr_uint32_t currentRun;
+	volatile apr_uint32_t longestRun;
+	volatile apr_uint32_t threshold;  ///< OnStarvation() threshold, 0 if off
+	apr_size_t            filled;     ///< Bytes set into the current frame
+	bool                  started;    ///< Audio supplied at least once
+};
+
+/** @brief Per-message phase histograms by resource and method or event */
+static UniMRCPHistogram latencyMsg[UW_LATENCY_EVENT + 1][3][UW_METRIC_MAX_IDS];
+/** @brief Channel add histograms by resource */
+static UniMRCPHistogram latencyChannel[3];
+/** @brief Session update histogram */
+static UniMRCPHistogram latencySession;
+/** @brief Audio histograms, time to first audio and frame jitter */
+static UniMRCPHistogram latencyAudio[2];
+
+static unsigned HistogramIndex(apr_interval_time_t value)
+{
+	if (value < 2 * HIST_SUB)
+		return value < 0 ? 0 : static_cast<unsigned>(value);
+	apr_uint64_t v = static_cast<apr_uint64_t>(value);
+	unsigned shift = 0;
+	while ((v >> shift) >= 2 * HIST_SUB)
+		shift++;
+	unsigned index = shift * HIST_SUB + static_cast<unsigned>(v >> shift);
+	return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+}
+
+/** @brief Highest value counted in the bucket */
+static apr_uint64_t HistogramValue(unsigned index)
+{
+	if (index < 2 * HIST_SUB)
+		return index;
+	unsigned shift = index / HIST_SUB - 1;
+	return ((static_cast<apr_uint64_t>(index - shift * HIST_SUB) + 1) << shift) - 1;
+}
+
+static inline void HistogramRecord(UniMRCPHistogram* h, apr_interval_time_t value)
+{
+	if (h)
+		apr_atomic_inc32(&h->buckets[HistogramIndex(value)]);
+}
+
+static UniMRCPHistogram* LatencyHistogram(UniMRCPLatencyPhase phase, UniMRCPResource resource, apr_size_t id)
+{
+	if (phase == UW_LATENCY_SESSION_UPDATE)
+		return &latencySession;
+	if ((phase == UW_LATENCY_FIRST_AUDIO) || (phase == UW_LATENCY_FRAME_JITTER))
+		return &latencyAudio[phase - UW_LATENCY_FIRST_AUDIO];
+	if ((resource < MRCP_SYNTHESIZER) || (resource > MRCP_RECORDER))
+		return NULL;
+	if (phase == UW_LATENCY_CHANNEL_ADD)
+		return &latencyChannel[resource];
+	if ((phase < UW_LATENCY_RESPONSE) || (phase > UW_LATENCY_EVENT) || (id >= UW_METRIC_MAX_IDS))
+		return NULL;
+	return &latencyMsg[phase][resource][id];
+}
+
 
 /**
  * @brief Allocate object's memory from APR memory pool
@@ -100,8 +336,25 @@ void operator delete(void* obj, apr_pool_t* pool)
 }
 
 
+/** @brief Pool userdata key of the bytes allocated by operator new(size_t, mrcp_session_t*) */
+static char const POOL_BYTES_KEY[] = "UniMRCPPoolBytes";
+
+
+/** @brief Counter of the bytes allocated from the session pool, NULL if the session does not count */
+static apr_uint32_t volatile* SessionPoolBytes(mrcp_session_t const* sess)
+{
+	void* data = NULL;
+	apr_pool_userdata_get(&data, POOL_BYTES_KEY, mrcp_application_session_pool_get(sess));
+	return static_cast<apr_uint32_t volatile*>(data);
+}
+
+
 void* operator new(size_t objSize, mrcp_session_t* sess)
 {
+	MetricAdd(UW_METRIC_SESSION_POOL_BYTES, objSize);
+	apr_uint32_t volatile* bytes = SessionPoolBytes(sess);
+	if (bytes)
+		apr_atomic_add32(bytes, static_cast<apr_uint32_t>(objSize));
 	return apr_palloc(mrcp_application_session_pool_get(sess), objSize);
 }
 
@@ -112,504 +365,3758 @@ unsigned       UniMRCPClient::staticInitialized = 0;
 apr_pool_t*    UniMRCPClient::staticPool = NULL;
 
 
-UniMRCPLogger::~UniMRCPLogger()
-{
-#ifdef _DEBUG
-	printf("~UniMRCPLogger logger(%p)\n", logger);
-#endif
-	logger = NULL;
-}
+/** @brief Grammar ID buffer size */
+#define GRAMMAR_ID_SIZE 20
 
+/** @brief Grammar registered in the process-wide grammar cache */
+struct UniMRCPGrammar {
+	char        id[GRAMMAR_ID_SIZE]; ///< Content-Id: "uw-" and 16 hex digits of content hash
+	char const* uri;                 ///< session: URI
+	char const* content_type;        ///< Grammar content type
+	char const* body;                ///< Grammar content
+	apr_size_t  len;                 ///< Grammar content length
+};
 
-int UniMRCPLogger::LogExtHandler(char const* file, int line, char const* id, UniMRCPLogPriority priority, char const* format, va_list arg_ptr)
-{
-	(void) id;
-	if (!logger) return false;
-	char buf[MAX_LOG_ENTRY_SIZE];
-	buf[0] = 0;
-	apr_vsnprintf(buf, MAX_LOG_ENTRY_SIZE, format, arg_ptr);
-	return logger->Log(file, line, priority, buf);
-}
+/** @brief DEFINE-GRAMMAR sent by a recognizer channel */
+struct UniMRCPPendingGrammar {
+	UniMRCPGrammar const* grammar;
+	mrcp_message_t const* msg;       ///< Request, the stack assigns its ID when sending
+};
 
+/** @brief Grammar cache memory pool, child of UniMRCPClient::staticPool */
+static apr_pool_t*         grammarCachePool = NULL;
+/** @brief Grammar cache lock */
+static apr_thread_mutex_t* grammarCacheMutex = NULL;
+/** @brief Registered grammars by ID */
+static apr_hash_t*         grammarCache = NULL;
+
+
+/** @brief Admission limit of one kind of objects */
+struct UniMRCPGate {
+	unsigned     limit;     ///< 0 for unlimited
+	long         wait;      ///< How long to wait for a free slot (ms), 0 to reject, -1 for infinity
+	unsigned     current;
+	unsigned     peak;
+	apr_uint64_t admitted;
+	apr_uint64_t queued;
+	apr_uint64_t rejected;
+	apr_uint64_t timedOut;
+};
 
-void UniMRCPClient::UniMRCPVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
-{
-	major = UNI_MAJOR_VERSION;
-	minor = UNI_MINOR_VERSION;
-	patch = UNI_PATCH_VERSION;
+
+/** @brief Limits of the client or of a profile */
+struct UniMRCPGateSet {
+	UniMRCPAdmission* owner;
+	UniMRCPGateSet*   parent;  ///< Client limits for a profile, NULL for the client
+	UniMRCPGate       gates[UW_LIMIT_REQUESTS + 1];
+};
+
+
+struct UniMRCPProfileGroup;
+
+/** @brief Profile in a group, see UniMRCPClient::AddProfileToGroup() */
+struct UniMRCPGroupMember {
+	char const*          profile;
+	unsigned             weight;
+	unsigned             index;     ///< Bit in the mask of tried members
+	long                 current;   ///< Smooth weighted round robin state
+	UniMRCPGateSet*      set;       ///< Occupancy of the profile
+	unsigned             failures;  ///< Consecutive failures
+	apr_time_t           downUntil; ///< Skipped until then after a failure
+	UniMRCPProfileGroup* group;
+	UniMRCPGroupMember*  next;
+};
+
+
+/** @brief Profiles to spread sessions over */
+struct UniMRCPProfileGroup {
+	char const*         name;
+	UniMRCPBalancing    balancing;
+	apr_interval_time_t retryAfter;
+	unsigned            count;
+	unsigned            next;      ///< Least outstanding tie breaker, rotates
+	UniMRCPGroupMember* members;
+};
+
+/** @brief States of a retired session, see UniMRCPRetiredSession */
+enum {
+	RETIRED_TERMINATING,  ///< Termination requested
+	RETIRED_TERMINATED,   ///< Terminated, waits for the session that replaced it
+	RETIRED_ORPHANED      ///< Replacement gone, free upon termination
+};
+
+/**
+ * @brief C session of a profile that failed to set up, replaced by one on the next profile.
+ *
+ * Allocated from its own pool, found by RETIRED_KEY there. Memory of the session
+ * object and its channels may come from it, so it is destroyed along with
+ * the replacement (by a cleanup of the replacement's pool) or upon its termination,
+ * whichever comes later. Failing over again chains the same way.
+ */
+struct UniMRCPRetiredSession {
+	mrcp_session_t*       sess;
+	mrcp_application_t*   app;
+	volatile apr_uint32_t state;
+};
+
+/** @brief Pool user data key of UniMRCPRetiredSession */
+static char const RETIRED_KEY[] = "UniMRCPRetiredSession";
+
+/** @brief Members are tracked in a 64-bit mask while retrying */
+#define UW_GROUP_MAX_PROFILES 64
+
+
+/**
+ * @brief Admission limits and profile groups of a client, one mutex and condition for all of them.
+ *
+ * Reference counted like UniMRCPTimerWheel: sessions release their slots
+ * after the client may be gone.
+ */
+class UniMRCPAdmission {
+public:
+	UniMRCPAdmission() THROWS(UniMRCPException);
+
+	/** @brief Take a reference */
+	void Retain();
+	/** @brief Drop a reference, the last one deletes the admission */
+	void Release();
+
+	/** @brief Get limits of a profile, NULL if not known and not to be created */
+	UniMRCPGateSet* Profile(char const* profile, bool create);
+	inline UniMRCPGateSet* Client() {return &client;}
+	/** @brief Take a slot in the set and its parent, wait (unless told not to) or throw if over limit */
+	void Acquire(UniMRCPGateSet* set, UniMRCPLimitType type, bool wait = true) THROWS(UniMRCPException);
+	/** @brief Free the slot taken by Acquire */
+	static void Release(UniMRCPGateSet* set, UniMRCPLimitType type);
+	void SetLimit(UniMRCPGateSet* set, UniMRCPLimitType type, unsigned max, long wait_ms);
+	void GetOccupancy(UniMRCPGateSet* set, UniMRCPLimitType type, UniMRCPOccupancy& occupancy);
+
+	/** @brief Get profile group, NULL if not defined */
+	UniMRCPProfileGroup* Group(char const* name);
+	void AddMember(char const* group, char const* profile, unsigned weight) THROWS(UniMRCPException);
+	void SetBalancing(UniMRCPProfileGroup* group, UniMRCPBalancing balancing, unsigned long retry_after_ms);
+	/** @brief Choose a member not in tried and add it there, NULL if all tried */
+	UniMRCPGroupMember* Select(UniMRCPProfileGroup* group, apr_uint64_t& tried);
+	/** @brief Record session setup or termination status of the member */
+	void Report(UniMRCPGroupMember* member, bool success);
+	bool IsHealthy(char const* group, char const* profile);
+	/** @brief Reject new sessions from now on */
+	void SetDraining();
+	void Register(UniMRCPClientSession* session);
+	void Unregister(UniMRCPClientSession* session);
+	/** @brief Tell Drain() a session or the requests of a channel ended */
+	void Wake();
+	/** @brief Wait until woken after the events seen or until the deadline, regMutex locked */
+	void WaitWake(apr_uint32_t seen, apr_time_t deadline);
+
+	apr_thread_mutex_t*   regMutex; ///< Guards sessions, taken before session and channel mutexes
+	UniMRCPClientSession* sessions; ///< Sessions of the client, for Drain()
+	apr_uint32_t          events;   ///< Wake() calls, guarded by regMutex
+
+private:
+	~UniMRCPAdmission();
+
+	apr_thread_cond_t*  regCond;   ///< Broadcast by Wake() while draining
+	volatile apr_uint32_t waking;  ///< Draining, Wake() has to signal
+	volatile apr_uint32_t refs;
+	apr_pool_t*         pool;
+	apr_thread_mutex_t* mutex;
+	apr_thread_cond_t*  cond;      ///< Broadcast when a slot frees or a limit changes
+	UniMRCPGateSet      client;
+	apr_hash_t*         profiles;
+	apr_hash_t*         groups;
+	bool                draining;  ///< Reject all sessions
+};
+
+
+UniMRCPAdmission::UniMRCPAdmission() THROWS(UniMRCPException) :
+	regMutex(NULL),
+	sessions(NULL),
+	events(0),
+	regCond(NULL),
+	waking(0),
+	refs(1),
+	pool(NULL),
+	mutex(NULL),
+	cond(NULL),
+	profiles(NULL),
+	groups(NULL),
+	draining(false)
+{
+	memset(&client, 0, sizeof(client));
+	client.owner = this;
+	pool = apt_pool_create();
+	if (!pool)
+		UNIMRCP_THROW("Cannot create admission memory pool");
+	if ((apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&cond, pool) != APR_SUCCESS) ||
+		(apr_thread_mutex_create(&regMutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&regCond, pool) != APR_SUCCESS))
+	{
+		apr_pool_destroy(pool);
+		UNIMRCP_THROW("Cannot create admission synchronization objects");
+	}
+	profiles = apr_hash_make(pool);
+	groups = apr_hash_make(pool);
 }
 
 
-void UniMRCPClient::WrapperVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+UniMRCPAdmission::~UniMRCPAdmission()
 {
-	major = UW_MAJOR_VERSION;
-	minor = UW_MINOR_VERSION;
-	patch = UW_PATCH_VERSION;
+	apr_pool_destroy(pool);
 }
 
 
-void UniMRCPClient::APRVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+void UniMRCPAdmission::Retain()
 {
-	major = APR_MAJOR_VERSION;
-	minor = APR_MINOR_VERSION;
-	patch = APR_PATCH_VERSION;
+	apr_atomic_inc32(&refs);
 }
 
 
-void UniMRCPClient::APRUtilVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+void UniMRCPAdmission::Release()
 {
-	major = APU_MAJOR_VERSION;
-	minor = APU_MINOR_VERSION;
-	patch = APU_PATCH_VERSION;
+	if (!apr_atomic_dec32(&refs))
+		delete this;
 }
 
 
-char const* UniMRCPClient::SofiaSIPVersion()
+UniMRCPGateSet* UniMRCPAdmission::Profile(char const* profile, bool create)
 {
-	return SOFIA_SIP_VERSION;
+	apr_thread_mutex_lock(mutex);
+	UniMRCPGateSet* set = static_cast<UniMRCPGateSet*>(apr_hash_get(profiles, profile, APR_HASH_KEY_STRING));
+	if (!set && create) {
+		set = static_cast<UniMRCPGateSet*>(apr_pcalloc(pool, sizeof(UniMRCPGateSet)));
+		set->owner = this;
+		set->parent = &client;
+		apr_hash_set(profiles, apr_pstrdup(pool, profile), APR_HASH_KEY_STRING, set);
+	}
+	apr_thread_mutex_unlock(mutex);
+	return set;
 }
 
 
-void UniMRCPClient::StaticPreinitialize(int& fd_stdin, int& fd_stdout, int& fd_stderr) THROWS(UniMRCPException)
+void UniMRCPAdmission::Acquire(UniMRCPGateSet* set, UniMRCPLimitType type, bool wait /* = true */) THROWS(UniMRCPException)
 {
-	if (staticInitialized) {
-		staticInitialized++;
-#ifdef _DEBUG
-		printf("staticInitialized(%u)\n", staticInitialized);
-#endif
-		return;
+	apr_time_t start = apr_time_now();
+	UniMRCPGate* waited = NULL;
+	apr_thread_mutex_lock(mutex);
+	for (;;) {
+		if (draining && (type == UW_LIMIT_SESSIONS)) {
+			apr_thread_mutex_unlock(mutex);
+			UNIMRCP_THROW_CODE(UW_ERROR_ADMISSION_REJECTED, "Client draining");
+		}
+		UniMRCPGate* full = NULL;
+		for (UniMRCPGateSet* s = set; s && !full; s = s->parent) {
+			UniMRCPGate* g = &s->gates[type];
+			if (g->limit && (g->current >= g->limit))
+				full = g;
+		}
+		if (!full)
+			break;
+		if (!full->wait || !wait) {
+			full->rejected++;
+			apr_thread_mutex_unlock(mutex);
+			UNIMRCP_THROW_CODE(UW_ERROR_ADMISSION_REJECTED, "Admission limit reached");
+		}
+		if (waited != full) {
+			full->queued++;
+			waited = full;
+		}
+		if (full->wait < 0)
+			apr_thread_cond_wait(cond, mutex);
+		else {
+			apr_interval_time_t left = start + apr_time_from_msec(full->wait) - apr_time_now();
+			if ((left <= 0) || (apr_thread_cond_timedwait(cond, mutex, left) == APR_TIMEUP)) {
+				full->timedOut++;
+				apr_thread_mutex_unlock(mutex);
+				UNIMRCP_THROW_CODE(UW_ERROR_ADMISSION_TIMEOUT, "Admission limit reached, timed out waiting");
+			}
+		}
+	}
+	for (UniMRCPGateSet* s = set; s; s = s->parent) {
+		UniMRCPGate* g = &s->gates[type];
+		g->current++;
+		g->admitted++;
+		if (g->current > g->peak)
+			g->peak = g->current;
 	}
+	apr_thread_mutex_unlock(mutex);
+}
 
-// Must be called once per process when linked statically for SofiaSIP to work
-#if defined(WIN32) && defined(PTW32_STATIC_LIB)
-	if (!pthread_win32_process_attach_np())
-		UNIMRCP_THROW("Cannot initialize pthreads win32");
-#endif
 
-// Switch file descriptors in order to be able to write on console
-#if defined(WIN32) && defined(DOTNET_CONSOLE_HACK)
-	fd_stdin = _fileno(stdin);
-	if (fd_stdin < 0) freopen("CONIN$", "rt", stdin);
-	fd_stdout = _fileno(stdout);
-	if (fd_stdout < 0) freopen("CONOUT$", "wt", stdout);
-	fd_stderr = _fileno(stderr);
-	if (fd_stderr < 0) freopen("CONERR$", "wt", stderr);
-#else
-	(void) fd_stdin;
-	(void) fd_stdout;
-	(void) fd_stderr;
-#endif
+void UniMRCPAdmission::Release(UniMRCPGateSet* set, UniMRCPLimitType type)
+{
+	UniMRCPAdmission* a = set->owner;
+	apr_thread_mutex_lock(a->mutex);
+	for (UniMRCPGateSet* s = set; s; s = s->parent)
+		if (s->gates[type].current)
+			s->gates[type].current--;
+	apr_thread_cond_broadcast(a->cond);
+	apr_thread_mutex_unlock(a->mutex);
+}
 
-	/* APR global initialization */
-	if(apr_initialize() != APR_SUCCESS)
-	{
-		apr_terminate();
-		UNIMRCP_THROW("Error initializing APR");
-	}
 
-	/* Create APR pool */
-	staticPool = apt_pool_create();
-	if (!staticPool)
-		UNIMRCP_THROW("Insufficient memory");
+void UniMRCPAdmission::SetLimit(UniMRCPGateSet* set, UniMRCPLimitType type, unsigned max, long wait_ms)
+{
+	apr_thread_mutex_lock(mutex);
+	set->gates[type].limit = max;
+	set->gates[type].wait = wait_ms;
+	apr_thread_cond_broadcast(cond);
+	apr_thread_mutex_unlock(mutex);
+}
 
-	staticInitialized++;
-#ifdef _DEBUG
-	printf("staticInitialized(%u)\n", staticInitialized);
-#endif
+
+void UniMRCPAdmission::GetOccupancy(UniMRCPGateSet* set, UniMRCPLimitType type, UniMRCPOccupancy& occupancy)
+{
+	apr_thread_mutex_lock(mutex);
+	UniMRCPGate const* g = &set->gates[type];
+	occupancy.limit = g->limit;
+	occupancy.current = g->current;
+	occupancy.peak = g->peak;
+	occupancy.admitted = g->admitted;
+	occupancy.queued = g->queued;
+	occupancy.rejected = g->rejected;
+	occupancy.timedOut = g->timedOut;
+	apr_thread_mutex_unlock(mutex);
 }
 
 
-void UniMRCPClient::StaticInitialize(char const* root_dir,
-                                     UniMRCPLogPriority log_prio,
-                                     UniMRCPLogOutput log_out,
-                                     char const* log_fname,
-                                     unsigned max_log_fsize,
-                                     unsigned max_log_fcount) THROWS(UniMRCPException)
+UniMRCPProfileGroup* UniMRCPAdmission::Group(char const* name)
 {
-	int fd_stdin, fd_stdout, fd_stderr;
-	apt_dir_layout_t* dirLayout;
-	StaticPreinitialize(fd_stdin, fd_stdout, fd_stderr);
+	apr_thread_mutex_lock(mutex);
+	UniMRCPProfileGroup* group = static_cast<UniMRCPProfileGroup*>(apr_hash_get(groups, name, APR_HASH_KEY_STRING));
+	apr_thread_mutex_unlock(mutex);
+	return group;
+}
 
-	/* create the structure of default directories layout */
-	dirLayout = apt_default_dir_layout_create(root_dir, staticPool);
 
-	/* get path to logger configuration file */
-	const char* logConfPath = apt_confdir_filepath_get(dirLayout, "logger.xml", staticPool);
-	/* create and load singleton logger */
-	apt_log_instance_load(logConfPath, staticPool);
-	/* override the log priority, if specified in command line */
-	apt_log_priority_set(static_cast<apt_log_priority_e>(log_prio));
-	apt_log_output_mode_set(static_cast<apt_log_output_e>(log_out));
-	if (!log_fname) log_fname = unimrcp_client_log_name;
-	if (apt_log_output_mode_check(APT_LOG_OUTPUT_FILE) == TRUE)
-	{
-		/* open the log file */
-#if defined(UNI_VERSION_AT_LEAST) && UNI_VERSION_AT_LEAST(1, 3, 0)
-		apt_log_file_open(apt_dir_layout_path_get(dirLayout, APT_LAYOUT_LOG_DIR),
-			log_fname, max_log_fsize, max_log_fcount, FALSE, staticPool);
-#else
-		apt_log_file_open(dirLayout->log_dir_path, log_fname,
-			max_log_fsize, max_log_fcount, FALSE, staticPool);
-#endif
+void UniMRCPAdmission::AddMember(char const* name, char const* profile, unsigned weight) THROWS(UniMRCPException)
+{
+	UniMRCPGateSet* set = Profile(profile, true);
+	apr_thread_mutex_lock(mutex);
+	UniMRCPProfileGroup* group = static_cast<UniMRCPProfileGroup*>(apr_hash_get(groups, name, APR_HASH_KEY_STRING));
+	if (!group) {
+		group = static_cast<UniMRCPProfileGroup*>(apr_pcalloc(pool, sizeof(UniMRCPProfileGroup)));
+		group->name = apr_pstrdup(pool, name);
+		group->balancing = UW_BALANCE_ROUND_ROBIN;
+		group->retryAfter = apr_time_from_msec(5000);
+		apr_hash_set(groups, group->name, APR_HASH_KEY_STRING, group);
 	}
-	apt_log(APT_LOG_MARK, APT_PRIO_INFO, "Initialized UniMRCP for %s: log_root_dir(%s) "
-		"log_prio(%d) log_out(%d) log_fname(%s) max_log_fsize(%u) max_log_fcount(%u)",
-		swig_target_platform, root_dir, static_cast<int>(log_prio),
-		static_cast<int>(log_out), log_fname, max_log_fsize, max_log_fcount);
-	StaticPostinitialize(fd_stdin, fd_stdout, fd_stderr);
+	UniMRCPGroupMember** last = &group->members;
+	for (; *last; last = &(*last)->next)
+		if (!strcmp((*last)->profile, profile)) {
+			apr_thread_mutex_unlock(mutex);
+			UNIMRCP_THROW("Profile already in the group");
+		}
+	if (group->count >= UW_GROUP_MAX_PROFILES) {
+		apr_thread_mutex_unlock(mutex);
+		UNIMRCP_THROW("Too many profiles in the group");
+	}
+	UniMRCPGroupMember* m = static_cast<UniMRCPGroupMember*>(apr_pcalloc(pool, sizeof(UniMRCPGroupMember)));
+	m->profile = apr_pstrdup(pool, profile);
+	m->weight = weight;
+	m->index = group->count++;
+	m->set = set;
+	m->group = group;
+	*last = m;
+	apr_thread_mutex_unlock(mutex);
 }
 
 
-void UniMRCPClient::StaticInitialize(UniMRCPLogger* logger,
-                                     UniMRCPLogPriority log_prio) THROWS(UniMRCPException)
+void UniMRCPAdmission::SetBalancing(UniMRCPProfileGroup* group, UniMRCPBalancing balancing, unsigned long retry_after_ms)
 {
-	int fd_stdin, fd_stdout, fd_stderr;
-	StaticPreinitialize(fd_stdin, fd_stdout, fd_stderr);
-
-	apt_log_instance_create(APT_LOG_OUTPUT_NONE, static_cast<apt_log_priority_e>(log_prio), staticPool);
-	UniMRCPLogger::logger = logger;
-	apt_log_ext_handler_set(reinterpret_cast<apt_log_ext_handler_f>(UniMRCPLogger::LogExtHandler));
-	apt_log(APT_LOG_MARK, APT_PRIO_INFO, "Initialized UniMRCP for %s: "
-		"logger(%pp) log_prio(%d)", swig_target_platform, logger, static_cast<int>(log_prio));
-	StaticPostinitialize(fd_stdin, fd_stdout, fd_stderr);
+	apr_thread_mutex_lock(mutex);
+	group->balancing = balancing;
+	group->retryAfter = apr_time_from_msec(retry_after_ms);
+	apr_thread_mutex_unlock(mutex);
 }
 
 
-void UniMRCPClient::StaticPostinitialize(int fd_stdin, int fd_stdout, int fd_stderr)
+UniMRCPGroupMember* UniMRCPAdmission::Select(UniMRCPProfileGroup* group, apr_uint64_t& tried)
 {
-#if defined(WIN32) && defined(DOTNET_CONSOLE_HACK)
-	if (fd_stdin < 0) apt_log(APT_LOG_MARK, APT_PRIO_DEBUG,
-		".NET console hack for stdin: old fd: %d, new fd %d", fd_stdin, _fileno(stdin));
-	if (fd_stdout < 0) apt_log(APT_LOG_MARK, APT_PRIO_DEBUG,
-		".NET console hack for stdout: old fd: %d, new fd %d", fd_stdout, _fileno(stdout));
-	if (fd_stderr < 0) apt_log(APT_LOG_MARK, APT_PRIO_DEBUG,
-		".NET console hack for stderr: old fd: %d, new fd %d", fd_stderr, _fileno(stderr));
-#else
-	(void) fd_stdin;
-	(void) fd_stdout;
-	(void) fd_stderr;
-#endif
+	apr_time_t now = apr_time_now();
+	UniMRCPGroupMember* best = NULL;
+	apr_thread_mutex_lock(mutex);
+	/* Healthy profiles first, then any not tried yet rather than nothing */
+	for (int pass = 0; !best && (pass < 2); pass++) {
+		long total = 0;
+		apr_uint64_t bestLoad = 0;
+		unsigned bestRank = 0;
+		for (UniMRCPGroupMember* m = group->members; m; m = m->next) {
+			if ((tried & (APR_UINT64_C(1) << m->index)) || (!pass && (m->downUntil > now)))
+				continue;
+			if (group->balancing == UW_BALANCE_ROUND_ROBIN) {
+				m->current += m->weight;
+				total += m->weight;
+				if (!best || (m->current > best->current))
+					best = m;
+				continue;
+			}
+			/* Compare load / weight without division, equal loads rotate */
+			apr_uint64_t load = m->set->gates[UW_LIMIT_SESSIONS].current + m->set->gates[UW_LIMIT_REQUESTS].current;
+			unsigned rank = (m->index + group->count - group->next % group->count) % group->count;
+			if (!best || (load * best->weight < bestLoad * m->weight) ||
+				((load * best->weight == bestLoad * m->weight) && (rank < bestRank)))
+			{
+				best = m;
+				bestLoad = load;
+				bestRank = rank;
+			}
+		}
+		if (best && (group->balancing == UW_BALANCE_ROUND_ROBIN))
+			best->current -= total;
+	}
+	if (best) {
+		tried |= APR_UINT64_C(1) << best->index;
+		group->next++;
+	}
+	apr_thread_mutex_unlock(mutex);
+	return best;
 }
 
 
-void UniMRCPClient::StaticDeinitialize() THROWS(UniMRCPException)
+void UniMRCPAdmission::Report(UniMRCPGroupMember* member, bool success)
 {
-	if (!staticInitialized) {
-#ifdef _DEBUG
-		printf("staticInitialized(%u) deinitialize\n", staticInitialized);
-#endif
-		return;
+	apr_thread_mutex_lock(mutex);
+	if (success) {
+		member->failures = 0;
+		member->downUntil = 0;
+	} else {
+		unsigned shift = member->failures < 5 ? member->failures : 5;
+		member->failures++;
+		member->downUntil = apr_time_now() + (member->group->retryAfter << shift);
+		UW_LOG(APT_PRIO_WARNING, "%s Profile %s of group %s failed %u times, skipped for %lu ms",
+			swig_target_platform, member->profile, member->group->name, member->failures,
+			static_cast<unsigned long>(apr_time_as_msec(member->group->retryAfter << shift)));
 	}
-	if ((staticInitialized == 1) && instances)
-		UNIMRCP_THROW("Destroy all clients before static deinitialization");
-	staticInitialized--;
-	if (staticInitialized) {
-#ifdef _DEBUG
-		printf("staticInitialized(%u) deinitialize\n", staticInitialized);
-#endif
-		return;
+	apr_thread_mutex_unlock(mutex);
+}
+
+
+bool UniMRCPAdmission::IsHealthy(char const* name, char const* profile)
+{
+	bool healthy = false;
+	apr_thread_mutex_lock(mutex);
+	UniMRCPProfileGroup* group = static_cast<UniMRCPProfileGroup*>(apr_hash_get(groups, name, APR_HASH_KEY_STRING));
+	for (UniMRCPGroupMember* m = group ? group->members : NULL; m; m = m->next)
+		if (!strcmp(m->profile, profile)) {
+			healthy = m->downUntil <= apr_time_now();
+			break;
+		}
+	apr_thread_mutex_unlock(mutex);
+	return healthy;
+}
+
+
+void UniMRCPAdmission::SetDraining()
+{
+	apr_thread_mutex_lock(mutex);
+	draining = true;
+	apr_atomic_set32(&waking, 1);
+	/* Those waiting for a session slot are rejected too */
+	apr_thread_cond_broadcast(cond);
+	apr_thread_mutex_unlock(mutex);
+}
+
+
+void UniMRCPAdmission::Register(UniMRCPClientSession* s)
+{
+	apr_thread_mutex_lock(regMutex);
+	s->admit.prev = NULL;
+	s->admit.next = sessions;
+	if (sessions)
+		sessions->admit.prev = s;
+	sessions = s;
+	apr_thread_mutex_unlock(regMutex);
+}
+
+
+void UniMRCPAdmission::Unregister(UniMRCPClientSession* s)
+{
+	apr_thread_mutex_lock(regMutex);
+	if (s->admit.prev)
+		s->admit.prev->admit.next = s->admit.next;
+	else if (sessions == s)
+		sessions = s->admit.next;
+	if (s->admit.next)
+		s->admit.next->admit.prev = s->admit.prev;
+	s->admit.prev = s->admit.next = NULL;
+	if (apr_atomic_read32(&waking)) {
+		events++;
+		apr_thread_cond_broadcast(regCond);
 	}
-	/* destroy singleton logger */
-	apt_log_instance_destroy();
-	/* destroy APR pool */
-	apr_pool_destroy(staticPool);
-	staticPool = NULL;
-	/* APR global termination */
-	apr_terminate();
+	apr_thread_mutex_unlock(regMutex);
+}
 
-#	ifdef PTW32_STATIC_LIB
-	pthread_win32_process_detach_np();
-#	endif
-#ifdef _DEBUG
-	printf("staticDeinitialized\n");
-#endif
+
+void UniMRCPAdmission::Wake()
+{
+	if (!apr_atomic_read32(&waking))
+		return;
+	apr_thread_mutex_lock(regMutex);
+	events++;
+	apr_thread_cond_broadcast(regCond);
+	apr_thread_mutex_unlock(regMutex);
 }
 
 
-UniMRCPClient::UniMRCPClient(char const* config, bool dir /* = false */)  THROWS(UniMRCPException) :
-	client(NULL),
-	app(NULL),
-	terminated(false),
-	sess_id(1)
+void UniMRCPAdmission::WaitWake(apr_uint32_t seen, apr_time_t deadline)
 {
-	if (!staticInitialized)
-		UNIMRCP_THROW("UniMRCP platform not statically initialized");
+	apr_time_t now;
+	while ((events == seen) && ((now = apr_time_now()) < deadline))
+		apr_thread_cond_timedwait(regCond, regMutex, deadline - now);
+}
 
-	if (dir) {
-		/* create the structure of default directories layout */
-		apt_dir_layout_t* dirLayout = apt_default_dir_layout_create(config, staticPool);
-		client = unimrcp_client_create(dirLayout);
-	} else
-		client = unimrcp_client_create2(config);
 
-	apt_log(APT_LOG_MARK, APT_PRIO_NOTICE, "Creating %s UniMRCPClient (%pp) instance %u",
-		swig_target_platform, this, instances);
+/** @brief FNV-1a offset basis */
+#define FNV1A_INIT APR_UINT64_C(0xcbf29ce484222325)
 
-	if (!client)
-		UNIMRCP_THROW("Cannot create UniMRCP client");
-	app = mrcp_application_create(AppMessageHandler, this, mrcp_client_memory_pool_get(client));
-	if (!app) {
-		mrcp_client_destroy(client);
-		client = NULL;
-		UNIMRCP_THROW("Cannot create UniMRCP client application");
+/**
+ * @brief 64-bit FNV-1a hash
+ * @param hash #FNV1A_INIT or result of previous call to hash more buffers
+ */
+static apr_uint64_t HashFNV1a(apr_uint64_t hash, char const* buf, apr_size_t len)
+{
+	for (apr_size_t i = 0; i < len; i++) {
+		hash ^= static_cast<unsigned char>(buf[i]);
+		hash *= APR_UINT64_C(0x100000001b3);
 	}
+	return hash;
+}
 
-	/* register MRCP application to MRCP client */
-	if (mrcp_client_application_register(client, app, unimrcp_client_app_name) == FALSE) {
-		mrcp_application_destroy(app);
-		app = NULL;
-		mrcp_client_destroy(client);
-		client = NULL;
-		UNIMRCP_THROW("Cannot register UniMRCP client application");
+/** @brief Timer wheel entry, usually embedded in or allocated along with its owner */
+struct UniMRCPTimer {
+	UniMRCPTimer*  next;                      ///< Next timer in the slot
+	UniMRCPTimer** pprev;                     ///< Link pointing to this timer, NULL if not scheduled
+	apr_uint64_t   expires;                   ///< Expiration tick
+	void         (*callback)(UniMRCPTimer*);  ///< Called from the timer thread upon expiration
+	void*          obj;                       ///< Owner object
+	UniMRCPTimerWheel* wheel;                 ///< Wheel the timer is scheduled in
+};
+
+
+/** @brief Session pool entry states */
+enum UniMRCPPooledState {
+	POOLED_WARMING,  ///< Channel being added
+	POOLED_IDLE,     ///< Ready for checkout
+	POOLED_BUSY,     ///< Checked out
+	POOLED_CLOSED    ///< Being torn down
+};
+
+
+/** @brief Session pool entry */
+struct UniMRCPPooledSession {
+	UniMRCPSessionPool*   pool;
+	UniMRCPClientSession* sess;
+	UniMRCPClientChannel* chan;
+	UniMRCPPooledSession* next;     ///< Next idle session
+	UniMRCPPooledState    state;
+	volatile apr_uint32_t healthy;  ///< Cleared upon unexpected termination
+	apr_time_t            created;  ///< For refill latency
+	UniMRCPTimer          timer;    ///< Idle timeout
+};
+
+
+/** @brief Session batch entry */
+struct UniMRCPBatchEntry {
+	UniMRCPSessionBatch*  batch;
+	UniMRCPClientSession* sess;
+	UniMRCPClientChannel* chan;
+	bool                  setup;        ///< Channel being added
+	bool                  ready;        ///< Channel added successfully
+	bool                  terminating;  ///< Terminated by the batch, not reported yet
+};
+
+
+/**
+ * @brief Hierarchical timer wheel with a single thread, started upon first use.
+ *
+ * Level 0 has a slot per tick, every next level a slot per full turn of the previous one.
+ * Timers are cascaded down as the wheel turns, so scheduling and cancellation are O(1).
+ * Timers beyond the range of the top level wait in its farthest slot and are placed
+ * again whenever it cascades.
+ *
+ * Reference counted: the client and every session holding timers keep it alive,
+ * so that timers may still be cancelled after the client stopped it.
+ */
+class UniMRCPTimerWheel {
+public:
+	UniMRCPTimerWheel() THROWS(UniMRCPException);
+
+	/** @brief Take a reference */
+	void Retain();
+	/** @brief Drop a reference, the last one stops and deletes the wheel */
+	void Release();
+	/** @brief Schedule (or reschedule) timer to expire after timeout_ms */
+	void Add(UniMRCPTimer* timer, unsigned long timeout_ms) THROWS(UniMRCPException);
+	/** @brief Cancel timer. If it is just being fired from another thread, waits for the callback to return. */
+	void Cancel(UniMRCPTimer* timer);
+	/** @brief Stop the thread for good, scheduled timers are not fired but detached */
+	void Stop();
+
+private:
+	enum {
+		LEVEL_BITS = 6,
+		LEVEL_SIZE = 1 << LEVEL_BITS,
+		LEVEL_MASK = LEVEL_SIZE - 1,
+		LEVELS     = 4
+	};
+
+	~UniMRCPTimerWheel();
+
+	apr_pool_t*         pool;
+	apr_thread_mutex_t* mutex;
+	apr_thread_cond_t*  cond;       ///< Wakes up the thread
+	apr_thread_cond_t*  fired;      ///< Signalled when a callback returns
+	apr_thread_t*       thread;
+	apr_os_thread_t     threadId;
+	volatile apr_uint32_t refs;
+	bool                running;
+	bool                stopped;    ///< No more timers accepted
+	apr_time_t          start;      ///< Time of tick 0
+	apr_uint64_t        now;        ///< Current tick
+	apr_size_t          count;      ///< Scheduled timers
+	UniMRCPTimer*       current;    ///< Timer being fired
+	UniMRCPTimer*       expired;    ///< Expired timers not fired yet
+	UniMRCPTimer*       slots[LEVELS][LEVEL_SIZE];
+
+	void Link(UniMRCPTimer** list, UniMRCPTimer* timer);
+	void Unlink(UniMRCPTimer* timer);
+	void Place(UniMRCPTimer* timer);
+	void Tick();
+	void Detach(UniMRCPTimer** list);
+	static void* APR_THREAD_FUNC Run(apr_thread_t* thread, void* data);
+
+	friend class UniMRCPTest;  ///< Tests/WrapperTest.cpp includes this file
+};
+
+
+UniMRCPTimerWheel::UniMRCPTimerWheel() THROWS(UniMRCPException) :
+	pool(NULL),
+	mutex(NULL),
+	cond(NULL),
+	fired(NULL),
+	thread(NULL),
+	refs(1),
+	running(false),
+	stopped(false),
+	start(apr_time_now()),
+	now(0),
+	count(0),
+	current(NULL),
+	expired(NULL)
+{
+	memset(&threadId, 0, sizeof(threadId));
+	memset(slots, 0, sizeof(slots));
+	/* Not from the client pool, sessions may cancel their timers after the client is destroyed */
+	pool = apt_pool_create();
+	if (!pool)
+		UNIMRCP_THROW("Cannot create timer memory pool");
+	if ((apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&cond, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&fired, pool) != APR_SUCCESS))
+	{
+		apr_pool_destroy(pool);
+		UNIMRCP_THROW("Cannot create timer synchronization objects");
 	}
-	/* start MRCP client stack processing */
-	if (mrcp_client_start(client) == FALSE) {
-		mrcp_application_destroy(app);
-		app = NULL;
-		mrcp_client_destroy(client);
-		client = NULL;
-		UNIMRCP_THROW("Cannot start UniMRCP client");
+}
+
+
+UniMRCPTimerWheel::~UniMRCPTimerWheel()
+{
+	Stop();
+	apr_pool_destroy(pool);
+}
+
+
+void UniMRCPTimerWheel::Retain()
+{
+	apr_atomic_inc32(&refs);
+}
+
+
+void UniMRCPTimerWheel::Release()
+{
+	if (!apr_atomic_dec32(&refs))
+		delete this;
+}
+
+
+void UniMRCPTimerWheel::Link(UniMRCPTimer** list, UniMRCPTimer* timer)
+{
+	timer->next = *list;
+	if (timer->next)
+		timer->next->pprev = &timer->next;
+	timer->pprev = list;
+	*list = timer;
+}
+
+
+void UniMRCPTimerWheel::Unlink(UniMRCPTimer* timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next)
+		timer->next->pprev = timer->pprev;
+	timer->next = NULL;
+	timer->pprev = NULL;
+}
+
+
+void UniMRCPTimerWheel::Place(UniMRCPTimer* timer)
+{
+	apr_uint64_t delta = (timer->expires > now) ? timer->expires - now : 0;
+	apr_uint64_t at = timer->expires;
+	int level = 0;
+	while ((level < LEVELS - 1) && (delta >= (APR_UINT64_C(1) << (LEVEL_BITS * (level + 1)))))
+		level++;
+	/* Out of range, wait in the farthest slot and get placed again when it cascades */
+	if (delta >= (APR_UINT64_C(1) << (LEVEL_BITS * LEVELS)))
+		at = now + (APR_UINT64_C(1) << (LEVEL_BITS * LEVELS)) - 1;
+	if (!delta)
+		Link(&expired, timer);
+	else
+		Link(&slots[level][(at >> (LEVEL_BITS * level)) & LEVEL_MASK], timer);
+}
+
+
+void UniMRCPTimerWheel::Tick()
+{
+	now++;
+	/* Cascade timers from upper levels once the lower level completes its turn */
+	for (int level = 1; level < LEVELS; level++) {
+		if (now & ((APR_UINT64_C(1) << (LEVEL_BITS * level)) - 1))
+			break;
+		UniMRCPTimer** slot = &slots[level][(now >> (LEVEL_BITS * level)) & LEVEL_MASK];
+		while (*slot) {
+			UniMRCPTimer* t = *slot;
+			Unlink(t);
+			Place(t);
+		}
+	}
+	UniMRCPTimer** slot = &slots[0][now & LEVEL_MASK];
+	while (*slot) {
+		UniMRCPTimer* t = *slot;
+		Unlink(t);
+		Link(&expired, t);
 	}
-	instances++;
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s UniMRCPClient created: client(%pp) app(%pp) instances(%u) this(%pp)",
-		swig_target_platform, client, app, instances, this);
 }
 
 
+void UniMRCPTimerWheel::Detach(UniMRCPTimer** list)
+{
+	while (*list) {
+		UniMRCPTimer* t = *list;
+		Unlink(t);
+		t->wheel = NULL;
+		count--;
+	}
+}
+
 
-UniMRCPClient::~UniMRCPClient()
+void UniMRCPTimerWheel::Add(UniMRCPTimer* timer, unsigned long timeout_ms) THROWS(UniMRCPException)
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPClient: client(%pp) app(%pp) this(%pp)",
-		swig_target_platform, client, app, this);
-	Destroy();
+	apr_thread_mutex_lock(mutex);
+	if (stopped) {
+		apr_thread_mutex_unlock(mutex);
+		UNIMRCP_THROW("Timer wheel stopped");
+	}
+	if (!thread) {
+		running = true;
+		if (apr_thread_create(&thread, NULL, Run, this, pool) != APR_SUCCESS) {
+			running = false;
+			thread = NULL;
+			apr_thread_mutex_unlock(mutex);
+			UNIMRCP_THROW("Cannot start timer thread");
+		}
+	}
+	if (timer->pprev)
+		Unlink(timer);
+	else if (!count++) {
+		/* The thread does not turn an empty wheel, catch up with the clock */
+		now = static_cast<apr_uint64_t>((apr_time_now() - start) / apr_time_from_msec(UW_TIMER_TICK_MS));
+	}
+	timer->wheel = this;
+	/* Round up, the timer must never fire early */
+	timer->expires = now + (timeout_ms + UW_TIMER_TICK_MS - 1) / UW_TIMER_TICK_MS + 1;
+	Place(timer);
+	apr_thread_cond_signal(cond);
+	apr_thread_mutex_unlock(mutex);
 }
 
 
-void UniMRCPClient::Destroy()
+void UniMRCPTimerWheel::Cancel(UniMRCPTimer* timer)
 {
-	if (client && !terminated) {
-		terminated = true;
-		mrcp_client_shutdown(client);
-		mrcp_client_destroy(client);
-		app = NULL;
-		client = NULL;
-		instances--;
-		apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s UniMRCPClient (%pp) destroyed, instances(%u)",
-			swig_target_platform, this, instances);
+	apr_thread_mutex_lock(mutex);
+	if (timer->pprev) {
+		Unlink(timer);
+		count--;
 	}
+	while ((current == timer) && !apr_os_thread_equal(threadId, apr_os_thread_current()))
+		apr_thread_cond_wait(fired, mutex);
+	apr_thread_mutex_unlock(mutex);
 }
 
 
-apt_bool_t UniMRCPClient::AppMessageHandler(mrcp_app_message_t const* msg)
+void UniMRCPTimerWheel::Stop()
 {
-	static const mrcp_app_message_dispatcher_t appDisp =
-	{
-		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_sig_status_code_e)>(
-			UniMRCPClientSession::AppOnSessionUpdate),
-		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_sig_status_code_e)>(
-			UniMRCPClientSession::AppOnSessionTerminate),
-		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_channel_t*, mrcp_sig_status_code_e)>(
-			UniMRCPClientChannel::AppOnChannelAdd),
-		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_channel_t*, mrcp_sig_status_code_e)>(
-			UniMRCPClientChannel::AppOnChannelRemove),
-		UniMRCPClientChannel::AppOnMessageReceive,
-		UniMRCPClientSession::AppOnTerminateEvent,
-		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_session_descriptor_t*, mrcp_sig_status_code_e)>(
-			UniMRCPClientSession::AppOnResourceDiscover)
+	apr_thread_mutex_lock(mutex);
+	apr_thread_t* t = thread;
+	running = false;
+	stopped = true;
+	apr_thread_cond_signal(cond);
+	apr_thread_mutex_unlock(mutex);
+	if (t) {
+		apr_status_t rv;
+		apr_thread_join(&rv, t);
+		thread = NULL;
+	}
+	/* Their owners may still cancel them, that must not touch the slots anymore */
+	apr_thread_mutex_lock(mutex);
+	for (int level = 0; level < LEVELS; level++)
+		for (int i = 0; i < LEVEL_SIZE; i++)
+			Detach(&slots[level][i]);
+	Detach(&expired);
+	apr_thread_mutex_unlock(mutex);
+}
+
+
+void* APR_THREAD_FUNC UniMRCPTimerWheel::Run(apr_thread_t* thread, void* data)
+{
+	UniMRCPTimerWheel* w = static_cast<UniMRCPTimerWheel*>(data);
+	apr_interval_time_t tick = apr_time_from_msec(UW_TIMER_TICK_MS);
+	UW_LOG(APT_PRIO_DEBUG, "%s Timer thread started: wheel(%pp)",
+		swig_target_platform, w);
+	apr_thread_mutex_lock(w->mutex);
+	w->threadId = apr_os_thread_current();
+	while (w->running) {
+		apr_uint64_t target = static_cast<apr_uint64_t>((apr_time_now() - w->start) / tick);
+		/* Idle, nothing to tick through, Add() does the same */
+		if (!w->count)
+			w->now = target;
+		while ((w->now < target) && !w->expired)
+			w->Tick();
+		if (w->expired) {
+			/* Fire one at a time, so that Cancel can remove the rest meanwhile */
+			UniMRCPTimer* t = w->expired;
+			w->Unlink(t);
+			w->count--;
+			w->current = t;
+			apr_thread_mutex_unlock(w->mutex);
+			t->callback(t);
+			apr_thread_mutex_lock(w->mutex);
+			w->current = NULL;
+			apr_thread_cond_broadcast(w->fired);
+			continue;
+		}
+		if (w->count)
+			apr_thread_cond_timedwait(w->cond, w->mutex, w->start + (w->now + 1) * tick - apr_time_now());
+		else
+			apr_thread_cond_wait(w->cond, w->mutex);
+	}
+	apr_thread_mutex_unlock(w->mutex);
+	UW_LOG(APT_PRIO_DEBUG, "%s Timer thread stopped: wheel(%pp)",
+		swig_target_platform, w);
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+
+/** @brief Callback dispatcher queue cell */
+struct UniMRCPDispatchCell {
+	volatile apr_uint32_t     seq;     ///< Sequence number telling whether the cell is free or filled
+	mrcp_app_message_t const* msg;     ///< Queued message, NULL for a task
+	void                    (*task)(void*);
+	void*                     obj;     ///< Argument of the task
+	apr_time_t                queued;  ///< When queued
+};
+
+
+/**
+ * @brief Pool of callback worker threads.
+ *
+ * Every worker has a bounded lock-free multiple-producer single-consumer queue (ring of cells
+ * with sequence numbers), the worker is chosen by hash of the session. Tasks of the wrapper
+ * itself are queued the same way.
+ */
+class UniMRCPDispatcher {
+public:
+	typedef int (*Handler)(mrcp_app_message_t const* msg);
+
+	UniMRCPDispatcher(apr_pool_t* pool, Handler handler, unsigned threads, unsigned queue_size) THROWS(UniMRCPException);
+	~UniMRCPDispatcher();
+
+	/**
+	 * @brief Queue message to its session's worker, blocks while the queue is full
+	 * @return False if stopped, the caller is to run the callback itself
+	 */
+	bool Push(mrcp_app_message_t const* msg);
+	/** @brief Queue a call of task(obj) to the worker chosen by obj, false if stopped or the queue is full */
+	bool PushTask(void (*task)(void*), void* obj);
+	/** @brief Run the callbacks still queued and stop the workers, Push() refuses messages from now on */
+	void Stop();
+	void GetStats(UniMRCPDispatchStats& stats) const;
+
+private:
+	struct Worker {
+		UniMRCPDispatcher*    owner;
+		apr_thread_t*         thread;
+		apr_thread_mutex_t*   mutex;
+		apr_thread_cond_t*    cond;
+		apr_thread_cond_t*    space;       ///< Signaled by the worker when a producer waits for a free cell
+		volatile apr_uint32_t sleeping;    ///< Waiting for cond, producers must signal
+		volatile apr_uint32_t blocked;     ///< Producers waiting for space
+		UniMRCPDispatchCell*  cells;
+		volatile apr_uint32_t enqueuePos;  ///< Shared by producers
+		volatile apr_uint32_t dequeuePos;  ///< Owned by the worker
+		/* Statistics, written by the worker only */
+		apr_uint64_t          dispatched;
+		apr_uint64_t          latencySum;
+		apr_interval_time_t   latencyMax;
+		volatile apr_uint32_t depthMax;
 	};
-	return mrcp_application_message_dispatch(&appDisp, msg);
+
+	Handler               handler;
+	Worker*               workers;
+	unsigned              count;
+	apr_uint32_t          mask;
+	volatile apr_uint32_t running;
+	volatile apr_uint32_t pushing;    ///< Producers in Push(), Stop() waits for them
+	volatile apr_uint32_t queueFull;
+
+	bool Post(void const* key, mrcp_app_message_t const* msg, void (*task)(void*), void* obj, bool wait);
+	bool Enqueue(Worker* w, mrcp_app_message_t const* msg, void (*task)(void*), void* obj);
+	bool Dequeue(Worker* w, UniMRCPDispatchCell& out);
+	void Call(UniMRCPDispatchCell const& cell);
+	static void Wake(Worker* w);
+	static void* APR_THREAD_FUNC Run(apr_thread_t* thread, void* data);
+};
+
+
+UniMRCPDispatcher::UniMRCPDispatcher(apr_pool_t* pool, Handler _handler, unsigned threads, unsigned queue_size) THROWS(UniMRCPException) :
+	handler(_handler),
+	workers(NULL),
+	count(0),
+	mask(1),
+	running(1),
+	pushing(0),
+	queueFull(0)
+{
+	if (!threads || (queue_size < 2) || (queue_size > 0x10000000))
+		UNIMRCP_THROW("Invalid dispatcher thread count or queue size");
+	while (mask < queue_size)
+		mask <<= 1;
+	mask--;
+	workers = static_cast<Worker*>(apr_pcalloc(pool, sizeof(Worker) * threads));
+	for (unsigned i = 0; i < threads; i++) {
+		Worker* w = &workers[i];
+		w->owner = this;
+		w->cells = static_cast<UniMRCPDispatchCell*>(apr_pcalloc(pool, sizeof(UniMRCPDispatchCell) * (mask + 1)));
+		for (apr_uint32_t c = 0; c <= mask; c++)
+			w->cells[c].seq = c;
+		if ((apr_thread_mutex_create(&w->mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+			(apr_thread_cond_create(&w->cond, pool) != APR_SUCCESS) ||
+			(apr_thread_cond_create(&w->space, pool) != APR_SUCCESS) ||
+			(apr_thread_create(&w->thread, NULL, Run, w, pool) != APR_SUCCESS))
+		{
+			Stop();
+			UNIMRCP_THROW("Cannot start dispatcher worker");
+		}
+		count++;
+	}
+}
+
+
+UniMRCPDispatcher::~UniMRCPDispatcher()
+{
+	Stop();
+}
+
+
+bool UniMRCPDispatcher::Enqueue(Worker* w, mrcp_app_message_t const* msg, void (*task)(void*), void* obj)
+{
+	apr_uint32_t pos = apr_atomic_read32(&w->enqueuePos);
+	UniMRCPDispatchCell* cell;
+	for (;;) {
+		cell = &w->cells[pos & mask];
+		apr_int32_t dif = static_cast<apr_int32_t>(apr_atomic_read32(&cell->seq) - pos);
+		if (!dif) {
+			apr_uint32_t cur = apr_atomic_cas32(&w->enqueuePos, pos + 1, pos);
+			if (cur == pos)
+				break;
+			pos = cur;
+		} else if (dif < 0)
+			return false;
+		else
+			pos = apr_atomic_read32(&w->enqueuePos);
+	}
+	cell->msg = msg;
+	cell->task = task;
+	cell->obj = obj;
+	cell->queued = apr_time_now();
+	apr_atomic_xchg32(&cell->seq, pos + 1);
+	return true;
+}
+
+
+bool UniMRCPDispatcher::Dequeue(Worker* w, UniMRCPDispatchCell& out)
+{
+	apr_uint32_t pos = w->dequeuePos;
+	UniMRCPDispatchCell* cell = &w->cells[pos & mask];
+	if (apr_atomic_read32(&cell->seq) != pos + 1)
+		return false;
+	out.msg = cell->msg;
+	out.task = cell->task;
+	out.obj = cell->obj;
+	out.queued = cell->queued;
+	w->dequeuePos = pos + 1;
+	apr_atomic_xchg32(&cell->seq, pos + mask + 1);
+	return true;
+}
+
+
+void UniMRCPDispatcher::Wake(Worker* w)
+{
+	if (!apr_atomic_read32(&w->sleeping))
+		return;
+	apr_thread_mutex_lock(w->mutex);
+	apr_thread_cond_signal(w->cond);
+	apr_thread_mutex_unlock(w->mutex);
+}
+
+
+bool UniMRCPDispatcher::Push(mrcp_app_message_t const* msg)
+{
+	/* Same session, same worker, so that callbacks keep their order */
+	return Post(msg->session, msg, NULL, NULL, true);
+}
+
+
+bool UniMRCPDispatcher::PushTask(void (*task)(void*), void* obj)
+{
+	/* Never waits, a worker blocked on the caller (e.g. in UniMRCPTimerWheel::Cancel()) would not free a cell */
+	return Post(obj, NULL, task, obj, false);
+}
+
+
+bool UniMRCPDispatcher::Post(void const* key, mrcp_app_message_t const* msg, void (*task)(void*), void* obj, bool wait)
+{
+	/* Announce before checking, Stop() clears running first and then waits for the producers */
+	apr_atomic_inc32(&pushing);
+	if (!apr_atomic_read32(&running)) {
+		apr_atomic_dec32(&pushing);
+		return false;
+	}
+	apr_size_t h = reinterpret_cast<apr_size_t>(key);
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+	Worker* w = &workers[h % count];
+	if (!Enqueue(w, msg, task, obj)) {
+		if (!wait) {
+			apr_atomic_dec32(&pushing);
+			return false;
+		}
+		apr_atomic_inc32(&queueFull);
+		apr_thread_mutex_lock(w->mutex);
+		/* The worker frees a cell before checking blocked, we check the cells after setting it */
+		apr_atomic_inc32(&w->blocked);
+		while (!Enqueue(w, msg, task, obj)) {
+			apr_thread_cond_signal(w->cond);
+			apr_thread_cond_wait(w->space, w->mutex);
+		}
+		apr_atomic_dec32(&w->blocked);
+		apr_thread_mutex_unlock(w->mutex);
+	}
+	Wake(w);
+	apr_atomic_dec32(&pushing);
+	return true;
+}
+
+
+void UniMRCPDispatcher::Stop()
+{
+	if (!count)
+		return;
+	apr_atomic_set32(&running, 0);
+	/* Workers keep emptying the queues, so that a blocked producer gets through */
+	for (unsigned i = 0; i < count; i++)
+		Wake(&workers[i]);
+	while (apr_atomic_read32(&pushing))
+		apr_thread_yield();
+	for (unsigned i = 0; i < count; i++) {
+		Worker* w = &workers[i];
+		apr_thread_mutex_lock(w->mutex);
+		apr_thread_cond_signal(w->cond);
+		apr_thread_mutex_unlock(w->mutex);
+		apr_status_t rv;
+		apr_thread_join(&rv, w->thread);
+		/* Queued after the worker saw its queue empty */
+		UniMRCPDispatchCell cell;
+		while (Dequeue(w, cell))
+			Call(cell);
+	}
+	count = 0;
+}
+
+
+void UniMRCPDispatcher::GetStats(UniMRCPDispatchStats& stats) const
+{
+	apr_uint64_t latencySum = 0;
+	memset(&stats, 0, sizeof(stats));
+	stats.threads = count;
+	for (unsigned i = 0; i < count; i++) {
+		Worker const* w = &workers[i];
+		stats.queueDepth += w->enqueuePos - w->dequeuePos;
+		if (w->depthMax > stats.queueDepthMax)
+			stats.queueDepthMax = w->depthMax;
+		stats.dispatched += w->dispatched;
+		latencySum += w->latencySum;
+		if (static_cast<unsigned long>(w->latencyMax) > stats.latencyMaxUs)
+			stats.latencyMaxUs = static_cast<unsigned long>(w->latencyMax);
+	}
+	stats.queueFull = queueFull;
+	if (stats.dispatched)
+		stats.latencyAvgUs = static_cast<unsigned long>(latencySum / stats.dispatched);
+}
+
+
+void UniMRCPDispatcher::Call(UniMRCPDispatchCell const& cell)
+{
+	if (cell.msg)
+		handler(cell.msg);
+	else
+		cell.task(cell.obj);
+}
+
+
+void* APR_THREAD_FUNC UniMRCPDispatcher::Run(apr_thread_t* thread, void* data)
+{
+	Worker* w = static_cast<Worker*>(data);
+	UniMRCPDispatcher* d = w->owner;
+	UniMRCPDispatchCell cell;
+	for (;;) {
+		if (d->Dequeue(w, cell)) {
+			apr_uint32_t depth = w->enqueuePos - w->dequeuePos + 1;
+			if (depth > w->depthMax)
+				w->depthMax = depth;
+			apr_interval_time_t latency = apr_time_now() - cell.queued;
+			w->dispatched++;
+			w->latencySum += latency;
+			if (latency > w->latencyMax)
+				w->latencyMax = latency;
+			if (apr_atomic_read32(&w->blocked)) {
+				apr_thread_mutex_lock(w->mutex);
+				apr_thread_cond_signal(w->space);
+				apr_thread_mutex_unlock(w->mutex);
+			}
+			d->Call(cell);
+			continue;
+		}
+		if (!apr_atomic_read32(&d->running))
+			break;
+		apr_thread_mutex_lock(w->mutex);
+		/* Announce sleeping before the last check, a producer signals then */
+		apr_atomic_xchg32(&w->sleeping, 1);
+		UniMRCPDispatchCell* next = &w->cells[w->dequeuePos & d->mask];
+		if ((apr_atomic_read32(&next->seq) != w->dequeuePos + 1) && apr_atomic_read32(&d->running))
+			apr_thread_cond_wait(w->cond, w->mutex);
+		apr_atomic_xchg32(&w->sleeping, 0);
+		apr_thread_mutex_unlock(w->mutex);
+	}
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+
+#ifndef UW_LOG_RECORD_SIZE
+/** @brief Longest message passed through the asynchronous logging queue */
+#	define UW_LOG_RECORD_SIZE MAX_LOG_ENTRY_SIZE
+#endif
+
+#ifndef UW_LOG_INLINE_SIZE
+/** @brief Messages up to this long are kept in the queue cell, longer ones are allocated */
+#	define UW_LOG_INLINE_SIZE 224
+#endif
+
+/** @brief Most cells of the asynchronous logging queue */
+#define UW_LOG_QUEUE_MAX 0x10000
+
+/** @brief Asynchronous logging queue cell */
+struct UniMRCPLogCell {
+	volatile apr_uint32_t seq;                       ///< Sequence number telling whether the cell is free or filled
+	char const*           file;
+	int                   line;
+	UniMRCPLogPriority    priority;
+	char*                 longText;                  ///< Allocated by malloc if the text does not fit, NULL otherwise
+	char                  text[UW_LOG_INLINE_SIZE];
+};
+
+
+/**
+ * @brief Asynchronous logging queue and its thread.
+ *
+ * Bounded lock-free multiple-producer single-consumer ring like the dispatcher's,
+ * producers format the message into the cell they claimed. Only messages longer
+ * than the cell are allocated, so that the ring stays small.
+ */
+class UniMRCPLogQueue {
+public:
+	UniMRCPLogQueue(apr_pool_t* pool, unsigned queue_size) THROWS(UniMRCPException);
+	~UniMRCPLogQueue();
+
+	/** @brief Format and queue a message, drop it if the queue is full */
+	void Push(char const* file, int line, UniMRCPLogPriority priority, char const* format, va_list arg_ptr);
+	/** @brief Write out the messages still queued and stop the thread */
+	void Stop();
+	void GetStats(UniMRCPLogStats& stats) const;
+
+private:
+	apr_thread_t*         thread;
+	apr_thread_mutex_t*   mutex;
+	apr_thread_cond_t*    cond;
+	UniMRCPLogCell*       cells;
+	apr_uint32_t          mask;
+	volatile apr_uint32_t running;
+	volatile apr_uint32_t sleeping;    ///< Waiting for cond, producers must signal
+	volatile apr_uint32_t enqueuePos;  ///< Shared by producers
+	volatile apr_uint32_t dequeuePos;  ///< Owned by the thread
+	volatile apr_uint32_t dropped;
+	apr_uint32_t          reported;    ///< Drops already logged
+	volatile apr_uint32_t logged;
+
+	/** @brief Write all queued messages */
+	void Drain();
+	static void* APR_THREAD_FUNC Run(apr_thread_t* thread, void* data);
+};
+
+/** @brief Active asynchronous logging queue, NULL if logging is synchronous */
+static UniMRCPLogQueue* logQueue = NULL;
+
+
+UniMRCPLogQueue::UniMRCPLogQueue(apr_pool_t* pool, unsigned queue_size) THROWS(UniMRCPException) :
+	thread(NULL),
+	mutex(NULL),
+	cond(NULL),
+	cells(NULL),
+	mask(1),
+	running(1),
+	sleeping(0),
+	enqueuePos(0),
+	dequeuePos(0),
+	dropped(0),
+	reported(0),
+	logged(0)
+{
+	if ((queue_size < 2) || (queue_size > UW_LOG_QUEUE_MAX))
+		UNIMRCP_THROW("Invalid logging queue size");
+	while (mask < queue_size)
+		mask <<= 1;
+	mask--;
+	cells = static_cast<UniMRCPLogCell*>(apr_palloc(pool, sizeof(UniMRCPLogCell) * (mask + 1)));
+	if (!cells)
+		UNIMRCP_THROW("Insufficient memory");
+	for (apr_uint32_t c = 0; c <= mask; c++)
+		cells[c].seq = c;
+	if ((apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&cond, pool) != APR_SUCCESS) ||
+		(apr_thread_create(&thread, NULL, Run, this, pool) != APR_SUCCESS))
+	{
+		thread = NULL;
+		UNIMRCP_THROW("Cannot start logging thread");
+	}
+}
+
+
+UniMRCPLogQueue::~UniMRCPLogQueue()
+{
+	Stop();
+}
+
+
+void UniMRCPLogQueue::Push(char const* file, int line, UniMRCPLogPriority priority, char const* format, va_list arg_ptr)
+{
+	apr_uint32_t pos = apr_atomic_read32(&enqueuePos);
+	UniMRCPLogCell* cell;
+	for (;;) {
+		cell = &cells[pos & mask];
+		apr_int32_t dif = static_cast<apr_int32_t>(apr_atomic_read32(&cell->seq) - pos);
+		if (!dif) {
+			apr_uint32_t cur = apr_atomic_cas32(&enqueuePos, pos + 1, pos);
+			if (cur == pos)
+				break;
+			pos = cur;
+		} else if (dif < 0) {
+			apr_atomic_inc32(&dropped);
+			return;
+		} else
+			pos = apr_atomic_read32(&enqueuePos);
+	}
+	cell->file = file;
+	cell->line = line;
+	cell->priority = priority;
+	cell->longText = NULL;
+	char buf[UW_LOG_RECORD_SIZE];
+	buf[0] = 0;
+	apr_size_t len = apr_vsnprintf(buf, sizeof(buf), format, arg_ptr);
+	if (len >= sizeof(cell->text))
+		cell->longText = static_cast<char*>(malloc(len + 1));
+	if (cell->longText)
+		memcpy(cell->longText, buf, len + 1);
+	else
+		apr_cpystrn(cell->text, buf, sizeof(cell->text));
+	apr_atomic_xchg32(&cell->seq, pos + 1);
+	if (apr_atomic_read32(&sleeping)) {
+		apr_thread_mutex_lock(mutex);
+		apr_thread_cond_signal(cond);
+		apr_thread_mutex_unlock(mutex);
+	}
+}
+
+
+void UniMRCPLogQueue::Drain()
+{
+	for (;;) {
+		apr_uint32_t pos = dequeuePos;
+		UniMRCPLogCell* cell = &cells[pos & mask];
+		if (apr_atomic_read32(&cell->seq) != pos + 1)
+			break;
+		UniMRCPLogger* l = UniMRCPLogger::logger;
+		if (l) {
+			l->Log(cell->file, static_cast<unsigned>(cell->line), cell->priority,
+				cell->longText ? cell->longText : cell->text);
+			apr_atomic_inc32(&logged);
+		}
+		free(cell->longText);
+		cell->longText = NULL;
+		apr_atomic_set32(&dequeuePos, pos + 1);
+		apr_atomic_xchg32(&cell->seq, pos + mask + 1);
+	}
+	apr_uint32_t lost = apr_atomic_read32(&dropped);
+	if (lost != reported) {
+		char buf[80];
+		apr_snprintf(buf, sizeof(buf), "%s logging queue full, %u messages dropped",
+			swig_target_platform, static_cast<unsigned>(lost - reported));
+		reported = lost;
+		UniMRCPLogger* l = UniMRCPLogger::logger;
+		if (l)
+			l->Log(__FILE__, __LINE__, ENUM_MEM(APT_PRIO_, WARNING), buf);
+	}
+}
+
+
+void UniMRCPLogQueue::Stop()
+{
+	if (!thread)
+		return;
+	apr_atomic_set32(&running, 0);
+	apr_thread_mutex_lock(mutex);
+	apr_thread_cond_signal(cond);
+	apr_thread_mutex_unlock(mutex);
+	apr_status_t rv;
+	apr_thread_join(&rv, thread);
+	thread = NULL;
+}
+
+
+void UniMRCPLogQueue::GetStats(UniMRCPLogStats& stats) const
+{
+	stats.capacity = mask + 1;
+	stats.queueDepth = apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&enqueuePos)) -
+		apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&dequeuePos));
+	stats.logged = apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&logged));
+	stats.dropped = apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&dropped));
+}
+
+
+void* APR_THREAD_FUNC UniMRCPLogQueue::Run(apr_thread_t* thread, void* data)
+{
+	UniMRCPLogQueue* q = static_cast<UniMRCPLogQueue*>(data);
+	for (;;) {
+		q->Drain();
+		if (!apr_atomic_read32(&q->running))
+			break;
+		apr_thread_mutex_lock(q->mutex);
+		/* Announce sleeping before the last check, a producer signals then */
+		apr_atomic_xchg32(&q->sleeping, 1);
+		UniMRCPLogCell* next = &q->cells[q->dequeuePos & q->mask];
+		if ((apr_atomic_read32(&next->seq) != q->dequeuePos + 1) && apr_atomic_read32(&q->running))
+			apr_thread_cond_wait(q->cond, q->mutex);
+		apr_atomic_xchg32(&q->sleeping, 0);
+		apr_thread_mutex_unlock(q->mutex);
+	}
+	q->Drain();
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+
+/** @brief Trace log file version, see Tools/uwtrace.py */
+#define UW_TRACE_VERSION 1
+/** @brief Resource of records without a channel */
+#define UW_TRACE_NO_RESOURCE 0xFFFF
+
+/** @brief Trace log file header, followed by the ring of records */
+struct UniMRCPTraceHeader {
+	char                  magic[8];    ///< "UWTRACE"
+	apr_uint32_t          byteOrder;   ///< 0x01020304 in byte order of the writer
+	apr_uint32_t          version;
+	apr_uint32_t          recordSize;
+	apr_uint32_t          capacity;    ///< Records in the ring, power of 2
+	volatile apr_uint32_t next;        ///< Records claimed so far
+	apr_uint32_t          reserved;
+	apr_uint64_t          started;     ///< When the log was started (microseconds since epoch)
+	char                  pad[24];
+};
+
+/** @brief Trace log record */
+struct UniMRCPTraceRecord {
+	volatile apr_uint32_t seq;         ///< Record number + 1 once written, 0 while being written
+	apr_uint16_t          event;       ///< UniMRCPTraceEvent
+	apr_uint16_t          resource;    ///< UniMRCPResource or UW_TRACE_NO_RESOURCE
+	apr_uint64_t          time;        ///< Microseconds since epoch
+	apr_uint32_t          thread;      ///< Writing thread (folded OS thread ID)
+	apr_uint32_t          session;     ///< Session number, 0 if none
+	apr_uint32_t          channel;     ///< Channel number, 0 if none
+	apr_uint32_t          value;       ///< Event specific, see UniMRCPTraceEvent
+	apr_uint64_t          request;     ///< MRCP request ID, 0 if none
+	apr_uint32_t          value1;
+	apr_uint32_t          value2;
+	char                  name[16];    ///< Session name, truncated
+};
+
+/** @brief The decoder relies on the layout */
+typedef char UniMRCPTraceLayoutCheck[((sizeof(UniMRCPTraceHeader) == 64) && (sizeof(UniMRCPTraceRecord) == 64)) ? 1 : -1];
+
+/** @brief Trace log memory pool, child of UniMRCPClient::staticPool */
+static apr_pool_t*           tracePool = NULL;
+static apr_file_t*           traceFile = NULL;
+static apr_mmap_t*           traceMap = NULL;
+static UniMRCPTraceRecord*   traceRecords = NULL;
+/** @brief Mapped header, NULL if tracing is off */
+static UniMRCPTraceHeader*   traceHeader = NULL;
+/** @brief Session and channel numbers given so far */
+static volatile apr_uint32_t traceSessions = 0;
+static volatile apr_uint32_t traceChannels = 0;
+
+
+/** @brief Write a trace record if tracing is on */
+static void TraceEvent(UniMRCPTraceEvent event, mrcp_session_t const* sess, apr_uint32_t session,
+                       apr_uint32_t channel, apr_uint32_t resource, apr_uint32_t value,
+                       apr_uint64_t request = 0, apr_uint32_t value1 = 0, apr_uint32_t value2 = 0)
+{
+	UniMRCPTraceHeader* h = traceHeader;
+	if (!h) return;
+	apr_uint32_t n = apr_atomic_inc32(&h->next);
+	UniMRCPTraceRecord* r = &traceRecords[n & (h->capacity - 1)];
+	apr_atomic_set32(&r->seq, 0);
+	r->event = static_cast<apr_uint16_t>(event);
+	r->resource = static_cast<apr_uint16_t>(resource);
+	r->time = static_cast<apr_uint64_t>(apr_time_now());
+	apr_os_thread_t t = apr_os_thread_current();
+	apr_uint64_t tid = 0;
+	memcpy(&tid, &t, sizeof(t) < sizeof(tid) ? sizeof(t) : sizeof(tid));
+	r->thread = static_cast<apr_uint32_t>(tid ^ (tid >> 32));
+	r->session = session;
+	r->channel = channel;
+	r->value = value;
+	r->request = request;
+	r->value1 = value1;
+	r->value2 = value2;
+	memset(r->name, 0, sizeof(r->name));
+	char const* name = sess ? mrcp_application_session_name_get(sess) : NULL;
+	if (name)
+		strncpy(r->name, name, sizeof(r->name));
+	apr_atomic_xchg32(&r->seq, n + 1);
+}
+
+
+/*
+ * USDT probes of provider unimrcpwrapper, built in with UW_USDT, see Tools/bpftrace.
+ * A probe is a nop until bpftrace or perf attaches to it. Without UW_USDT the
+ * arguments are not even evaluated. Sessions and channels are identified by their
+ * numbers as in the trace log, resources, methods and events by the UniMRCP values.
+ *
+ *   session_create     session, name
+ *   session_update     session, status         (setup or update finished)
+ *   session_terminate  session                 (Terminate() called)
+ *   session_terminated session, status
+ *   session_destroy    session
+ *   channel_add        session, channel, resource
+ *   channel_added      session, channel, resource, status
+ *   channel_remove     session, channel, resource
+ *   channel_removed    session, channel, resource, status
+ *   message_send       session, channel, resource, method (once sent, the response may be in already)
+ *   request_id         session, channel, resource, method, request ID, microseconds since sent
+ *                      (first response matched to the request, the ID is assigned after sending)
+ *   message_receive    session, channel, resource, message type, method or event, request ID
+ *   read_frame_start   session                 (before UniMRCPStreamRx::ReadFrame())
+ *   read_frame_done    session, frame type, supplied
+ *   write_frame_start  session, frame type     (before UniMRCPStreamTx::WriteFrame())
+ *   write_frame_done   session, result
+ *   add_data           session, bytes, bytes queued (UniMRCPStreamRxBuffered::AddData())
+ *   dtmf               session, digit, detected (0 if generated)
+ */
+#ifdef UW_USDT
+#	define UW_PROBE1(name, a)                DTRACE_PROBE1(unimrcpwrapper, name, a)
+#	define UW_PROBE2(name, a, b)             DTRACE_PROBE2(unimrcpwrapper, name, a, b)
+#	define UW_PROBE3(name, a, b, c)          DTRACE_PROBE3(unimrcpwrapper, name, a, b, c)
+#	define UW_PROBE4(name, a, b, c, d)       DTRACE_PROBE4(unimrcpwrapper, name, a, b, c, d)
+#	define UW_PROBE5(name, a, b, c, d, e)    DTRACE_PROBE5(unimrcpwrapper, name, a, b, c, d, e)
+#	define UW_PROBE6(name, a, b, c, d, e, f) DTRACE_PROBE6(unimrcpwrapper, name, a, b, c, d, e, f)
+#else
+#	define UW_PROBE1(name, a)                ((void) 0)
+#	define UW_PROBE2(name, a, b)             ((void) 0)
+#	define UW_PROBE3(name, a, b, c)          ((void) 0)
+#	define UW_PROBE4(name, a, b, c, d)       ((void) 0)
+#	define UW_PROBE5(name, a, b, c, d, e)    ((void) 0)
+#	define UW_PROBE6(name, a, b, c, d, e, f) ((void) 0)
+#endif
+
+
+UniMRCPLogger::~UniMRCPLogger()
+{
+#ifdef _DEBUG
+	printf("~UniMRCPLogger logger(%p)\n", logger);
+#endif
+	logger = NULL;
+}
+
+
+int UniMRCPLogger::LogExtHandler(char const* file, int line, char const* id, UniMRCPLogPriority priority, char const* format, va_list arg_ptr)
+{
+	(void) id;
+	if (!logger) return false;
+	if (logQueue) {
+		logQueue->Push(file, line, priority, format, arg_ptr);
+		return true;
+	}
+	char buf[MAX_LOG_ENTRY_SIZE];
+	buf[0] = 0;
+	apr_vsnprintf(buf, MAX_LOG_ENTRY_SIZE, format, arg_ptr);
+	return logger->Log(file, line, priority, buf);
+}
+
+
+void UniMRCPClient::UniMRCPVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+{
+	major = UNI_MAJOR_VERSION;
+	minor = UNI_MINOR_VERSION;
+	patch = UNI_PATCH_VERSION;
+}
+
+
+void UniMRCPClient::WrapperVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+{
+	major = UW_MAJOR_VERSION;
+	minor = UW_MINOR_VERSION;
+	patch = UW_PATCH_VERSION;
+}
+
+
+void UniMRCPClient::APRVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+{
+	major = APR_MAJOR_VERSION;
+	minor = APR_MINOR_VERSION;
+	patch = APR_PATCH_VERSION;
+}
+
+
+void UniMRCPClient::APRUtilVersion(unsigned short& major, unsigned short& minor, unsigned short& patch)
+{
+	major = APU_MAJOR_VERSION;
+	minor = APU_MINOR_VERSION;
+	patch = APU_PATCH_VERSION;
+}
+
+
+char const* UniMRCPClient::SofiaSIPVersion()
+{
+	return SOFIA_SIP_VERSION;
+}
+
+
+void UniMRCPClient::StaticPreinitialize(int& fd_stdin, int& fd_stdout, int& fd_stderr) THROWS(UniMRCPException)
+{
+	if (staticInitialized) {
+		staticInitialized++;
+#ifdef _DEBUG
+		printf("staticInitialized(%u)\n", staticInitialized);
+#endif
+		return;
+	}
+
+// Must be called once per process when linked statically for SofiaSIP to work
+#if defined(WIN32) && defined(PTW32_STATIC_LIB)
+	if (!pthread_win32_process_attach_np())
+		UNIMRCP_THROW("Cannot initialize pthreads win32");
+#endif
+
+// Switch file descriptors in order to be able to write on console
+#if defined(WIN32) && defined(DOTNET_CONSOLE_HACK)
+	fd_stdin = _fileno(stdin);
+	if (fd_stdin < 0) freopen("CONIN$", "rt", stdin);
+	fd_stdout = _fileno(stdout);
+	if (fd_stdout < 0) freopen("CONOUT$", "wt", stdout);
+	fd_stderr = _fileno(stderr);
+	if (fd_stderr < 0) freopen("CONERR$", "wt", stderr);
+#else
+	(void) fd_stdin;
+	(void) fd_stdout;
+	(void) fd_stderr;
+#endif
+
+	/* APR global initialization */
+	if(apr_initialize() != APR_SUCCESS)
+	{
+		apr_terminate();
+		UNIMRCP_THROW("Error initializing APR");
+	}
+
+	/* Create APR pool */
+	staticPool = apt_pool_create();
+	if (!staticPool)
+		UNIMRCP_THROW("Insufficient memory");
+
+	/* Create process-wide grammar cache */
+	if ((apr_pool_create(&grammarCachePool, staticPool) != APR_SUCCESS) ||
+		(apr_thread_mutex_create(&grammarCacheMutex, APR_THREAD_MUTEX_DEFAULT, grammarCachePool) != APR_SUCCESS))
+	{
+		UNIMRCP_THROW("Cannot create grammar cache");
+	}
+	grammarCache = apr_hash_make(grammarCachePool);
+
+	if (apr_thread_mutex_create(&metricMutex, APR_THREAD_MUTEX_DEFAULT, staticPool) != APR_SUCCESS)
+		UNIMRCP_THROW("Cannot create metrics mutex");
+
+	staticInitialized++;
+#ifdef _DEBUG
+	printf("staticInitialized(%u)\n", staticInitialized);
+#endif
+}
+
+
+void UniMRCPClient::StaticInitialize(char const* root_dir,
+                                     UniMRCPLogPriority log_prio,
+                                     UniMRCPLogOutput log_out,
+                                     char const* log_fname,
+                                     unsigned max_log_fsize,
+                                     unsigned max_log_fcount) THROWS(UniMRCPException)
+{
+	int fd_stdin, fd_stdout, fd_stderr;
+	apt_dir_layout_t* dirLayout;
+	StaticPreinitialize(fd_stdin, fd_stdout, fd_stderr);
+
+	/* create the structure of default directories layout */
+	dirLayout = apt_default_dir_layout_create(root_dir, staticPool);
+
+	/* get path to logger configuration file */
+	const char* logConfPath = apt_confdir_filepath_get(dirLayout, "logger.xml", staticPool);
+	/* create and load singleton logger */
+	apt_log_instance_load(logConfPath, staticPool);
+	/* override the log priority, if specified in command line */
+	apt_log_priority_set(static_cast<apt_log_priority_e>(log_prio));
+	logHandler = NULL;
+	apt_log_output_mode_set(static_cast<apt_log_output_e>(log_out));
+	if (!log_fname) log_fname = unimrcp_client_log_name;
+	if (apt_log_output_mode_check(APT_LOG_OUTPUT_FILE) == TRUE)
+	{
+		/* open the log file */
+#if defined(UNI_VERSION_AT_LEAST) && UNI_VERSION_AT_LEAST(1, 3, 0)
+		apt_log_file_open(apt_dir_layout_path_get(dirLayout, APT_LAYOUT_LOG_DIR),
+			log_fname, max_log_fsize, max_log_fcount, FALSE, staticPool);
+#else
+		apt_log_file_open(dirLayout->log_dir_path, log_fname,
+			max_log_fsize, max_log_fcount, FALSE, staticPool);
+#endif
+	}
+	UW_LOG(APT_PRIO_INFO, "Initialized UniMRCP for %s: log_root_dir(%s) "
+		"log_prio(%d) log_out(%d) log_fname(%s) max_log_fsize(%u) max_log_fcount(%u)",
+		swig_target_platform, root_dir, static_cast<int>(log_prio),
+		static_cast<int>(log_out), log_fname, max_log_fsize, max_log_fcount);
+	StaticPostinitialize(fd_stdin, fd_stdout, fd_stderr);
+}
+
+
+void UniMRCPClient::StaticInitialize(UniMRCPLogger* logger,
+                                     UniMRCPLogPriority log_prio) THROWS(UniMRCPException)
+{
+	int fd_stdin, fd_stdout, fd_stderr;
+	StaticPreinitialize(fd_stdin, fd_stdout, fd_stderr);
+
+	apt_log_instance_create(APT_LOG_OUTPUT_NONE, static_cast<apt_log_priority_e>(log_prio), staticPool);
+	UniMRCPLogger::logger = logger;
+	apt_log_ext_handler_set(reinterpret_cast<apt_log_ext_handler_f>(UniMRCPLogger::LogExtHandler));
+	logHandler = logger ? UniMRCPLogger::LogExtHandler : NULL;
+	UW_LOG(APT_PRIO_INFO, "Initialized UniMRCP for %s: "
+		"logger(%pp) log_prio(%d)", swig_target_platform, logger, static_cast<int>(log_prio));
+	StaticPostinitialize(fd_stdin, fd_stdout, fd_stderr);
+}
+
+
+void UniMRCPClient::StartAsyncLogging(unsigned queue_size /* = 1024 */) THROWS(UniMRCPException)
+{
+	if (!staticInitialized || !UniMRCPLogger::logger)
+		UNIMRCP_THROW("Initialize the platform with a logger first");
+	if (logQueue)
+		UNIMRCP_THROW("Asynchronous logging already started");
+	logQueue = new UniMRCPLogQueue(staticPool, queue_size);
+	UW_LOG(APT_PRIO_INFO, "%s Asynchronous logging started: queue(%u)",
+		swig_target_platform, queue_size);
+}
+
+
+void UniMRCPClient::StartTraceLog(char const* path, unsigned records /* = 65536 */) THROWS(UniMRCPException)
+{
+	if (!staticInitialized)
+		UNIMRCP_THROW("Initialize the platform first");
+	if (traceHeader)
+		UNIMRCP_THROW("Trace log already started");
+	if (!path || (records < 2) || (records > 0x1000000))
+		UNIMRCP_THROW("Invalid trace log file or size");
+	apr_uint32_t capacity = 2;
+	while (capacity < records)
+		capacity <<= 1;
+	apr_size_t size = sizeof(UniMRCPTraceHeader) + capacity * sizeof(UniMRCPTraceRecord);
+	if (apr_pool_create(&tracePool, staticPool) != APR_SUCCESS)
+		UNIMRCP_THROW("Insufficient memory");
+	apr_status_t status = apr_file_open(&traceFile, path,
+		APR_FOPEN_CREATE | APR_FOPEN_READ | APR_FOPEN_WRITE | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY,
+		APR_FPROT_OS_DEFAULT, tracePool);
+	if (status == APR_SUCCESS)
+		status = apr_file_trunc(traceFile, static_cast<apr_off_t>(size));
+	if (status == APR_SUCCESS)
+		status = apr_mmap_create(&traceMap, traceFile, 0, size, APR_MMAP_READ | APR_MMAP_WRITE, tracePool);
+	if (status != APR_SUCCESS) {
+		UW_LOG(APT_PRIO_WARNING, "%s Cannot create trace log %s: %d %pm",
+			swig_target_platform, path, status, &status);
+		apr_pool_destroy(tracePool);
+		tracePool = NULL;
+		traceFile = NULL;
+		traceMap = NULL;
+		UNIMRCP_THROW("Cannot create trace log file");
+	}
+	memset(traceMap->mm, 0, size);
+	UniMRCPTraceHeader* h = static_cast<UniMRCPTraceHeader*>(traceMap->mm);
+	memcpy(h->magic, "UWTRACE", 8);
+	h->byteOrder = 0x01020304;
+	h->version = UW_TRACE_VERSION;
+	h->recordSize = sizeof(UniMRCPTraceRecord);
+	h->capacity = capacity;
+	h->started = static_cast<apr_uint64_t>(apr_time_now());
+	traceRecords = reinterpret_cast<UniMRCPTraceRecord*>(h + 1);
+	/* Published last, writers check only the header */
+	traceHeader = h;
+	UW_LOG(APT_PRIO_INFO, "%s Trace log started: %s records(%u)",
+		swig_target_platform, path, static_cast<unsigned>(capacity));
+}
+
+
+void UniMRCPClient::StopTraceLog() THROWS(UniMRCPException)
+{
+	if (!traceHeader)
+		return;
+	if (instances)
+		UNIMRCP_THROW("Destroy all clients before stopping the trace log");
+	traceHeader = NULL;
+	traceRecords = NULL;
+	apr_mmap_delete(traceMap);
+	apr_file_close(traceFile);
+	apr_pool_destroy(tracePool);
+	traceMap = NULL;
+	traceFile = NULL;
+	tracePool = NULL;
+}
+
+
+void UniMRCPClient::GetLogStats(UniMRCPLogStats& stats)
+{
+	if (logQueue)
+		logQueue->GetStats(stats);
+	else
+		memset(&stats, 0, sizeof(stats));
+}
+
+
+void UniMRCPClient::SetLogSampling(unsigned one_in, UniMRCPLogPriority priority /* = APT_PRIO_DEBUG */)
+{
+	logSamplePriority = priority;
+	/* Different processes sample different sessions */
+	apr_atomic_set32(&logSampleSeq, static_cast<apr_uint32_t>(apr_time_now()));
+	apr_atomic_set32(&logSampling, one_in);
+	UW_LOG(APT_PRIO_INFO, "%s Log sampling: one_in(%u) prio(%d)",
+		swig_target_platform, one_in, static_cast<int>(priority));
+}
+
+
+void UniMRCPClient::StaticPostinitialize(int fd_stdin, int fd_stdout, int fd_stderr)
+{
+#if defined(WIN32) && defined(DOTNET_CONSOLE_HACK)
+	if (fd_stdin < 0) UW_LOG(APT_PRIO_DEBUG,
+		".NET console hack for stdin: old fd: %d, new fd %d", fd_stdin, _fileno(stdin));
+	if (fd_stdout < 0) UW_LOG(APT_PRIO_DEBUG,
+		".NET console hack for stdout: old fd: %d, new fd %d", fd_stdout, _fileno(stdout));
+	if (fd_stderr < 0) UW_LOG(APT_PRIO_DEBUG,
+		".NET console hack for stderr: old fd: %d, new fd %d", fd_stderr, _fileno(stderr));
+#else
+	(void) fd_stdin;
+	(void) fd_stdout;
+	(void) fd_stderr;
+#endif
+}
+
+
+void UniMRCPClient::GetMetrics(UniMRCPMetricsSnapshot& snapshot)
+{
+	if (metricMutex)
+		apr_thread_mutex_lock(metricMutex);
+	for (unsigned i = 0; i < UW_METRIC_CELLS; i++) {
+		apr_uint32_t value = apr_atomic_read32(&metricCells[i].value);
+		if (i <= UW_METRIC_STREAMS) {
+			snapshot.values[i] = value;
+			continue;
+		}
+		/* Unsigned difference is right across a wrap */
+		metricTotal[i] += static_cast<apr_uint32_t>(value - metricSeen[i]);
+		metricSeen[i] = value;
+		snapshot.values[i] = metricTotal[i];
+	}
+	if (metricMutex)
+		apr_thread_mutex_unlock(metricMutex);
+}
+
+
+void UniMRCPClient::GetLatency(UniMRCPLatencyPhase phase, UniMRCPResource resource, unsigned id, UniMRCPLatencyStats& stats)
+{
+	memset(&stats, 0, sizeof(stats));
+	UniMRCPHistogram const* h = LatencyHistogram(phase, resource, id);
+	if (!h)
+		return;
+	/* Copy first, the buckets keep changing */
+	apr_uint32_t counts[HIST_BUCKETS];
+	apr_uint64_t total = 0;
+	double sum = 0;
+	for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+		counts[i] = apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&h->buckets[i]));
+		total += counts[i];
+		sum += static_cast<double>(counts[i]) * static_cast<double>(HistogramValue(i));
+	}
+	if (!total)
+		return;
+	stats.count = total;
+	stats.meanUs = static_cast<unsigned long>(sum / static_cast<double>(total));
+	double const percentiles[] = {50, 90, 99, 99.9};
+	unsigned long* const results[] = {&stats.p50Us, &stats.p90Us, &stats.p99Us, &stats.p999Us};
+	apr_uint64_t seen = 0;
+	unsigned p = 0;
+	for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+		if (!counts[i])
+			continue;
+		if (!seen)
+			stats.minUs = static_cast<unsigned long>(HistogramValue(i));
+		seen += counts[i];
+		stats.maxUs = static_cast<unsigned long>(HistogramValue(i));
+		for (; (p < 4) && (static_cast<double>(seen) >= percentiles[p] / 100 * static_cast<double>(total)); p++)
+			*results[p] = stats.maxUs;
+	}
+}
+
+
+unsigned long UniMRCPClient::GetLatencyPercentile(UniMRCPLatencyPhase phase, UniMRCPResource resource, unsigned id, double percentile)
+{
+	UniMRCPHistogram const* h = LatencyHistogram(phase, resource, id);
+	if (!h)
+		return 0;
+	apr_uint32_t counts[HIST_BUCKETS];
+	apr_uint64_t total = 0;
+	for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+		counts[i] = apr_atomic_read32(const_cast<apr_uint32_t volatile*>(&h->buckets[i]));
+		total += counts[i];
+	}
+	if (!total)
+		return 0;
+	double target = (percentile < 0 ? 0 : percentile > 100 ? 100 : percentile) / 100 * static_cast<double>(total);
+	apr_uint64_t seen = 0;
+	unsigned last = 0;
+	for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+		if (!counts[i])
+			continue;
+		seen += counts[i];
+		last = i;
+		if (static_cast<double>(seen) >= target)
+			break;
+	}
+	return static_cast<unsigned long>(HistogramValue(last));
+}
+
+
+void UniMRCPClient::ResetLatency()
+{
+	UniMRCPHistogram* all[] = {&latencyMsg[0][0][0], latencyChannel, &latencySession, latencyAudio};
+	unsigned const sizes[] = {sizeof(latencyMsg) / sizeof(UniMRCPHistogram), 3, 1, 2};
+	for (unsigned a = 0; a < 4; a++)
+		for (unsigned h = 0; h < sizes[a]; h++)
+			for (unsigned i = 0; i < HIST_BUCKETS; i++)
+				apr_atomic_set32(&all[a][h].buckets[i], 0);
+}
+
+
+UniMRCPMetricsSnapshot::UniMRCPMetricsSnapshot()
+{
+	memset(values, 0, sizeof(values));
+}
+
+
+unsigned long long UniMRCPMetricsSnapshot::Get(UniMRCPMetric metric) const
+{
+	if ((metric < UW_METRIC_CLIENTS) || (metric > UW_METRIC_SESSION_POOL_BYTES))
+		return 0;
+	return values[metric];
+}
+
+
+unsigned long long UniMRCPMetricsSnapshot::GetSent(UniMRCPResource resource, unsigned method) const
+{
+	if ((resource < MRCP_SYNTHESIZER) || (resource > MRCP_RECORDER) || (method >= UW_METRIC_MAX_IDS))
+		return 0;
+	return values[METRIC_MSG_INDEX(METRIC_MSG_SENT, resource, method)];
+}
+
+
+unsigned long long UniMRCPMetricsSnapshot::GetResponses(UniMRCPResource resource, unsigned method) const
+{
+	if ((resource < MRCP_SYNTHESIZER) || (resource > MRCP_RECORDER) || (method >= UW_METRIC_MAX_IDS))
+		return 0;
+	return values[METRIC_MSG_INDEX(METRIC_MSG_RESPONSES, resource, method)];
+}
+
+
+unsigned long long UniMRCPMetricsSnapshot::GetEvents(UniMRCPResource resource, unsigned event) const
+{
+	if ((resource < MRCP_SYNTHESIZER) || (resource > MRCP_RECORDER) || (event >= UW_METRIC_MAX_IDS))
+		return 0;
+	return values[METRIC_MSG_INDEX(METRIC_MSG_EVENTS, resource, event)];
+}
+
+
+void UniMRCPClient::StaticDeinitialize() THROWS(UniMRCPException)
+{
+	if (!staticInitialized) {
+#ifdef _DEBUG
+		printf("staticInitialized(%u) deinitialize\n", staticInitialized);
+#endif
+		return;
+	}
+	if ((staticInitialized == 1) && instances)
+		UNIMRCP_THROW("Destroy all clients before static deinitialization");
+	staticInitialized--;
+	if (staticInitialized) {
+#ifdef _DEBUG
+		printf("staticInitialized(%u) deinitialize\n", staticInitialized);
+#endif
+		return;
+	}
+	StopTraceLog();
+	/* write out and stop asynchronous logging, nothing is logged from now on */
+	if (logQueue) {
+		UniMRCPLogQueue* q = logQueue;
+		logQueue = NULL;
+		delete q;
+	}
+	/* destroy singleton logger */
+	logHandler = NULL;
+	apt_log_instance_destroy();
+	/* destroy APR pool (along with the grammar cache) */
+	apr_pool_destroy(staticPool);
+	staticPool = NULL;
+	grammarCachePool = NULL;
+	grammarCacheMutex = NULL;
+	grammarCache = NULL;
+	metricMutex = NULL;
+	/* APR global termination */
+	apr_terminate();
+
+#	ifdef PTW32_STATIC_LIB
+	pthread_win32_process_detach_np();
+#	endif
+#ifdef _DEBUG
+	printf("staticDeinitialized\n");
+#endif
+}
+
+
+UniMRCPClient::UniMRCPClient(char const* config, bool dir /* = false */)  THROWS(UniMRCPException) :
+	client(NULL),
+	app(NULL),
+	terminated(false),
+	sess_id(1),
+	sessions(0),
+	timers(NULL),
+	disp(NULL),
+	admission(NULL)
+{
+	if (!staticInitialized)
+		UNIMRCP_THROW("UniMRCP platform not statically initialized");
+
+	if (dir) {
+		/* create the structure of default directories layout */
+		apt_dir_layout_t* dirLayout = apt_default_dir_layout_create(config, staticPool);
+		client = unimrcp_client_create(dirLayout);
+	} else
+		client = unimrcp_client_create2(config);
+
+	UW_LOG(APT_PRIO_NOTICE, "Creating %s UniMRCPClient (%pp) instance %u",
+		swig_target_platform, this, instances);
+
+	if (!client)
+		UNIMRCP_THROW("Cannot create UniMRCP client");
+	app = mrcp_application_create(AppMessageHandler, this, mrcp_client_memory_pool_get(client));
+	if (!app) {
+		mrcp_client_destroy(client);
+		client = NULL;
+		UNIMRCP_THROW("Cannot create UniMRCP client application");
+	}
+
+	/* register MRCP application to MRCP client */
+	if (mrcp_client_application_register(client, app, unimrcp_client_app_name) == FALSE) {
+		mrcp_application_destroy(app);
+		app = NULL;
+		mrcp_client_destroy(client);
+		client = NULL;
+		UNIMRCP_THROW("Cannot register UniMRCP client application");
+	}
+	/* start MRCP client stack processing */
+	if (mrcp_client_start(client) == FALSE) {
+		mrcp_application_destroy(app);
+		app = NULL;
+		mrcp_client_destroy(client);
+		client = NULL;
+		UNIMRCP_THROW("Cannot start UniMRCP client");
+	}
+	try {
+		timers = new UniMRCPTimerWheel();
+		admission = new UniMRCPAdmission();
+	} catch (...) {
+		if (timers)
+			timers->Release();
+		timers = NULL;
+		admission = NULL;
+		mrcp_client_shutdown(client);
+		mrcp_client_destroy(client);
+		app = NULL;
+		client = NULL;
+		throw;
+	}
+	instances++;
+	MetricInc(UW_METRIC_CLIENTS);
+	UW_LOG(APT_PRIO_DEBUG, "%s UniMRCPClient created: client(%pp) app(%pp) instances(%u) this(%pp)",
+		swig_target_platform, client, app, instances, this);
+}
+
+
+
+UniMRCPClient::~UniMRCPClient()
+{
+	UW_LOG(APT_PRIO_DEBUG, "%s ~UniMRCPClient: client(%pp) app(%pp) this(%pp)",
+		swig_target_platform, client, app, this);
+	Destroy();
+	/* Sessions left keep their own reference */
+	if (admission)
+		admission->Release();
+	/* Sessions left keep their own reference */
+	if (timers)
+		timers->Release();
+}
+
+
+void UniMRCPClient::Destroy()
+{
+	if (client && !terminated) {
+		terminated = true;
+		/* No deadline may fire into the stack being shut down */
+		timers->Stop();
+		/* Run the callbacks queued while the stack is still up, the rest run on the client task */
+		if (disp)
+			disp->Stop();
+		mrcp_client_shutdown(client);
+		/* Client task is gone, nothing refers to the dispatcher anymore */
+		delete disp;
+		disp = NULL;
+		mrcp_client_destroy(client);
+		app = NULL;
+		client = NULL;
+		instances--;
+		MetricDec(UW_METRIC_CLIENTS);
+		UW_LOG(APT_PRIO_DEBUG, "%s UniMRCPClient (%pp) destroyed, instances(%u)",
+			swig_target_platform, this, instances);
+	}
+}
+
+
+bool UniMRCPClient::Drain(unsigned long timeout_ms)
+{
+	if (!client || terminated)
+		return true;
+	UW_LOG(APT_PRIO_NOTICE, "%s UniMRCPClient (%pp) draining, timeout %lu ms",
+		swig_target_platform, this, timeout_ms);
+	admission->SetDraining();
+	apr_time_t deadline = apr_time_now() + apr_time_from_msec(timeout_ms);
+	unsigned lastSessions = 0, lastRequests = 0;
+	bool first = true;
+	for (;;) {
+		unsigned sessions = 0, requests = 0;
+		unsigned seen = DrainStep(sessions, requests);
+		if (first || (sessions != lastSessions) || (requests != lastRequests)) {
+			OnDrainProgress(sessions, requests);
+			lastSessions = sessions;
+			lastRequests = requests;
+			first = false;
+		}
+		if (!sessions) {
+			UW_LOG(APT_PRIO_NOTICE, "%s UniMRCPClient (%pp) drained",
+				swig_target_platform, this);
+			return true;
+		}
+		if (apr_time_now() >= deadline) {
+			UW_LOG(APT_PRIO_WARNING, "%s UniMRCPClient (%pp) drain timed out, %u sessions with %u requests left",
+				swig_target_platform, this, sessions, requests);
+			return false;
+		}
+		/* Woken by session terminations and completed requests since the step */
+		apr_thread_mutex_lock(admission->regMutex);
+		admission->WaitWake(seen, deadline);
+		apr_thread_mutex_unlock(admission->regMutex);
+	}
+}
+
+
+unsigned UniMRCPClient::DrainStep(unsigned& sessions, unsigned& requests)
+{
+	apr_thread_mutex_lock(admission->regMutex);
+	for (UniMRCPClientSession* s = admission->sessions; s; s = s->admit.next) {
+		if (!s->sess || s->terminated)
+			continue;
+		sessions++;
+		/* Channels may be gone with the session any time now */
+		if (s->admit.drained || s->destroyOnTerminate)
+			continue;
+		unsigned busy = 0;
+		apr_thread_mutex_lock(s->mutex);
+		for (UniMRCPClientChannel* c = s->channels; c; c = c->nextChannel)
+			busy += c->PendingRequests();
+		apr_thread_mutex_unlock(s->mutex);
+		requests += busy;
+		if (!busy) {
+			s->admit.drained = true;
+			s->Terminate();
+		}
+	}
+	unsigned seen = admission->events;
+	apr_thread_mutex_unlock(admission->regMutex);
+	return seen;
+}
+
+
+void UniMRCPClient::OnDrainProgress(unsigned _sessions, unsigned requests)
+{
+	(void) _sessions;
+	(void) requests;
+}
+
+
+void UniMRCPClient::StartDispatcher(unsigned threads, unsigned queue_size /* = 1024 */) THROWS(UniMRCPException)
+{
+	if (!client)
+		UNIMRCP_THROW("UniMRCP client already destroyed");
+	if (disp)
+		UNIMRCP_THROW("Dispatcher already started");
+	if (apr_atomic_read32(&sess_id) != 1)
+		UNIMRCP_THROW("Dispatcher must be started before creating sessions");
+	disp = new UniMRCPDispatcher(mrcp_client_memory_pool_get(client), AppMessageDispatch, threads, queue_size);
+	UW_LOG(APT_PRIO_INFO, "%s UniMRCPClient (%pp) dispatches callbacks to %u threads",
+		swig_target_platform, this, threads);
+}
+
+
+void UniMRCPClient::GetDispatchStats(UniMRCPDispatchStats& stats) const
+{
+	if (disp)
+		disp->GetStats(stats);
+	else
+		memset(&stats, 0, sizeof(stats));
+}
+
+
+unsigned UniMRCPClient::GetSessionCount() const
+{
+	return apr_atomic_read32(const_cast<unsigned volatile*>(&sessions));
+}
+
+
+void UniMRCPClient::SetLimit(UniMRCPLimitType type, unsigned max, long wait_ms /* = 0 */, char const* profile /* = NULL */) THROWS(UniMRCPException)
+{
+	if (!admission)
+		UNIMRCP_THROW("UniMRCP client not created");
+	if ((type < UW_LIMIT_SESSIONS) || (type > UW_LIMIT_REQUESTS))
+		UNIMRCP_THROW("Invalid limit type");
+	admission->SetLimit(profile ? admission->Profile(profile, true) : admission->Client(), type, max, wait_ms);
+}
+
+
+void UniMRCPClient::GetOccupancy(UniMRCPLimitType type, UniMRCPOccupancy& occupancy, char const* profile /* = NULL */) const
+{
+	UniMRCPGateSet* set = NULL;
+	if (admission && (type >= UW_LIMIT_SESSIONS) && (type <= UW_LIMIT_REQUESTS))
+		set = profile ? admission->Profile(profile, false) : admission->Client();
+	if (set)
+		admission->GetOccupancy(set, type, occupancy);
+	else
+		memset(&occupancy, 0, sizeof(occupancy));
+}
+
+
+void UniMRCPClient::AddProfileToGroup(char const* group, char const* profile, unsigned weight /* = 1 */) THROWS(UniMRCPException)
+{
+	if (!admission)
+		UNIMRCP_THROW("UniMRCP client not created");
+	if (!group || !profile || !weight)
+		UNIMRCP_THROW("Group, profile and non-zero weight must be specified");
+	admission->AddMember(group, profile, weight);
+}
+
+
+void UniMRCPClient::SetGroupBalancing(char const* group, UniMRCPBalancing balancing, unsigned long retry_after_ms /* = 5000 */) THROWS(UniMRCPException)
+{
+	UniMRCPProfileGroup* g = (admission && group) ? admission->Group(group) : NULL;
+	if (!g)
+		UNIMRCP_THROW("Unknown profile group");
+	if ((balancing != UW_BALANCE_ROUND_ROBIN) && (balancing != UW_BALANCE_LEAST_OUTSTANDING))
+		UNIMRCP_THROW("Invalid balancing policy");
+	admission->SetBalancing(g, balancing, retry_after_ms);
+}
+
+
+char const* UniMRCPClient::SelectProfile(char const* group) THROWS(UniMRCPException)
+{
+	UniMRCPProfileGroup* g = (admission && group) ? admission->Group(group) : NULL;
+	if (!g)
+		UNIMRCP_THROW("Unknown profile group");
+	apr_uint64_t tried = 0;
+	return admission->Select(g, tried)->profile;
+}
+
+
+bool UniMRCPClient::IsProfileHealthy(char const* group, char const* profile) const
+{
+	return admission && group && profile && admission->IsHealthy(group, profile);
+}
+
+
+/** @brief Number of CPUs the process may run on, online ones where affinity is not known */
+static unsigned CPUCount()
+{
+#ifdef WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors ? static_cast<unsigned>(si.dwNumberOfProcessors) : 1;
+#else
+#ifdef __linux__
+	cpu_set_t allowed;
+	if (!sched_getaffinity(0, sizeof(allowed), &allowed) && CPU_COUNT(&allowed))
+		return static_cast<unsigned>(CPU_COUNT(&allowed));
+#endif
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? static_cast<unsigned>(n) : 1;
+#endif
+}
+
+
+#ifdef __linux__
+/** @brief CPU number of the index-th CPU in allowed, round robin */
+static int AllowedCPU(cpu_set_t const& allowed, unsigned index)
+{
+	int count = CPU_COUNT(&allowed);
+	if (!count)
+		return -1;
+	index %= static_cast<unsigned>(count);
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		if (CPU_ISSET(cpu, &allowed) && !index--)
+			return cpu;
+	return -1;
+}
+#endif
+
+
+#ifdef __linux__
+/** @brief Client of a pool started on its own thread pinned to cpu, its task threads inherit the affinity */
+struct UniMRCPPinnedStart {
+	char const*      config;
+	bool             dir;
+	int              cpu;
+	UniMRCPClient*   client;  ///< Created client, NULL if failed
+	char const*      file;    ///< Exception of the failure
+	unsigned         line;
+	char const*      msg;
+	UniMRCPErrorCode code;
+};
+
+
+static void* APR_THREAD_FUNC PinnedStart(apr_thread_t* thread, void* data)
+{
+	UniMRCPPinnedStart* s = static_cast<UniMRCPPinnedStart*>(data);
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(s->cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set))
+		UW_LOG(APT_PRIO_WARNING, "%s Cannot pin UniMRCPClient to CPU %d",
+			swig_target_platform, s->cpu);
+	try {
+		s->client = new UniMRCPClient(s->config, s->dir);
+	} catch (UniMRCPException const& ex) {
+		s->file = ex.file;
+		s->line = ex.line;
+		s->msg = ex.msg;
+		s->code = ex.code;
+	} catch (...) {
+		s->file = __FILE__;
+		s->line = __LINE__;
+		s->msg = "Cannot create UniMRCP client";
+		s->code = UW_ERROR_GENERIC;
+	}
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+
+/** @brief Create a client pinned to cpu, the calling thread keeps its affinity */
+static UniMRCPClient* CreatePinnedClient(char const* config, bool dir, int cpu) THROWS(UniMRCPException)
+{
+	UniMRCPPinnedStart s = {config, dir, cpu, NULL, NULL, 0, NULL, UW_ERROR_GENERIC};
+	apr_pool_t* pool = apt_pool_create();
+	if (!pool)
+		UNIMRCP_THROW("Cannot create client pool memory pool");
+	apr_thread_t* thread;
+	if (apr_thread_create(&thread, NULL, PinnedStart, &s, pool) != APR_SUCCESS) {
+		apr_pool_destroy(pool);
+		UNIMRCP_THROW("Cannot start pinned client thread");
+	}
+	apr_status_t rv;
+	apr_thread_join(&rv, thread);
+	apr_pool_destroy(pool);
+	if (!s.client)
+		throw UniMRCPException(s.file, s.line, s.msg, s.code);
+	return s.client;
+}
+#endif
+
+
+/** @brief Jump consistent hash (Lamping, Veach) of key into buckets */
+static unsigned JumpHash(apr_uint64_t key, unsigned buckets)
+{
+	apr_int64_t b = -1, j = 0;
+	while (j < static_cast<apr_int64_t>(buckets)) {
+		b = j;
+		key = key * APR_UINT64_C(2862933555777941757) + 1;
+		j = static_cast<apr_int64_t>((b + 1) * (static_cast<double>(APR_INT64_C(1) << 31) / static_cast<double>((key >> 33) + 1)));
+	}
+	return static_cast<unsigned>(b);
+}
+
+
+UniMRCPClientPool::UniMRCPClientPool(char const* config, bool dir /* = false */, unsigned _clients /* = 0 */, bool pin /* = false */) THROWS(UniMRCPException) :
+	clients(NULL),
+	count(0),
+	placement(UW_PLACEMENT_LEAST_LOADED),
+	next(0)
+{
+	unsigned n = _clients ? _clients : CPUCount();
+	clients = new UniMRCPClient*[n];
+#ifdef __linux__
+	/* One of the CPUs the process is allowed to run on (cgroup cpuset, taskset) */
+	cpu_set_t allowed;
+	bool pinned = pin && !sched_getaffinity(0, sizeof(allowed), &allowed);
+#else
+	(void) pin;
+#endif
+	try {
+		for (; count < n; count++) {
+#ifdef __linux__
+			int cpu = pinned ? AllowedCPU(allowed, count) : -1;
+			if (cpu >= 0) {
+				clients[count] = CreatePinnedClient(config, dir, cpu);
+				continue;
+			}
+#endif
+			clients[count] = new UniMRCPClient(config, dir);
+		}
+	} catch (...) {
+		Destroy();
+		throw;
+	}
+	UW_LOG(APT_PRIO_NOTICE, "Created %s UniMRCPClientPool (%pp) of %u clients, pinned(%s)",
+		swig_target_platform, this, count, pin ? "TRUE" : "FALSE");
+}
+
+
+UniMRCPClientPool::~UniMRCPClientPool()
+{
+	Destroy();
+}
+
+
+void UniMRCPClientPool::Destroy()
+{
+	while (count)
+		delete clients[--count];
+	delete[] clients;
+	clients = NULL;
+}
+
+
+void UniMRCPClientPool::SetPlacement(UniMRCPPlacement _placement)
+{
+	placement = _placement;
+}
+
+
+unsigned UniMRCPClientPool::GetClientCount() const
+{
+	return count;
+}
+
+
+UniMRCPClient* UniMRCPClientPool::GetClient(unsigned index) const THROWS(UniMRCPException)
+{
+	if (index >= count)
+		UNIMRCP_THROW("UniMRCPClientPool client index out of bounds");
+	return clients[index];
+}
+
+
+UniMRCPClient* UniMRCPClientPool::SelectClient(char const* key /* = NULL */) THROWS(UniMRCPException)
+{
+	if (!count)
+		UNIMRCP_THROW("UniMRCPClientPool already destroyed");
+	if ((placement == UW_PLACEMENT_HASH) && key)
+		return clients[JumpHash(HashFNV1a(FNV1A_INIT, key, strlen(key)), count)];
+	/* Rotate the start, so that equally loaded clients take turns */
+	unsigned start = apr_atomic_inc32(&next);
+	UniMRCPClient* best = NULL;
+	unsigned bestLoad = 0;
+	for (unsigned i = 0; i < count; i++) {
+		UniMRCPClient* c = clients[(start + i) % count];
+		unsigned load = c->GetSessionCount();
+		if (!best || (load < bestLoad)) {
+			best = c;
+			bestLoad = load;
+		}
+	}
+	return best;
+}
+
+
+apt_bool_t UniMRCPClient::AppMessageHandler(mrcp_app_message_t const* msg)
+{
+	UniMRCPClient* c = static_cast<UniMRCPClient*>(mrcp_application_object_get(msg->application));
+	/* Stopped while the client is being destroyed, the stack is still up */
+	if (c && c->disp && c->disp->Push(msg))
+		return TRUE;
+	return AppMessageDispatch(msg);
+}
+
+
+apt_bool_t UniMRCPClient::AppMessageDispatch(mrcp_app_message_t const* msg)
+{
+	static const mrcp_app_message_dispatcher_t appDisp =
+	{
+		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_sig_status_code_e)>(
+			UniMRCPClientSession::AppOnSessionUpdate),
+		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_sig_status_code_e)>(
+			UniMRCPClientSession::AppOnSessionTerminate),
+		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_channel_t*, mrcp_sig_status_code_e)>(
+			UniMRCPClientChannel::AppOnChannelAdd),
+		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_channel_t*, mrcp_sig_status_code_e)>(
+			UniMRCPClientChannel::AppOnChannelRemove),
+		UniMRCPClientChannel::AppOnMessageReceive,
+		UniMRCPClientSession::AppOnTerminateEvent,
+		reinterpret_cast<int (*)(mrcp_application_t*, mrcp_session_t*, mrcp_session_descriptor_t*, mrcp_sig_status_code_e)>(
+			UniMRCPClientSession::AppOnResourceDiscover)
+	};
+	return mrcp_application_message_dispatch(&appDisp, msg);
+}
+
+
+UniMRCPClientSession::UniMRCPClientSession(UniMRCPClient* _client, char const* profile) THROWS(UniMRCPException) :
+	sess(NULL),
+	client(_client),
+	terminated(false),
+	destroyOnTerminate(false),
+	mutex(NULL),
+	channels(NULL),
+	timers(NULL),
+	owner(),
+	failover(),
+	admit(),
+	diag()
+{
+	diag.traceId = apr_atomic_inc32(&traceSessions) + 1;
+	diag.logPrio = -1;
+	if (!client)
+		UNIMRCP_THROW("Client must be specified");
+	Create(profile);
+}
+
+
+UniMRCPClientSession::UniMRCPClientSession(UniMRCPClientPool* pool, char const* profile, char const* key /* = NULL */) THROWS(UniMRCPException) :
+	sess(NULL),
+	client(pool ? pool->SelectClient(key) : NULL),
+	terminated(false),
+	destroyOnTerminate(false),
+	mutex(NULL),
+	channels(NULL),
+	timers(NULL),
+	owner(),
+	failover(),
+	admit(),
+	diag()
+{
+	diag.traceId = apr_atomic_inc32(&traceSessions) + 1;
+	diag.logPrio = -1;
+	if (!client)
+		UNIMRCP_THROW("Client pool must be specified");
+	Create(profile);
+}
+
+
+void UniMRCPClientSession::Create(char const* profile) THROWS(UniMRCPException)
+{
+	UniMRCPProfileGroup* group = profile ? client->admission->Group(profile) : NULL;
+	if (!group) {
+		Open(profile);
+		return;
+	}
+	apr_uint64_t tried = 0;
+	UniMRCPGroupMember* m = client->admission->Select(group, tried);
+	while (m) {
+		try {
+			Open(m->profile);
+			failover.member = m;
+			failover.group = group;
+			failover.tried = tried;
+			return;
+		} catch (UniMRCPException const& ex) {
+			/* A full profile has not failed */
+			if (ex.code == UW_ERROR_GENERIC)
+				client->admission->Report(m, false);
+			UW_LOG(APT_PRIO_WARNING, "%s Cannot create session on profile %s of group %s: %s",
+				swig_target_platform, m->profile, profile, ex.msg);
+			m = client->admission->Select(group, tried);
+			if (!m)
+				throw;
+		}
+	}
+}
+
+
+void UniMRCPClientSession::Open(char const* profile) THROWS(UniMRCPException)
+{
+	UniMRCPGateSet* set = client->admission->Profile(profile ? profile : "", true);
+	client->admission->Acquire(set, UW_LIMIT_SESSIONS);
+	admit.limits = set;
+	sess = mrcp_application_session_create(client->app, profile, this);
+	if (!sess) {
+		ReleaseLimits();
+		UNIMRCP_THROW("Cannot create UniMRCP client session");
+	}
+	if (apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_NESTED, mrcp_application_session_pool_get(sess)) != APR_SUCCESS) {
+		mrcp_application_session_destroy(sess);
+		sess = NULL;
+		ReleaseLimits();
+		UNIMRCP_THROW("Cannot create session mutex");
+	}
+	/* Kept by the C session, so that operator new need not know whose it is */
+	apr_pool_t* pool = mrcp_application_session_pool_get(sess);
+	apr_pool_userdata_setn(apr_pcalloc(pool, sizeof(apr_uint32_t)), POOL_BYTES_KEY, NULL, pool);
+	apr_atomic_inc32(&client->sessions);
+	MetricInc(UW_METRIC_SESSIONS);
+	if (!timers) {
+		/* Request deadlines are cancelled even after the client is gone */
+		timers = client->timers;
+		timers->Retain();
+		/* So are the admission slots released */
+		admit.admission = client->admission;
+		admit.admission->Retain();
+	}
+	diag.createdAt = apr_time_now();
+	client->admission->Register(this);
+	NameSession();
+	apr_uint32_t one_in = apr_atomic_read32(&logSampling);
+	if (one_in && (diag.logPrio < logSamplePriority)) {
+		/* Hashed, so that the picked sessions do not follow the creation pattern */
+		apr_uint32_t h = apr_atomic_inc32(&logSampleSeq) * 2654435761U;
+		if ((h ^ (h >> 16)) % one_in == 0) {
+			diag.logPrio = logSamplePriority;
+			UW_LOG(APT_PRIO_NOTICE, "%s Session %s sampled for logging: prio(%d) sess(%pp)",
+				swig_target_platform, mrcp_application_session_name_get(sess), diag.logPrio, sess);
+		}
+	}
+}
+
+
+void UniMRCPClientSession::NameSession()
+{
+	char name[64];
+	unsigned int id = apr_atomic_inc32(&client->sess_id);
+	snprintf(name, sizeof(name) - 1, "%s-%02u", swig_target_platform, static_cast<unsigned>(id));
+	mrcp_application_session_name_set(sess, name);
+	TraceEvent(UW_TRACE_SESSION_CREATE, sess, diag.traceId, 0, UW_TRACE_NO_RESOURCE, 0);
+	UW_PROBE2(session_create, diag.traceId, name);
+}
+
+
+bool UniMRCPClientSession::Failover()
+{
+	if (!failover.group || failover.established || terminated || destroyOnTerminate || client->terminated)
+		return false;
+	apr_uint64_t t = failover.tried;
+	UniMRCPGroupMember* m;
+	while ((m = client->admission->Select(failover.group, t)) != NULL) {
+		failover.tried = t;
+		try {
+			bool added = Reopen(m->profile);
+			failover.member = m;
+			return added;
+		} catch (UniMRCPException const& ex) {
+			/* A full profile has not failed */
+			if (ex.code == UW_ERROR_GENERIC)
+				client->admission->Report(m, false);
+			UW_LOG(APT_PRIO_WARNING, "%s Cannot fail over to profile %s of group %s: %s",
+				swig_target_platform, m->profile, failover.group->name, ex.msg);
+		}
+	}
+	return false;
+}
+
+
+bool UniMRCPClientSession::Reopen(char const* profile) THROWS(UniMRCPException)
+{
+	UniMRCPGateSet* set = admit.admission->Profile(profile, true);
+	/* Called back by the client task, which must not wait for a slot */
+	admit.admission->Acquire(set, UW_LIMIT_SESSIONS, false);
+	mrcp_session_t* fresh = mrcp_application_session_create(client->app, profile, this);
+	if (!fresh) {
+		UniMRCPAdmission::Release(set, UW_LIMIT_SESSIONS);
+		UNIMRCP_THROW("Cannot create UniMRCP client session");
+	}
+	apr_thread_mutex_lock(mutex);
+	unsigned count = 0;
+	for (UniMRCPClientChannel* c = channels; c; c = c->nextChannel)
+		count++;
+	mrcp_channel_t** chans = static_cast<mrcp_channel_t**>(
+		apr_pcalloc(mrcp_application_session_pool_get(fresh), sizeof(mrcp_channel_t*) * (count + 1)));
+	unsigned i = 0;
+	try {
+		for (UniMRCPClientChannel* c = channels; c; c = c->nextChannel, i++) {
+			admit.admission->Acquire(set, UW_LIMIT_CHANNELS, false);
+			chans[i] = c->CreateChannel(fresh);
+			if (!chans[i]) {
+				UniMRCPAdmission::Release(set, UW_LIMIT_CHANNELS);
+				UNIMRCP_THROW("Cannot create UniMRCP client channel");
+			}
+		}
+	} catch (...) {
+		apr_thread_mutex_unlock(mutex);
+		while (i--)
+			UniMRCPAdmission::Release(set, UW_LIMIT_CHANNELS);
+		/* Nothing was sent, channels and terminations go with the pool */
+		mrcp_application_session_destroy(fresh);
+		UniMRCPAdmission::Release(set, UW_LIMIT_SESSIONS);
+		throw;
+	}
+	/* Memory of this object is still in the pool of the failed session */
+	mrcp_session_t* old = sess;
+	apr_pool_t* oldPool = mrcp_application_session_pool_get(old);
+	UniMRCPRetiredSession* r = static_cast<UniMRCPRetiredSession*>(apr_palloc(oldPool, sizeof(UniMRCPRetiredSession)));
+	r->sess = old;
+	r->app = client->app;
+	r->state = RETIRED_TERMINATING;
+	apr_pool_userdata_setn(r, RETIRED_KEY, NULL, oldPool);
+	apr_pool_cleanup_register(mrcp_application_session_pool_get(fresh), r, RetiredCleanup, apr_pool_cleanup_null);
+	sess = fresh;
+	ReleaseLimits();
+	admit.limits = set;
+	i = 0;
+	for (UniMRCPClientChannel* c = channels; c; c = c->nextChannel)
+		c->Reattach(fresh, chans[i++], set);
+	apr_atomic_inc32(&client->sessions);
+	MetricInc(UW_METRIC_SESSIONS);
+	diag.createdAt = apr_time_now();
+	NameSession();
+	UW_LOG(APT_PRIO_NOTICE, "%s Session %s failed over to profile %s: old sess(%pp) sess(%pp)",
+		swig_target_platform, mrcp_application_session_name_get(sess), profile, old, sess);
+	mrcp_application_session_terminate(old);
+	bool added = true;
+	for (UniMRCPClientChannel* c = channels; c; c = c->nextChannel) {
+		UW_PROBE3(channel_add, diag.traceId, c->traceId, static_cast<int>(c->resourceType));
+		if (!mrcp_application_channel_add(sess, c->chan)) {
+			UW_LOG(APT_PRIO_WARNING, "%s Error adding UniMRCP client channel into session %s",
+				swig_target_platform, mrcp_application_session_name_get(sess));
+			added = false;
+		}
+	}
+	apr_thread_mutex_unlock(mutex);
+	return added;
+}
+
+
+bool UniMRCPClientSession::IsRetired(mrcp_session_t* session)
+{
+	void* r = NULL;
+	apr_pool_userdata_get(&r, RETIRED_KEY, mrcp_application_session_pool_get(session));
+	return r != NULL;
+}
+
+
+int UniMRCPClientSession::RetiredCleanup(void* data)
+{
+	UniMRCPRetiredSession* r = static_cast<UniMRCPRetiredSession*>(data);
+	if (apr_atomic_cas32(&r->state, RETIRED_ORPHANED, RETIRED_TERMINATING) == RETIRED_TERMINATED) {
+		/* Frees r as well, and possibly the session retired before it */
+		mrcp_application_t* app = r->app;
+		mrcp_application_session_destroy(r->sess);
+		UniMRCPClient* c = static_cast<UniMRCPClient*>(mrcp_application_object_get(app));
+		if (c)
+			apr_atomic_dec32(&c->sessions);
+		MetricDec(UW_METRIC_SESSIONS);
+	}
+	return APR_SUCCESS;
+}
+
+
+UniMRCPClientSession::~UniMRCPClientSession()
+{
+	UW_SLOG(diag.logPrio, APT_PRIO_DEBUG, "%s ~UniMRCPClientSession sess(%pp) terminated(%s) this(%pp)",
+		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
+	TraceEvent(UW_TRACE_SESSION_DESTROY, sess, diag.traceId, 0, UW_TRACE_NO_RESOURCE, 0);
+	UW_PROBE1(session_destroy, diag.traceId);
+	/* Drain() must not see it anymore */
+	if (admit.admission)
+		admit.admission->Unregister(this);
+	if (sess)
+		// This object will not exist anymore
+		mrcp_application_session_object_set(sess, NULL);
+	DetachChannels();
+	Destroy();
+	/* Not usable anymore, even if the C session waits for termination */
+	ReleaseLimits();
+	if (timers)
+		timers->Release();
+	if (admit.admission)
+		admit.admission->Release();
+}
+
+
+void UniMRCPClientSession::ReleaseLimits()
+{
+	if (admit.limits) {
+		UniMRCPAdmission::Release(admit.limits, UW_LIMIT_SESSIONS);
+		admit.limits = NULL;
+	}
+}
+
+
+void UniMRCPClientSession::ReportHealth(bool success)
+{
+	if (failover.member)
+		client->admission->Report(failover.member, success);
+}
+
+
+void UniMRCPClientSession::DetachChannels()
+{
+	if (!mutex) return;
+	apr_thread_mutex_lock(mutex);
+	for (UniMRCPClientChannel* c = channels; c; c = c->nextChannel) {
+		c->FailRequests();
+		c->session = NULL;
+		if (c->limits) {
+			UniMRCPAdmission::Release(c->limits, UW_LIMIT_CHANNELS);
+			c->limits = NULL;
+		}
+	}
+	channels = NULL;
+	apr_thread_mutex_unlock(mutex);
+	// Allocated from the session pool
+	mutex = NULL;
+}
+
+
+void UniMRCPClientSession::ResourceDiscover()
+{
+	UW_SLOG(diag.logPrio, APT_PRIO_DEBUG, "%s Session ResourceDiscover sess(%pp) this(%pp)",
+		swig_target_platform, sess, this);
+	if (sess)
+		mrcp_application_resource_discover(sess);
+}
+
+
+void UniMRCPClientSession::Terminate()
+{
+	UW_SLOG(diag.logPrio, APT_PRIO_DEBUG, "%s Session Terminate sess(%pp) terminated(%s) this(%pp)",
+		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
+	if (sess && !terminated) {
+		UW_PROBE1(session_terminate, diag.traceId);
+		mrcp_application_session_terminate(sess);
+	}
+}
+
+
+void UniMRCPClientSession::Destroy()
+{
+	UW_SLOG(diag.logPrio, APT_PRIO_DEBUG, "%s Session Destroy sess(%pp) terminated(%s) this(%pp)",
+		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
+	if (client->terminated) return;
+	if (destroyOnTerminate) return;
+	if (sess) {
+		if (!terminated) {
+			destroyOnTerminate = true;
+			mrcp_application_session_terminate(sess);
+		} else {
+			DetachChannels();
+			mrcp_application_session_destroy(sess);
+			apr_atomic_dec32(&client->sessions);
+			MetricDec(UW_METRIC_SESSIONS);
+			sess = NULL;
+			ReleaseLimits();
+		}
+	}
+}
+
+
+char const* UniMRCPClientSession::GetID() const
+{
+	if (!sess) return NULL;
+	return mrcp_application_session_id_get(sess)->buf;
+}
+
+
+void UniMRCPClientSession::SetLogPriority(UniMRCPLogPriority priority)
+{
+	diag.logPrio = priority;
+}
+
+
+void UniMRCPClientSession::ResetLogPriority()
+{
+	diag.logPrio = -1;
+}
+
+
+int UniMRCPClientSession::GetLogPriority() const
+{
+	return diag.logPrio;
+}
+
+
+unsigned UniMRCPClientSession::GetPoolBytes() const
+{
+	apr_uint32_t volatile* bytes = sess ? SessionPoolBytes(sess) : NULL;
+	return bytes ? apr_atomic_read32(bytes) : 0;
+}
+
+
+bool UniMRCPClientSession::OnUpdate(UniMRCPSigStatusCode status)
+{
+	(void) status;
+	return true;
+}
+
+
+bool UniMRCPClientSession::OnTerminate(UniMRCPSigStatusCode status)
+{
+	(void) status;
+	return true;
+}
+
+
+bool UniMRCPClientSession::OnTerminateEvent()
+{
+	return true;
+}
+
+
+apt_bool_t UniMRCPClientSession::AppOnSessionUpdate(mrcp_application_t* application, mrcp_session_t* session, UniMRCPSigStatusCode status)
+{
+	(void) application;
+	if (IsRetired(session)) return TRUE;
+	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
+	int lp = s ? s->diag.logPrio : -1;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnSessionUpdate: sess(%pp) status(%d) sess_obj(%pp)",
+		swig_target_platform, session, static_cast<int>(status), s);
+	if (!s) return FALSE;
+	TraceEvent(UW_TRACE_SESSION_UPDATE, session, s->diag.traceId, 0, UW_TRACE_NO_RESOURCE, status);
+	UW_PROBE2(session_update, s->traceId, static_cast<int>(status));
+	if (status != UW_MRCP_SIG_STATUS_CODE_SUCCESS)
+		s->ReportHealth(false);
+	if (s->diag.createdAt) {
+		HistogramRecord(&latencySession, apr_time_now() - static_cast<apr_time_t>(s->diag.createdAt));
+		s->diag.createdAt = 0;
+	}
+	/* Retried on the next profile of the group, the application sees the outcome there */
+	if ((status != UW_MRCP_SIG_STATUS_CODE_SUCCESS) && s->Failover())
+		return TRUE;
+	bool ret = s->OnUpdate(status);
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnSessionUpdate: return %s",
+		swig_target_platform, ret ? "TRUE" : "FALSE");
+	return ret;
+}
+
+
+apt_bool_t UniMRCPClientSession::AppOnSessionTerminate(mrcp_application_t* application, mrcp_session_t* session, UniMRCPSigStatusCode status)
+{
+	(void) application;
+	void* retired = NULL;
+	apr_pool_userdata_get(&retired, RETIRED_KEY, mrcp_application_session_pool_get(session));
+	if (retired) {
+		UniMRCPRetiredSession* r = static_cast<UniMRCPRetiredSession*>(retired);
+		UW_LOG(APT_PRIO_DEBUG, "%s OnSessionTerminate: sess(%pp) status(%d) retired",
+			swig_target_platform, session, static_cast<int>(status));
+		/* Freed here only if the session which replaced it is gone */
+		if (apr_atomic_cas32(&r->state, RETIRED_TERMINATED, RETIRED_TERMINATING) == RETIRED_ORPHANED) {
+			mrcp_application_session_destroy(session);
+			UniMRCPClient* c = static_cast<UniMRCPClient*>(mrcp_application_object_get(application));
+			if (c)
+				apr_atomic_dec32(&c->sessions);
+			MetricDec(UW_METRIC_SESSIONS);
+		}
+		return TRUE;
+	}
+	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
+	if (!s) {
+		// Session object already destroyed so free the C memory as well
+		UW_LOG(APT_PRIO_DEBUG, "%s OnSessionTerminate: sess(%pp) status(%d) sess_obj(NULL)",
+			swig_target_platform, session);
+		mrcp_application_session_destroy(session);
+		UniMRCPClient* c = static_cast<UniMRCPClient*>(mrcp_application_object_get(application));
+		if (c)
+			apr_atomic_dec32(&c->sessions);
+		MetricDec(UW_METRIC_SESSIONS);
+		return false;
+	}
+	int lp = s->diag.logPrio;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnSessionTerminate: sess(%pp) status(%d) destroyOnTerminate(%s)",
+		swig_target_platform, session, static_cast<int>(status), s->destroyOnTerminate ? "TRUE" : "FALSE");
+	TraceEvent(UW_TRACE_SESSION_TERMINATE, session, s->diag.traceId, 0, UW_TRACE_NO_RESOURCE, status);
+	UW_PROBE2(session_terminated, s->traceId, static_cast<int>(status));
+	s->terminated = true;
+	if (s->owner.pooled)
+		apr_atomic_set32(&s->owner.pooled->healthy, 0);
+	if (status != UW_MRCP_SIG_STATUS_CODE_SUCCESS)
+		s->ReportHealth(false);
+	/* No more responses nor events will arrive */
+	apr_thread_mutex_lock(s->mutex);
+	for (UniMRCPClientChannel* c = s->channels; c; c = c->nextChannel)
+		c->FailRequests();
+	apr_thread_mutex_unlock(s->mutex);
+	if (s->admit.admission)
+		s->admit.admission->Wake();
+	/* Setup of a batch session ends here if the channel has not been reported */
+	if (s->owner.batched)
+		s->owner.batched->batch->Added(s->owner.batched, false);
+	bool ret;
+	if (s->destroyOnTerminate)
+		ret = false;
+	else if (s->owner.batched && s->owner.batched->batch->Terminated(s->owner.batched))
+		ret = true;
+	else
+		ret = s->OnTerminate(status);
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnSessionTerminate: return %s",
+		swig_target_platform, ret ? "TRUE" : "FALSE");
+	if (s->destroyOnTerminate) {
+		s->DetachChannels();
+		mrcp_application_session_destroy(session);
+		apr_atomic_dec32(&s->client->sessions);
+		MetricDec(UW_METRIC_SESSIONS);
+		s->sess = NULL;
+		s->ReleaseLimits();
+	}
+	return ret;
+}
+
+
+apt_bool_t UniMRCPClientSession::AppOnTerminateEvent(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel)
+{
+	(void) application;
+	if (IsRetired(session)) return TRUE;
+	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
+	UniMRCPClientChannel* c = reinterpret_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(channel));
+	if (!s) {
+		UW_LOG(APT_PRIO_DEBUG, "%s OnTerminateEvent: sess(%pp) status(%d) obj(NULL)",
+			swig_target_platform, session);
+		return false;
+	}
+	int lp = s->diag.logPrio;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnTerminateEvent: sess(%pp) chan(%pp) sess_obj(%pp) chan_obj(%pp)",
+		swig_target_platform, session, channel, s, c);
+	if (c)
+		TraceEvent(UW_TRACE_TERMINATE_EVENT, session, s->diag.traceId, c->traceId, c->resourceType, 0);
+	else
+		TraceEvent(UW_TRACE_TERMINATE_EVENT, session, s->diag.traceId, 0, UW_TRACE_NO_RESOURCE, 0);
+	bool ret = false;
+	if (c)
+		c->FailRequests();
+	if (s->owner.pooled)
+		apr_atomic_set32(&s->owner.pooled->healthy, 0);
+	s->ReportHealth(false);
+	if (!s->destroyOnTerminate) {
+		if (channel) {
+			if (c) ret |= c->OnTerminateEvent();
+		}
+		if (session) {
+			ret |= s->OnTerminateEvent();
+		}
+	}
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnTerminateEvent: return %s",
+		swig_target_platform, ret ? "TRUE" : "FALSE");
+	return ret;
+}
+
+
+apt_bool_t UniMRCPClientSession::AppOnResourceDiscover(mrcp_application_t* application, mrcp_session_t* session, mrcp_session_descriptor_t* descriptor, UniMRCPSigStatusCode status)
+{
+	(void) application;
+	(void) descriptor;
+	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
+	int lp = s ? s->diag.logPrio : -1;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnResourceDiscover: sess(%pp) status(%d) sess_obj(%pp)",
+		swig_target_platform, session, static_cast<int>(status), s);
+	bool ret = false;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnResourceDiscover: return %s",
+		swig_target_platform, ret ? "TRUE" : "FALSE");
+	return ret;
+}
+
+
+UniMRCPSessionPool::UniMRCPSessionPool(UniMRCPClient* _client, char const* _profile, unsigned _size, unsigned long idle_timeout_ms /* = 60000 */) THROWS(UniMRCPException) :
+	client(_client),
+	pool(NULL),
+	mutex(NULL),
+	cond(NULL),
+	profile(NULL),
+	size(_size),
+	idleTimeout(idle_timeout_ms),
+	closing(false),
+	idle(NULL),
+	expired(NULL),
+	pending(0),
+	refilled(0),
+	refillSum(0)
+{
+	memset(&stats, 0, sizeof(stats));
+	stats.size = size;
+	if (!client || !_profile)
+		UNIMRCP_THROW("Client and profile must be specified");
+	pool = apt_pool_create();
+	if (!pool)
+		UNIMRCP_THROW("Cannot create session pool memory pool");
+	if ((apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&cond, pool) != APR_SUCCESS))
+	{
+		apr_pool_destroy(pool);
+		pool = NULL;
+		UNIMRCP_THROW("Cannot create session pool synchronization objects");
+	}
+	profile = apr_pstrdup(pool, _profile);
+}
+
+
+UniMRCPSessionPool::~UniMRCPSessionPool()
+{
+	Destroy();
+	if (pool)
+		apr_pool_destroy(pool);
+}
+
+
+void UniMRCPSessionPool::Start() THROWS(UniMRCPException)
+{
+	Refill();
+}
+
+
+void UniMRCPSessionPool::Destroy()
+{
+	if (!mutex) return;
+	apr_thread_mutex_lock(mutex);
+	closing = true;
+	/* Warming sessions are still referenced from the client task, a queued MaintainTask() refers to the pool */
+	while (stats.warming || pending)
+		apr_thread_cond_wait(cond, mutex);
+	UniMRCPPooledSession* list = idle;
+	idle = NULL;
+	stats.idle = 0;
+	/* Idle timeouts firing now leave them alone, Teardown() waits for them to return */
+	for (UniMRCPPooledSession* e = list; e; e = e->next)
+		e->state = POOLED_CLOSED;
+	UniMRCPPooledSession* last = expired;
+	expired = NULL;
+	apr_thread_mutex_unlock(mutex);
+	while (list) {
+		UniMRCPPooledSession* next = list->next;
+		Teardown(list);
+		list = next;
+	}
+	while (last) {
+		UniMRCPPooledSession* next = last->next;
+		Teardown(last);
+		last = next;
+	}
+}
+
+
+void UniMRCPSessionPool::Maintain()
+{
+	apr_thread_mutex_lock(mutex);
+	UniMRCPPooledSession* list = expired;
+	expired = NULL;
+	apr_thread_mutex_unlock(mutex);
+	while (list) {
+		UniMRCPPooledSession* next = list->next;
+		Teardown(list);
+		list = next;
+	}
+	Refill();
+}
+
+
+void UniMRCPSessionPool::MaintainTask(void* obj)
+{
+	UniMRCPSessionPool* p = static_cast<UniMRCPSessionPool*>(obj);
+	for (;;) {
+		p->Maintain();
+		apr_thread_mutex_lock(p->mutex);
+		/* Expired meanwhile, no other task was queued for them */
+		if (p->expired && !p->closing) {
+			apr_thread_mutex_unlock(p->mutex);
+			continue;
+		}
+		p->pending--;
+		apr_thread_cond_broadcast(p->cond);
+		apr_thread_mutex_unlock(p->mutex);
+		return;
+	}
+}
+
+
+void UniMRCPSessionPool::Refill()
+{
+	unsigned need;
+	apr_thread_mutex_lock(mutex);
+	need = closing ? 0 : size - ((stats.idle + stats.warming > size) ? size : stats.idle + stats.warming);
+	stats.warming += need;
+	apr_thread_mutex_unlock(mutex);
+
+	for (; need; need--) {
+		UniMRCPPooledSession* e = new UniMRCPPooledSession;
+		memset(e, 0, sizeof(*e));
+		e->pool = this;
+		e->state = POOLED_WARMING;
+		e->healthy = 1;
+		e->created = apr_time_now();
+		e->timer.callback = IdleTimeout;
+		e->timer.obj = e;
+		try {
+			e->sess = CreateSession(client, profile);
+			if (!e->sess)
+				UNIMRCP_THROW("No session created");
+			e->sess->owner.pooled = e;
+			/* Channel add may complete before CreateChannel returns, Warmed() waits for the mutex */
+			apr_thread_mutex_lock(mutex);
+			try {
+				e->chan = CreateChannel(e->sess);
+			} catch (...) {
+				apr_thread_mutex_unlock(mutex);
+				throw;
+			}
+			apr_thread_mutex_unlock(mutex);
+			if (!e->chan)
+				UNIMRCP_THROW("No channel created");
+		} catch (UniMRCPException const& ex) {
+			UW_LOG(APT_PRIO_WARNING, "%s Session pool (%pp) cannot create session: %s",
+				swig_target_platform, this, ex.msg);
+			Warmed(e, false);
+		}
+	}
+}
+
+
+void UniMRCPSessionPool::ScheduleIdle(UniMRCPPooledSession* e)
+{
+	if (!idleTimeout || !client->timers)
+		return;
+	try {
+		client->timers->Add(&e->timer, idleTimeout);
+	} catch (UniMRCPException const& ex) {
+		UW_LOG(APT_PRIO_WARNING, "%s Session pool (%pp) idle timeout not scheduled: %s",
+			swig_target_platform, this, ex.msg);
+	}
+}
+
+
+void UniMRCPSessionPool::Warmed(UniMRCPPooledSession* e, bool success)
+{
+	apr_thread_mutex_lock(mutex);
+	stats.warming--;
+	if (success && !closing) {
+		apr_interval_time_t latency = apr_time_now() - e->created;
+		refilled++;
+		refillSum += latency;
+		if (static_cast<unsigned long>(apr_time_as_msec(latency)) > stats.refillMaxMs)
+			stats.refillMaxMs = static_cast<unsigned long>(apr_time_as_msec(latency));
+		e->state = POOLED_IDLE;
+		e->next = idle;
+		idle = e;
+		stats.idle++;
+		ScheduleIdle(e);
+		apr_thread_cond_broadcast(cond);
+		apr_thread_mutex_unlock(mutex);
+		return;
+	}
+	if (!success)
+		stats.failures++;
+	e->state = POOLED_CLOSED;
+	apr_thread_cond_broadcast(cond);
+	apr_thread_mutex_unlock(mutex);
+	Teardown(e);
+}
+
+
+void UniMRCPSessionPool::Teardown(UniMRCPPooledSession* e)
+{
+	if (e->timer.wheel)
+		e->timer.wheel->Cancel(&e->timer);
+	if (e->sess) {
+		e->sess->owner.pooled = NULL;
+		DestroySession(e->sess, e->chan);
+	}
+	delete e;
+}
+
+
+bool UniMRCPSessionPool::IsHealthy(UniMRCPPooledSession* e)
+{
+	if (!apr_atomic_read32(&e->healthy) || !e->sess->sess || e->sess->terminated || !e->chan || !e->chan->session)
+		return false;
+	/* A request still running would confuse the next user */
+	UniMRCPClientChannel* c = e->chan;
+	apr_thread_mutex_lock(c->reqMutex);
+	bool idle = !c->sentHead && !apr_hash_count(c->activeRequests);
+	apr_thread_mutex_unlock(c->reqMutex);
+	return idle;
+}
+
+
+void UniMRCPSessionPool::IdleTimeout(UniMRCPTimer* timer)
+{
+	UniMRCPPooledSession* e = static_cast<UniMRCPPooledSession*>(timer->obj);
+	UniMRCPSessionPool* p = e->pool;
+	apr_thread_mutex_lock(p->mutex);
+	if (e->state != POOLED_IDLE) {
+		apr_thread_mutex_unlock(p->mutex);
+		return;
+	}
+	for (UniMRCPPooledSession** i = &p->idle; *i; i = &(*i)->next)
+		if (*i == e) {
+			*i = e->next;
+			break;
+		}
+	p->stats.idle--;
+	p->stats.recycled++;
+	e->state = POOLED_CLOSED;
+	e->next = p->expired;
+	p->expired = e;
+	/* Factory methods may be overridden by the application, so they do not run on the timer thread */
+	UniMRCPDispatcher* disp = p->client->disp;
+	bool post = disp && !p->closing && !p->pending;
+	if (post)
+		p->pending++;
+	apr_thread_mutex_unlock(p->mutex);
+	if (post && !disp->PushTask(MaintainTask, p)) {
+		/* Left for the next Checkout() */
+		apr_thread_mutex_lock(p->mutex);
+		p->pending--;
+		apr_thread_cond_broadcast(p->cond);
+		apr_thread_mutex_unlock(p->mutex);
+	}
+}
+
+
+UniMRCPClientSession* UniMRCPSessionPool::Checkout(long timeout_ms /* = 0 */) THROWS(UniMRCPException)
+{
+	UniMRCPPooledSession* e = NULL;
+	bool waited = false;
+	apr_time_t deadline = apr_time_now() + apr_time_from_msec(timeout_ms);
+	Maintain();
+	apr_thread_mutex_lock(mutex);
+	for (;;) {
+		UniMRCPPooledSession* discard = NULL;
+		while (idle && !e) {
+			UniMRCPPooledSession* i = idle;
+			idle = i->next;
+			stats.idle--;
+			if (IsHealthy(i))
+				e = i;
+			else {
+				stats.discarded++;
+				i->state = POOLED_CLOSED;
+				i->next = discard;
+				discard = i;
+			}
+		}
+		if (discard) {
+			/* Replace them before waiting */
+			apr_thread_mutex_unlock(mutex);
+			while (discard) {
+				UniMRCPPooledSession* next = discard->next;
+				Teardown(discard);
+				discard = next;
+			}
+			Refill();
+			apr_thread_mutex_lock(mutex);
+		}
+		if (e || closing || !timeout_ms)
+			break;
+		waited = true;
+		if (timeout_ms < 0)
+			apr_thread_cond_wait(cond, mutex);
+		else {
+			apr_interval_time_t left = deadline - apr_time_now();
+			if ((left <= 0) || (apr_thread_cond_timedwait(cond, mutex, left) == APR_TIMEUP)) {
+				timeout_ms = 0;  // One more look
+				continue;
+			}
+		}
+	}
+	if (e) {
+		e->state = POOLED_BUSY;
+		e->next = NULL;
+		stats.busy++;
+		stats.checkouts++;
+		if (!waited)
+			stats.hits++;
+	} else
+		stats.timeouts++;
+	apr_thread_mutex_unlock(mutex);
+	if (!e)
+		return NULL;
+	if (e->timer.wheel)
+		e->timer.wheel->Cancel(&e->timer);
+	Refill();
+	return e->sess;
+}
+
+
+void UniMRCPSessionPool::Checkin(UniMRCPClientSession* session) THROWS(UniMRCPException)
+{
+	if (!session || !session->owner.pooled || (session->owner.pooled->pool != this))
+		UNIMRCP_THROW("Session does not belong to the pool");
+	UniMRCPPooledSession* e = session->owner.pooled;
+	apr_thread_mutex_lock(mutex);
+	if (e->state != POOLED_BUSY) {
+		apr_thread_mutex_unlock(mutex);
+		UNIMRCP_THROW("Session not checked out");
+	}
+	stats.busy--;
+	bool healthy = IsHealthy(e);
+	if (healthy && !closing && (stats.idle < size)) {
+		e->state = POOLED_IDLE;
+		e->next = idle;
+		idle = e;
+		stats.idle++;
+		ScheduleIdle(e);
+		apr_thread_cond_broadcast(cond);
+		apr_thread_mutex_unlock(mutex);
+		return;
+	}
+	if (!healthy)
+		stats.discarded++;
+	e->state = POOLED_CLOSED;
+	apr_thread_mutex_unlock(mutex);
+	Teardown(e);
+	Refill();
+}
+
+
+UniMRCPClientChannel* UniMRCPSessionPool::GetChannel(UniMRCPClientSession* session) const THROWS(UniMRCPException)
+{
+	if (!session || !session->owner.pooled || (session->owner.pooled->pool != this))
+		UNIMRCP_THROW("Session does not belong to the pool");
+	return session->owner.pooled->chan;
+}
+
+
+void UniMRCPSessionPool::GetStats(UniMRCPSessionPoolStats& _stats) const
+{
+	apr_thread_mutex_lock(mutex);
+	_stats = stats;
+	apr_thread_mutex_unlock(mutex);
+	if (_stats.checkouts + _stats.timeouts)
+		_stats.hitRate = static_cast<double>(_stats.hits) / static_cast<double>(_stats.checkouts + _stats.timeouts);
+	if (refilled)
+		_stats.refillAvgMs = static_cast<unsigned long>(refillSum / refilled / 1000);
 }
 
 
-UniMRCPClientSession::UniMRCPClientSession(UniMRCPClient* _client, char const* profile) THROWS(UniMRCPException) :
-	sess(NULL),
-	client(_client),
-	terminated(false),
-	destroyOnTerminate(false)
+UniMRCPClientSession* UniMRCPSessionPool::CreateSession(UniMRCPClient* _client, char const* _profile) THROWS(UniMRCPException)
 {
-	sess = mrcp_application_session_create(client->app, profile, this);
-	if (!sess)
-		UNIMRCP_THROW("Cannot create UniMRCP client session");
-	char name[64];
-	unsigned int id = apr_atomic_inc32(&client->sess_id);
-	snprintf(name, sizeof(name) - 1, "%s-%02u", swig_target_platform, static_cast<unsigned>(id));
-	mrcp_application_session_name_set(sess, name);
+	return new UniMRCPClientSession(_client, _profile);
 }
 
 
-UniMRCPClientSession::~UniMRCPClientSession()
+void UniMRCPSessionPool::DestroySession(UniMRCPClientSession* session, UniMRCPClientChannel* channel)
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPClientSession sess(%pp) terminated(%s) this(%pp)",
-		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
-	if (sess)
-		// This object will not exist anymore
-		mrcp_application_session_object_set(sess, NULL);
-	Destroy();
+	delete channel;
+	delete session;
 }
 
 
-void UniMRCPClientSession::ResourceDiscover()
+UniMRCPSessionBatch::UniMRCPSessionBatch(UniMRCPClient* _client, char const* _profile) THROWS(UniMRCPException) :
+	client(_client),
+	pool(NULL),
+	mutex(NULL),
+	cond(NULL),
+	profile(NULL),
+	entries(NULL),
+	count(0),
+	setupPending(0),
+	succeeded(0),
+	terminatePending(0),
+	terminated(0)
+{
+	if (!client || !_profile)
+		UNIMRCP_THROW("Client and profile must be specified");
+	pool = apt_pool_create();
+	if (!pool)
+		UNIMRCP_THROW("Cannot create session batch memory pool");
+	if ((apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+		(apr_thread_cond_create(&cond, pool) != APR_SUCCESS))
+	{
+		apr_pool_destroy(pool);
+		pool = NULL;
+		mutex = NULL;
+		UNIMRCP_THROW("Cannot create session batch synchronization objects");
+	}
+	profile = apr_pstrdup(pool, _profile);
+}
+
+
+UniMRCPSessionBatch::~UniMRCPSessionBatch()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s Session ResourceDiscover sess(%pp) this(%pp)",
-		swig_target_platform, sess, this);
-	if (sess)
-		mrcp_application_resource_discover(sess);
+	Destroy();
+	if (pool)
+		apr_pool_destroy(pool);
 }
 
 
-void UniMRCPClientSession::Terminate()
+void UniMRCPSessionBatch::Create(unsigned _count) THROWS(UniMRCPException)
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s Session Terminate sess(%pp) terminated(%s) this(%pp)",
-		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
-	if (sess && !terminated) {
-		mrcp_application_session_terminate(sess);
+	if (!_count)
+		UNIMRCP_THROW("No sessions requested");
+	UniMRCPBatchEntry* list = new UniMRCPBatchEntry[_count];
+	memset(list, 0, _count * sizeof(UniMRCPBatchEntry));
+	apr_thread_mutex_lock(mutex);
+	if (entries) {
+		apr_thread_mutex_unlock(mutex);
+		delete[] list;
+		UNIMRCP_THROW("Batch already created");
+	}
+	entries = list;
+	count = _count;
+	succeeded = 0;
+	terminated = 0;
+	/* Every entry reports exactly once, no need to guard the loop */
+	setupPending = _count;
+	for (unsigned i = 0; i < _count; i++) {
+		entries[i].batch = this;
+		entries[i].setup = true;
+	}
+	apr_thread_mutex_unlock(mutex);
+	UW_LOG(APT_PRIO_INFO, "%s Session batch (%pp) creating %u sessions using %s",
+		swig_target_platform, this, _count, profile);
+
+	for (unsigned i = 0; i < _count; i++) {
+		UniMRCPBatchEntry* e = &entries[i];
+		try {
+			e->sess = CreateSession(client, profile);
+			if (!e->sess)
+				UNIMRCP_THROW("No session created");
+			e->sess->owner.batched = e;
+			e->chan = CreateChannel(e->sess);
+			if (!e->chan)
+				UNIMRCP_THROW("No channel created");
+		} catch (UniMRCPException const& ex) {
+			UW_LOG(APT_PRIO_WARNING, "%s Session batch (%pp) cannot create session %u: %s",
+				swig_target_platform, this, i, ex.msg);
+			Added(e, false);
+		}
 	}
 }
 
 
-void UniMRCPClientSession::Destroy()
+void UniMRCPSessionBatch::Terminate()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s Session Destroy sess(%pp) terminated(%s) this(%pp)",
-		swig_target_platform, sess, terminated ? "TRUE" : "FALSE", this);
-	if (client->terminated) return;
-	if (destroyOnTerminate) return;
-	if (sess) {
-		if (!terminated) {
-			destroyOnTerminate = true;
-			mrcp_application_session_terminate(sess);
-		} else {
-			mrcp_application_session_destroy(sess);
-			sess = NULL;
+	unsigned n = 0;
+	apr_thread_mutex_lock(mutex);
+	for (unsigned i = 0; i < count; i++) {
+		UniMRCPBatchEntry* e = &entries[i];
+		if (e->sess && e->sess->sess && !e->sess->terminated && !e->sess->destroyOnTerminate && !e->terminating) {
+			e->terminating = true;
+			n++;
 		}
 	}
+	/* One more until all are sent, a termination may be reported meanwhile */
+	terminatePending += n + 1;
+	apr_thread_mutex_unlock(mutex);
+	UW_LOG(APT_PRIO_INFO, "%s Session batch (%pp) terminating %u sessions",
+		swig_target_platform, this, n);
+
+	for (unsigned i = 0; n && (i < count); i++) {
+		UniMRCPBatchEntry* e = &entries[i];
+		apr_thread_mutex_lock(mutex);
+		bool send = e->terminating;
+		apr_thread_mutex_unlock(mutex);
+		if (send)
+			e->sess->Terminate();
+	}
+	TerminateDone();
 }
 
 
-char const* UniMRCPClientSession::GetID() const
+void UniMRCPSessionBatch::Destroy()
 {
-	if (!sess) return NULL;
-	return mrcp_application_session_id_get(sess)->buf;
+	if (!mutex) return;
+	apr_thread_mutex_lock(mutex);
+	/* Entries are still referenced from the client task */
+	while (setupPending || terminatePending)
+		apr_thread_cond_wait(cond, mutex);
+	UniMRCPBatchEntry* list = entries;
+	unsigned n = count;
+	entries = NULL;
+	count = 0;
+	apr_thread_mutex_unlock(mutex);
+	for (unsigned i = 0; i < n; i++)
+		if (list[i].sess) {
+			list[i].sess->owner.batched = NULL;
+			DestroySession(list[i].sess, list[i].chan);
+		}
+	delete[] list;
 }
 
 
-bool UniMRCPClientSession::OnUpdate(UniMRCPSigStatusCode status)
+UniMRCPBatchEntry* UniMRCPSessionBatch::Entry(unsigned index) const THROWS(UniMRCPException)
 {
-	(void) status;
-	return true;
+	if (index >= count)
+		UNIMRCP_THROW("Session index out of range");
+	return &entries[index];
 }
 
 
-bool UniMRCPClientSession::OnTerminate(UniMRCPSigStatusCode status)
+unsigned UniMRCPSessionBatch::GetCount() const
 {
-	(void) status;
-	return true;
+	return count;
 }
 
 
-bool UniMRCPClientSession::OnTerminateEvent()
+UniMRCPClientSession* UniMRCPSessionBatch::GetSession(unsigned index) const THROWS(UniMRCPException)
 {
-	return true;
+	return Entry(index)->sess;
 }
 
 
-apt_bool_t UniMRCPClientSession::AppOnSessionUpdate(mrcp_application_t* application, mrcp_session_t* session, UniMRCPSigStatusCode status)
+UniMRCPClientChannel* UniMRCPSessionBatch::GetChannel(unsigned index) const THROWS(UniMRCPException)
 {
-	(void) application;
-	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnSessionUpdate: sess(%pp) status(%d) sess_obj(%pp)",
-		swig_target_platform, session, static_cast<int>(status), s);
-	if (!s) return FALSE;
-	bool ret = s->OnUpdate(status);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnSessionUpdate: return %s",
-		swig_target_platform, ret ? "TRUE" : "FALSE");
-	return ret;
+	return Entry(index)->chan;
 }
 
 
-apt_bool_t UniMRCPClientSession::AppOnSessionTerminate(mrcp_application_t* application, mrcp_session_t* session, UniMRCPSigStatusCode status)
+bool UniMRCPSessionBatch::IsReady(unsigned index) const THROWS(UniMRCPException)
 {
-	(void) application;
-	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
-	if (!s) {
-		// Session object already destroyed so free the C memory as well
-		apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnSessionTerminate: sess(%pp) status(%d) sess_obj(NULL)",
-			swig_target_platform, session);
-		mrcp_application_session_destroy(session);
+	UniMRCPBatchEntry* e = Entry(index);
+	apr_thread_mutex_lock(mutex);
+	bool ready = e->ready;
+	apr_thread_mutex_unlock(mutex);
+	return ready;
+}
+
+
+bool UniMRCPSessionBatch::Added(UniMRCPBatchEntry* e, bool success)
+{
+	apr_thread_mutex_lock(mutex);
+	if (!e->setup) {
+		apr_thread_mutex_unlock(mutex);
 		return false;
 	}
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnSessionTerminate: sess(%pp) status(%d) destroyOnTerminate(%s)",
-		swig_target_platform, session, static_cast<int>(status), s->destroyOnTerminate ? "TRUE" : "FALSE");
-	s->terminated = true;
-	bool ret;
-	if (!s->destroyOnTerminate)
-		ret = s->OnTerminate(status);
-	else
-		ret = false;
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnSessionTerminate: return %s",
-		swig_target_platform, ret ? "TRUE" : "FALSE");
-	if (s->destroyOnTerminate) {
-		mrcp_application_session_destroy(session);
-		s->sess = NULL;
+	e->setup = false;
+	e->ready = success;
+	if (success)
+		succeeded++;
+	/* Stay pending until the callback returns, Destroy() waits for it */
+	bool last = setupPending == 1;
+	if (!last)
+		setupPending--;
+	unsigned ok = succeeded;
+	apr_thread_mutex_unlock(mutex);
+	if (last) {
+		UW_LOG(APT_PRIO_INFO, "%s Session batch (%pp) set up: %u succeeded, %u failed",
+			swig_target_platform, this, ok, count - ok);
+		OnSetupComplete(ok, count - ok);
+		apr_thread_mutex_lock(mutex);
+		setupPending = 0;
+		apr_thread_cond_broadcast(cond);
+		apr_thread_mutex_unlock(mutex);
 	}
-	return ret;
+	return true;
 }
 
 
-apt_bool_t UniMRCPClientSession::AppOnTerminateEvent(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel)
+bool UniMRCPSessionBatch::Terminated(UniMRCPBatchEntry* e)
 {
-	(void) application;
-	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
-	UniMRCPClientChannel* c = reinterpret_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(channel));
-	if (!s) {
-		apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnTerminateEvent: sess(%pp) status(%d) obj(NULL)",
-			swig_target_platform, session);
+	apr_thread_mutex_lock(mutex);
+	if (!e->terminating) {
+		apr_thread_mutex_unlock(mutex);
 		return false;
 	}
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnTerminateEvent: sess(%pp) chan(%pp) sess_obj(%pp) chan_obj(%pp)",
-		swig_target_platform, session, channel, s, c);
-	bool ret = false;
-	if (!s->destroyOnTerminate) {
-		if (channel) {
-			if (c) ret |= c->OnTerminateEvent();
-		}
-		if (session) {
-			ret |= s->OnTerminateEvent();
-		}
+	e->terminating = false;
+	terminated++;
+	apr_thread_mutex_unlock(mutex);
+	TerminateDone();
+	return true;
+}
+
+
+void UniMRCPSessionBatch::TerminateDone()
+{
+	apr_thread_mutex_lock(mutex);
+	bool last = terminatePending == 1;
+	if (!last)
+		terminatePending--;
+	unsigned n = terminated;
+	apr_thread_mutex_unlock(mutex);
+	if (last) {
+		UW_LOG(APT_PRIO_INFO, "%s Session batch (%pp) terminated %u sessions",
+			swig_target_platform, this, n);
+		OnTerminateComplete(n);
+		apr_thread_mutex_lock(mutex);
+		terminatePending = 0;
+		apr_thread_cond_broadcast(cond);
+		apr_thread_mutex_unlock(mutex);
 	}
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnTerminateEvent: return %s",
-		swig_target_platform, ret ? "TRUE" : "FALSE");
-	return ret;
 }
 
 
-apt_bool_t UniMRCPClientSession::AppOnResourceDiscover(mrcp_application_t* application, mrcp_session_t* session, mrcp_session_descriptor_t* descriptor, UniMRCPSigStatusCode status)
+UniMRCPClientSession* UniMRCPSessionBatch::CreateSession(UniMRCPClient* _client, char const* _profile) THROWS(UniMRCPException)
 {
-	(void) application;
-	(void) descriptor;
-	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnResourceDiscover: sess(%pp) status(%d) sess_obj(%pp)",
-		swig_target_platform, session, static_cast<int>(status), s);
-	bool ret = false;
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnResourceDiscover: return %s",
-		swig_target_platform, ret ? "TRUE" : "FALSE");
-	return ret;
+	return new UniMRCPClientSession(_client, _profile);
+}
+
+
+void UniMRCPSessionBatch::DestroySession(UniMRCPClientSession* session, UniMRCPClientChannel* channel)
+{
+	delete channel;
+	delete session;
+}
+
+
+void UniMRCPSessionBatch::OnSetupComplete(unsigned _succeeded, unsigned failed)
+{
+	(void) _succeeded;
+	(void) failed;
+}
+
+
+void UniMRCPSessionBatch::OnTerminateComplete(unsigned _terminated)
+{
+	(void) _terminated;
 }
 
 
 UniMRCPStreamRx::UniMRCPStreamRx() :
 	frm(NULL),
 	dtmf_gen(NULL),
-	term(NULL)
+	term(NULL),
+	counters(static_cast<UniMRCPRxCounters*>(calloc(1, sizeof(UniMRCPRxCounters))))
 {}
 
 
 UniMRCPStreamRx::~UniMRCPStreamRx()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPStreamRx term(%pp) dtmf_gen(%pp) this(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s ~UniMRCPStreamRx term(%pp) dtmf_gen(%pp) this(%pp)",
 		swig_target_platform, term, dtmf_gen, this);
+	/* Set while open, counted then */
 	if (term) {
 		term->streamRx = NULL;
 		term = NULL;
+		MetricDec(UW_METRIC_STREAMS);
+	}
+	free(counters);
+	counters = NULL;
+}
+
+
+void UniMRCPStreamRx::GetRxStats(UniMRCPRxStats& stats) const
+{
+	memset(&stats, 0, sizeof(stats));
+	if (!counters) return;
+	stats.requested = apr_atomic_read32(&counters->requested);
+	stats.supplied = apr_atomic_read32(&counters->supplied);
+	stats.shortFrames = apr_atomic_read32(&counters->shortFrames);
+	stats.zeroFilled = apr_atomic_read32(&counters->zeroFilled);
+	stats.starved = apr_atomic_read32(&counters->starved);
+	stats.runs = apr_atomic_read32(&counters->runs);
+	stats.currentRun = apr_atomic_read32(&counters->currentRun);
+	stats.longestRun = apr_atomic_read32(&counters->longestRun);
+}
+
+
+void UniMRCPStreamRx::SetStarvationThreshold(unsigned frames)
+{
+	if (counters)
+		apr_atomic_set32(&counters->threshold, frames);
+}
+
+
+void UniMRCPStreamRx::OnStarvation(unsigned frames)
+{
+	(void) frames;
+}
+
+
+void UniMRCPStreamRx::CountFrame(bool supplied)
+{
+	if (!counters) return;
+	UniMRCPRxCounters* c = counters;
+	apr_atomic_inc32(&c->requested);
+	if (supplied) {
+		apr_atomic_inc32(&c->supplied);
+		if (!c->filled)
+			apr_atomic_inc32(&c->zeroFilled);
+		else if (c->filled < frm->codec_frame.size)
+			apr_atomic_inc32(&c->shortFrames);
+		c->started = true;
+		apr_atomic_set32(&c->currentRun, 0);
+		return;
+	}
+	apr_atomic_inc32(&c->starved);
+	if (!c->started)
+		return;
+	apr_uint32_t run = apr_atomic_inc32(&c->currentRun) + 1;
+	if (run == 1)
+		apr_atomic_inc32(&c->runs);
+	if (run > apr_atomic_read32(&c->longestRun))
+		apr_atomic_set32(&c->longestRun, run);
+	if (run == apr_atomic_read32(&c->threshold)) {
+		if (term)
+			TraceEvent(UW_TRACE_STARVATION, term->sess, term->traceSession, 0, UW_TRACE_NO_RESOURCE, run);
+		OnStarvation(run);
 	}
 }
 
@@ -618,7 +4125,11 @@ bool UniMRCPStreamRx::SendDTMF(char digit)
 {
 	if (!dtmf_gen) return false;
 	char digits[2] = {digit, 0};
-	return mpf_dtmf_generator_enqueue(dtmf_gen, digits) ? true : false;
+	if (!mpf_dtmf_generator_enqueue(dtmf_gen, digits))
+		return false;
+	MetricInc(UW_METRIC_DTMF_EVENTS);
+	UW_PROBE3(dtmf, term ? term->traceSession : 0, digit, 0);
+	return true;
 }
 
 
@@ -636,9 +4147,13 @@ void UniMRCPStreamRx::SetData(void const* buf, size_t len)
 		len = frm->codec_frame.size;
 	if (buf && len)
 		memcpy(frm->codec_frame.buffer, buf, len);
+	else
+		len = 0;
 	memset(static_cast<char*>(frm->codec_frame.buffer) + len,
 		0, frm->codec_frame.size - len);
 	frm->type |= MEDIA_FRAME_TYPE_AUDIO;
+	if (counters)
+		counters->filled = len;
 #ifdef LOG_STREAM_DATA
 	printf("%s UniMRCPStreamRx::SetData %lu bytes:\n", swig_target_platform,
 		static_cast<unsigned long>(len));
@@ -673,7 +4188,7 @@ bool UniMRCPStreamRx::OnOpenInternal(UniMRCPAudioTermination const* term, mpf_au
 			term->dg_tone, term->dg_silence, mrcp_application_session_pool_get(term->sess));
 #endif
 		if (!dtmf_gen) {
-			apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "%s StreamOpenRx: Failed to create DTMF generator",
+			UW_LOG(APT_PRIO_WARNING, "%s StreamOpenRx: Failed to create DTMF generator",
 				swig_target_platform);
 			return false;
 		}
@@ -726,7 +4241,7 @@ bool UniMRCPStreamRxBuffered::AddData(void const* buf, size_t len)
 	ch->next = NULL;
 #ifdef UW_TRACE_BUFFERS
 	rcv += len;
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "Received %8lu bytes, total: %8lu",
+	UW_LOG(APT_PRIO_DEBUG, "Received %8lu bytes, total: %8lu",
 		static_cast<unsigned long>(len), rcv);
 #endif
 	ch->digit = 0;
@@ -739,6 +4254,7 @@ bool UniMRCPStreamRxBuffered::AddData(void const* buf, size_t len)
 		first = ch;
 	last = ch;
 	this->len += len;
+	UW_PROBE3(add_data, term ? term->traceSession : 0, len, this->len);
 	apr_thread_mutex_unlock(mutex);
 	return true;
 }
@@ -799,7 +4315,7 @@ bool UniMRCPStreamRxBuffered::ReadFrame()
 				char const digits[2] = {first->digit, 0};
 				if (dtmf_gen)
 					ret = mpf_dtmf_generator_enqueue(dtmf_gen, digits);
-				apt_log(APT_LOG_MARK, ret ? APT_PRIO_INFO : APT_PRIO_WARNING,
+				UW_LOG(ret ? APT_PRIO_INFO : APT_PRIO_WARNING,
 					"Sending DTMF: %s (%s)", digits, ret ? "OK" : "Failed");
 			}
 			pos = 0;
@@ -814,12 +4330,14 @@ bool UniMRCPStreamRxBuffered::ReadFrame()
 	if (copied) {
 #ifdef UW_TRACE_BUFFERS
 		snt += copied;
-		apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "Sent %8lu bytes, total: %8lu",
+		UW_LOG(APT_PRIO_DEBUG, "Sent %8lu bytes, total: %8lu",
 			static_cast<unsigned long>(copied), snt);
 #endif
 		frm->type |= MEDIA_FRAME_TYPE_AUDIO;
 		memset(static_cast<char*>(frm->codec_frame.buffer) + copied, 0,
 			frm->codec_frame.size - copied);
+		if (counters)
+			counters->filled = copied;
 	}
 	return true;
 }
@@ -832,7 +4350,7 @@ bool UniMRCPStreamRxBuffered::OnOpenInternal(UniMRCPAudioTermination const* term
 	apr_status_t status = apr_thread_mutex_create(&mutex, APR_THREAD_MUTEX_DEFAULT,
 		mrcp_application_session_pool_get(term->sess));
 	if (status != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "%s StreamRxBuffered Cannot create mutex: %d %pm",
+		UW_LOG(APT_PRIO_WARNING, "%s StreamRxBuffered Cannot create mutex: %d %pm",
 			swig_target_platform, status, &status);
 		return false;
 	}
@@ -980,25 +4498,25 @@ bool UniMRCPStreamRxFile::OnOpenInternal(UniMRCPAudioTermination const* term, mp
 	apr_status_t status;
 	status = apr_file_open(&file, filename, APR_FOPEN_READ | APR_FOPEN_BINARY, APR_FPROT_OS_DEFAULT, pool);
 	if (status != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Error opening file %s: %d %pm", filename, status, &status);
+		UW_LOG(APT_PRIO_WARNING, "Error opening file %s: %d %pm", filename, status, &status);
 		return false;
 	}
 	apr_finfo_t finfo;
 	status = apr_file_info_get(&finfo, APR_FINFO_SIZE, file);
 	if (status != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Error getting size of file %s: %d %pm", filename, status, &status);
+		UW_LOG(APT_PRIO_WARNING, "Error getting size of file %s: %d %pm", filename, status, &status);
 		apr_file_close(file);
 		return false;
 	}
 	if ((finfo.size < 0) || (offset >= static_cast<size_t>(finfo.size))) {
-		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Offest %"APR_SIZE_T_FMT" beyond file size %"APR_OFF_T_FMT, offset, finfo.size);
+		UW_LOG(APT_PRIO_WARNING, "Offest %"APR_SIZE_T_FMT" beyond file size %"APR_OFF_T_FMT, offset, finfo.size);
 		return false;
 	}
 	apr_size_t poffset = offset & ~(PAGE_SIZE - 1);
 	apr_size_t psize = static_cast<apr_size_t>(finfo.size - poffset);
 	status = apr_mmap_create(&mmap, file, poffset, psize, APR_MMAP_READ, pool);
 	if (status != APR_SUCCESS) {
-		apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Error mmapping file %s: %d %pm", filename, status, &status);
+		UW_LOG(APT_PRIO_WARNING, "Error mmapping file %s: %d %pm", filename, status, &status);
 		apr_file_close(file);
 		return false;
 	}
@@ -1013,13 +4531,13 @@ void UniMRCPStreamRxFile::Close()
 	if (mmap) {
 		apr_status_t status = apr_mmap_delete(mmap);
 		if (status != APR_SUCCESS)
-			apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Error unmmapping file %s: %d %pm", filename, status, &status);
+			UW_LOG(APT_PRIO_WARNING, "Error unmmapping file %s: %d %pm", filename, status, &status);
 		mmap = NULL;
 	}
 	if (file) {
 		apr_status_t status = apr_file_close(file);
 		if (status != APR_SUCCESS)
-			apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "Error closing file %s: %d %pm", filename, status, &status);
+			UW_LOG(APT_PRIO_WARNING, "Error closing file %s: %d %pm", filename, status, &status);
 		file = NULL;
 	}
 }
@@ -1035,11 +4553,13 @@ UniMRCPStreamTx::UniMRCPStreamTx() :
 
 UniMRCPStreamTx::~UniMRCPStreamTx()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPStreamTx term(%pp) dtmf_det(%pp) this(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s ~UniMRCPStreamTx term(%pp) dtmf_det(%pp) this(%pp)",
 		swig_target_platform, term, dtmf_det, this);
+	/* Set while open, counted then */
 	if (term) {
 		term->streamTx = NULL;
 		term = NULL;
+		MetricDec(UW_METRIC_STREAMS);
 	}
 }
 
@@ -1047,7 +4567,12 @@ UniMRCPStreamTx::~UniMRCPStreamTx()
 char UniMRCPStreamTx::GetDTMF()
 {
 	if (!dtmf_det) return 0;
-	return mpf_dtmf_detector_digit_get(dtmf_det);
+	char digit = mpf_dtmf_detector_digit_get(dtmf_det);
+	if (digit) {
+		MetricInc(UW_METRIC_DTMF_EVENTS);
+		UW_PROBE3(dtmf, term ? term->traceSession : 0, digit, 1);
+	}
+	return digit;
 }
 
 
@@ -1100,7 +4625,7 @@ bool UniMRCPStreamTx::OnOpenInternal(UniMRCPAudioTermination const* term, mpf_au
 				(stm->tx_event_descriptor ? MPF_DTMF_DETECTOR_OUTBAND : MPF_DTMF_DETECTOR_INBAND),
 			mrcp_application_session_pool_get(term->sess));
 		if (!dtmf_det) {
-			apt_log(APT_LOG_MARK, APT_PRIO_WARNING, "%s StreamOpenRx: Failed to create DTMF detector",
+			UW_LOG(APT_PRIO_WARNING, "%s StreamOpenRx: Failed to create DTMF detector",
 				swig_target_platform);
 			return false;
 		}
@@ -1128,17 +4653,25 @@ UniMRCPAudioTermination::UniMRCPAudioTermination(UniMRCPClientSession* session)
 	dg_band(-1),
 	dg_tone(70),
 	dg_silence(50),
-	dd_band(-1)
+	dd_band(-1),
+	txTiming(NULL),
+	traceSession(session->diag.traceId)
 {
-	caps = mpf_stream_capabilities_create(STREAM_DIRECTION_DUPLEX, mrcp_application_session_pool_get(sess));
+	apr_pool_t* pool = mrcp_application_session_pool_get(sess);
+	caps = mpf_stream_capabilities_create(STREAM_DIRECTION_DUPLEX, pool);
 	if (!caps)
 		UNIMRCP_THROW("Cannot initialize UniMRCP stream capabilities");
+	txTiming = static_cast<UniMRCPTxTiming*>(apr_pcalloc(pool, sizeof(UniMRCPTxTiming)));
+	txTiming->lastInterval = -1;
+	txTiming->silence = -1;
+	if (apr_thread_mutex_create(&txTiming->mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS)
+		UNIMRCP_THROW("Cannot create audio timing mutex");
 }
 
 
 UniMRCPAudioTermination::~UniMRCPAudioTermination()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPAudioTermination sess(%pp) streamRx(%pp) stmRx(%pp) streamTx(%pp) stmTx(%pp) this(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s ~UniMRCPAudioTermination sess(%pp) streamRx(%pp) stmRx(%pp) streamTx(%pp) stmTx(%pp) this(%pp)",
 		swig_target_platform, sess, streamRx, stmRx, streamTx, stmTx, this);
 	if (stmRx) {
 		stmRx->obj = NULL;
@@ -1148,13 +4681,16 @@ UniMRCPAudioTermination::~UniMRCPAudioTermination()
 		stmTx->obj = NULL;
 		stmTx = NULL;
 	}
+	/* Still open, the media engine will not close them through this object anymore */
 	if (streamRx) {
 		streamRx->term = NULL;
 		streamRx = NULL;
+		MetricDec(UW_METRIC_STREAMS);
 	}
 	if (streamTx) {
 		streamTx->term = NULL;
 		streamTx = NULL;
+		MetricDec(UW_METRIC_STREAMS);
 	}
 }
 
@@ -1214,7 +4750,7 @@ UniMRCPStreamTx* UniMRCPAudioTermination::OnStreamOpenTx(bool enabled, unsigned
 apt_bool_t UniMRCPAudioTermination::StmDestroy(mpf_audio_stream_t* stream)
 {
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamDestroy: stream(%pp) term(%pp) term.stmRx(%pp) term.stmTx(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamDestroy: stream(%pp) term(%pp) term.stmRx(%pp) term.stmTx(%pp)",
 		swig_target_platform, stream, t,
 		t ? t->stmRx : NULL, t ? t->stmTx : NULL);
 	if (t && (t->stmRx == stream)) t->stmRx = NULL;
@@ -1226,7 +4762,7 @@ apt_bool_t UniMRCPAudioTermination::StmDestroy(mpf_audio_stream_t* stream)
 apt_bool_t UniMRCPAudioTermination::StmOpenRx(mpf_audio_stream_t* stream, mpf_codec_t* codec)
 {
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamOpenRx: stream(%pp) codec(%pp) rx_descriptor(%pp) term(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamOpenRx: stream(%pp) codec(%pp) rx_descriptor(%pp) term(%pp)",
 		swig_target_platform, stream, codec, stream->rx_descriptor, t);
 	if (!t) return FALSE;
 	mpf_codec_descriptor_t const* d = stream->rx_descriptor;
@@ -1240,7 +4776,7 @@ apt_bool_t UniMRCPAudioTermination::StmOpenRx(mpf_audio_stream_t* stream, mpf_co
 #endif
 	else
 		sr = t->OnStreamOpenRx(false, 0, NULL, NULL, 0, 0);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamOpenRx: return %pp",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamOpenRx: return %pp",
 		swig_target_platform, sr);
 	if (sr) {
 		if (sr->OnOpenInternal(t, stream))
@@ -1251,6 +4787,8 @@ apt_bool_t UniMRCPAudioTermination::StmOpenRx(mpf_audio_stream_t* stream, mpf_co
 	if (!sr || !t->streamRx) return FALSE;
 	sr->term = t;
 	t->stmRx = stream;
+	MetricInc(UW_METRIC_STREAMS);
+	TraceEvent(UW_TRACE_STREAM_OPEN, t->sess, t->traceSession, 0, UW_TRACE_NO_RESOURCE, 0);
 	return TRUE;
 }
 
@@ -1258,12 +4796,14 @@ apt_bool_t UniMRCPAudioTermination::StmOpenRx(mpf_audio_stream_t* stream, mpf_co
 apt_bool_t UniMRCPAudioTermination::StmCloseRx(mpf_audio_stream_t* stream)
 {
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamCloseRx: stream(%pp) term(%pp) term.streamRx(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamCloseRx: stream(%pp) term(%pp) term.streamRx(%pp)",
 		swig_target_platform, stream, t, t ? t->streamRx : NULL);
 	if (t && t->streamRx) {
 		t->streamRx->OnClose();
 		t->streamRx->OnCloseInternal();
 		t->streamRx->term = NULL;
+		MetricDec(UW_METRIC_STREAMS);
+		TraceEvent(UW_TRACE_STREAM_CLOSE, t->sess, t->traceSession, 0, UW_TRACE_NO_RESOURCE, 0);
 	}
 	if (t) {
 		t->streamRx = NULL;
@@ -1276,20 +4816,26 @@ apt_bool_t UniMRCPAudioTermination::StmCloseRx(mpf_audio_stream_t* stream)
 apt_bool_t UniMRCPAudioTermination::StmReadFrame(mpf_audio_stream_t* stream, mpf_frame_t* frame)
 {
 #ifdef LOG_STREAM_FRAMES
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamReadFrame: stream(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamReadFrame: stream(%pp)",
 		swig_target_platform, stream);
 #endif
 	bool ret;
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
 	if (t && t->streamRx) {
 		t->streamRx->frm = frame;
+		if (t->streamRx->counters)
+			t->streamRx->counters->filled = 0;
+		UW_PROBE1(read_frame_start, t->traceSession);
 		ret = t->streamRx->ReadFrame();
+		UW_PROBE3(read_frame_done, t->traceSession, frame->type, static_cast<int>(ret));
+		MetricInc(ret ? UW_METRIC_FRAMES_READ : UW_METRIC_UNDERRUNS);
+		t->streamRx->CountFrame(ret && (frame->type & MEDIA_FRAME_TYPE_AUDIO));
 		if (t->streamRx->dtmf_gen)
 			mpf_dtmf_generator_put_frame(t->streamRx->dtmf_gen, frame);
 	} else
 		ret = FALSE;
 #ifdef LOG_STREAM_FRAMES
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamReadFrame: return %s",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamReadFrame: return %s",
 		swig_target_platform, ret ? "TRUE" : "FALSE");
 #endif
 	return ret;
@@ -1299,7 +4845,7 @@ apt_bool_t UniMRCPAudioTermination::StmReadFrame(mpf_audio_stream_t* stream, mpf
 apt_bool_t UniMRCPAudioTermination::StmOpenTx(mpf_audio_stream_t* stream, mpf_codec_t* codec)
 {
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamOpenTx: stream(%pp) codec(%pp) tx_descriptor(%pp) term(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamOpenTx: stream(%pp) codec(%pp) tx_descriptor(%pp) term(%pp)",
 		swig_target_platform, stream, codec, stream->tx_descriptor, t);
 	if (!t) return FALSE;
 	mpf_codec_descriptor_t const* d = stream->tx_descriptor;
@@ -1313,7 +4859,7 @@ apt_bool_t UniMRCPAudioTermination::StmOpenTx(mpf_audio_stream_t* stream, mpf_co
 #endif
 	else
 		st = t->OnStreamOpenTx(false, 0, NULL, NULL, 0, 0);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamOpenTx: return %pp",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamOpenTx: return %pp",
 		swig_target_platform, st);
 	if (st) {
 		if (st->OnOpenInternal(t, stream))
@@ -1324,6 +4870,16 @@ apt_bool_t UniMRCPAudioTermination::StmOpenTx(mpf_audio_stream_t* stream, mpf_co
 	if (!st || !t->streamTx) return FALSE;
 	st->term = t;
 	t->stmTx = stream;
+	/* Silence of G.711 is not zero bytes, anything else is taken for linear samples */
+	t->txTiming->silence = -1;
+	if (d && d->name.buf) {
+		if (!apr_strnatcasecmp(d->name.buf, "PCMU"))
+			t->txTiming->silence = 0x7F;
+		else if (!apr_strnatcasecmp(d->name.buf, "PCMA"))
+			t->txTiming->silence = 0x55;
+	}
+	MetricInc(UW_METRIC_STREAMS);
+	TraceEvent(UW_TRACE_STREAM_OPEN, t->sess, t->traceSession, 0, UW_TRACE_NO_RESOURCE, 1);
 	return TRUE;
 }
 
@@ -1331,12 +4887,14 @@ apt_bool_t UniMRCPAudioTermination::StmOpenTx(mpf_audio_stream_t* stream, mpf_co
 apt_bool_t UniMRCPAudioTermination::StmCloseTx(mpf_audio_stream_t* stream)
 {
 	UniMRCPAudioTermination* t = reinterpret_cast<UniMRCPAudioTermination*>(stream->obj);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamCloseTx: stream(%pp) term(%pp) term.streamTx(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamCloseTx: stream(%pp) term(%pp) term.streamTx(%pp)",
 		swig_target_platform, stream, t, t ? t->streamTx : NULL);
 	if (t && t->streamTx) {
 		t->streamTx->OnClose();
 		t->streamTx->OnCloseInternal();
 		t->streamTx->term = NULL;
+		MetricDec(UW_METRIC_STREAMS);
+		TraceEvent(UW_TRACE_STREAM_CLOSE, t->sess, t->traceSession, 0, UW_TRACE_NO_RESOURCE, 1);
 	}
 	if (t) {
 		t->streamTx = NULL;
@@ -1346,10 +4904,80 @@ apt_bool_t UniMRCPAudioTermination::StmCloseTx(mpf_audio_stream_t* stream)
 }
 
 
+/** @brief Whether an audio frame has any sound, codec silence is skipped as no audio yet */
+static bool TxFrameAudible(mpf_frame_t const* frame, int silence)
+{
+	if (!frame->codec_frame.buffer)
+		return false;
+	if (silence >= 0) {
+		apr_byte_t const* b = static_cast<apr_byte_t const*>(frame->codec_frame.buffer);
+		for (apr_size_t i = 0; i < frame->codec_frame.size; i++)
+			if ((b[i] & 0x7F) != silence)
+				return true;
+		return false;
+	}
+	apr_int16_t const* pcm = static_cast<apr_int16_t const*>(frame->codec_frame.buffer);
+	for (apr_size_t i = 0; i < frame->codec_frame.size / sizeof(apr_int16_t); i++)
+		if (pcm[i])
+			return true;
+	return false;
+}
+
+
+/** @brief Update incoming audio timing by a frame arrived, called from the media thread */
+static void TxTimingFrame(UniMRCPTxTiming* tt, mpf_frame_t const* frame)
+{
+	apr_time_t now = apr_time_now();
+	bool audio = (frame->type & MEDIA_FRAME_TYPE_AUDIO) != 0;
+	apr_atomic_inc32(&tt->frames);
+	if (!audio)
+		apr_atomic_inc32(&tt->nonAudioFrames);
+	apr_uint32_t seq = apr_atomic_read32(&tt->speakSeq);
+	if (seq != tt->seenSeq) {
+		/* New SPEAK, measure the next audio and restart jitter */
+		apr_thread_mutex_lock(tt->mutex);
+		tt->seenSeq = apr_atomic_read32(&tt->speakSeq);
+		tt->seenAt = tt->speakAt;
+		apr_thread_mutex_unlock(tt->mutex);
+		seq = tt->seenSeq;
+		tt->awaiting = true;
+		tt->lastFrame = 0;
+		tt->lastInterval = -1;
+	}
+	if (tt->awaiting) {
+		/* Servers stream silence before the synthesized speech, it is no first audio */
+		if (!audio || !TxFrameAudible(frame, tt->silence))
+			return;
+		apr_interval_time_t first = now - tt->seenAt;
+		tt->awaiting = false;
+		apr_atomic_set32(&tt->firstAudioUs, first > 0 ? static_cast<apr_uint32_t>(first) : 0);
+		apr_atomic_inc32(&tt->speaks);
+		HistogramRecord(&latencyAudio[0], first);
+	}
+	if (!seq)
+		return;
+	if (tt->lastFrame) {
+		apr_interval_time_t interval = now - tt->lastFrame;
+		if (tt->lastInterval >= 0) {
+			apr_interval_time_t d = interval - tt->lastInterval;
+			if (d < 0)
+				d = -d;
+			tt->jitter += d - ((tt->jitter + 8) >> 4);
+			apr_atomic_set32(&tt->jitterUs, static_cast<apr_uint32_t>(tt->jitter >> 4));
+			if (d > static_cast<apr_interval_time_t>(apr_atomic_read32(&tt->maxJitterUs)))
+				apr_atomic_set32(&tt->maxJitterUs, static_cast<apr_uint32_t>(d));
+			HistogramRecord(&latencyAudio[1], d);
+		}
+		tt->lastInterval = interval;
+	}
+	tt->lastFrame = now;
+}
+
+
 apt_bool_t UniMRCPAudioTermination::StmWriteFrame(mpf_audio_stream_t* stream, const mpf_frame_t* frame)
 {
 #ifdef LOG_STREAM_FRAMES
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamWriteFrame: stream(%pp)",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamWriteFrame: stream(%pp)",
 		swig_target_platform, stream);
 #endif
 	bool ret;
@@ -1358,20 +4986,79 @@ apt_bool_t UniMRCPAudioTermination::StmWriteFrame(mpf_audio_stream_t* stream, co
 		t->streamTx->frm = frame;
 		if (t->streamTx->dtmf_det)
 			mpf_dtmf_detector_get_frame(t->streamTx->dtmf_det, frame);
+		TxTimingFrame(t->txTiming, frame);
+		UW_PROBE2(write_frame_start, t->traceSession, frame->type);
 		ret = t->streamTx->WriteFrame();
+		UW_PROBE2(write_frame_done, t->traceSession, static_cast<int>(ret));
+		MetricInc(UW_METRIC_FRAMES_WRITTEN);
 	} else
 		ret = FALSE;
 #ifdef LOG_STREAM_FRAMES
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s StreamWriteFrame: return %s",
+	UW_LOG(APT_PRIO_DEBUG, "%s StreamWriteFrame: return %s",
 		swig_target_platform, ret ? "TRUE" : "FALSE");
 #endif
 	return ret;
 }
 
 
-UniMRCPClientChannel::UniMRCPClientChannel(UniMRCPClientSession* session, UniMRCPResource resource, UniMRCPAudioTermination* termination) THROWS(UniMRCPException) :
-	sess(session->sess),
-	chan(NULL)
+UniMRCPClientChannel::UniMRCPClientChannel(UniMRCPClientSession* _session, UniMRCPResource resource, UniMRCPAudioTermination* _termination) THROWS(UniMRCPException) :
+	sess(_session->sess),
+	chan(NULL),
+	resourceType(resource),
+	termination(_termination),
+	session(NULL),
+	limits(NULL),
+	nextChannel(NULL),
+	reqMutex(NULL),
+	sentHead(NULL),
+	sentTail(NULL),
+	freeRequests(NULL),
+	activeRequests(NULL),
+	inflight(NULL),
+	unanswered(0),
+	progressing(NULL),
+	addedAt(0),
+	txTiming(_termination->txTiming),
+	traceId(apr_atomic_inc32(&traceChannels) + 1),
+	traceSession(_session->diag.traceId)
+{
+	UniMRCPAdmission* admission = _session->client->admission;
+	admission->Acquire(_session->admit.limits ? _session->admit.limits : admission->Client(), UW_LIMIT_CHANNELS);
+	limits = _session->admit.limits ? _session->admit.limits : admission->Client();
+	apr_pool_t* pool = mrcp_application_session_pool_get(sess);
+	if (apr_thread_mutex_create(&reqMutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) {
+		sess = NULL;
+		ReleaseLimits();
+		UNIMRCP_THROW("Cannot create channel mutex");
+	}
+	activeRequests = apr_hash_make(pool);
+	inflight = static_cast<UniMRCPLatencySlot*>(apr_pcalloc(pool, sizeof(UniMRCPLatencySlot) * UW_LATENCY_SLOTS));
+	progressing = apr_array_make(pool, 4, sizeof(UniMRCPRequestId));
+	chan = CreateChannel(sess);
+	if (!chan) {
+		sess = NULL;
+		ReleaseLimits();
+		UNIMRCP_THROW("Cannot create UniMRCP client channel");
+	}
+	addedAt = apr_time_now();
+	UW_PROBE3(channel_add, traceSession, traceId, static_cast<int>(resourceType));
+	if (!mrcp_application_channel_add(sess, chan)) {
+		chan = NULL;
+		sess = NULL;
+		ReleaseLimits();
+		UNIMRCP_THROW("Error adding UniMRCP client channel into session");
+	}
+	session = _session;
+	apr_thread_mutex_lock(session->mutex);
+	nextChannel = session->channels;
+	session->channels = this;
+	apr_thread_mutex_unlock(session->mutex);
+	MetricInc(UW_METRIC_CHANNELS);
+	TraceEvent(UW_TRACE_CHANNEL_CREATE, sess, traceSession, traceId, resourceType, 0);
+}
+
+
+mrcp_channel_t* UniMRCPClientChannel::CreateChannel(mrcp_session_t* s)
 {
 	static const mpf_audio_stream_vtable_t audio_stream_vtable =
 	{
@@ -1384,28 +5071,204 @@ UniMRCPClientChannel::UniMRCPClientChannel(UniMRCPClientSession* session, UniMRC
 		UniMRCPAudioTermination::StmWriteFrame,
 		NULL          /* Trace */
 	};
-	mpf_termination_t* term = mrcp_application_audio_termination_create(sess, &audio_stream_vtable, termination->caps, termination);
-	if (!term) {
-		sess = NULL;
-		UNIMRCP_THROW("Cannot create UniMRCP client audio termination");
+	mpf_termination_t* term = mrcp_application_audio_termination_create(s, &audio_stream_vtable, termination->caps, termination);
+	if (!term)
+		return NULL;
+	return mrcp_application_channel_create(s, resourceType, term, NULL, this);
+}
+
+
+void UniMRCPClientChannel::Reattach(mrcp_session_t* s, mrcp_channel_t* c, UniMRCPGateSet* set)
+{
+	ReleaseLimits();
+	limits = set;
+	sess = s;
+	chan = c;
+	/* Streams are opened in the new session */
+	termination->sess = s;
+	addedAt = apr_time_now();
+	TraceEvent(UW_TRACE_CHANNEL_CREATE, sess, traceSession, traceId, resourceType, 0);
+}
+
+
+int UniMRCPClientChannel::LogPrio() const
+{
+	return session ? session->diag.logPrio : -1;
+}
+
+
+UniMRCPClientChannel::~UniMRCPClientChannel()
+{
+	UW_SLOG(LogPrio(), APT_PRIO_DEBUG, "%s ~UniMRCPClientChannel sess(%pp) chan(%pp) this(%pp)",
+		swig_target_platform, sess, chan, this);
+	if (session) {
+		apr_thread_mutex_lock(session->mutex);
+		for (UniMRCPClientChannel** c = &session->channels; *c; c = &(*c)->nextChannel)
+			if (*c == this) {
+				*c = nextChannel;
+				break;
+			}
+		apr_thread_mutex_unlock(session->mutex);
+		session = NULL;
+		FailRequests();
 	}
-	chan = mrcp_application_channel_create(sess, resource, term, NULL, this);
-	if (!chan) {
-		sess = NULL;
-		UNIMRCP_THROW("Cannot create UniMRCP client channel");
+	ReleaseLimits();
+	MetricDec(UW_METRIC_CHANNELS);
+}
+
+
+void UniMRCPClientChannel::LatencySent(mrcp_message_t const* message)
+{
+	apr_time_t now = apr_time_now();
+	apr_thread_mutex_lock(reqMutex);
+	UniMRCPLatencySlot* slot = inflight;
+	for (unsigned i = 0; i < UW_LATENCY_SLOTS; i++) {
+		if (!inflight[i].msg) {
+			slot = &inflight[i];
+			break;
+		}
+		if (inflight[i].sent < slot->sent)
+			slot = &inflight[i];
+	}
+	/* No request ID yet, it is read from the message when the response arrives */
+	slot->msg = message;
+	slot->id = 0;
+	slot->method = message->start_line.method_id;
+	slot->sent = now;
+	slot->responded = false;
+	unanswered++;
+	if ((resourceType == MRCP_SYNTHESIZER) && (message->start_line.method_id == SYNTHESIZER_SPEAK) && txTiming) {
+		apr_thread_mutex_lock(txTiming->mutex);
+		txTiming->speakAt = now;
+		apr_atomic_inc32(&txTiming->speakSeq);
+		apr_thread_mutex_unlock(txTiming->mutex);
+	}
+	apr_thread_mutex_unlock(reqMutex);
+}
+
+
+void UniMRCPClientChannel::LatencyUnsent(mrcp_message_t const* message)
+{
+	apr_thread_mutex_lock(reqMutex);
+	for (unsigned i = 0; i < UW_LATENCY_SLOTS; i++)
+		if ((inflight[i].msg == message) && !inflight[i].id) {
+			inflight[i].msg = NULL;
+			break;
+		}
+	if (unanswered)
+		unanswered--;
+	apr_thread_mutex_unlock(reqMutex);
+}
+
+
+/** @brief Remove request ID from the array, order does not matter */
+static void RemoveRequestId(apr_array_header_t* ids, UniMRCPRequestId id)
+{
+	UniMRCPRequestId* elts = reinterpret_cast<UniMRCPRequestId*>(ids->elts);
+	for (int i = 0; i < ids->nelts; i++)
+		if (elts[i] == id) {
+			elts[i] = elts[--ids->nelts];
+			break;
+		}
+}
+
+
+bool UniMRCPClientChannel::LatencyReceived(mrcp_message_t const* message)
+{
+	apr_time_t now = apr_time_now();
+	mrcp_request_id rid = message->start_line.request_id;
+	mrcp_request_state_e rstate = message->start_line.request_state;
+	bool resolved = false;
+	apr_size_t method = 0;
+	apr_interval_time_t sinceSent = 0;
+	apr_thread_mutex_lock(reqMutex);
+	UniMRCPLatencySlot* slot = NULL;
+	for (unsigned i = 0; i < UW_LATENCY_SLOTS; i++)
+		if (inflight[i].msg && (inflight[i].id == rid)) {
+			slot = &inflight[i];
+			break;
+		}
+	/* First response, the stack has assigned the ID to the very message sent, like UpdateRequests() */
+	if (!slot && (message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE))
+		for (unsigned i = 0; i < UW_LATENCY_SLOTS; i++)
+			if (inflight[i].msg && !inflight[i].id && (inflight[i].msg->start_line.request_id == rid)) {
+				slot = &inflight[i];
+				slot->id = rid;
+				resolved = true;
+				method = slot->method;
+				sinceSent = now - slot->sent;
+				break;
+			}
+	if (slot) {
+		apr_interval_time_t latency = now - slot->sent;
+		if (message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT)
+			HistogramRecord(LatencyHistogram(UW_LATENCY_EVENT, resourceType, message->start_line.method_id), latency);
+		else if (!slot->responded) {
+			HistogramRecord(LatencyHistogram(UW_LATENCY_RESPONSE, resourceType, slot->method), latency);
+			slot->responded = true;
+		}
+		if (rstate == MRCP_REQUEST_STATE_COMPLETE) {
+			HistogramRecord(LatencyHistogram(UW_LATENCY_COMPLETE, resourceType, slot->method), latency);
+			slot->msg = NULL;
+			slot->id = 0;
+		}
 	}
-	if (!mrcp_application_channel_add(sess, chan)) {
-		chan = NULL;
-		sess = NULL;
-		UNIMRCP_THROW("Error adding UniMRCP client channel into session");
+	/* Every request is counted for Drain(), from sending until its completion */
+	if (message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		if (unanswered)
+			unanswered--;
+		if (rstate != MRCP_REQUEST_STATE_COMPLETE)
+			*static_cast<UniMRCPRequestId*>(apr_array_push(progressing)) = rid;
+		else if (mrcp_generic_header_property_check(message, UW_HEADER_GENERIC_ACTIVE_REQUEST_ID_LIST) == TRUE) {
+			/* Terminated by e.g. STOP, no completion event follows, like UpdateRequests() */
+			mrcp_generic_header_t* hdr = mrcp_generic_header_get(message);
+			for (apr_size_t i = 0; hdr && (i < hdr->active_request_id_list.count); i++)
+				RemoveRequestId(progressing, hdr->active_request_id_list.ids[i]);
+		}
+	} else if (rstate == MRCP_REQUEST_STATE_COMPLETE)
+		RemoveRequestId(progressing, rid);
+	bool idle = (rstate == MRCP_REQUEST_STATE_COMPLETE) && !unanswered && !progressing->nelts;
+	apr_thread_mutex_unlock(reqMutex);
+	/* Joins the MESSAGE_SEND record written without the ID */
+	if (resolved) {
+		TraceEvent(UW_TRACE_REQUEST_ID, sess, traceSession, traceId, resourceType,
+			static_cast<apr_uint32_t>(method), rid, static_cast<apr_uint32_t>(sinceSent));
+		UW_PROBE6(request_id, traceSession, traceId, static_cast<int>(resourceType), method, rid,
+			static_cast<unsigned long>(sinceSent));
 	}
+	return idle;
 }
 
 
-UniMRCPClientChannel::~UniMRCPClientChannel()
+void UniMRCPClientChannel::GetTxStats(UniMRCPTxStats& stats) const
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s ~UniMRCPClientChannel sess(%pp) chan(%pp) this(%pp)",
-		swig_target_platform, sess, chan, this);
+	memset(&stats, 0, sizeof(stats));
+	if (!txTiming)
+		return;
+	stats.frames = apr_atomic_read32(&txTiming->frames);
+	stats.nonAudioFrames = apr_atomic_read32(&txTiming->nonAudioFrames);
+	stats.speaks = apr_atomic_read32(&txTiming->speaks);
+	stats.firstAudioUs = apr_atomic_read32(&txTiming->firstAudioUs);
+	stats.jitterUs = apr_atomic_read32(&txTiming->jitterUs);
+	stats.maxJitterUs = apr_atomic_read32(&txTiming->maxJitterUs);
+}
+
+
+unsigned UniMRCPClientChannel::PendingRequests()
+{
+	apr_thread_mutex_lock(reqMutex);
+	unsigned n = unanswered + static_cast<unsigned>(progressing->nelts);
+	apr_thread_mutex_unlock(reqMutex);
+	return n;
+}
+
+
+void UniMRCPClientChannel::ReleaseLimits()
+{
+	if (limits) {
+		UniMRCPAdmission::Release(limits, UW_LIMIT_CHANNELS);
+		limits = NULL;
+	}
 }
 
 
@@ -1420,8 +5283,9 @@ mrcp_message_t* UniMRCPClientChannel::CreateMsg(unsigned method) THROWS(UniMRCPE
 
 void UniMRCPClientChannel::Remove()
 {
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s Channel Remove sess(%pp) chan(%pp) this(%pp)",
+	UW_SLOG(LogPrio(), APT_PRIO_DEBUG, "%s Channel Remove sess(%pp) chan(%pp) this(%pp)",
 		swig_target_platform, sess, chan, this);
+	UW_PROBE3(channel_remove, traceSession, traceId, static_cast<int>(resourceType));
 	mrcp_application_channel_remove(sess, chan);
 }
 
@@ -1453,16 +5317,362 @@ bool UniMRCPClientChannel::OnTerminateEvent()
 }
 
 
+UniMRCPTimeoutAction UniMRCPClientChannel::OnRequestTimeout(UniMRCPRequest* request)
+{
+	(void) request;
+	return UW_TIMEOUT_STOP;
+}
+
+
+UniMRCPRequest* UniMRCPClientChannel::ReuseRequest()
+{
+	apr_thread_mutex_lock(reqMutex);
+	UniMRCPRequest* req = freeRequests;
+	if (req) {
+		freeRequests = req->next;
+		req->next = NULL;
+	}
+	apr_thread_mutex_unlock(reqMutex);
+	return req;
+}
+
+
+void UniMRCPClientChannel::RecycleRequest(UniMRCPRequest* req)
+{
+	if (!req->owned)
+		return;
+	apr_thread_mutex_lock(reqMutex);
+	req->next = freeRequests;
+	freeRequests = req;
+	apr_thread_mutex_unlock(reqMutex);
+}
+
+
+void UniMRCPClientChannel::SendTracked(UniMRCPMessage* msg, UniMRCPRequest* req, unsigned long timeout_ms, bool owned /* = false */) THROWS(UniMRCPException)
+{
+	if (!msg || !req)
+		UNIMRCP_THROW("Request and its handle must be specified");
+	if (req->channel && !req->IsComplete())
+		UNIMRCP_THROW("Request handle already in use");
+	req->owned = owned;
+	try {
+		if ((timeout_ms || limits) && !session)
+			UNIMRCP_THROW("Session already destroyed");
+		apr_pool_t* pool = mrcp_application_session_pool_get(sess);
+		if (!req->mutex &&
+			((apr_thread_mutex_create(&req->mutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS) ||
+			(apr_thread_cond_create(&req->cond, pool) != APR_SUCCESS)))
+		{
+			req->mutex = NULL;
+			UNIMRCP_THROW("Cannot create request synchronization objects");
+		}
+		if (timeout_ms && !req->timer) {
+			req->timer = static_cast<UniMRCPTimer*>(apr_pcalloc(pool, sizeof(UniMRCPTimer)));
+			req->timer->callback = RequestTimeout;
+			req->timer->obj = req;
+		}
+		if (limits) {
+			session->client->admission->Acquire(limits, UW_LIMIT_REQUESTS);
+			req->limits = limits;
+		}
+	} catch (...) {
+		/* Not handed out, the next SendAsync() takes it */
+		RecycleRequest(req);
+		throw;
+	}
+	req->channel = this;
+	req->msg = msg->msg;
+	req->response = NULL;
+	req->event = NULL;
+	req->id = 0;
+	req->status = UW_MRCP_STATUS_CODE_UNKNOWN;
+	req->next = NULL;
+	req->state = UW_ASYNC_SENT;
+
+	/* Enqueue first, the response can arrive before Send() returns */
+	apr_thread_mutex_lock(reqMutex);
+	if (sentTail)
+		sentTail->next = req;
+	else
+		sentHead = req;
+	sentTail = req;
+	apr_thread_mutex_unlock(reqMutex);
+
+	if (timeout_ms) {
+		try {
+			session->timers->Add(req->timer, timeout_ms);
+		} catch (...) {
+			DetachRequest(req);
+			req->state = UW_ASYNC_FAILED;
+			if (req->limits) {
+				UniMRCPAdmission::Release(req->limits, UW_LIMIT_REQUESTS);
+				req->limits = NULL;
+			}
+			RecycleRequest(req);
+			throw;
+		}
+	}
+	if (msg->Send())
+		return;
+	if (DetachRequest(req))
+		CompleteRequest(req, UW_ASYNC_FAILED);
+}
+
+
+bool UniMRCPClientChannel::DetachRequest(UniMRCPRequest* req)
+{
+	bool found = false;
+	apr_thread_mutex_lock(reqMutex);
+	UniMRCPRequest* prev = NULL;
+	for (UniMRCPRequest* r = sentHead; r; prev = r, r = r->next)
+		if (r == req) {
+			if (prev) prev->next = r->next;
+			else sentHead = r->next;
+			if (sentTail == r) sentTail = prev;
+			r->next = NULL;
+			found = true;
+			break;
+		}
+	if (!found && (apr_hash_get(activeRequests, &req->id, sizeof(req->id)) == req))
+	{
+		apr_hash_set(activeRequests, &req->id, sizeof(req->id), NULL);
+		found = true;
+	}
+	apr_thread_mutex_unlock(reqMutex);
+	return found;
+}
+
+
+void UniMRCPClientChannel::RequestTimeout(UniMRCPTimer* timer)
+{
+	UniMRCPRequest* req = static_cast<UniMRCPRequest*>(timer->obj);
+	UniMRCPClientChannel* c = req->channel;
+	UW_SLOG(c ? c->LogPrio() : -1, APT_PRIO_INFO, "%s Request timed out: id(%"APR_UINT64_T_FMT") state(%d) req(%pp)",
+		swig_target_platform, static_cast<apr_uint64_t>(req->id), static_cast<int>(req->state), req);
+	if (req->IsComplete())
+		return;
+	UniMRCPTimeoutAction action = c->OnRequestTimeout(req);
+	TraceEvent(UW_TRACE_REQUEST_TIMEOUT, c->sess, c->traceSession, c->traceId, c->resourceType,
+		action, static_cast<apr_uint64_t>(req->id));
+	if ((action == UW_TIMEOUT_STOP) && c->session) {
+		unsigned method = RECOGNIZER_STOP;
+		if (c->resourceType == MRCP_SYNTHESIZER)
+			method = SYNTHESIZER_STOP;
+		else if (c->resourceType == MRCP_RECORDER)
+			method = RECORDER_STOP;
+		mrcp_message_t* stop = mrcp_application_message_create(c->sess, c->chan, method);
+		if (stop) {
+			/* Not known yet if no response arrived, STOP all then */
+			if (req->id) {
+				mrcp_generic_header_t* hdr = mrcp_generic_header_get(stop);
+				hdr->active_request_id_list.ids[0] = static_cast<mrcp_request_id>(req->id);
+				hdr->active_request_id_list.count = 1;
+				mrcp_generic_header_property_add(stop, UW_HEADER_GENERIC_ACTIVE_REQUEST_ID_LIST);
+			}
+			if (mrcp_application_message_send(c->sess, c->chan, stop)) {
+				MetricMessage(METRIC_MSG_SENT, c->resourceType, method);
+				c->LatencySent(stop);
+			}
+		}
+	} else if ((action == UW_TIMEOUT_TERMINATE) && c->session)
+		c->session->Terminate();
+	if (c->DetachRequest(req))
+		CompleteRequest(req, UW_ASYNC_TIMED_OUT);
+}
+
+
+void UniMRCPClientChannel::UpdateRequests(mrcp_message_t* message, UniMRCPMessage const* wrapped)
+{
+	UniMRCPRequest* done = NULL;
+	mrcp_request_id rid = message->start_line.request_id;
+	mrcp_request_state_e rstate = message->start_line.request_state;
+
+	apr_thread_mutex_lock(reqMutex);
+	if (message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) {
+		/* The stack assigned request ID to the very message we sent */
+		UniMRCPRequest* prev = NULL;
+		UniMRCPRequest* req;
+		for (req = sentHead; req; prev = req, req = req->next)
+			if (req->msg->start_line.request_id == rid)
+				break;
+		if (req) {
+			if (prev) prev->next = req->next;
+			else sentHead = req->next;
+			if (sentTail == req) sentTail = prev;
+			req->next = NULL;
+			req->id = rid;
+			req->response = wrapped;
+			req->status = static_cast<UniMRCPStatusCode>(message->start_line.status_code);
+			if ((rstate == MRCP_REQUEST_STATE_COMPLETE) || (message->start_line.status_code >= MRCP_STATUS_CODE_METHOD_NOT_ALLOWED))
+				done = req;
+			else {
+				req->state = (rstate == MRCP_REQUEST_STATE_PENDING) ? UW_ASYNC_PENDING : UW_ASYNC_IN_PROGRESS;
+				apr_hash_set(activeRequests, &req->id, sizeof(req->id), req);
+			}
+		}
+		/* Requests terminated by e.g. STOP or BARGE-IN-OCCURRED get no completion event */
+		mrcp_generic_header_t* hdr = mrcp_generic_header_get(message);
+		if ((rstate == MRCP_REQUEST_STATE_COMPLETE) && hdr &&
+			mrcp_generic_header_property_check(message, UW_HEADER_GENERIC_ACTIVE_REQUEST_ID_LIST) == TRUE)
+		{
+			for (apr_size_t i = 0; i < hdr->active_request_id_list.count; i++) {
+				UniMRCPRequestId aid = hdr->active_request_id_list.ids[i];
+				UniMRCPRequest* areq = static_cast<UniMRCPRequest*>(apr_hash_get(activeRequests, &aid, sizeof(aid)));
+				if (!areq) continue;
+				apr_hash_set(activeRequests, &areq->id, sizeof(areq->id), NULL);
+				areq->next = done;
+				done = areq;
+			}
+		}
+	} else if (message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT) {
+		UniMRCPRequestId eid = rid;
+		UniMRCPRequest* req = static_cast<UniMRCPRequest*>(apr_hash_get(activeRequests, &eid, sizeof(eid)));
+		if (req && (rstate == MRCP_REQUEST_STATE_COMPLETE)) {
+			apr_hash_set(activeRequests, &req->id, sizeof(req->id), NULL);
+			req->event = wrapped;
+			done = req;
+		}
+	}
+	apr_thread_mutex_unlock(reqMutex);
+
+	while (done) {
+		UniMRCPRequest* next = done->next;
+		done->next = NULL;
+		CompleteRequest(done, UW_ASYNC_COMPLETE);
+		done = next;
+	}
+}
+
+
+void UniMRCPClientChannel::FailRequests()
+{
+	UniMRCPRequest* failed;
+	apr_thread_mutex_lock(reqMutex);
+	failed = sentHead;
+	sentHead = sentTail = NULL;
+	for (apr_hash_index_t* it = apr_hash_first(NULL, activeRequests); it; it = apr_hash_next(it)) {
+		void* val;
+		apr_hash_this(it, NULL, NULL, &val);
+		UniMRCPRequest* req = static_cast<UniMRCPRequest*>(val);
+		req->next = failed;
+		failed = req;
+	}
+	apr_hash_clear(activeRequests);
+	/* No response nor event will arrive anymore */
+	unanswered = 0;
+	progressing->nelts = 0;
+	apr_thread_mutex_unlock(reqMutex);
+
+	while (failed) {
+		UniMRCPRequest* next = failed->next;
+		failed->next = NULL;
+		CompleteRequest(failed, UW_ASYNC_FAILED);
+		failed = next;
+	}
+}
+
+
+void UniMRCPClientChannel::CompleteRequest(UniMRCPRequest* req, UniMRCPAsyncState state)
+{
+	UW_SLOG(req->channel ? req->channel->LogPrio() : -1, APT_PRIO_DEBUG, "%s Request %s: id(%"APR_UINT64_T_FMT") status(%d) req(%pp)",
+		swig_target_platform, state == UW_ASYNC_COMPLETE ? "complete" : state == UW_ASYNC_TIMED_OUT ? "timed out" : "failed",
+		static_cast<apr_uint64_t>(req->id), static_cast<int>(req->status), req);
+	if (req->timer && req->timer->wheel)
+		req->timer->wheel->Cancel(req->timer);
+	if (req->limits) {
+		UniMRCPAdmission::Release(req->limits, UW_LIMIT_REQUESTS);
+		req->limits = NULL;
+	}
+	apr_thread_mutex_lock(req->mutex);
+	req->state = state;
+	apr_thread_cond_broadcast(req->cond);
+	apr_thread_mutex_unlock(req->mutex);
+	req->OnComplete();
+	/* Only now, a later SendAsync() would reset it */
+	req->channel->RecycleRequest(req);
+}
+
+
+UniMRCPRequest::UniMRCPRequest() :
+	response(NULL),
+	event(NULL),
+	channel(NULL),
+	msg(NULL),
+	mutex(NULL),
+	cond(NULL),
+	timer(NULL),
+	limits(NULL),
+	id(0),
+	state(UW_ASYNC_FAILED),
+	status(UW_MRCP_STATUS_CODE_UNKNOWN),
+	owned(false),
+	next(NULL)
+{
+}
+
+
+UniMRCPRequest::~UniMRCPRequest()
+{
+}
+
+
+bool UniMRCPRequest::Wait(long timeout_ms /* = -1 */)
+{
+	if (!mutex)
+		return IsComplete();
+	apr_time_t deadline = apr_time_now() + apr_time_from_msec(timeout_ms);
+	apr_thread_mutex_lock(mutex);
+	while (!IsComplete()) {
+		if (timeout_ms < 0)
+			apr_thread_cond_wait(cond, mutex);
+		else {
+			apr_interval_time_t left = deadline - apr_time_now();
+			if ((left <= 0) || (apr_thread_cond_timedwait(cond, mutex, left) == APR_TIMEUP))
+				break;
+		}
+	}
+	apr_thread_mutex_unlock(mutex);
+	return IsComplete();
+}
+
+
+void UniMRCPRequest::OnComplete()
+{
+}
+
+
 apt_bool_t UniMRCPClientChannel::AppOnChannelAdd(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel, UniMRCPSigStatusCode status)
 {
 	(void) application;
+	if (UniMRCPClientSession::IsRetired(session)) return TRUE;
 	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
 	UniMRCPClientChannel* c = reinterpret_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(channel));
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnChannelAdd: sess(%pp), chan(%pp), status(%d) obj_s(%pp) obj_c(%pp)",
+	int lp = s ? s->diag.logPrio : -1;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnChannelAdd: sess(%pp), chan(%pp), status(%d) obj_s(%pp) obj_c(%pp)",
 		swig_target_platform, session, channel, static_cast<int>(status), s, c);
 	if (!s || !c) return FALSE;
+	TraceEvent(UW_TRACE_CHANNEL_ADD, session, s->diag.traceId, c->traceId, c->resourceType, status);
+	UW_PROBE4(channel_added, s->traceId, c->traceId, static_cast<int>(c->resourceType), static_cast<int>(status));
+	if (c->addedAt) {
+		HistogramRecord(&latencyChannel[c->resourceType], apr_time_now() - static_cast<apr_time_t>(c->addedAt));
+		c->addedAt = 0;
+	}
+	s->ReportHealth(status == UW_MRCP_SIG_STATUS_CODE_SUCCESS);
+	if (status == UW_MRCP_SIG_STATUS_CODE_SUCCESS)
+		s->failover.established = true;
+	else if (s->Failover())
+		/* Retried on the next profile of the group, reported once added there */
+		return TRUE;
+	UniMRCPPooledSession* e = s->owner.pooled;
+	if (e && (e->state == POOLED_WARMING)) {
+		/* Warming up, the session is not the application's yet. May be torn down here. */
+		e->pool->Warmed(e, status == UW_MRCP_SIG_STATUS_CODE_SUCCESS);
+		return TRUE;
+	}
+	if (s->owner.batched && s->owner.batched->batch->Added(s->owner.batched, status == UW_MRCP_SIG_STATUS_CODE_SUCCESS))
+		return TRUE;
 	bool ret = c->OnAdd(status);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnChannelAdd: return %s",
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnChannelAdd: return %s",
 		swig_target_platform, ret ? "TRUE" : "FALSE");
 	return ret;
 }
@@ -1471,13 +5681,18 @@ apt_bool_t UniMRCPClientChannel::AppOnChannelAdd(mrcp_application_t* application
 apt_bool_t UniMRCPClientChannel::AppOnChannelRemove(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel, UniMRCPSigStatusCode status)
 {
 	(void) application;
+	if (UniMRCPClientSession::IsRetired(session)) return TRUE;
 	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
 	UniMRCPClientChannel* c = reinterpret_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(channel));
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnChannelRemove: sess(%pp), chan(%pp), status(%d) obj_s(%pp) obj_c(%pp)",
+	int lp = s ? s->diag.logPrio : -1;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnChannelRemove: sess(%pp), chan(%pp), status(%d) obj_s(%pp) obj_c(%pp)",
 		swig_target_platform, session, channel, static_cast<int>(status), s, c);
 	if (!s || !c) return FALSE;
+	TraceEvent(UW_TRACE_CHANNEL_REMOVE, session, s->diag.traceId, c->traceId, c->resourceType, status);
+	UW_PROBE4(channel_removed, s->traceId, c->traceId, static_cast<int>(c->resourceType), static_cast<int>(status));
+	c->FailRequests();
 	bool ret = c->OnRemove(status);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnChannelRemove: return %s",
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnChannelRemove: return %s",
 		swig_target_platform, ret ? "TRUE" : "FALSE");
 	return ret;
 }
@@ -1486,13 +5701,27 @@ apt_bool_t UniMRCPClientChannel::AppOnChannelRemove(mrcp_application_t* applicat
 apt_bool_t UniMRCPClientChannel::AppOnMessageReceive(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel, mrcp_message_t* message)
 {
 	(void) application;
+	if (UniMRCPClientSession::IsRetired(session)) return TRUE;
 	UniMRCPClientSession* s = reinterpret_cast<UniMRCPClientSession*>(mrcp_application_session_object_get(session));
 	UniMRCPClientChannel* c = reinterpret_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(channel));
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnMessageReceive: sess(%pp), chan(%pp) obj_s(%pp) obj_c(%pp)",
+	int lp = s ? s->diag.logPrio : -1;
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnMessageReceive: sess(%pp), chan(%pp) obj_s(%pp) obj_c(%pp)",
 		swig_target_platform, session, channel, s, c);
 	if (!s || !c) return FALSE;
+	MetricMessage(message->start_line.message_type == MRCP_MESSAGE_TYPE_EVENT ? METRIC_MSG_EVENTS : METRIC_MSG_RESPONSES,
+		c->resourceType, message->start_line.method_id);
+	/* Drain() waits for the last request to complete */
+	if (c->LatencyReceived(message) && s->admit.admission)
+		s->admit.admission->Wake();
+	TraceEvent(UW_TRACE_MESSAGE_RECEIVE, session, s->diag.traceId, c->traceId, c->resourceType,
+		static_cast<apr_uint32_t>(message->start_line.method_id), message->start_line.request_id,
+		message->start_line.message_type,
+		message->start_line.status_code | (static_cast<apr_uint32_t>(message->start_line.request_state) << 16));
+	UW_PROBE6(message_receive, s->traceId, c->traceId, static_cast<int>(c->resourceType),
+		static_cast<int>(message->start_line.message_type), message->start_line.method_id,
+		message->start_line.request_id);
 	bool ret = c->OnMsgReceive(message);
-	apt_log(APT_LOG_MARK, APT_PRIO_DEBUG, "%s OnMessageReceive: return %s",
+	UW_SLOG(lp, APT_PRIO_DEBUG, "%s OnMessageReceive: return %s",
 		swig_target_platform, ret ? "TRUE" : "FALSE");
 	return ret;
 }
@@ -1503,7 +5732,8 @@ UniMRCPMessage::UniMRCPMessage(mrcp_session_t* _sess, mrcp_channel_t* _chan, mrc
 	msg(_msg),
 	sess(_sess),
 	chan(_chan),
-	hdr(mrcp_generic_header_get(_msg))
+	hdr(mrcp_generic_header_get(_msg)),
+	stamp(static_cast<unsigned long long>(apr_time_now()))
 {
 	if (!hdr) UNIMRCP_THROW("Cannot access generic header");
 	memset(generic_props, 0, sizeof(generic_props));
@@ -1583,7 +5813,7 @@ void UniMRCPMessage::SetBody(void const* buf, size_t len)
 }
 
 
-bool UniMRCPMessage::Send()
+void UniMRCPMessage::RenderProperties()
 {
 	for (unsigned i = 0; i < sizeof(generic_props) * 8; i++)
 		if (generic_props[i >> 3] & (1 << (i & 7)))
@@ -1591,7 +5821,38 @@ bool UniMRCPMessage::Send()
 	for (unsigned i = 0; i < sizeof(resource_props) * 8; i++)
 		if (resource_props[i >> 3] & (1 << (i & 7)))
 			mrcp_resource_header_property_add(msg, i);
-	return mrcp_application_message_send(sess, chan, msg) == TRUE;
+}
+
+
+bool UniMRCPMessage::Send()
+{
+	RenderProperties();
+	/* The response may arrive before message_send returns */
+	apr_time_t now = apr_time_now();
+	UniMRCPClientChannel* c = static_cast<UniMRCPClientChannel*>(mrcp_application_channel_object_get(chan));
+	if (c)
+		c->LatencySent(msg);
+	if (mrcp_application_message_send(sess, chan, msg) != TRUE) {
+		if (c)
+			c->LatencyUnsent(msg);
+		return false;
+	}
+	stamp = static_cast<unsigned long long>(now);
+	if (c) {
+		MetricMessage(METRIC_MSG_SENT, c->resourceType, msg->start_line.method_id);
+		/* The client task assigns the ID later, see UW_TRACE_REQUEST_ID */
+		TraceEvent(UW_TRACE_MESSAGE_SEND, sess, c->traceSession, c->traceId, c->resourceType,
+			static_cast<apr_uint32_t>(msg->start_line.method_id));
+		UW_PROBE4(message_send, c->traceSession, c->traceId, static_cast<int>(c->resourceType),
+			msg->start_line.method_id);
+	}
+	return true;
+}
+
+
+unsigned long long UniMRCPMessage::GetTimestamp() const
+{
+	return stamp;
 }
 
 
@@ -1842,6 +6103,547 @@ PROCESS_RECOG_HEADERS_BOOL(BOOL_HEADER_DEF, UniMRCPResourceMessage<MRCP_RECOGNIZ
 PROCESS_RECOG_HEADERS_SIMPLE(SIMPLE_HEADER_DEF, UniMRCPResourceMessage<MRCP_RECOGNIZER>)
 
 
+/** @brief XML white space */
+static inline bool NLSMLIsSpace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+
+/** @brief Strip leading and trailing white space */
+static void NLSMLTrim(char const*& buf, size_t& len)
+{
+	while (len && NLSMLIsSpace(*buf)) {
+		buf++;
+		len--;
+	}
+	while (len && NLSMLIsSpace(buf[len - 1]))
+		len--;
+}
+
+
+/** @brief Compare element or attribute local name (namespace prefix ignored) */
+static bool NLSMLNameIs(char const* name, size_t len, char const* what)
+{
+	char const* colon = static_cast<char const*>(memchr(name, ':', len));
+	if (colon) {
+		len -= colon + 1 - name;
+		name = colon + 1;
+	}
+	return (strlen(what) == len) && !memcmp(name, what, len);
+}
+
+
+/** @brief Parse confidence, locale independent. MRCPv1 0 - 100 scale (percent) is normalized to 0.0 - 1.0 */
+static float NLSMLConfidence(char const* buf, size_t len, bool percent)
+{
+	float val = 0, scale = 1;
+	bool frac = false;
+	NLSMLTrim(buf, len);
+	for (; len; buf++, len--) {
+		if ((*buf >= '0') && (*buf <= '9')) {
+			if (frac)
+				val += (*buf - '0') * (scale /= 10);
+			else
+				val = val * 10 + (*buf - '0');
+		} else if ((*buf == '.') && !frac)
+			frac = true;
+		else
+			break;
+	}
+	return percent ? val / 100 : val;
+}
+
+
+/** @brief Find the end of a markup construct */
+static char const* NLSMLSkip(char const* p, char const* end, char const* term)
+{
+	size_t tlen = strlen(term);
+	for (; p + tlen <= end; p++)
+		if ((*p == *term) && !memcmp(p, term, tlen))
+			return p + tlen;
+	return end;
+}
+
+
+/**
+ * @brief Single-pass NLSML scanner.
+ *
+ * Not a validating parser: it only recognizes interpretation, input and instance
+ * elements in any namespace and ignores everything else. Instance content is not
+ * interpreted, nested input elements (multimodal input) are kept in the outer input.
+ */
+static unsigned NLSMLParse(char const* p, char const* end, UniMRCPNLSMLInterpretation* out, unsigned max, bool percent)
+{
+	enum {NLSML_OTHER, NLSML_INTERPRETATION, NLSML_INPUT, NLSML_INSTANCE};
+	UniMRCPNLSMLInterpretation* cur = NULL;
+	unsigned count = 0;
+	int inputDepth = 0, instanceDepth = 0;
+	char const* inputStart = NULL;
+	char const* instanceStart = NULL;
+	bool confidenceSet = false;
+
+	if (!p) return 0;
+	while (p < end) {
+		char const* lt = static_cast<char const*>(memchr(p, '<', end - p));
+		if (!lt || (lt + 1 >= end)) break;
+		p = lt + 1;
+		/* Processing instructions, comments, CDATA and declarations */
+		if (*p == '?') {
+			p = NLSMLSkip(p, end, "?>");
+			continue;
+		}
+		if (*p == '!') {
+			if ((end - p >= 3) && !memcmp(p, "!--", 3))
+				p = NLSMLSkip(p + 3, end, "-->");
+			else if ((end - p >= 8) && !memcmp(p, "![CDATA[", 8))
+				p = NLSMLSkip(p + 8, end, "]]>");
+			else
+				p = NLSMLSkip(p, end, ">");
+			continue;
+		}
+
+		/* Element name */
+		bool closing = (*p == '/');
+		if (closing) p++;
+		char const* name = p;
+		while ((p < end) && !NLSMLIsSpace(*p) && (*p != '>') && (*p != '/')) p++;
+		int elem = NLSML_OTHER;
+		if (NLSMLNameIs(name, p - name, "interpretation"))
+			elem = NLSML_INTERPRETATION;
+		else if (NLSMLNameIs(name, p - name, "input"))
+			elem = NLSML_INPUT;
+		else if (NLSMLNameIs(name, p - name, "instance"))
+			elem = NLSML_INSTANCE;
+		/* Anything inside instance is application data */
+		if (instanceDepth && (elem != NLSML_INSTANCE))
+			elem = NLSML_OTHER;
+		if (!closing && (elem == NLSML_INTERPRETATION)) {
+			cur = (count < max) ? &out[count++] : NULL;
+			if (cur) {
+				memset(cur, 0, sizeof(*cur));
+				cur->confidence = -1;
+			}
+			confidenceSet = false;
+			inputDepth = 0;
+		}
+
+		/* Attributes */
+		bool empty = false;
+		for (;;) {
+			while ((p < end) && NLSMLIsSpace(*p)) p++;
+			if (p >= end)
+				return count;
+			if (*p == '>') {
+				p++;
+				break;
+			}
+			if (*p == '/') {
+				empty = true;
+				p++;
+				continue;
+			}
+			char const* attr = p;
+			while ((p < end) && !NLSMLIsSpace(*p) && (*p != '=') && (*p != '>') && (*p != '/')) p++;
+			size_t alen = p - attr;
+			while ((p < end) && NLSMLIsSpace(*p)) p++;
+			if ((p >= end) || (*p != '='))
+				continue;
+			p++;
+			while ((p < end) && NLSMLIsSpace(*p)) p++;
+			if ((p >= end) || ((*p != '"') && (*p != '\'')))
+				return count;
+			char const* val = p + 1;
+			p = static_cast<char const*>(memchr(val, *p, end - val));
+			if (!p)
+				return count;
+			size_t vlen = p++ - val;
+			if (!cur || closing)
+				continue;
+			if (elem == NLSML_INTERPRETATION) {
+				if (NLSMLNameIs(attr, alen, "grammar")) {
+					cur->grammar = val;
+					cur->grammar_len = vlen;
+				} else if (NLSMLNameIs(attr, alen, "confidence")) {
+					cur->confidence = NLSMLConfidence(val, vlen, percent);
+					confidenceSet = true;
+				}
+			} else if (elem == NLSML_INPUT) {
+				if (NLSMLNameIs(attr, alen, "mode") && !cur->mode_len) {
+					cur->mode = val;
+					cur->mode_len = vlen;
+				} else if (NLSMLNameIs(attr, alen, "confidence") && !confidenceSet) {
+					cur->confidence = NLSMLConfidence(val, vlen, percent);
+					confidenceSet = true;
+				}
+			}
+		}
+
+		/* Element content boundaries */
+		switch (elem) {
+		case NLSML_INTERPRETATION:
+			if (closing) cur = NULL;
+			break;
+		case NLSML_INPUT:
+			if (!closing && !empty) {
+				if (!inputDepth++)
+					inputStart = p;
+			} else if (closing && inputDepth && !--inputDepth && cur) {
+				cur->input = inputStart;
+				cur->input_len = lt - inputStart;
+				NLSMLTrim(cur->input, cur->input_len);
+			}
+			break;
+		case NLSML_INSTANCE:
+			if (!closing && !empty) {
+				if (!instanceDepth++)
+					instanceStart = p;
+			} else if (closing && instanceDepth && !--instanceDepth && cur) {
+				cur->instance = instanceStart;
+				cur->instance_len = lt - instanceStart;
+				NLSMLTrim(cur->instance, cur->instance_len);
+			}
+			break;
+		}
+	}
+	return count;
+}
+
+
+unsigned UniMRCPResourceMessage<MRCP_RECOGNIZER>::ParseNLSML(UniMRCPNLSMLInterpretation* out, unsigned max) const
+{
+	return NLSMLParse(msg->body.buf, msg->body.buf + msg->body.length, out, max,
+		msg->start_line.version == MRCP_VERSION_1);
+}
+
+
+bool UniMRCPResourceMessage<MRCP_RECOGNIZER>::ParseNLSML(UniMRCPNLSMLResult& result) const
+{
+	result.pool = msg->pool;
+	result.count = ParseNLSML(result.items, UW_NLSML_MAX_INTERPRETATIONS);
+	memset(result.strings, 0, sizeof(result.strings));
+	return result.count > 0;
+}
+
+
+UniMRCPNLSMLResult::UniMRCPNLSMLResult() :
+	count(0),
+	pool(NULL)
+{
+	memset(strings, 0, sizeof(strings));
+}
+
+
+UniMRCPNLSMLInterpretation const& UniMRCPNLSMLResult::Get(unsigned i) const THROWS(UniMRCPException)
+{
+	if (i >= count)
+		UNIMRCP_THROW("NLSML interpretation index out of range");
+	return items[i];
+}
+
+
+float UniMRCPNLSMLResult::Confidence(unsigned i) const THROWS(UniMRCPException)
+{
+	return Get(i).confidence;
+}
+
+
+/**
+ * @brief Decode XML character reference &#NN; or &#xNN; at buf into UTF-8 at dst.
+ * Never longer than the reference itself. Returns length of the reference, 0 if not valid.
+ */
+static size_t NLSMLCharRef(char const* buf, char const* end, char*& dst)
+{
+	char const* p = buf + 2;
+	if ((end - buf < 4) || (buf[1] != '#'))
+		return 0;
+	bool hex = (*p == 'x');
+	if (hex)
+		p++;
+	apr_uint32_t cp = 0;
+	char const* digits = p;
+	for (; (p < end) && (p - digits < 8); p++) {
+		int d;
+		if ((*p >= '0') && (*p <= '9'))
+			d = *p - '0';
+		else if (hex && (*p >= 'a') && (*p <= 'f'))
+			d = *p - 'a' + 10;
+		else if (hex && (*p >= 'A') && (*p <= 'F'))
+			d = *p - 'A' + 10;
+		else
+			break;
+		cp = cp * (hex ? 16 : 10) + static_cast<apr_uint32_t>(d);
+	}
+	/* No digits, unterminated, NUL, surrogate or beyond Unicode */
+	if ((p == digits) || (p >= end) || (*p != ';') || !cp || ((cp >= 0xD800) && (cp <= 0xDFFF)) || (cp > 0x10FFFF))
+		return 0;
+	if (cp < 0x80)
+		*dst++ = static_cast<char>(cp);
+	else if (cp < 0x800) {
+		*dst++ = static_cast<char>(0xC0 | (cp >> 6));
+		*dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		*dst++ = static_cast<char>(0xE0 | (cp >> 12));
+		*dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+	} else {
+		*dst++ = static_cast<char>(0xF0 | (cp >> 18));
+		*dst++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		*dst++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*dst++ = static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	return static_cast<size_t>(p + 1 - buf);
+}
+
+
+/** @brief Copy string from message body into pool, optionally decoding predefined XML entities and character references */
+static char const* NLSMLString(apr_pool_t* pool, char const* buf, size_t len, bool decode)
+{
+	char* str = static_cast<char*>(apr_palloc(pool, len + 1));
+	char* dst = str;
+	char const* end = buf + len;
+	while (buf < end) {
+		if (decode && (*buf == '&')) {
+			static const struct {char const* ent; size_t len; char c;} entities[] = {
+				{"&lt;", 4, '<'}, {"&gt;", 4, '>'}, {"&amp;", 5, '&'}, {"&quot;", 6, '"'}, {"&apos;", 6, '\''}
+			};
+			size_t e;
+			for (e = 0; e < sizeof(entities) / sizeof(entities[0]); e++)
+				if ((static_cast<size_t>(end - buf) >= entities[e].len) && !memcmp(buf, entities[e].ent, entities[e].len))
+					break;
+			if (e < sizeof(entities) / sizeof(entities[0])) {
+				*dst++ = entities[e].c;
+				buf += entities[e].len;
+				continue;
+			}
+			size_t ref = NLSMLCharRef(buf, end, dst);
+			if (ref) {
+				buf += ref;
+				continue;
+			}
+		}
+		*dst++ = *buf++;
+	}
+	*dst = 0;
+	return str;
+}
+
+
+char const* UniMRCPNLSMLResult::String(unsigned i, unsigned which) const THROWS(UniMRCPException)
+{
+	UniMRCPNLSMLInterpretation const& item = Get(i);
+	if (strings[i][which])
+		return strings[i][which];
+	switch (which) {
+	case STR_GRAMMAR:
+		return strings[i][which] = NLSMLString(pool, item.grammar, item.grammar_len, true);
+	case STR_MODE:
+		return strings[i][which] = NLSMLString(pool, item.mode, item.mode_len, true);
+	case STR_INPUT:
+		return strings[i][which] = NLSMLString(pool, item.input, item.input_len, true);
+	default:
+		return strings[i][which] = NLSMLString(pool, item.instance, item.instance_len, false);
+	}
+}
+
+
+char const* UniMRCPNLSMLResult::Grammar(unsigned i) const THROWS(UniMRCPException)
+{
+	return String(i, STR_GRAMMAR);
+}
+
+
+char const* UniMRCPNLSMLResult::Mode(unsigned i) const THROWS(UniMRCPException)
+{
+	return String(i, STR_MODE);
+}
+
+
+char const* UniMRCPNLSMLResult::Input(unsigned i) const THROWS(UniMRCPException)
+{
+	return String(i, STR_INPUT);
+}
+
+
+char const* UniMRCPNLSMLResult::Instance(unsigned i) const THROWS(UniMRCPException)
+{
+	return String(i, STR_INSTANCE);
+}
+
+
+UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::UniMRCPClientResourceChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) THROWS(UniMRCPException) :
+	UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER>(session, termination),
+	grammarMutex(NULL),
+	grammars(NULL),
+	pendingGrammars(NULL)
+{
+	apr_pool_t* pool = mrcp_application_session_pool_get(sess);
+	if (apr_thread_mutex_create(&grammarMutex, APR_THREAD_MUTEX_DEFAULT, pool) != APR_SUCCESS)
+		UNIMRCP_THROW("Cannot create grammar mutex");
+	grammars = apr_hash_make(pool);
+	pendingGrammars = apr_array_make(pool, 4, sizeof(UniMRCPPendingGrammar));
+}
+
+
+UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::~UniMRCPClientResourceChannel()
+{
+}
+
+
+char const* UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::RegisterGrammar(char const* content_type, char const* body) THROWS(UniMRCPException)
+{
+	if (!grammarCache)
+		UNIMRCP_THROW("UniMRCP platform not statically initialized");
+	if (!content_type || !body)
+		UNIMRCP_THROW("Grammar content type and body must be specified");
+	apr_size_t ctlen = strlen(content_type);
+	apr_size_t len = strlen(body);
+	apr_uint64_t hash = HashFNV1a(FNV1A_INIT, content_type, ctlen + 1);
+	hash = HashFNV1a(hash, body, len);
+	char id[GRAMMAR_ID_SIZE];
+	apr_snprintf(id, sizeof(id), "uw-%016" APR_UINT64_T_HEX_FMT, hash);
+
+	apr_thread_mutex_lock(grammarCacheMutex);
+	UniMRCPGrammar* g = static_cast<UniMRCPGrammar*>(apr_hash_get(grammarCache, id, APR_HASH_KEY_STRING));
+	if (g) {
+		bool same = (g->len == len) && !strcmp(g->content_type, content_type) && !memcmp(g->body, body, len);
+		apr_thread_mutex_unlock(grammarCacheMutex);
+		if (!same)
+			UNIMRCP_THROW("Grammar ID collision");
+		return g->id;
+	}
+	g = static_cast<UniMRCPGrammar*>(apr_palloc(grammarCachePool, sizeof(UniMRCPGrammar)));
+	memcpy(g->id, id, sizeof(g->id));
+	g->uri = apr_pstrcat(grammarCachePool, "session:", id, NULL);
+	g->content_type = apr_pstrmemdup(grammarCachePool, content_type, ctlen);
+	g->body = apr_pstrmemdup(grammarCachePool, body, len);
+	g->len = len;
+	apr_hash_set(grammarCache, g->id, APR_HASH_KEY_STRING, g);
+	apr_thread_mutex_unlock(grammarCacheMutex);
+	UW_LOG(APT_PRIO_DEBUG, "%s Grammar registered: id(%s) content_type(%s) len(%"APR_SIZE_T_FMT")",
+		swig_target_platform, g->id, g->content_type, len);
+	return g->id;
+}
+
+
+char const* UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::DefineGrammar(char const* grammar_id) THROWS(UniMRCPException)
+{
+	if (!grammarCache || !grammar_id)
+		UNIMRCP_THROW("Unknown grammar");
+	apr_thread_mutex_lock(grammarCacheMutex);
+	UniMRCPGrammar const* g = static_cast<UniMRCPGrammar const*>(apr_hash_get(grammarCache, grammar_id, APR_HASH_KEY_STRING));
+	apr_thread_mutex_unlock(grammarCacheMutex);
+	if (!g)
+		UNIMRCP_THROW("Unknown grammar");
+
+	apr_thread_mutex_lock(grammarMutex);
+	if (apr_hash_get(grammars, g->id, APR_HASH_KEY_STRING)) {
+		apr_thread_mutex_unlock(grammarMutex);
+		return g->uri;
+	}
+	/* Marked at once, so that concurrent calls send it only once */
+	apr_hash_set(grammars, g->id, APR_HASH_KEY_STRING, g);
+	apr_thread_mutex_unlock(grammarMutex);
+
+	UniMRCPResourceMessage<MRCP_RECOGNIZER>* msg = NULL;
+	bool sent = false;
+	try {
+		msg = CreateMessage(RECOGNIZER_DEFINE_GRAMMAR);
+		msg->content_type_set(g->content_type);
+		msg->content_id_set(g->id);
+		msg->SetBody(g->body, g->len);
+		/* Tracked before sending, the response can arrive before we get the lock back */
+		apr_thread_mutex_lock(grammarMutex);
+		UniMRCPPendingGrammar* p = static_cast<UniMRCPPendingGrammar*>(apr_array_push(pendingGrammars));
+		p->grammar = g;
+		p->msg = msg->msg;
+		apr_thread_mutex_unlock(grammarMutex);
+		sent = msg->Send();
+	} catch (...) {
+	}
+	if (!sent) {
+		apr_thread_mutex_lock(grammarMutex);
+		apr_hash_set(grammars, g->id, APR_HASH_KEY_STRING, NULL);
+		if (msg)
+			ForgetPendingGrammar(msg->msg);
+		apr_thread_mutex_unlock(grammarMutex);
+		UNIMRCP_THROW("Cannot send DEFINE-GRAMMAR");
+	}
+	UW_LOG(APT_PRIO_DEBUG, "%s DEFINE-GRAMMAR sent: id(%s) sess(%pp) chan(%pp) this(%pp)",
+		swig_target_platform, g->id, sess, chan, this);
+	return g->uri;
+}
+
+
+char const* UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::DefineGrammar(char const* content_type, char const* body) THROWS(UniMRCPException)
+{
+	return DefineGrammar(RegisterGrammar(content_type, body));
+}
+
+
+bool UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::IsGrammarDefined(char const* grammar_id) const
+{
+	if (!grammar_id)
+		return false;
+	apr_thread_mutex_lock(grammarMutex);
+	bool defined = apr_hash_get(grammars, grammar_id, APR_HASH_KEY_STRING) != NULL;
+	apr_thread_mutex_unlock(grammarMutex);
+	return defined;
+}
+
+
+UniMRCPResourceMessage<MRCP_RECOGNIZER>* UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::CreateRecognizeMessage(char const* uris, bool autoAddProperty) THROWS(UniMRCPException)
+{
+	UniMRCPResourceMessage<MRCP_RECOGNIZER>* msg = CreateMessage(RECOGNIZER_RECOGNIZE, autoAddProperty);
+	msg->content_type_set("text/uri-list");
+	if (!autoAddProperty)
+		msg->UniMRCPMessage::AddProperty(UW_HEADER_GENERIC_CONTENT_TYPE);
+	msg->SetBody(uris);
+	return msg;
+}
+
+
+UniMRCPGrammar const* UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::ForgetPendingGrammar(mrcp_message_t const* request)
+{
+	UniMRCPPendingGrammar* pending = reinterpret_cast<UniMRCPPendingGrammar*>(pendingGrammars->elts);
+	for (int i = 0; i < pendingGrammars->nelts; i++)
+		if (pending[i].msg == request) {
+			UniMRCPGrammar const* g = pending[i].grammar;
+			pending[i] = pending[--pendingGrammars->nelts];
+			return g;
+		}
+	return NULL;
+}
+
+
+bool UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::OnMsgReceive(mrcp_message_t* message)
+{
+	if ((message->start_line.message_type == MRCP_MESSAGE_TYPE_RESPONSE) &&
+		(message->start_line.method_id == RECOGNIZER_DEFINE_GRAMMAR))
+	{
+		/* The stack assigned request ID to the very message sent, like UpdateRequests() */
+		UniMRCPGrammar const* g = NULL;
+		mrcp_request_id rid = message->start_line.request_id;
+		apr_thread_mutex_lock(grammarMutex);
+		UniMRCPPendingGrammar const* pending = reinterpret_cast<UniMRCPPendingGrammar const*>(pendingGrammars->elts);
+		for (int i = 0; i < pendingGrammars->nelts; i++)
+			if (pending[i].msg->start_line.request_id == rid) {
+				g = ForgetPendingGrammar(pending[i].msg);
+				break;
+			}
+		if (g && ((message->start_line.status_code < MRCP_STATUS_CODE_SUCCESS) ||
+			(message->start_line.status_code > MRCP_STATUS_CODE_SUCCESS_WITH_IGNORE)))
+		{
+			apr_hash_set(grammars, g->id, APR_HASH_KEY_STRING, NULL);
+			UW_LOG(APT_PRIO_WARNING, "%s DEFINE-GRAMMAR failed: id(%s) status(%d) sess(%pp) chan(%pp)",
+				swig_target_platform, g->id, static_cast<int>(message->start_line.status_code), sess, chan);
+		}
+		apr_thread_mutex_unlock(grammarMutex);
+	}
+	return UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER>::OnMsgReceive(message);
+}
+
+
 UniMRCPResourceMessage<MRCP_RECORDER>::UniMRCPResourceMessage(mrcp_session_t* sess, mrcp_channel_t* chan, mrcp_message_t* msg, bool autoAddProperty) THROWS(UniMRCPException) :
 	UniMRCPResourceMessageBase<UniMRCPRecorderHeaderId, UniMRCPRecorderMethod, UniMRCPRecorderEvent>(
 		sess, chan, msg, autoAddProperty),
@@ -167,7 +167,7 @@
  *    - Override UniMRCPClientChannel::OnAdd and if the #UniMRCPSigStatusCode
  *      parameter is #MRCP_SIG_STATUS_CODE_SUCCESS, start sending messages
  *      and return @c true (@c false causes disconnection).
- *    - Override UniMRCPClientResourceChannel::OnMessageReceive to get responses and events
+ *    - Override UniMRCPClientResourceChannelBase::OnMessageReceive to get responses and events
  *      from the server.
  * -# When done, call UniMRCPClientSession::Terminate.
  *    In UniMRCPClientSession::OnTerminate you can UniMRCPClientSession::Destroy
@@ -314,8 +314,11 @@
 /* Opaque structures */
 struct apr_pool_t;                //< APR memory pool opaque C structure
 struct apr_thread_mutex_t;        //< APR mutex opaque C structure
+struct apr_thread_cond_t;         //< APR condition variable opaque C structure
 struct apr_file_t;                //< APR file opaque C structure
 struct apr_mmap_t;                //< APR memory mapping opaque C structure
+struct apr_hash_t;                //< APR hash table opaque C structure
+struct apr_array_header_t;        //< APR array opaque C structure
 struct mrcp_client_t;             //< MRCP client opaque C structure
 struct mrcp_application_t;        //< MRCP application opaque C structure
 struct mrcp_app_message_t;        //< MRCP application message opaque C structure
@@ -327,6 +330,7 @@ struct mrcp_generic_header_t;     //< MRCP message generic header opaque C struc
 struct mrcp_synth_header_t;       //< MRCP message synthesizer header opaque C structure
 struct mrcp_recog_header_t;       //< MRCP message recognizer header opaque C structure
 struct mrcp_recorder_header_t;    //< MRCP message recorder header opaque C structure
+struct mrcp_resource_factory_t;   //< MRCP resource factory opaque C structure
 struct mpf_termination_t;         //< Media termination opaque C structure
 struct mpf_stream_capabilities_t; //< Media stream capabilities opaque C structure
 struct mpf_audio_stream_t;        //< Audio stream opaque C structure
@@ -334,6 +338,17 @@ struct mpf_codec_t;               //< Media codec opaque C structure
 struct mpf_frame_t;               //< Media frame opaque C structure
 struct mpf_dtmf_generator_t;      //< DTMF generator opaque C structure
 struct mpf_dtmf_detector_t;       //< DTMF detector opaque C structure
+struct UniMRCPTimer;              //< Timer wheel entry opaque structure
+struct UniMRCPPooledSession;      //< Session pool entry opaque structure
+struct UniMRCPGateSet;            //< Admission limits opaque structure
+struct UniMRCPGroupMember;        //< Profile group member opaque structure
+struct UniMRCPProfileGroup;       //< Profile group opaque structure
+struct UniMRCPBatchEntry;         //< Session batch entry opaque structure
+struct UniMRCPRetiredSession;     //< C session replaced upon failover opaque structure
+struct UniMRCPLatencySlot;        //< Request latency tracking opaque structure
+struct UniMRCPTxTiming;           //< Incoming audio timing opaque structure
+struct UniMRCPRxCounters;         //< Outgoing stream counters opaque structure
+struct UniMRCPGrammar;            //< Cached grammar opaque structure
 
 /** @brief MRCP request ID */
 typedef unsigned long long UniMRCPRequestId;
@@ -347,6 +362,13 @@ class UniMRCPStreamTx;
 class UniMRCPAudioTermination;
 class UniMRCPClientChannel;
 class UniMRCPMessage;
+class UniMRCPRequest;
+class UniMRCPTimerWheel;
+class UniMRCPDispatcher;
+class UniMRCPClientPool;
+class UniMRCPSessionPool;
+class UniMRCPAdmission;
+class UniMRCPSessionBatch;
 
 
 /*
@@ -777,6 +799,96 @@ enum UniMRCPProsodyVolumeLabel {
 	ENUM_MEM(PROSODY_, VOLUME_UNKNOWN)
 };
 
+/** @brief State of a request tracked by UniMRCPRequest */
+enum UniMRCPAsyncState {
+	ENUM_MEM(ASYNC_, SENT),        /**< Sent, waiting for response */
+	ENUM_MEM(ASYNC_, PENDING),     /**< PENDING response received, waiting for completion event */
+	ENUM_MEM(ASYNC_, IN_PROGRESS), /**< IN-PROGRESS response received, waiting for completion event */
+	ENUM_MEM(ASYNC_, COMPLETE),    /**< COMPLETE response or completion event received */
+	ENUM_MEM(ASYNC_, FAILED),      /**< Could not be sent or channel gone before completion */
+	ENUM_MEM(ASYNC_, TIMED_OUT)    /**< Deadline expired before completion */
+};
+
+/** @brief What to do with a request whose deadline expired, see UniMRCPClientChannel::OnRequestTimeout() */
+enum UniMRCPTimeoutAction {
+	ENUM_MEM(TIMEOUT_, NONE),      /**< Only complete the request as timed out */
+	ENUM_MEM(TIMEOUT_, STOP),      /**< Also send STOP for the request */
+	ENUM_MEM(TIMEOUT_, TERMINATE)  /**< Also terminate the whole session */
+};
+
+/** @brief How UniMRCPClientPool places new sessions on its clients */
+enum UniMRCPPlacement {
+	ENUM_MEM(PLACEMENT_, LEAST_LOADED), /**< Client with the fewest sessions */
+	ENUM_MEM(PLACEMENT_, HASH)          /**< Consistent hash of the session key (least loaded without key) */
+};
+
+/** @brief What UniMRCPClient::SetLimit() limits */
+enum UniMRCPLimitType {
+	ENUM_MEM(LIMIT_, SESSIONS),    /**< Concurrent sessions */
+	ENUM_MEM(LIMIT_, CHANNELS),    /**< Concurrent channels */
+	ENUM_MEM(LIMIT_, REQUESTS)     /**< Requests sent by SendAsync() and not completed yet */
+};
+
+/** @brief How a profile group chooses the profile of a new session */
+enum UniMRCPBalancing {
+	ENUM_MEM(BALANCE_, ROUND_ROBIN),       /**< Weighted round robin */
+	ENUM_MEM(BALANCE_, LEAST_OUTSTANDING)  /**< Fewest sessions and SendAsync() requests per weight */
+};
+
+/** @brief Wrapper-wide metric, see UniMRCPClient::GetMetrics() */
+enum UniMRCPMetric {
+	ENUM_MEM(METRIC_, CLIENTS),            /**< Live clients (gauge) */
+	ENUM_MEM(METRIC_, SESSIONS),           /**< Live sessions (gauge) */
+	ENUM_MEM(METRIC_, CHANNELS),           /**< Live channels (gauge) */
+	ENUM_MEM(METRIC_, STREAMS),            /**< Open audio streams of both directions (gauge) */
+	ENUM_MEM(METRIC_, MESSAGES_SENT),      /**< Requests sent */
+	ENUM_MEM(METRIC_, MESSAGES_RECEIVED),  /**< Responses and events received */
+	ENUM_MEM(METRIC_, FRAMES_READ),        /**< Frames supplied by UniMRCPStreamRx::ReadFrame() */
+	ENUM_MEM(METRIC_, FRAMES_WRITTEN),     /**< Frames passed to UniMRCPStreamTx::WriteFrame() */
+	ENUM_MEM(METRIC_, UNDERRUNS),          /**< ReadFrame() calls which supplied no frame */
+	ENUM_MEM(METRIC_, DTMF_EVENTS),        /**< DTMF digits sent or detected */
+	ENUM_MEM(METRIC_, SESSION_POOL_BYTES)  /**< Bytes of wrapper objects allocated from session memory pools */
+};
+
+/** @brief Measured phase, see UniMRCPClient::GetLatency() */
+enum UniMRCPLatencyPhase {
+	ENUM_MEM(LATENCY_, RESPONSE),        /**< Request sent to its first response, by method */
+	ENUM_MEM(LATENCY_, COMPLETE),        /**< Request sent to COMPLETE response or completion event, by method */
+	ENUM_MEM(LATENCY_, EVENT),           /**< Request sent to an event it caused, by event */
+	ENUM_MEM(LATENCY_, CHANNEL_ADD),     /**< Channel added to OnAdd(), by resource */
+	ENUM_MEM(LATENCY_, SESSION_UPDATE),  /**< Session created to its first OnUpdate() */
+	ENUM_MEM(LATENCY_, FIRST_AUDIO),     /**< SPEAK sent to the first audio frame in UniMRCPStreamTx::WriteFrame() */
+	ENUM_MEM(LATENCY_, FRAME_JITTER)     /**< Variation of incoming frame intervals after the first audio */
+};
+
+/** @brief Reason of UniMRCPException */
+enum UniMRCPErrorCode {
+	ENUM_MEM(ERROR_, GENERIC),            /**< Any error not listed below */
+	ENUM_MEM(ERROR_, ADMISSION_REJECTED), /**< Limit reached, see UniMRCPClient::SetLimit() */
+	ENUM_MEM(ERROR_, ADMISSION_TIMEOUT)   /**< Limit reached and no slot freed in time */
+};
+
+/** @brief Event code of a trace log record, see UniMRCPClient::StartTraceLog() */
+enum UniMRCPTraceEvent {
+	ENUM_MEM(TRACE_, SESSION_CREATE),     /**< Session created */
+	ENUM_MEM(TRACE_, SESSION_UPDATE),     /**< Session updated: value = status */
+	ENUM_MEM(TRACE_, SESSION_TERMINATE),  /**< Session terminated: value = status */
+	ENUM_MEM(TRACE_, TERMINATE_EVENT),    /**< Session terminated unexpectedly */
+	ENUM_MEM(TRACE_, SESSION_DESTROY),    /**< Session object destroyed */
+	ENUM_MEM(TRACE_, CHANNEL_CREATE),     /**< Channel created and being added */
+	ENUM_MEM(TRACE_, CHANNEL_ADD),        /**< Channel added: value = status */
+	ENUM_MEM(TRACE_, CHANNEL_REMOVE),     /**< Channel removed: value = status */
+	ENUM_MEM(TRACE_, MESSAGE_SEND),       /**< Request sent: value = method, request = 0 (ID assigned later, see #TRACE_REQUEST_ID) */
+	ENUM_MEM(TRACE_, MESSAGE_RECEIVE),    /**< Response or event: value = method or event, request = ID,
+	                                           value1 = message type, value2 = status code | request state << 16 */
+	ENUM_MEM(TRACE_, REQUEST_TIMEOUT),    /**< Request deadline expired: value = timeout action, request = ID */
+	ENUM_MEM(TRACE_, STREAM_OPEN),        /**< Media stream opened: value = 0 for RX, 1 for TX */
+	ENUM_MEM(TRACE_, STREAM_CLOSE),       /**< Media stream closed: value = 0 for RX, 1 for TX */
+	ENUM_MEM(TRACE_, STARVATION),         /**< RX stream starved: value = frames in a row */
+	ENUM_MEM(TRACE_, REQUEST_ID)          /**< First response matched to the request sent: value = method, request = ID,
+	                                           value1 = microseconds since #TRACE_MESSAGE_SEND */
+};
+
 
 /**
  * @brief The only exception thrown directly by the wrapper.
@@ -787,13 +899,14 @@ enum UniMRCPProsodyVolumeLabel {
 #endif
 class UniMRCPException {
 public:
-	UniMRCPException(char const* _file, unsigned _line, char const* _msg) :
-		file(_file), line(_line), msg(_msg)
+	UniMRCPException(char const* _file, unsigned _line, char const* _msg, UniMRCPErrorCode _code = ENUM_MEM(ERROR_, GENERIC)) :
+		file(_file), line(_line), msg(_msg), code(_code)
 	{};
 
-	char const* const file;
-	unsigned const    line;
-	char const* const msg;
+	char const* const      file;
+	unsigned const         line;
+	char const* const      msg;
+	UniMRCPErrorCode const code;
 };
 #ifdef _MSC_VER
 #	pragma warning (pop)
@@ -817,6 +930,122 @@ private:
 	static UniMRCPLogger* logger;
 
 	friend class UniMRCPClient;
+	friend class UniMRCPLogQueue;
+};
+
+
+/**
+ * @brief Asynchronous logging statistics, see UniMRCPClient::GetLogStats()
+ */
+struct UniMRCPLogStats {
+	unsigned           capacity;    ///< Records the queue can hold, 0 if logging is synchronous
+	unsigned           queueDepth;  ///< Records waiting for the logging thread
+	unsigned long long logged;      ///< Records passed to UniMRCPLogger::Log()
+	unsigned long long dropped;     ///< Records lost because the queue was full
+};
+
+
+/**
+ * @brief Callback dispatcher statistics, see UniMRCPClient::GetDispatchStats()
+ */
+struct UniMRCPDispatchStats {
+	unsigned           threads;       ///< Worker threads, 0 if callbacks run on the client task
+	unsigned           queueDepth;    ///< Callbacks currently queued in all workers
+	unsigned           queueDepthMax; ///< Highest queue depth of a single worker seen
+	unsigned long long dispatched;    ///< Callbacks run so far
+	unsigned long long queueFull;     ///< How many times the client task had to wait for a full queue
+	unsigned long      latencyAvgUs;  ///< Average time from queueing to running a callback (microseconds)
+	unsigned long      latencyMaxUs;  ///< Maximum time from queueing to running a callback (microseconds)
+};
+
+
+#ifndef UW_METRIC_MAX_IDS
+/** @brief Methods and events counted per resource, higher IDs are only counted in totals */
+#	define UW_METRIC_MAX_IDS 16
+#endif
+/** @brief Metrics above followed by sent, responded and event counters per resource */
+#define UW_METRIC_CELLS (ENUM_MEM(METRIC_, SESSION_POOL_BYTES) + 1 + 3 * 3 * UW_METRIC_MAX_IDS)
+
+/**
+ * @brief Values of all metrics at one moment, see UniMRCPClient::GetMetrics()
+ *
+ * Counters only grow, gauges are current values.
+ */
+class UniMRCPMetricsSnapshot {
+public:
+	WRAPPER_DECL UniMRCPMetricsSnapshot();
+	/** @brief Value of a metric */
+	WRAPPER_DECL unsigned long long Get(UniMRCPMetric metric) const;
+	/** @brief Requests sent with the method */
+	WRAPPER_DECL unsigned long long GetSent(UniMRCPResource resource, unsigned method) const;
+	/** @brief Responses received to requests with the method */
+	WRAPPER_DECL unsigned long long GetResponses(UniMRCPResource resource, unsigned method) const;
+	/** @brief Events received */
+	WRAPPER_DECL unsigned long long GetEvents(UniMRCPResource resource, unsigned event) const;
+
+private:
+	unsigned long long values[UW_METRIC_CELLS];
+
+	friend class UniMRCPClient;
+};
+
+
+/**
+ * @brief Latency distribution summary, see UniMRCPClient::GetLatency()
+ *
+ * Values are in microseconds with up to 1/16 relative error.
+ */
+struct UniMRCPLatencyStats {
+	unsigned long long count;   ///< Number of measurements
+	unsigned long      minUs;   ///< Lowest
+	unsigned long      maxUs;   ///< Highest
+	unsigned long      meanUs;  ///< Average
+	unsigned long      p50Us;   ///< Median
+	unsigned long      p90Us;   ///< 90th percentile
+	unsigned long      p99Us;   ///< 99th percentile
+	unsigned long      p999Us;  ///< 99.9th percentile
+};
+
+
+/**
+ * @brief Frame accounting of an outgoing stream, see UniMRCPStreamRx::GetRxStats()
+ */
+struct UniMRCPRxStats {
+	unsigned long requested;       ///< Frames requested by the media engine
+	unsigned long supplied;        ///< Frames sent with audio
+	unsigned long shortFrames;     ///< Supplied frames only partly filled (padded with zeros)
+	unsigned long zeroFilled;      ///< Supplied frames with no data at all
+	unsigned long starved;         ///< Frames not supplied, nothing was sent
+	unsigned long runs;            ///< Starvation runs after audio started
+	unsigned long currentRun;      ///< Frames starved in a row now
+	unsigned long longestRun;      ///< Longest starvation run
+};
+
+
+/**
+ * @brief Incoming audio timing of a channel, see UniMRCPClientChannel::GetTxStats()
+ */
+struct UniMRCPTxStats {
+	unsigned long frames;          ///< Frames passed to UniMRCPStreamTx::WriteFrame()
+	unsigned long nonAudioFrames;  ///< Frames without audio (silence, events)
+	unsigned long speaks;          ///< SPEAK requests followed by audio
+	unsigned long firstAudioUs;    ///< Time to first non-silent audio of the last SPEAK
+	unsigned long jitterUs;        ///< Smoothed interarrival jitter (RFC 3550)
+	unsigned long maxJitterUs;     ///< Highest single interval variation
+};
+
+
+/**
+ * @brief Occupancy of an admission limit, see UniMRCPClient::GetOccupancy()
+ */
+struct UniMRCPOccupancy {
+	unsigned           limit;     ///< Configured limit, 0 for unlimited
+	unsigned           current;   ///< Currently admitted
+	unsigned           peak;      ///< Highest occupancy seen
+	unsigned long long admitted;  ///< Admitted so far
+	unsigned long long queued;    ///< Had to wait for a free slot
+	unsigned long long rejected;  ///< Rejected immediately
+	unsigned long long timedOut;  ///< Rejected after waiting
 };
 
 
@@ -870,6 +1099,78 @@ public:
 	 */
 	WRAPPER_DECL static void StaticDeinitialize() THROWS(UniMRCPException);
 
+	/**
+	 * @brief Pass messages to the user logger from a dedicated thread.
+	 *
+	 * Call after StaticInitialize() with a logger. Logging threads (signaling, media)
+	 * then only format the message into a lock-free queue and never call
+	 * UniMRCPLogger::Log() themselves. When the queue is full, messages are dropped
+	 * and counted, the number dropped is logged once there is space again.
+	 * The thread is stopped, after the queue is written out, by StaticDeinitialize().
+	 *
+	 * @param queue_size Records buffered (rounded up to power of 2, at most 65536), each takes
+	 *                   256 bytes, messages longer than about 200 characters are allocated
+	 */
+	WRAPPER_DECL static void StartAsyncLogging(unsigned queue_size = 1024) THROWS(UniMRCPException);
+	/** @brief Get asynchronous logging statistics (all zero if not started) */
+	WRAPPER_DECL static void GetLogStats(UniMRCPLogStats& stats);
+	/**
+	 * @brief Log some sessions in more detail than the global priority.
+	 *
+	 * Each session created from now on is picked with probability 1/one_in and gets
+	 * the priority as by UniMRCPClientSession::SetLogPriority(). Which sessions were
+	 * picked is logged at NOTICE priority.
+	 *
+	 * @param one_in   Sample one in so many sessions, 0 to stop sampling
+	 * @param priority Log priority of the sampled sessions
+	 */
+	WRAPPER_DECL static void SetLogSampling(unsigned one_in, UniMRCPLogPriority priority = ENUM_MEM(APT_PRIO_, DEBUG));
+
+	/**
+	 * @brief Write binary trace records of sessions, channels, messages and streams.
+	 *
+	 * Every record is 64 bytes: time, thread, session number and name, channel number,
+	 * resource, UniMRCPTraceEvent and numeric values. They are written lock-free into
+	 * a ring of fixed-size records in a memory-mapped file, the oldest get overwritten.
+	 * Decode the file by Tools/uwtrace.py. Call after StaticInitialize().
+	 *
+	 * @param path    File to create (truncated if it exists)
+	 * @param records Ring capacity (rounded up to power of 2)
+	 */
+	WRAPPER_DECL static void StartTraceLog(char const* path, unsigned records = 65536) THROWS(UniMRCPException);
+	/** @brief Flush and close the trace log, only when no client exists. Called by StaticDeinitialize(). */
+	WRAPPER_DECL static void StopTraceLog() THROWS(UniMRCPException);
+
+	/**
+	 * @brief Get wrapper-wide metrics of all clients.
+	 *
+	 * Updating the metrics takes one atomic operation and no lock, so they are always on.
+	 * Counters are kept in 32 bits and extended here, so call at least every 2^32 events.
+	 */
+	WRAPPER_DECL static void GetMetrics(UniMRCPMetricsSnapshot& snapshot);
+
+	/**
+	 * @brief Get latency distribution of all clients.
+	 *
+	 * Every phase, resource and method or event has a fixed-size log-linear histogram
+	 * updated by atomic operations, up to about 70 minutes.
+	 * Only requests whose responses arrive with the request ID are measured.
+	 *
+	 * @param phase    What was measured
+	 * @param resource Resource, ignored for #LATENCY_SESSION_UPDATE, #LATENCY_FIRST_AUDIO and #LATENCY_FRAME_JITTER
+	 * @param id       Method or event ID (by phase), ignored for session and channel phases
+	 * @param stats    Filled with the summary, all zero for unknown IDs
+	 */
+	WRAPPER_DECL static void GetLatency(UniMRCPLatencyPhase phase, UniMRCPResource resource, unsigned id, UniMRCPLatencyStats& stats);
+	/**
+	 * @brief Get a percentile of a latency distribution, parameters as above
+	 * @param percentile 0 to 100
+	 * @return Latency in microseconds, 0 if nothing measured
+	 */
+	WRAPPER_DECL static unsigned long GetLatencyPercentile(UniMRCPLatencyPhase phase, UniMRCPResource resource, unsigned id, double percentile);
+	/** @brief Clear all latency histograms */
+	WRAPPER_DECL static void ResetLatency();
+
 public:
 	/**
 	 * @brief Create UniMRCP client instance.
@@ -879,15 +1180,106 @@ public:
 	 */
 	WRAPPER_DECL UniMRCPClient(char const* config, bool dir = false) THROWS(UniMRCPException);
 	/** @brief Calls Destroy if not already destroyed */
-	WRAPPER_DECL ~UniMRCPClient();
+	WRAPPER_DECL virtual ~UniMRCPClient();
 	/** @brief Destroy the client immediately (blocking call) */
 	WRAPPER_DECL void Destroy();
 
+	/**
+	 * @brief Wind down sessions before Destroy() (blocking call).
+	 *
+	 * New sessions are rejected with #ERROR_ADMISSION_REJECTED from now on. Every session
+	 * is terminated as soon as none of its requests is in progress, whether sent by Send()
+	 * or SendAsync(): a request counts until its response or completion event is COMPLETE.
+	 * The sessions must still be destroyed by the application as usual.
+	 *
+	 * @param timeout_ms How long to wait for the sessions to terminate
+	 * @return true if all sessions terminated, false on timeout
+	 */
+	WRAPPER_DECL bool Drain(unsigned long timeout_ms);
+	/**
+	 * @brief Called from Drain() whenever the numbers below change
+	 *
+	 * @param sessions Sessions not terminated yet
+	 * @param requests Requests in progress in them
+	 */
+	WRAPPER_DECL virtual void OnDrainProgress(unsigned sessions, unsigned requests);
+
+	/**
+	 * @brief Run callbacks on a pool of worker threads instead of the UniMRCP client task.
+	 *
+	 * By default all callbacks of all sessions run on the single client task thread,
+	 * so a slow one delays signaling of every session. With the dispatcher the task only
+	 * queues them. Callbacks of a session always run on the same worker, in order.
+	 * Must be called before the first session is created. Destroy() stops the workers
+	 * after the callbacks queued have run, the ones during shutdown run on the client task.
+	 *
+	 * @param threads    Number of worker threads
+	 * @param queue_size Capacity of each worker queue (rounded up to power of 2).
+	 *                   The client task waits when the queue is full.
+	 */
+	WRAPPER_DECL void StartDispatcher(unsigned threads, unsigned queue_size = 1024) THROWS(UniMRCPException);
+	/** @brief Get callback dispatcher statistics (all zero if not started) */
+	WRAPPER_DECL void GetDispatchStats(UniMRCPDispatchStats& stats) const;
+	/** @brief Get number of sessions created and not destroyed yet */
+	WRAPPER_DECL unsigned GetSessionCount() const;
+
+	/**
+	 * @brief Limit concurrent sessions, channels or requests of the client or of one profile.
+	 *
+	 * Over the limit, creation of the object (or SendAsync()) either waits for a free slot
+	 * or throws UniMRCPException with code #ERROR_ADMISSION_REJECTED or #ERROR_ADMISSION_TIMEOUT.
+	 * In Java these are RejectedExecutionException and its subclass UniMRCP.AdmissionTimeoutException,
+	 * in C# InvalidOperationException and TimeoutException, in Python RuntimeError(message, code).
+	 * Requests sent by plain Send() are not tracked, thus not limited.
+	 *
+	 * @param type    What to limit
+	 * @param max     Maximum concurrent objects, 0 for unlimited
+	 * @param wait_ms How long to wait for a free slot, 0 to reject immediately, -1 for infinity
+	 * @param profile MRCP profile, NULL for the whole client
+	 */
+	WRAPPER_DECL void SetLimit(UniMRCPLimitType type, unsigned max, long wait_ms = 0, char const* profile = NULL) THROWS(UniMRCPException);
+	/** @brief Get current and peak occupancy of the client or profile (zeros for unknown profile) */
+	WRAPPER_DECL void GetOccupancy(UniMRCPLimitType type, UniMRCPOccupancy& occupancy, char const* profile = NULL) const;
+
+	/**
+	 * @brief Add a profile to a profile group, creating the group.
+	 *
+	 * A session created with the group name instead of a profile name gets a profile
+	 * chosen by the group. If the session cannot be created there, the other profiles
+	 * of the group are tried. So are they if the session or its channels fail to set up
+	 * before the first channel is added: the session is created on the next profile with
+	 * the same channels, and OnAdd() reports the outcome there. A profile whose session
+	 * or channel fails to set up or terminates with an error is skipped for a while,
+	 * see SetGroupBalancing().
+	 *
+	 * @param group   Name of the group, must differ from the profile names
+	 * @param profile MRCP profile
+	 * @param weight  Share of sessions relative to the other profiles
+	 */
+	WRAPPER_DECL void AddProfileToGroup(char const* group, char const* profile, unsigned weight = 1) THROWS(UniMRCPException);
+	/**
+	 * @brief Configure a profile group
+	 *
+	 * @param group          Name of the group
+	 * @param balancing      Selection policy, default #BALANCE_ROUND_ROBIN
+	 * @param retry_after_ms How long to skip a failed profile, doubled with
+	 *                       every consecutive failure (up to 32 times)
+	 */
+	WRAPPER_DECL void SetGroupBalancing(char const* group, UniMRCPBalancing balancing, unsigned long retry_after_ms = 5000) THROWS(UniMRCPException);
+	/** @brief Choose a profile of the group as a new session would */
+	WRAPPER_DECL char const* SelectProfile(char const* group) THROWS(UniMRCPException);
+	/** @brief Whether a profile in a group is not being skipped after failure */
+	WRAPPER_DECL bool IsProfileHealthy(char const* group, char const* profile) const;
+
 private:
-	mrcp_client_t* client;   ///< The client opaque object
-	mrcp_application_t* app; ///< Application opaque object
-	bool terminated;         ///< Destroying
-	unsigned sess_id;        ///< Sessions counter
+	mrcp_client_t* client;       ///< The client opaque object
+	mrcp_application_t* app;     ///< Application opaque object
+	bool terminated;             ///< Destroying
+	unsigned sess_id;            ///< Sessions counter
+	unsigned sessions;           ///< Active sessions
+	UniMRCPTimerWheel* timers;   ///< Request deadlines scheduler
+	UniMRCPDispatcher* disp;     ///< Callback dispatcher, NULL to run on client task
+	UniMRCPAdmission* admission; ///< Admission limits and occupancy
 
 	static unsigned instances;         ///< How many clients there are
 	static unsigned staticInitialized; ///< How many times static initialized
@@ -897,12 +1289,59 @@ private:
 	static void StaticPreinitialize(int& fd_stdin, int& fd_stdout, int& fd_stderr) THROWS(UniMRCPException);
 	/** @brief Common static post-initialization steps with possible file descriptor hack */
 	static void StaticPostinitialize(int fd_stdin, int fd_stdout, int fd_stderr);
+	/** @brief Terminate idle sessions and count what remains, returns the wake events seen */
+	unsigned DrainStep(unsigned& sessions, unsigned& requests);
 
 private:
 	/** @brief Called by UniMRCP client task */
 	static int AppMessageHandler(const mrcp_app_message_t* msg);
+	/** @brief Run the callback, either from AppMessageHandler or a dispatcher worker */
+	static int AppMessageDispatch(const mrcp_app_message_t* msg);
 
 	friend class UniMRCPClientSession;
+	friend class UniMRCPClientChannel;
+	friend class UniMRCPSessionPool;
+};
+
+
+/**
+ * @brief Several clients started from the same configuration, sessions spread among them.
+ *
+ * Every client has its own signaling task and media engine, so a pool scales across cores.
+ * Create sessions with UniMRCPClientSession(UniMRCPClientPool*, ...).
+ * Note the configuration must not bind fixed local ports (e.g. SIP) then.
+ */
+class UniMRCPClientPool {
+public:
+	/**
+	 * @brief Create and start the clients
+	 *
+	 * @param config  Client framework root dir or inline XML configuration
+	 * @param dir     If true, above parameter is the root dir, otherwise it is XML string
+	 * @param clients Number of clients, 0 for one per CPU the process may run on
+	 * @param pin     Pin threads of every client to one of the allowed CPUs (round robin), Linux only.
+	 *                Clients are started from a thread pinned so, the calling thread keeps its affinity.
+	 */
+	WRAPPER_DECL UniMRCPClientPool(char const* config, bool dir = false, unsigned clients = 0, bool pin = false) THROWS(UniMRCPException);
+	/** @brief Calls Destroy */
+	WRAPPER_DECL ~UniMRCPClientPool();
+	/** @brief Destroy all clients (blocking call) */
+	WRAPPER_DECL void Destroy();
+
+	/** @brief Set how new sessions are placed, default #PLACEMENT_LEAST_LOADED */
+	WRAPPER_DECL void SetPlacement(UniMRCPPlacement placement);
+	/** @brief Get number of clients */
+	WRAPPER_DECL unsigned GetClientCount() const;
+	/** @brief Get client by index, e.g. to start its dispatcher */
+	WRAPPER_DECL UniMRCPClient* GetClient(unsigned index) const THROWS(UniMRCPException);
+	/** @brief Choose client for a new session */
+	WRAPPER_DECL UniMRCPClient* SelectClient(char const* key = NULL) THROWS(UniMRCPException);
+
+private:
+	UniMRCPClient** clients;    ///< Owned clients
+	unsigned count;             ///< Number of clients
+	UniMRCPPlacement placement; ///< Placement policy
+	unsigned next;              ///< Round robin start among equally loaded
 };
 
 
@@ -911,8 +1350,13 @@ private:
  */
 class UniMRCPClientSession {
 public:
-	/** @brief Create an MRCP session using specified profile */
+	/** @brief Create an MRCP session using specified profile or profile group */
 	WRAPPER_DECL UniMRCPClientSession(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException);
+	/**
+	 * @brief Create an MRCP session on a client chosen by the pool
+	 * @param key Placement key (e.g. call ID) for #PLACEMENT_HASH
+	 */
+	WRAPPER_DECL UniMRCPClientSession(UniMRCPClientPool* pool, char const* profile, char const* key = NULL) THROWS(UniMRCPException);
 	/** @brief Calls Destroy */
 	WRAPPER_DECL virtual ~UniMRCPClientSession();
 
@@ -923,6 +1367,27 @@ public:
 	WRAPPER_DECL void Destroy();
 	/** @brief Get MRCP session ID */
 	WRAPPER_DECL char const* GetID() const;
+	/**
+	 * @brief Log messages of the session and its channels up to the priority.
+	 *
+	 * Overrides the global priority for the wrapper's messages about the session,
+	 * so that a single call can be debugged without flooding the log. A priority
+	 * the global one already covers has no effect. Messages of UniMRCP itself are
+	 * not affected. Only a UniMRCPLogger gets the extra messages, with their own
+	 * priority; the apt log output filters them out as before.
+	 */
+	WRAPPER_DECL void SetLogPriority(UniMRCPLogPriority priority);
+	/** @brief Follow the global log priority again */
+	WRAPPER_DECL void ResetLogPriority();
+	/** @brief Get the log priority override, set or sampled, -1 if none */
+	WRAPPER_DECL int GetLogPriority() const;
+	/**
+	 * @brief Get bytes of wrapper objects allocated from the session pool.
+	 *
+	 * Messages are allocated there and released with the session only, so the
+	 * value grows with every message of a long-lived session. 0 once destroyed.
+	 */
+	WRAPPER_DECL unsigned GetPoolBytes() const;
 
 	/** @brief Session updated (SDP renegotiated?) */
 	WRAPPER_DECL virtual bool OnUpdate(UniMRCPSigStatusCode status);
@@ -938,15 +1403,268 @@ private:
 	static int AppOnTerminateEvent(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel);
 	static int AppOnResourceDiscover(mrcp_application_t* application, mrcp_session_t* session, mrcp_session_descriptor_t* descriptor, UniMRCPSigStatusCode status);
 
+	/** @brief Create the C session, trying profiles of the group if profile names one */
+	void Create(char const* profile) THROWS(UniMRCPException);
+	/** @brief Create the C session using the profile */
+	void Open(char const* profile) THROWS(UniMRCPException);
+	/** @brief Name the C session for the log */
+	void NameSession();
+	/** @brief Replace the C session failed to set up by one on the next profile of the group, false if none left */
+	bool Failover();
+	/** @brief Replace the C session by one on the profile and add the channels there again */
+	bool Reopen(char const* profile) THROWS(UniMRCPException);
+	/** @brief Replaced session gone, free the C session retired by failover if terminated already */
+	static int RetiredCleanup(void* data);
+	/** @brief The C session was replaced by failover, callbacks of the object do not apply */
+	static bool IsRetired(mrcp_session_t* session);
+	/** @brief Tell the profile group about setup or termination status */
+	void ReportHealth(bool success);
+	/** @brief Free admission slot of the session once the C session is gone */
+	void ReleaseLimits();
+	/** @brief Fail requests of all channels and forget them before session memory is released */
+	void DetachChannels();
+
 private:
-	mrcp_session_t* sess;    ///< Opaque C object
-	UniMRCPClient* client;   ///< Owner of the session
-	bool terminated;         ///< Has it been terminated
-	bool destroyOnTerminate; ///< Destroy as soon as terminated
+	/** @brief Session pool or batch which created the session */
+	struct Owner {
+		UniMRCPPooledSession* pooled;   ///< Entry of the pool, or NULL
+		UniMRCPBatchEntry* batched;     ///< Entry of the batch, or NULL
+	};
+	/** @brief Profile group failover, until a channel is added */
+	struct FailoverState {
+		UniMRCPGroupMember* member;     ///< Profile group member the session was created on, or NULL
+		UniMRCPProfileGroup* group;     ///< Group to fail over in until a channel is added, or NULL
+		unsigned long long tried;       ///< Members of the group tried (bit mask)
+		bool established;               ///< A channel has been added, no failover anymore
+	};
+	/** @brief Admission limits and drain */
+	struct AdmissionState {
+		UniMRCPAdmission* admission;    ///< Admission of the client, referenced
+		UniMRCPGateSet* limits;         ///< Profile limits the session was admitted by, NULL when released
+		bool drained;                   ///< Terminated by UniMRCPClient::Drain()
+		UniMRCPClientSession* prev;     ///< Previous session of the client, for Drain()
+		UniMRCPClientSession* next;     ///< Next session of the client
+	};
+	/** @brief Metrics, trace log and logging */
+	struct Diagnostics {
+		unsigned long long createdAt;   ///< Creation time, 0 after the first OnUpdate()
+		unsigned traceId;               ///< Number of the session in the trace log
+		int logPrio;                    ///< Log priority override, -1 to follow the global one
+	};
+
+	mrcp_session_t* sess;           ///< Opaque C object
+	UniMRCPClient* client;          ///< Owner of the session
+	bool terminated;                ///< Has it been terminated
+	bool destroyOnTerminate;        ///< Destroy as soon as terminated
+	apr_thread_mutex_t* mutex;      ///< Guards channels
+	UniMRCPClientChannel* channels; ///< Channels of the session (intrusive list)
+	UniMRCPTimerWheel* timers;      ///< Deadline scheduler of the client, referenced
+	Owner owner;                    ///< Pool or batch entry
+	FailoverState failover;         ///< Profile group failover
+	AdmissionState admit;           ///< Limits and drain list
+	Diagnostics diag;               ///< Metrics, trace and logging
 
 	friend class UniMRCPClient;
+	friend class UniMRCPAdmission;
 	friend class UniMRCPAudioTermination;
 	friend class UniMRCPClientChannel;
+	friend class UniMRCPSessionPool;
+	friend class UniMRCPSessionBatch;
+};
+
+
+/**
+ * @brief Session pool statistics, see UniMRCPSessionPool::GetStats()
+ */
+struct UniMRCPSessionPoolStats {
+	unsigned           size;         ///< Target number of warm sessions
+	unsigned           idle;         ///< Warm sessions ready for checkout
+	unsigned           warming;      ///< Sessions being negotiated
+	unsigned           busy;         ///< Sessions checked out
+	unsigned long long checkouts;    ///< Successful checkouts
+	unsigned long long hits;         ///< Checkouts served by a warm session without waiting
+	unsigned long long timeouts;     ///< Checkouts which got no session
+	unsigned long long failures;     ///< Sessions failed to negotiate
+	unsigned long long discarded;    ///< Sessions found unhealthy on checkout or checkin
+	unsigned long long recycled;     ///< Sessions torn down after idle timeout
+	double             hitRate;      ///< hits / (checkouts + timeouts)
+	unsigned long      refillAvgMs;  ///< Average time to negotiate a session (milliseconds)
+	unsigned long      refillMaxMs;  ///< Maximum time to negotiate a session (milliseconds)
+};
+
+
+/**
+ * @brief Pool of sessions with a channel already added, ready to send requests.
+ *
+ * Saves the SIP/RTSP and SDP round trip from the call setup. Sessions and channels
+ * are created by the overridden factory methods, the pool keeps the given number
+ * of them negotiated and idle. OnAdd() of pooled channels is not called while warming.
+ * Idle sessions are replaced after idle timeout, so that the server does not drop them.
+ * The replacement runs on the callback dispatcher (see UniMRCPClient::StartDispatcher()),
+ * without it or with its queue full upon the next Checkout().
+ *
+ * Call Destroy() before the object goes away, as virtual methods cannot be called
+ * from the destructor. All sessions must be checked in by then.
+ */
+class UniMRCPSessionPool {
+public:
+	/**
+	 * @param client          Client to create sessions on
+	 * @param profile         MRCP profile of the sessions
+	 * @param size            How many sessions to keep ready
+	 * @param idle_timeout_ms Replace sessions idle for longer than this, 0 for never
+	 */
+	WRAPPER_DECL UniMRCPSessionPool(UniMRCPClient* client, char const* profile, unsigned size, unsigned long idle_timeout_ms = 60000) THROWS(UniMRCPException);
+	/** @brief Calls Destroy */
+	WRAPPER_DECL virtual ~UniMRCPSessionPool();
+	/** @brief Start warming the sessions */
+	WRAPPER_DECL void Start() THROWS(UniMRCPException);
+	/** @brief Tear down all sessions, waits for those still negotiating */
+	WRAPPER_DECL void Destroy();
+
+	/**
+	 * @brief Take a warm session
+	 * @param timeout_ms How long to wait if none is ready, -1 for infinity
+	 * @return The session or NULL on timeout
+	 */
+	WRAPPER_DECL UniMRCPClientSession* Checkout(long timeout_ms = 0) THROWS(UniMRCPException);
+	/** @brief Return a session after use. It is torn down if unhealthy or not needed. */
+	WRAPPER_DECL void Checkin(UniMRCPClientSession* session) THROWS(UniMRCPException);
+	/** @brief Get the channel created for a pooled session */
+	WRAPPER_DECL UniMRCPClientChannel* GetChannel(UniMRCPClientSession* session) const THROWS(UniMRCPException);
+	/** @brief Get pool statistics */
+	WRAPPER_DECL void GetStats(UniMRCPSessionPoolStats& stats) const;
+
+	/** @brief Create a session, by default a plain UniMRCPClientSession */
+	WRAPPER_DECL virtual UniMRCPClientSession* CreateSession(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException);
+	/** @brief Create termination and channel in the session. Must be overridden. */
+	WRAPPER_DECL virtual UniMRCPClientChannel* CreateChannel(UniMRCPClientSession* session) THROWS(UniMRCPException) = 0;
+	/**
+	 * @brief Release session and channel created by the factory methods, by default deletes them.
+	 *
+	 * Language bindings must keep references of the created objects until this is called.
+	 */
+	WRAPPER_DECL virtual void DestroySession(UniMRCPClientSession* session, UniMRCPClientChannel* channel);
+
+private:
+	UniMRCPClient*        client;        ///< Client to create sessions on
+	apr_pool_t*           pool;          ///< Memory pool
+	apr_thread_mutex_t*   mutex;         ///< Guards everything below
+	apr_thread_cond_t*    cond;          ///< Signalled when a session becomes idle or warming ends
+	char const*           profile;       ///< MRCP profile
+	unsigned              size;          ///< Target number of warm sessions
+	unsigned long         idleTimeout;   ///< Idle timeout in milliseconds
+	bool                  closing;       ///< Destroy() called
+	UniMRCPPooledSession* idle;          ///< Idle sessions, most recently used first
+	UniMRCPPooledSession* expired;       ///< Idle timed out, to be torn down and replaced
+	unsigned              pending;       ///< MaintainTask() queued to the dispatcher
+	UniMRCPSessionPoolStats stats;       ///< Counters
+	unsigned long long    refilled;      ///< Sessions negotiated
+	unsigned long long    refillSum;     ///< Total negotiation time (microseconds)
+
+	/** @brief Create sessions up to size */
+	void Refill();
+	/** @brief Schedule idle timeout of a session */
+	void ScheduleIdle(UniMRCPPooledSession* entry);
+	/** @brief Channel of a warming session added */
+	void Warmed(UniMRCPPooledSession* entry, bool success);
+	/** @brief Unhook and release the session */
+	void Teardown(UniMRCPPooledSession* entry);
+	/** @brief Session may be reused */
+	static bool IsHealthy(UniMRCPPooledSession* entry);
+	/** @brief Tear down expired sessions and refill */
+	void Maintain();
+	/** @brief Maintain() on the dispatcher */
+	static void MaintainTask(void* obj);
+	/** @brief Idle timeout callback, moves the session to expired */
+	static void IdleTimeout(UniMRCPTimer* timer);
+
+	friend class UniMRCPClientChannel;
+	friend class UniMRCPClientSession;
+};
+
+
+/**
+ * @brief Many sessions set up and terminated together.
+ *
+ * Create() makes all sessions and channels by the overridden factory methods in one go,
+ * so that the client task processes their setup back to back, and reports the outcome
+ * once in OnSetupComplete(). OnAdd() of the batch channels is not called. Terminate()
+ * likewise terminates all of them, OnTerminate() of the sessions is replaced by
+ * OnTerminateComplete() called after the last one.
+ *
+ * Call Destroy() before the object goes away, as virtual methods cannot be called
+ * from the destructor. It must not be called from the callbacks.
+ */
+class UniMRCPSessionBatch {
+public:
+	/**
+	 * @param client  Client to create sessions on
+	 * @param profile MRCP profile or profile group of the sessions
+	 */
+	WRAPPER_DECL UniMRCPSessionBatch(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException);
+	/** @brief Calls Destroy */
+	WRAPPER_DECL virtual ~UniMRCPSessionBatch();
+	/**
+	 * @brief Create sessions, each with a channel (once until Destroy())
+	 *
+	 * Sessions which cannot be created are counted as failed in OnSetupComplete().
+	 * @param count Number of sessions
+	 */
+	WRAPPER_DECL void Create(unsigned count) THROWS(UniMRCPException);
+	/** @brief Terminate all sessions of the batch */
+	WRAPPER_DECL void Terminate();
+	/** @brief Release all sessions, waits for setup and termination in progress */
+	WRAPPER_DECL void Destroy();
+
+	/** @brief Number of sessions requested by Create() */
+	WRAPPER_DECL unsigned GetCount() const;
+	/** @brief Get session by index, NULL if it could not be created */
+	WRAPPER_DECL UniMRCPClientSession* GetSession(unsigned index) const THROWS(UniMRCPException);
+	/** @brief Get channel by index, NULL if it could not be created */
+	WRAPPER_DECL UniMRCPClientChannel* GetChannel(unsigned index) const THROWS(UniMRCPException);
+	/** @brief Whether the channel of the session by index has been added successfully */
+	WRAPPER_DECL bool IsReady(unsigned index) const THROWS(UniMRCPException);
+
+	/** @brief Create a session, by default a plain UniMRCPClientSession */
+	WRAPPER_DECL virtual UniMRCPClientSession* CreateSession(UniMRCPClient* client, char const* profile) THROWS(UniMRCPException);
+	/** @brief Create termination and channel in the session. Must be overridden. */
+	WRAPPER_DECL virtual UniMRCPClientChannel* CreateChannel(UniMRCPClientSession* session) THROWS(UniMRCPException) = 0;
+	/**
+	 * @brief Release session and channel created by the factory methods, by default deletes them.
+	 *
+	 * Language bindings must keep references of the created objects until this is called.
+	 */
+	WRAPPER_DECL virtual void DestroySession(UniMRCPClientSession* session, UniMRCPClientChannel* channel);
+	/** @brief All channels added or failed */
+	WRAPPER_DECL virtual void OnSetupComplete(unsigned succeeded, unsigned failed);
+	/** @brief All sessions terminated after Terminate() */
+	WRAPPER_DECL virtual void OnTerminateComplete(unsigned terminated);
+
+private:
+	UniMRCPClient*       client;           ///< Client to create sessions on
+	apr_pool_t*          pool;             ///< Memory pool
+	apr_thread_mutex_t*  mutex;            ///< Guards everything below
+	apr_thread_cond_t*   cond;             ///< Signalled when nothing is pending
+	char const*          profile;          ///< MRCP profile
+	UniMRCPBatchEntry*   entries;          ///< Array of count entries
+	unsigned             count;            ///< Number of entries
+	unsigned             setupPending;     ///< Channels being added
+	unsigned             succeeded;        ///< Channels added
+	unsigned             terminatePending; ///< Sessions being terminated
+	unsigned             terminated;       ///< Sessions terminated by Terminate()
+
+	/** @brief Entry by index or throw */
+	UniMRCPBatchEntry* Entry(unsigned index) const THROWS(UniMRCPException);
+	/** @brief Channel of an entry added or failed, false if not being set up by the batch */
+	bool Added(UniMRCPBatchEntry* entry, bool success);
+	/** @brief Session of an entry terminated, false if not terminated by the batch */
+	bool Terminated(UniMRCPBatchEntry* entry);
+	/** @brief One termination less pending, calls OnTerminateComplete() after the last one */
+	void TerminateDone();
+
+	friend class UniMRCPClientChannel;
+	friend class UniMRCPClientSession;
 };
 
 
@@ -970,12 +1688,34 @@ public:
 	 */
 	WRAPPER_DECL void SetData(void const* buf, size_t len);
 
+	/**
+	 * @brief Get frame accounting, may be called from any thread
+	 *
+	 * Counters are updated atomically by the media thread, no lock is taken.
+	 */
+	WRAPPER_DECL void GetRxStats(UniMRCPRxStats& stats) const;
+	/**
+	 * @brief Call OnStarvation() when this many frames in a row were not supplied
+	 * @param frames 0 (default) switches the callback off
+	 */
+	WRAPPER_DECL void SetStarvationThreshold(unsigned frames);
+
 	/** @brief Called when stream is being closed */
 	WRAPPER_DECL virtual void OnClose();
 	/** @brief Called whenever a frame is needed */
 	WRAPPER_DECL virtual bool ReadFrame();
+	/**
+	 * @brief Starvation reached the threshold, called once per run from the media thread.
+	 *
+	 * Only counted after the first frame with audio, idle streams are not reported.
+	 * @param frames Frames starved in a row
+	 */
+	WRAPPER_DECL virtual void OnStarvation(unsigned frames);
 
 private:
+	/** @brief Account a frame requested by the media engine */
+	void CountFrame(bool supplied);
+
 	/** @brief Initialize internal data after user-defined creation procedure */
 	WRAPPER_DECL virtual bool OnOpenInternal(UniMRCPAudioTermination const* term, mpf_audio_stream_t const* stm);
 	/** @brief Clean-up after OnClose() event handled */
@@ -985,6 +1725,7 @@ private:
 	mpf_frame_t* frm;               ///< Single media frame
 	mpf_dtmf_generator_t* dtmf_gen; ///< DTMF generator C opaque object
 	UniMRCPAudioTermination* term;  ///< Owning audio termination
+	UniMRCPRxCounters* counters;    ///< Frame accounting, NULL if out of memory
 
 	friend class UniMRCPAudioTermination;
 	friend class UniMRCPStreamRxBuffered;
@@ -1184,7 +1925,9 @@ public:
 	WRAPPER_DECL virtual UniMRCPStreamTx* OnStreamOpenTx(bool enabled, unsigned char payload_type, char const* name,
 	                                                     char const* format, unsigned char channels, unsigned freq);
 
-private:
+protected:
+	/** @name C stream callbacks, called by the media thread or by a derived termination driving the streams itself */
+	/** @{ */
 	static int StmDestroy(mpf_audio_stream_t* stream);
 	static int StmOpenRx(mpf_audio_stream_t* stream, mpf_codec_t* codec);
 	static int StmCloseRx(mpf_audio_stream_t* stream);
@@ -1192,6 +1935,7 @@ private:
 	static int StmOpenTx(mpf_audio_stream_t* stream, mpf_codec_t* codec);
 	static int StmCloseTx(mpf_audio_stream_t* stream);
 	static int StmWriteFrame(mpf_audio_stream_t* stream, mpf_frame_t const* frame);
+	/** @} */
 
 private:
 	mpf_stream_capabilities_t* caps; ///< Capabilities structure
@@ -1204,6 +1948,8 @@ private:
 	unsigned dg_tone;                ///< DTMF generator tone length
 	unsigned dg_silence;             ///< DTMF generator silence length
 	int dd_band;                     ///< DTMF detector band
+	UniMRCPTxTiming* txTiming;       ///< Incoming audio timing, allocated from the session pool
+	unsigned traceSession;           ///< Number of the session in the trace log
 
 	friend class UniMRCPClientChannel;
 	friend class UniMRCPStreamTx;
@@ -1213,6 +1959,62 @@ private:
 };
 
 
+/**
+ * @brief Handle of a request sent by UniMRCPClientResourceChannelBase::SendAsync().
+ *
+ * Completion can be awaited with Wait(), polled with GetState() or handled
+ * in overridden OnComplete(). Should not be used directly, use specialized
+ * (resource) requests instead. Handles allocated by SendAsync() and all messages
+ * are owned by the session, do not use them after the session is destroyed.
+ * @see UniMRCPSynthesizerRequest
+ * @see UniMRCPRecognizerRequest
+ * @see UniMRCPRecorderRequest
+ */
+class UniMRCPRequest {
+public:
+	WRAPPER_DECL UniMRCPRequest();
+	WRAPPER_DECL virtual ~UniMRCPRequest();
+
+	/** @brief Request ID assigned by the stack, 0 until the response arrives */
+	inline UniMRCPRequestId GetRequestId() const { return id; }
+	/** @brief Current state */
+	inline UniMRCPAsyncState GetState() const { return state; }
+	/** @brief Is the request complete (or failed)? */
+	inline bool IsComplete() const { return state >= ENUM_MEM(ASYNC_, COMPLETE); }
+	/** @brief Response status code, MRCP_STATUS_CODE_UNKNOWN until the response arrives */
+	inline UniMRCPStatusCode GetStatusCode() const { return status; }
+
+	/**
+	 * @brief Wait for completion. Do not call from callbacks (client task thread).
+	 * @param timeout_ms Maximum time to wait in milliseconds, negative to wait forever
+	 * @return true if complete
+	 */
+	WRAPPER_DECL bool Wait(long timeout_ms = -1);
+
+	/** @brief Request completed or failed. Called from the client task thread. */
+	WRAPPER_DECL virtual void OnComplete();
+
+protected:
+	UniMRCPMessage const* response; ///< Response, NULL until received
+	UniMRCPMessage const* event;    ///< Completion event, NULL until received
+
+private:
+	UniMRCPClientChannel* channel;    ///< Owner channel, NULL when not tracked
+	mrcp_message_t* msg;              ///< Sent request, the stack fills in request ID
+	apr_thread_mutex_t* mutex;        ///< Guards completion
+	apr_thread_cond_t* cond;          ///< Signalled upon completion
+	UniMRCPTimer* timer;              ///< Deadline timer, NULL if never scheduled
+	UniMRCPGateSet* limits;           ///< Limits the request was admitted by, NULL when released
+	UniMRCPRequestId id;              ///< Request ID
+	volatile UniMRCPAsyncState state; ///< Current state
+	UniMRCPStatusCode status;         ///< Response status code
+	bool owned;                       ///< Allocated by SendAsync(), reused once complete
+	UniMRCPRequest* next;             ///< Next request awaiting response, or next free one
+
+	friend class UniMRCPClientChannel;
+};
+
+
 /**
  * @brief MRCP general signaling channel. Should not be used, use specialized (resource) channels instead.
  * @see UniMRCPSynthesizerChannel
@@ -1236,6 +2038,20 @@ public:
 	WRAPPER_DECL virtual bool OnRemove(UniMRCPSigStatusCode status);
 	/** @brief Session terminated unexpectedly */
 	WRAPPER_DECL virtual bool OnTerminateEvent();
+	/**
+	 * @brief Deadline of a request sent by SendAsync() expired. Called from the timer thread.
+	 *
+	 * The request is completed as #ASYNC_TIMED_OUT afterwards.
+	 * @return What to do with the request, by default send STOP
+	 */
+	WRAPPER_DECL virtual UniMRCPTimeoutAction OnRequestTimeout(UniMRCPRequest* request);
+
+	/**
+	 * @brief Get timing of audio received since the channel was created.
+	 *
+	 * Updated by the media thread without locking, so values may be one frame apart.
+	 */
+	WRAPPER_DECL void GetTxStats(UniMRCPTxStats& stats) const;
 
 protected:
 	/**
@@ -1252,6 +2068,30 @@ protected:
 	mrcp_session_t* sess;  ///< Owner session
 	mrcp_channel_t* chan;  ///< Opaque C structure
 
+private:
+	/** @brief Create the C channel with its termination in the C session, not added yet */
+	mrcp_channel_t* CreateChannel(mrcp_session_t* s);
+	/** @brief Move to the C channel created in the session replacing the failed one */
+	void Reattach(mrcp_session_t* s, mrcp_channel_t* c, UniMRCPGateSet* set);
+
+	UniMRCPResource resourceType;       ///< Channel resource type
+	UniMRCPAudioTermination* termination;  ///< Media of the channel, kept to create it again upon failover
+	UniMRCPClientSession* session;      ///< Owner session object, NULL if destroyed
+	UniMRCPGateSet* limits;             ///< Profile limits the channel was admitted by, NULL when released
+	UniMRCPClientChannel* nextChannel;  ///< Next channel of the session
+	apr_thread_mutex_t* reqMutex;       ///< Guards request tracking
+	UniMRCPRequest* sentHead;           ///< Requests awaiting response (FIFO)
+	UniMRCPRequest* sentTail;           ///< Last request awaiting response
+	UniMRCPRequest* freeRequests;       ///< Completed handles allocated by SendAsync()
+	apr_hash_t* activeRequests;         ///< Requests awaiting completion event by request ID
+	UniMRCPLatencySlot* inflight;       ///< Send times of requests, for latency histograms
+	unsigned unanswered;                ///< Requests sent and not responded yet
+	apr_array_header_t* progressing;    ///< IDs of requests responded but not complete yet
+	unsigned long long addedAt;         ///< When the channel add was requested
+	UniMRCPTxTiming* txTiming;          ///< Incoming audio timing shared with the termination
+	unsigned traceId;                   ///< Number of the channel in the trace log
+	unsigned traceSession;              ///< Number of the session in the trace log
+
 private:
 	static int AppOnChannelAdd(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel, UniMRCPSigStatusCode status);
 	static int AppOnChannelRemove(mrcp_application_t* application, mrcp_session_t* session, mrcp_channel_t* channel, UniMRCPSigStatusCode status);
@@ -1262,9 +2102,41 @@ private:
 	/** Message received, passed to resource channel to give it proper type */
 	virtual bool OnMsgReceive(mrcp_message_t* message);
 
+	/** Free admission slot of the channel */
+	void ReleaseLimits();
+	/** Log priority override of the session, -1 if none */
+	int LogPrio() const;
+	/** Number of requests sent and not completed yet */
+	unsigned PendingRequests();
+	/** Remember send time of a request */
+	void LatencySent(mrcp_message_t const* message);
+	/** Forget a request not sent after all */
+	void LatencyUnsent(mrcp_message_t const* message);
+	/** Measure response or event against the send time of its request, true if no request is pending anymore */
+	bool LatencyReceived(mrcp_message_t const* message);
+	/** Completed handle allocated by SendAsync() before, NULL if none */
+	WRAPPER_DECL UniMRCPRequest* ReuseRequest();
+	/** Put an owned handle on the free list */
+	void RecycleRequest(UniMRCPRequest* req);
+	/** Start tracking the request, schedule its deadline (if any) and send it, owned if allocated by SendAsync() */
+	WRAPPER_DECL void SendTracked(UniMRCPMessage* msg, UniMRCPRequest* req, unsigned long timeout_ms, bool owned = false) THROWS(UniMRCPException);
+	/** Stop tracking the request, false if not tracked (already completed) */
+	bool DetachRequest(UniMRCPRequest* req);
+	/** Request deadline timer callback */
+	static void RequestTimeout(UniMRCPTimer* timer);
+	/** Update tracked requests by received response or event */
+	WRAPPER_DECL void UpdateRequests(mrcp_message_t* message, UniMRCPMessage const* wrapped);
+	/** Fail all tracked requests, e.g. when the channel is gone */
+	WRAPPER_DECL void FailRequests();
+	/** Mark request done, wake up waiters and call its OnComplete */
+	static void CompleteRequest(UniMRCPRequest* req, UniMRCPAsyncState state);
+
 	friend class UniMRCPClient;
+	friend class UniMRCPClientSession;
+	friend class UniMRCPSessionPool;
+	friend class UniMRCPMessage;
 	template<UniMRCPResource resource>
-	friend class UniMRCPClientResourceChannel;
+	friend class UniMRCPClientResourceChannelBase;
 };
 
 
@@ -1460,8 +2332,8 @@ private:
  * @brief General MRCP message with generic headers.
  * Should not be used, use specialized (resource) messages instead.
  *
- * Create messages with UniMRCPClientResourceChannel::CreateMessage().
- * They are created automatically upon calling UniMRCPClientResourceChannel::OnMessageReceive().
+ * Create messages with UniMRCPClientResourceChannelBase::CreateMessage().
+ * They are created automatically upon calling UniMRCPClientResourceChannelBase::OnMessageReceive().
  * @see UniMRCPSynthesizerMessage
  * @see UniMRCPRecognizerMessage
  * @see UniMRCPRecorderMessage
@@ -1493,6 +2365,8 @@ public:
 
 	/// @brief Send the message through owner channel
 	WRAPPER_DECL bool Send();
+	/// @brief When the message was sent, or received if it has not been sent (microseconds since epoch)
+	WRAPPER_DECL unsigned long long GetTimestamp() const;
 
 public:
 	/// @brief Add (render to string) header to the message immediately.
@@ -1559,6 +2433,8 @@ protected:
 private:
 	/// Called from UniMRCPChannel::CreateMessage or UniMRCPChannel::OnMessageReceive alternatives
 	UniMRCPMessage(mrcp_session_t* sess, mrcp_channel_t* chan, mrcp_message_t* msg, bool autoAddProperty) THROWS(UniMRCPException);
+	/// Render headers added by LazyAddProperty(), called from Send()
+	void RenderProperties();
 
 private:
 	mrcp_session_t* sess;       ///< Owner session (for memory pool)
@@ -1566,6 +2442,7 @@ private:
 	mrcp_generic_header_t* hdr; ///< Generic header C structure
 	char generic_props[8];      ///< Generic headers to render upon sending if AutoAddProperty
 	char resource_props[8];     ///< Resource headers to render upon sending if AutoAddProperty
+	unsigned long long stamp;   ///< Creation (receive) or send time
 
 	friend class UniMRCPClientChannel;
 	template<typename prop_t, typename method_t, typename event_t>
@@ -1583,8 +2460,8 @@ PROCESS_GENERIC_HEADERS_SIMPLE(SIMPLE_HEADER_GLOBAL_DECL, UniMRCPMessage)
  * @brief Properties common to all resource messages (but some types can differ, therefore the template).
  * Should not be used, use specialized (resource) messages instead.
  *
- * Create messages with UniMRCPClientResourceChannel::CreateMessage().
- * They are created automatically upon calling UniMRCPClientResourceChannel::OnMessageReceive().
+ * Create messages with UniMRCPClientResourceChannelBase::CreateMessage().
+ * They are created automatically upon calling UniMRCPClientResourceChannelBase::OnMessageReceive().
  * @param prop_t   Property (header) ID enum
  *                 (#UniMRCPSynthesizerHeaderId, #UniMRCPRecognizerHeaderId, #UniMRCPRecorderHeaderId)
  * @param method_t Method ID enum
@@ -1726,8 +2603,8 @@ private:
 /**
  * @brief Synthesizer resource message with headers
  *
- * Create messages with UniMRCPClientResourceChannel<MRCP_SYNTHESIZER>::CreateMessage().
- * They are created automatically upon calling UniMRCPClientResourceChannel<MRCP_SYNTHESIZER>::OnMessageReceive().
+ * Create messages with UniMRCPClientResourceChannelBase<MRCP_SYNTHESIZER>::CreateMessage().
+ * They are created automatically upon calling UniMRCPClientResourceChannelBase<MRCP_SYNTHESIZER>::OnMessageReceive().
  * @see UniMRCPSynthesizerMessage
  * @see UniMRCPSynthesizerChannel
  */
@@ -1766,7 +2643,7 @@ private:
 	WRAPPER_DECL UniMRCPResourceMessage(mrcp_session_t* sess, mrcp_channel_t* chan, mrcp_message_t* msg, bool autoAddProperty) THROWS(UniMRCPException);
 
 	template<UniMRCPResource resource>
-	friend class UniMRCPClientResourceChannel;
+	friend class UniMRCPClientResourceChannelBase;
 };
 
 #ifndef DOXYGEN
@@ -1823,11 +2700,87 @@ typedef UniMRCPResourceMessage<MRCP_SYNTHESIZER> UniMRCPSynthesizerMessage;
 	cmd(hotword_min_duration,      size_t, HEADER_RECOGNIZER_HOTWORD_MIN_DURATION, arg)      \
 	cmd(dtmf_buffer_time,          size_t, HEADER_RECOGNIZER_DTMF_BUFFER_TIME, arg)          \
 
+/** @brief Capacity of UniMRCPNLSMLResult (maximum N-best list length) */
+#ifndef UW_NLSML_MAX_INTERPRETATIONS
+#	define UW_NLSML_MAX_INTERPRETATIONS 16
+#endif
+
+#ifndef SWIG
+/**
+ * @brief One NLSML interpretation. Strings point into the message body, they are
+ * not NUL-terminated and XML entities are not decoded. Missing strings have zero length.
+ * @see UniMRCPResourceMessage<MRCP_RECOGNIZER>::ParseNLSML(UniMRCPNLSMLInterpretation*, unsigned) const
+ */
+struct UniMRCPNLSMLInterpretation {
+	float       confidence;   ///< Confidence 0.0 - 1.0 (MRCPv1 0 - 100 normalized) or -1 if not present
+	char const* grammar;      ///< Grammar URI (interpretation grammar attribute)
+	size_t      grammar_len;  ///< Grammar URI length
+	char const* mode;         ///< Input mode (input mode attribute), e.g. speech or dtmf
+	size_t      mode_len;     ///< Input mode length
+	char const* input;        ///< Input text (input element content)
+	size_t      input_len;    ///< Input text length
+	char const* instance;     ///< Semantic interpretation (raw instance element content)
+	size_t      instance_len; ///< Semantic interpretation length
+};
+#endif
+
+/**
+ * @brief NLSML N-best list filled in a single call by UniMRCPResourceMessage<MRCP_RECOGNIZER>::ParseNLSML(UniMRCPNLSMLResult&) const
+ *
+ * Accessors with index out of range throw UniMRCPException.
+ * String accessors return NUL-terminated copies allocated from the message memory pool
+ * on first access and kept until the next parse, grammar, mode and input have XML
+ * entities and character references decoded (the latter to UTF-8), instance is raw XML.
+ */
+class UniMRCPNLSMLResult {
+public:
+	WRAPPER_DECL UniMRCPNLSMLResult();
+
+	/** @brief Number of interpretations */
+	inline unsigned Count() const { return count; }
+	/** @brief Confidence 0.0 - 1.0 or -1 if not present */
+	WRAPPER_DECL float Confidence(unsigned i) const THROWS(UniMRCPException);
+	/** @brief Grammar URI */
+	WRAPPER_DECL char const* Grammar(unsigned i) const THROWS(UniMRCPException);
+	/** @brief Input mode, e.g. speech or dtmf */
+	WRAPPER_DECL char const* Mode(unsigned i) const THROWS(UniMRCPException);
+	/** @brief Input text */
+	WRAPPER_DECL char const* Input(unsigned i) const THROWS(UniMRCPException);
+	/** @brief Semantic interpretation (instance element content) */
+	WRAPPER_DECL char const* Instance(unsigned i) const THROWS(UniMRCPException);
+
+#ifndef SWIG
+	/** @brief Interpretation with string views into the message body */
+	WRAPPER_DECL UniMRCPNLSMLInterpretation const& Get(unsigned i) const THROWS(UniMRCPException);
+
+private:
+	/** @brief Strings of an interpretation the accessors return */
+	enum {
+		STR_GRAMMAR,
+		STR_MODE,
+		STR_INPUT,
+		STR_INSTANCE,
+		STR_COUNT
+	};
+
+	/** @brief Copy of string which of interpretation i, made once per parse */
+	char const* String(unsigned i, unsigned which) const THROWS(UniMRCPException);
+
+	UniMRCPNLSMLInterpretation items[UW_NLSML_MAX_INTERPRETATIONS]; ///< Parsed interpretations
+	mutable char const* strings[UW_NLSML_MAX_INTERPRETATIONS][STR_COUNT]; ///< Copies returned so far, NULL if not yet
+#endif
+private:
+	unsigned count;    ///< Number of valid items
+	apr_pool_t* pool;  ///< Message memory pool for string copies
+
+	friend class UniMRCPResourceMessage<MRCP_RECOGNIZER>;
+};
+
 /**
  * @brief Recognizer resource message with headers
  *
- * Create messages with UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::CreateMessage().
- * They are created automatically upon calling UniMRCPClientResourceChannel<MRCP_RECOGNIZER>::OnMessageReceive().
+ * Create messages with UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER>::CreateMessage().
+ * They are created automatically upon calling UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER>::OnMessageReceive().
  * @see UniMRCPRecognizerMessage
  * @see UniMRCPRecognizerChannel
  */
@@ -1844,11 +2797,32 @@ public:
 public:
 	PROCESS_RECOG_HEADERS_SIMPLE(SIMPLE_HEADER_CLASS_DECL, UniMRCPRecogHeader)
 /** @} */
+/** @name NLSML result parsing */
+/** @{ */
+public:
+	/**
+	 * @brief Parse NLSML body (e.g. of RECOGNITION-COMPLETE) into N-best list.
+	 * @return false if the body contains no interpretation
+	 */
+	WRAPPER_DECL bool ParseNLSML(UniMRCPNLSMLResult& result) const;
+#ifndef SWIG
+	/**
+	 * @brief Parse NLSML body in a single pass without allocating memory.
+	 * @param out Array to fill, strings point into the message body
+	 * @param max Capacity of out
+	 * @return Number of interpretations filled
+	 */
+	WRAPPER_DECL unsigned ParseNLSML(UniMRCPNLSMLInterpretation* out, unsigned max) const;
+#endif
+/** @} */
 private:
 	mrcp_recog_header_t* hdr;  ///< Recognizer header opaque C structure
 
 	UniMRCPResourceMessage(mrcp_session_t* sess, mrcp_channel_t* chan, mrcp_message_t* msg, bool autoAddProperty) THROWS(UniMRCPException);
 
+	template<UniMRCPResource resource>
+	friend class UniMRCPClientResourceChannelBase;
+	/// The recognizer channel tracks its DEFINE-GRAMMAR requests
 	template<UniMRCPResource resource>
 	friend class UniMRCPClientResourceChannel;
 };
@@ -1892,8 +2866,8 @@ typedef UniMRCPResourceMessage<MRCP_RECOGNIZER> UniMRCPRecognizerMessage;
 /**
  * @brief Recorder resource message with headers
  *
- * Create messages with UniMRCPClientResourceChannel<MRCP_RECORDER>::CreateMessage().
- * They are created automatically upon calling UniMRCPClientResourceChannel<MRCP_RECORDER>::OnMessageReceive().
+ * Create messages with UniMRCPClientResourceChannelBase<MRCP_RECORDER>::CreateMessage().
+ * They are created automatically upon calling UniMRCPClientResourceChannelBase<MRCP_RECORDER>::OnMessageReceive().
  * @see UniMRCPRecorderMessage
  * @see UniMRCPRecorderChannel
  */
@@ -1916,7 +2890,7 @@ private:
 	UniMRCPResourceMessage(mrcp_session_t* sess, mrcp_channel_t* chan, mrcp_message_t* msg, bool autoAddProperty) THROWS(UniMRCPException);
 
 	template<UniMRCPResource resource>
-	friend class UniMRCPClientResourceChannel;
+	friend class UniMRCPClientResourceChannelBase;
 };
 
 /** @brief Shorthand for recorder resource message */
@@ -1929,6 +2903,43 @@ PROCESS_RECORDER_HEADERS_SIMPLE(SIMPLE_HEADER_GLOBAL_DECL_T, MRCP_RECORDER)
 #endif
 
 
+/**
+ * @brief Handle of a resource request with properly typed messages.
+ * @see UniMRCPClientResourceChannelBase::SendAsync()
+ */
+template<UniMRCPResource resource>
+class UniMRCPResourceRequest : public UniMRCPRequest {
+public:
+	inline UniMRCPResourceRequest()
+	{
+	}
+
+	/** @brief Explicitly define public destructor, otherwise SWIG exception occurs */
+	virtual inline ~UniMRCPResourceRequest()
+	{
+	}
+
+	/** @brief Response, NULL until received */
+	inline UniMRCPResourceMessage<resource> const* GetResponse() const
+	{
+		return static_cast<UniMRCPResourceMessage<resource> const*>(response);
+	}
+
+	/** @brief Completion event, NULL until received (and also if the request completed by its response) */
+	inline UniMRCPResourceMessage<resource> const* GetEvent() const
+	{
+		return static_cast<UniMRCPResourceMessage<resource> const*>(event);
+	}
+};
+
+/** @brief Shorthand for synthesizer request handle. */
+typedef UniMRCPResourceRequest<MRCP_SYNTHESIZER> UniMRCPSynthesizerRequest;
+/** @brief Shorthand for recognizer request handle. */
+typedef UniMRCPResourceRequest<MRCP_RECOGNIZER> UniMRCPRecognizerRequest;
+/** @brief Shorthand for recorder request handle. */
+typedef UniMRCPResourceRequest<MRCP_RECORDER> UniMRCPRecorderRequest;
+
+
 /** @brief Allocate object from MRCP session APR memory pool */
 WRAPPER_DECL void* operator new(size_t objSize, mrcp_session_t* sess);
 /** @brief Called if construction after allocation from session pool failed. @see operator new(size_t objSize, mrcp_session_t* sess) */
@@ -1939,19 +2950,14 @@ inline void operator delete(void* obj, mrcp_session_t* sess) {
 
 
 /**
- * @brief MRCP resource channel. Uses properly typed messages and methods.
+ * @brief Members shared by all MRCP resource channels. Uses properly typed messages and methods.
+ * @see UniMRCPClientResourceChannel
  */
 template<UniMRCPResource resource>
-class UniMRCPClientResourceChannel: public UniMRCPClientChannel {
+class UniMRCPClientResourceChannelBase: public UniMRCPClientChannel {
 public:
-	/** @brief Create a resource channel */
-	inline UniMRCPClientResourceChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) THROWS(UniMRCPException) :
-		UniMRCPClientChannel(session, resource, termination)
-	{
-	}
-
 	/** @brief Explicitly define public destructor, otherwise SWIG exception occurs */
-	virtual inline ~UniMRCPClientResourceChannel()
+	virtual inline ~UniMRCPClientResourceChannelBase()
 	{
 	}
 
@@ -1969,15 +2975,139 @@ public:
 			sess, chan, CreateMsg(method), autoAddProperty);
 	}
 
-private:
-	/** Create message of proper type and pass to OnMessageReceive */
+	/**
+	 * @brief Send request and track it until completion
+	 * @param msg Request created by CreateMessage()
+	 * @param req Handle to use (e.g. with overridden OnComplete) or NULL for one owned by the channel.
+	 *            Owned handles are reused by a later SendAsync() once complete, do not keep them longer.
+	 * @param timeout_ms Deadline in milliseconds, 0 for none. @see OnRequestTimeout()
+	 * @return The request handle
+	 */
+	inline UniMRCPResourceRequest<resource>* SendAsync(UniMRCPResourceMessage<resource>* msg, UniMRCPResourceRequest<resource>* req = NULL, unsigned long timeout_ms = 0) THROWS(UniMRCPException)
+	{
+		bool owned = !req;
+		if (owned) {
+			/* Only SendAsync() of this very channel puts handles there */
+			req = static_cast<UniMRCPResourceRequest<resource>*>(ReuseRequest());
+			if (!req)
+				req = new(sess) UniMRCPResourceRequest<resource>();
+		}
+		SendTracked(msg, req, timeout_ms, owned);
+		return req;
+	}
+
+protected:
+	/** @brief Create a resource channel, called by UniMRCPClientResourceChannel */
+	inline UniMRCPClientResourceChannelBase(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) THROWS(UniMRCPException) :
+		UniMRCPClientChannel(session, resource, termination)
+	{
+	}
+
+	/** @brief Create message of proper type and pass to OnMessageReceive */
 	virtual bool OnMsgReceive(mrcp_message_t* message)
 	{
-		return OnMessageReceive(new(sess) UniMRCPResourceMessage<resource>(
-			sess, chan, message, false));
+		UniMRCPResourceMessage<resource>* msg = new(sess) UniMRCPResourceMessage<resource>(
+			sess, chan, message, false);
+		UpdateRequests(message, msg);
+		return OnMessageReceive(msg);
 	}
 };
 
+
+/**
+ * @brief MRCP resource channel. Uses properly typed messages and methods.
+ */
+template<UniMRCPResource resource>
+class UniMRCPClientResourceChannel: public UniMRCPClientResourceChannelBase<resource> {
+public:
+	/** @brief Create a resource channel */
+	inline UniMRCPClientResourceChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) THROWS(UniMRCPException) :
+		UniMRCPClientResourceChannelBase<resource>(session, termination)
+	{
+	}
+
+	/** @brief Explicitly define public destructor, otherwise SWIG exception occurs */
+	virtual inline ~UniMRCPClientResourceChannel()
+	{
+	}
+};
+
+/**
+ * @brief MRCP recognizer channel with grammar management.
+ *
+ * Besides the generic resource channel functionality it keeps track of grammars
+ * defined in the server-side session. Grammars are registered process-wide by
+ * their content hash (see RegisterGrammar()), DEFINE-GRAMMAR is sent at most once
+ * per channel (see DefineGrammar()) and RECOGNIZE then only references the
+ * session: URI (see CreateRecognizeMessage()).
+ * @see UniMRCPRecognizerChannel
+ */
+template<>
+class UniMRCPClientResourceChannel<MRCP_RECOGNIZER>: public UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER> {
+public:
+	/** @brief Create a recognizer channel */
+	WRAPPER_DECL UniMRCPClientResourceChannel(UniMRCPClientSession* session, UniMRCPAudioTermination* termination) THROWS(UniMRCPException);
+
+	/** @brief Explicitly define public destructor, otherwise SWIG exception occurs */
+	WRAPPER_DECL virtual ~UniMRCPClientResourceChannel();
+
+/** @name Grammar management */
+/** @{ */
+public:
+	/**
+	 * @brief Register grammar in the process-wide grammar cache.
+	 *
+	 * Identical grammars (same content type and body) always get the same ID,
+	 * so they are defined only once per server-side session.
+	 * @param content_type Grammar content type, e.g. application/srgs+xml
+	 * @param body         Grammar content
+	 * @return Grammar ID (Content-Id) valid until UniMRCPClient::StaticDeinitialize()
+	 */
+	WRAPPER_DECL static char const* RegisterGrammar(char const* content_type, char const* body) THROWS(UniMRCPException);
+
+	/**
+	 * @brief Define a registered grammar in the server-side session.
+	 *
+	 * Sends DEFINE-GRAMMAR only if the grammar is not yet defined (or being defined)
+	 * on this channel. Failed definitions are forgotten when the response arrives.
+	 * Do not mix with DEFINE-GRAMMAR requests created by CreateMessage() on the same channel.
+	 * @param grammar_id ID returned by RegisterGrammar()
+	 * @return session: URI to reference the grammar with
+	 */
+	WRAPPER_DECL char const* DefineGrammar(char const* grammar_id) THROWS(UniMRCPException);
+
+	/**
+	 * @brief Register and define grammar in one step.
+	 * @see RegisterGrammar()
+	 * @see DefineGrammar(char const*)
+	 * @return session: URI to reference the grammar with
+	 */
+	WRAPPER_DECL char const* DefineGrammar(char const* content_type, char const* body) THROWS(UniMRCPException);
+
+	/** @brief Is the grammar defined (or being defined) in the server-side session? */
+	WRAPPER_DECL bool IsGrammarDefined(char const* grammar_id) const;
+
+	/**
+	 * @brief Create RECOGNIZE referencing grammars by URI.
+	 * @param uris text/uri-list body, i.e. session: URIs returned by DefineGrammar()
+	 *             or builtin: URIs, one per line
+	 */
+	WRAPPER_DECL UniMRCPResourceMessage<MRCP_RECOGNIZER>* CreateRecognizeMessage(char const* uris, bool autoAddProperty = true) THROWS(UniMRCPException);
+/** @} */
+
+private:
+	apr_thread_mutex_t* grammarMutex;    ///< Guards grammars and pendingGrammars
+	apr_hash_t* grammars;                ///< Grammars defined in the server-side session by ID
+	apr_array_header_t* pendingGrammars; ///< DEFINE-GRAMMAR requests awaiting response (UniMRCPPendingGrammar)
+
+	/** @brief Stop tracking a DEFINE-GRAMMAR request, returns its grammar. grammarMutex held. */
+	UniMRCPGrammar const* ForgetPendingGrammar(mrcp_message_t const* request);
+
+protected:
+	/** @brief Track DEFINE-GRAMMAR responses, then as any resource channel */
+	WRAPPER_DECL virtual bool OnMsgReceive(mrcp_message_t* message);
+};
+
 /** @brief Shorthand for synthesizer resource channel. */
 typedef UniMRCPClientResourceChannel<MRCP_SYNTHESIZER> UniMRCPSynthesizerChannel;
 /** @brief Shorthand for recognizer resource channel. */
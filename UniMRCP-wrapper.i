@@ -22,9 +22,15 @@
 %}
 
 %feature("director") UniMRCPLogger;
+%feature("director") UniMRCPClient;
 %feature("director") UniMRCPClientSession;
 %feature("director") UniMRCPClientChannel;
+%feature("director") UniMRCPSessionPool;
+%feature("director") UniMRCPSessionBatch;
+%feature("director") UniMRCPClientResourceChannelBase;
 %feature("director") UniMRCPClientResourceChannel;
+%feature("director") UniMRCPRequest;
+%feature("director") UniMRCPResourceRequest;
 %feature("director") UniMRCPAudioTermination;
 %feature("director") UniMRCPStreamRx;
 %feature("director") UniMRCPStreamRxBuffered;
@@ -45,6 +51,14 @@
 %ignore FrameBuffer;
 %ignore operator new;
 %ignore operator delete;
+%ignore UniMRCPAudioTermination::StmDestroy;
+%ignore UniMRCPAudioTermination::StmOpenRx;
+%ignore UniMRCPAudioTermination::StmCloseRx;
+%ignore UniMRCPAudioTermination::StmReadFrame;
+%ignore UniMRCPAudioTermination::StmOpenTx;
+%ignore UniMRCPAudioTermination::StmCloseTx;
+%ignore UniMRCPAudioTermination::StmWriteFrame;
+%ignore OnMsgReceive;
 
 #if !defined(SWIG)
 #elif defined(SWIGCSHARP)
@@ -116,9 +130,42 @@
 	public void SetBody(byte[] buf) {SetBody(buf, (uint)buf.Length);}
 	%}
 
+	/* System.TimeoutException is not one of SWIG_CSharpExceptionCodes, C# registers a callback raising it */
+	%insert(runtime) %{
+	typedef void (SWIGSTDCALL* UniMRCPTimeoutCallback)(char const* message);
+	static UniMRCPTimeoutCallback timeoutCallback = NULL;
+
+	extern "C" SWIGEXPORT void SWIGSTDCALL UniMRCPRegisterTimeoutCallback(UniMRCPTimeoutCallback callback)
+	{
+		timeoutCallback = callback;
+	}
+	%}
+	%pragma(csharp) imclasscode=%{
+	class UniMRCPTimeoutHelper {
+		public delegate void TimeoutDelegate(string message);
+		static TimeoutDelegate timeoutDelegate = new TimeoutDelegate(SetPendingTimeout);
+
+		[global::System.Runtime.InteropServices.DllImport("$dllimport", EntryPoint="UniMRCPRegisterTimeoutCallback")]
+		public static extern void UniMRCPRegisterTimeoutCallback(TimeoutDelegate callback);
+
+		static void SetPendingTimeout(string message) {
+			SWIGPendingException.Set(new global::System.TimeoutException(message));
+		}
+
+		static UniMRCPTimeoutHelper() {
+			UniMRCPRegisterTimeoutCallback(timeoutDelegate);
+		}
+	}
+	static UniMRCPTimeoutHelper timeoutHelper = new UniMRCPTimeoutHelper();
+	%}
+
 	%ignore UniMRCPException;
 	%typemap(throws, canthrow=1) UniMRCPException {
-		SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, $1.msg);
+		if (($1.code == ERROR_ADMISSION_TIMEOUT) && timeoutCallback)
+			timeoutCallback($1.msg);
+		else
+			SWIG_CSharpSetPendingException($1.code == ERROR_GENERIC ?
+				SWIG_CSharpApplicationException : SWIG_CSharpInvalidOperationException, $1.msg);
 		return $null;
 	}
 
@@ -163,7 +210,14 @@
 
 	%ignore UniMRCPException;
 	%typemap(throws, canthrow=1) UniMRCPException {
-		PyErr_SetString(PyExc_RuntimeError, $1.msg);
+		if ($1.code == ERROR_GENERIC)
+			PyErr_SetString(PyExc_RuntimeError, $1.msg);
+		else {
+			/* RuntimeError(message, code) for admission control failures */
+			PyObject* args = Py_BuildValue("(si)", $1.msg, static_cast<int>($1.code));
+			PyErr_SetObject(PyExc_RuntimeError, args);
+			Py_XDECREF(args);
+		}
 		return NULL;
 	}
 	%{
@@ -236,9 +290,25 @@
 	%apply (char *STRING, size_t LENGTH) { (void const* buf, size_t len) }
 	%apply (char *STRING, size_t LENGTH) { (void* buf, size_t len) }
 
+	/* Unchecked like RejectedExecutionException, so that the generated methods need not declare it */
+	%pragma(java) modulecode=%{
+	/** Admission limit reached and no slot freed in time, see UniMRCPClient.SetLimit() */
+	public static class AdmissionTimeoutException extends java.util.concurrent.RejectedExecutionException {
+		public AdmissionTimeoutException(String message) {
+			super(message);
+		}
+	}
+	%}
+
 	%ignore UniMRCPException;
 	%typemap(throws, canthrow=1) UniMRCPException {
-		jclass clazz = jenv->FindClass("java/lang/Exception");
+		char const* name = "java/lang/Exception";
+		if ($1.code == ERROR_ADMISSION_REJECTED)
+			name = "java/util/concurrent/RejectedExecutionException";
+		else if ($1.code == ERROR_ADMISSION_TIMEOUT)
+			/* Package set by CMakeLists.txt */
+			name = "org/unimrcp/swig/UniMRCP$AdmissionTimeoutException";
+		jclass clazz = jenv->FindClass(name);
 		jenv->ThrowNew(clazz, $1.msg);
 		return $null;
 	}
@@ -255,6 +325,16 @@
 %template(UniMRCPRecognizerMessage) UniMRCPResourceMessage<MRCP_RECOGNIZER>;
 %template(UniMRCPRecorderMessageBase) UniMRCPResourceMessageBase<UniMRCPRecorderHeaderId, UniMRCPRecorderMethod, UniMRCPRecorderEvent>;
 %template(UniMRCPRecorderMessage) UniMRCPResourceMessage<MRCP_RECORDER>;
+%template(UniMRCPSynthesizerRequest) UniMRCPResourceRequest<MRCP_SYNTHESIZER>;
+%template(UniMRCPRecognizerRequest) UniMRCPResourceRequest<MRCP_RECOGNIZER>;
+%template(UniMRCPRecorderRequest) UniMRCPResourceRequest<MRCP_RECORDER>;
+%template(UniMRCPSynthesizerChannelBase) UniMRCPClientResourceChannelBase<MRCP_SYNTHESIZER>;
+%template(UniMRCPRecognizerChannelBase) UniMRCPClientResourceChannelBase<MRCP_RECOGNIZER>;
+%template(UniMRCPRecorderChannelBase) UniMRCPClientResourceChannelBase<MRCP_RECORDER>;
 %template(UniMRCPSynthesizerChannel) UniMRCPClientResourceChannel<MRCP_SYNTHESIZER>;
 %template(UniMRCPRecognizerChannel) UniMRCPClientResourceChannel<MRCP_RECOGNIZER>;
 %template(UniMRCPRecorderChannel) UniMRCPClientResourceChannel<MRCP_RECORDER>;
+
+#ifdef UW_BENCHMARK
+%include "Benchmarks/BindingBench.i"
+#endif